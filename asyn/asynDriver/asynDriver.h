@@ -80,6 +80,13 @@ typedef enum {
     asynQueuePriorityConnect
 }asynQueuePriority;
 
+/* How the port thread chooses between requests of the same priority */
+typedef enum {
+    asynQueuePolicyFifo,        /* in the order they were queued */
+    asynQueuePolicyRoundRobin,  /* in turn for each address of a multiDevice port */
+    asynQueuePolicyDeadline     /* earliest deadline first, see queueRequestDeadline */
+}asynQueuePolicy;
+
 typedef struct asynUser {
     char          *errorMessage;
     int            errorMessageSize;
@@ -126,6 +133,18 @@ typedef struct interruptNode{
     void    *drvPvt;
 }interruptNode;
 
+/* Statistics of one priority queue of a port, times in seconds.
+ * The percentiles are upper limits with a resolution of 25%. */
+typedef struct asynQueueStatistics {
+    unsigned long nRequests;    /* queued, or processed at once if the port can not block */
+    unsigned long nTimeouts;    /* timeout callbacks */
+    unsigned long nExpired;     /* dropped because their deadline had passed */
+    unsigned long depth;        /* requests now on the queue, canceled ones not counted */
+    unsigned long maxDepth;
+    double waitMean, waitP50, waitP90, waitP99, waitMax;
+    double serviceMean, serviceP50, serviceP90, serviceP99, serviceMax;
+}asynQueueStatistics;
+
 typedef struct asynManager {
     void      (*report)(FILE *fp,int details,const char*portName);
     asynUser  *(*createAsynUser)(userCallback process,userCallback timeout);
@@ -200,6 +219,31 @@ typedef struct asynManager {
     asynStatus (*setTimeStamp)(asynUser *pasynUser, const epicsTimeStamp *pTimeStamp);
 
     const char *(*strStatus)(asynStatus status);
+    /* Parallel connection of ports at IOC startup */
+    asynStatus (*setParallelConnect)(int yesNo, double timeout);
+    asynStatus (*waitAllConnected)(double timeout);
+    void       (*connectReport)(FILE *fp);
+    /* autoConnect backoff of a port or device */
+    asynStatus (*setConnectBackoff)(asynUser *pasynUser,
+                   double minDelay, double maxDelay, double jitter, int failFast);
+    /* Queue wait and service time statistics of a port */
+    asynStatus (*getQueueStatistics)(asynUser *pasynUser,
+                   asynQueuePriority priority, asynQueueStatistics *pstats);
+    asynStatus (*resetQueueStatistics)(asynUser *pasynUser);
+    void       (*queueStatisticsReport)(FILE *fp, const char *portName);
+    /* Scheduling of requests across the addresses of a multiDevice port */
+    asynStatus (*setQueuePolicy)(asynUser *pasynUser, asynQueuePolicy policy);
+    asynStatus (*setQueueWeight)(asynUser *pasynUser, int weight);
+    /* queueRequest with an absolute deadline */
+    asynStatus (*queueRequestDeadline)(asynUser *pasynUser,
+                   asynQueuePriority priority, double timeout,
+                   const epicsTimeStamp *pdeadline, int dropExpired);
+    /* CPU affinity and scheduling policy of the port thread (Linux only) */
+    asynStatus (*setThreadAffinity)(asynUser *pasynUser, const char *cpuList);
+    asynStatus (*setThreadScheduler)(asynUser *pasynUser,
+                   const char *policy, int priority);
+    asynStatus (*placeThread)(asynUser *pasynUser);
+    void       (*threadReport)(FILE *fp, const char *portName);
 }asynManager;
 ASYN_API extern asynManager *pasynManager;
 
@@ -18,11 +18,13 @@
 #include <ctype.h>
 
 #include <ellLib.h>
+#include <gpHash.h>
 #include <errlog.h>
 #include <taskwd.h>
 #include <epicsStdio.h>
 #include <epicsString.h>
 #include <epicsMutex.h>
+#include <epicsAtomic.h>
 #include <epicsEvent.h>
 #include <epicsThread.h>
 #include <epicsTime.h>
@@ -30,9 +32,11 @@
 #include <cantProceed.h>
 #include <epicsAssert.h>
 #include <epicsExit.h>
+#include <initHooks.h>
 
 #include <epicsExport.h>
 #include "asynDriver.h"
+#include "asynThreadPlacement.h"
 
 #define BOOL int
 #ifndef TRUE
@@ -46,8 +50,21 @@
 #define DEFAULT_TRACE_TRUNCATE_SIZE 80
 #define DEFAULT_TRACE_BUFFER_SIZE 80
 #define DEFAULT_SECONDS_BETWEEN_PORT_CONNECT 20
+#define DEFAULT_SECONDS_BETWEEN_DEVICE_CONNECT 2.0
 #define DEFAULT_AUTOCONNECT_TIMEOUT 0.5
 #define DEFAULT_QUEUE_LOCK_PORT_TIMEOUT 2.0
+/* Used only when setConnectBackoff has been called */
+#define DEFAULT_CONNECT_BACKOFF_MIN DEFAULT_SECONDS_BETWEEN_DEVICE_CONNECT
+#define DEFAULT_CONNECT_BACKOFF_MAX DEFAULT_SECONDS_BETWEEN_PORT_CONNECT
+#define DEFAULT_CONNECT_BACKOFF_JITTER 0.1
+#define MIN_CONNECT_BACKOFF .01
+#define NUM_CONNECT_TIME_BINS 16
+/* Queue statistics histograms have 4 bins per power of 2 microseconds */
+#define STAT_SUB_BINS 4
+#define NUM_STAT_BINS (STAT_SUB_BINS + 30*STAT_SUB_BINS)
+#define PORT_HASH_SIZE 1024
+#define INTERFACE_TYPE_HASH_SIZE 256
+#define INITIAL_DEVICE_HASH_SIZE 16
 
 /* This is taken from dbDefs.h, which we don't want to include */
 /* Subtract member byte offset, returning pointer to parent object */
@@ -98,6 +115,8 @@ typedef struct memNode {
 
 typedef struct asynBase {
     ELLLIST           asynPortList;
+    struct gphPvt     *portHash;          /* portName -> port */
+    struct gphPvt     *interfaceTypeHash; /* interned interfaceType strings */
     ELLLIST           asynUserFreeList;
     ELLLIST           interruptNodeFree;
     epicsTimerQueueId timerQueue;
@@ -108,9 +127,18 @@ typedef struct asynBase {
     /* following for connectPort */
     epicsTimerQueueId connectPortTimerQueue;
     double            autoConnectTimeout;
+    /* following for parallel connection at startup */
+    BOOL              parallelConnect;
+    double            parallelConnectTimeout;
 }asynBase;
 static asynBase *pasynBase = 0;
 
+/* How often a lock was taken and how often it was held by another thread */
+typedef struct lockStats {
+    unsigned long nLocks;
+    unsigned long nContended;
+}lockStats;
+
 typedef struct interruptBase {
     ELLLIST      callbackList;
     ELLLIST      addRemoveList;
@@ -131,10 +159,47 @@ typedef struct interruptNodePvt {
 
 typedef struct interfaceNode {
     ELLNODE       node;
+    const char    *interfaceType; /* interned, compared by address */
     asynInterface *pasynInterface;
     interruptBase *pinterruptBase;
 }interfaceNode;
 
+/* Upper limits of the time to connect histogram, the last bin has no limit */
+static const double connectTimeLimit[NUM_CONNECT_TIME_BINS-1] = {
+    .001, .002, .005, .01, .02, .05, .1, .2, .5, 1., 2., 5., 10., 20., 50.};
+
+/* Allocated at the first connect attempt of a port or device */
+typedef struct connectStats {
+    unsigned long attempts;
+    unsigned long failures;
+    unsigned long nConnects;    /* number of times to connect recorded */
+    double        sumTime;
+    double        maxTime;
+    unsigned long timeBins[NUM_CONNECT_TIME_BINS];
+}connectStats;
+
+/* Histogram of times with a relative resolution of 1/STAT_SUB_BINS */
+typedef struct statHistogram {
+    unsigned long count;
+    double        sum;
+    double        max;
+    unsigned long bins[NUM_STAT_BINS];
+}statHistogram;
+
+/* Statistics of one queue of a port, allocated for all priorities at the
+ * first queueRequest. They are updated with asynManagerLock held, except
+ * that queueRequest records the wait and service times of ports that can
+ * not block with only synchronousLock held. They are read and reset with
+ * both locks held, see lockQueueStats. */
+typedef struct queueStats {
+    unsigned long nRequests;
+    unsigned long nTimeouts;
+    unsigned long nExpired;
+    unsigned long maxDepth;
+    statHistogram wait;
+    statHistogram service;
+}queueStats;
+
 typedef struct dpCommon { /*device/port common fields*/
     BOOL           enabled;
     BOOL           defunct;
@@ -148,6 +213,16 @@ typedef struct dpCommon { /*device/port common fields*/
     BOOL           exceptionActive;
     epicsTimeStamp lastConnectDisconnect;
     unsigned long  numberConnects;
+    /* following for autoConnect backoff */
+    BOOL           backoffEnabled;     /* set by setConnectBackoff */
+    double         backoffMin;
+    double         backoffMax;
+    double         backoffJitter;
+    BOOL           backoffFailFast;
+    double         backoffDelay;       /* 0 after a successful attempt */
+    epicsTimeStamp nextConnectAttempt;
+    epicsTimeStamp disconnectTime;     /* start of the current outage */
+    connectStats   *pconnectStats;
     tracePvt       trace;
     port           *pport;
     device         *pdevice; /* 0 if port.dpc*/
@@ -162,6 +237,11 @@ typedef struct exceptionUser {
 }exceptionUser;
 
 typedef enum {callbackIdle,callbackActive,callbackCanceled}callbackState;
+/* userPvt.queueState. It only leaves requestQueued by compare and swap, so
+ * cancelRequest can cancel a queued request without taking asynManagerLock.
+ * A canceled request stays on its queue until a holder of asynManagerLock
+ * unlinks it, see unlinkCanceled and takeRequest. */
+typedef enum {requestIdle,requestQueued,requestCanceled}requestState;
 struct userPvt {
     ELLNODE       node;        /*For asynPort.queueList*/
     /* timer,...,state are for queueRequest callbacks*/
@@ -178,7 +258,12 @@ struct userPvt {
     device        *pdevice;
     exceptionUser *pexceptionUser;
     BOOL          freeAfterCallback;
-    BOOL          isQueued;
+    int           queueState;  /* requestState, accessed with epicsAtomic */
+    asynQueuePriority priority;   /* of the last queueRequest */
+    epicsTimeStamp queueTime;     /* when it was queued */
+    BOOL          hasDeadline;    /* following from queueRequestDeadline */
+    BOOL          dropExpired;
+    epicsTimeStamp deadline;
     asynUser      user;
 };
 
@@ -186,6 +271,8 @@ struct device {
     ELLNODE   node;     /*For asynPort.deviceList*/
     dpCommon  dpc;
     int       addr;
+    device    *hashNext; /*For asynPort.deviceHash*/
+    int       queueWeight; /* requests per turn with asynQueuePolicyRoundRobin */
 };
 
 typedef enum portConnectStatus {
@@ -200,13 +287,17 @@ struct port {
     char          *portName;
     epicsMutexId  asynManagerLock; /*for asynManager*/
     epicsMutexId  synchronousLock; /*for synchronous drivers*/
+    epicsMutexId  interruptLock;   /*for the interruptBase of all interfaces*/
+    lockStats     managerLockStats;   /*queueRequest and port thread*/
+    lockStats     interruptLockStats;
     dpCommon      dpc;
     ELLLIST       deviceList;
+    device        **deviceHash;   /* addr -> device, deviceHashSize buckets */
+    int           deviceHashSize;
     ELLLIST       interfaceList;
     int           attributes;
     /* The following are for autoConnect*/
     asynUser      *pasynUser;
-    double        secondsBetweenPortConnect;
     portConnectStatus previousConnectStatus;
     /* The following are for asynLockPortNotify */
     asynLockPortNotify *pasynLockPortNotify;
@@ -214,21 +305,36 @@ struct port {
     /*The following are only initialized/used if attributes&ASYN_CANBLOCK*/
     ELLLIST       queueList[NUMBER_QUEUE_PRIORITIES];
     BOOL          queueStateChange;
+    asynQueuePolicy queuePolicy;
+    /* following for asynQueuePolicyRoundRobin, for each priority */
+    int           rrAddr[NUMBER_QUEUE_PRIORITIES];  /* last address served */
+    int           rrCount[NUMBER_QUEUE_PRIORITIES]; /* requests served in its turn */
     epicsEventId  notifyPortThread;
     epicsThreadId threadid;
+    asynThreadPlacement *pplacement; /* CPU affinity and scheduling policy */
     userPvt       *pblockProcessHolder;
     /* following are for portConnect */
     asynUser      *pconnectUser;
     asynInterface *pcommonInterface;
     epicsTimerId  connectTimer;
+    epicsTimeStamp connectStart;    /* when asynCommon was registered */
+    double        connectDuration;  /* until the first connect, <0 if not yet */
     epicsThreadPrivateId queueLockPortId;
     double        queueLockPortTimeout;
+    queueStats    *pqueueStats; /* [NUMBER_QUEUE_PRIORITIES] */
     /* The following are for timestamp support */
     epicsTimeStamp timeStamp;
     timeStampCallback timeStampSource;
     void          *timeStampPvt;
 };
 
+/* Candidates found while scanning a queue with asynQueuePolicyRoundRobin */
+typedef struct roundRobinScan {
+    userPvt *sameDevice; /* continues the turn of the last address served */
+    userPvt *next;       /* first request of the next address in address order */
+    userPvt *lowest;     /* first request of the lowest address, to wrap around */
+}roundRobinScan;
+
 typedef struct queueLockPortPvt {
     epicsEventId  queueLockPortEvent;
     epicsMutexId  queueLockPortMutex;
@@ -289,6 +395,9 @@ static asynInterface *findInterface(asynUser *pasynUser,
     const char *interfaceType,int interposeInterfaceOK);
 static asynStatus queueRequest(asynUser *pasynUser,
     asynQueuePriority priority,double timeout);
+static asynStatus queueRequestDeadline(asynUser *pasynUser,
+    asynQueuePriority priority,double timeout,
+    const epicsTimeStamp *pdeadline,int dropExpired);
 static asynStatus cancelRequest(asynUser *pasynUser,int *wasQueued);
 static asynStatus blockProcessCallback(asynUser *pasynUser, int allDevices);
 static asynStatus unblockProcessCallback(asynUser *pasynUser, int allDevices);
@@ -318,6 +427,22 @@ static asynStatus isAutoConnect(asynUser *pasynUser,int *yesNo);
 static asynStatus setAutoConnectTimeout(double timeout);
 static asynStatus getAutoConnectTimeout(double *timeout);
 static asynStatus waitConnect(asynUser *pasynUser, double timeout);
+static asynStatus setParallelConnect(int yesNo, double timeout);
+static asynStatus waitAllConnected(double timeout);
+static void connectReport(FILE *fp);
+static asynStatus setQueuePolicy(asynUser *pasynUser, asynQueuePolicy policy);
+static asynStatus setQueueWeight(asynUser *pasynUser, int weight);
+static asynStatus getQueueStatistics(asynUser *pasynUser,
+    asynQueuePriority priority, asynQueueStatistics *pstats);
+static asynStatus resetQueueStatistics(asynUser *pasynUser);
+static void queueStatisticsReport(FILE *fp, const char *portName);
+static asynStatus setThreadAffinity(asynUser *pasynUser, const char *cpuList);
+static asynStatus setThreadScheduler(asynUser *pasynUser,
+    const char *policy, int priority);
+static asynStatus placeThread(asynUser *pasynUser);
+static void threadReport(FILE *fp, const char *portName);
+static asynStatus setConnectBackoff(asynUser *pasynUser,
+    double minDelay, double maxDelay, double jitter, int failFast);
 static asynStatus registerInterruptSource(const char *portName,
     asynInterface *pasynInterface, void **pasynPvt);
 static asynStatus getInterruptPvt(asynUser *pasynUser,
@@ -337,6 +462,7 @@ static asynStatus updateTimeStamp(asynUser *pasynUser);
 static asynStatus getTimeStamp(asynUser *pasynUser, epicsTimeStamp *pTimeStamp);
 static asynStatus setTimeStamp(asynUser *pasynUser, const epicsTimeStamp *pTimeStamp);
 static const char *strStatus(asynStatus status);
+static void parallelConnectHook(initHookState state);
 
 static asynManager manager = {
     report,
@@ -390,7 +516,21 @@ static asynManager manager = {
     updateTimeStamp,
     getTimeStamp,
     setTimeStamp,
-    strStatus
+    strStatus,
+    setParallelConnect,
+    waitAllConnected,
+    connectReport,
+    setConnectBackoff,
+    getQueueStatistics,
+    resetQueueStatistics,
+    queueStatisticsReport,
+    setQueuePolicy,
+    setQueueWeight,
+    queueRequestDeadline,
+    setThreadAffinity,
+    setThreadScheduler,
+    placeThread,
+    threadReport
 };
 asynManager *pasynManager = &manager;
 
@@ -496,6 +636,8 @@ static void asynInit(void)
     if(pasynBase) return;
     pasynBase = callocMustSucceed(1,sizeof(asynBase),"asynInit");
     ellInit(&pasynBase->asynPortList);
+    gphInitPvt(&pasynBase->portHash,PORT_HASH_SIZE);
+    gphInitPvt(&pasynBase->interfaceTypeHash,INTERFACE_TYPE_HASH_SIZE);
     ellInit(&pasynBase->asynUserFreeList);
     ellInit(&pasynBase->interruptNodeFree);
     pasynBase->timerQueue = epicsTimerQueueAllocate(
@@ -528,11 +670,139 @@ static void dpCommonInit(port *pport,device *pdevice,BOOL autoConnect)
     pdpCommon->pport = pport;
     pdpCommon->pdevice = pdevice;
     tracePvtInit(&pdpCommon->trace);
+    if(pdevice) {
+        pdpCommon->backoffEnabled = pport->dpc.backoffEnabled;
+        pdpCommon->backoffMin = pport->dpc.backoffMin;
+        pdpCommon->backoffMax = pport->dpc.backoffMax;
+        pdpCommon->backoffJitter = pport->dpc.backoffJitter;
+        pdpCommon->backoffFailFast = pport->dpc.backoffFailFast;
+    } else {
+        pdpCommon->backoffEnabled = FALSE;
+        pdpCommon->backoffMin = DEFAULT_CONNECT_BACKOFF_MIN;
+        pdpCommon->backoffMax = DEFAULT_CONNECT_BACKOFF_MAX;
+        pdpCommon->backoffJitter = DEFAULT_CONNECT_BACKOFF_JITTER;
+        pdpCommon->backoffFailFast = FALSE;
+    }
+    epicsTimeGetCurrent(&pdpCommon->disconnectTime);
 }
 
 static void dpCommonFree(dpCommon *pdpCommon)
 {
     tracePvtFree(&pdpCommon->trace);
+    free(pdpCommon->pconnectStats);
+}
+
+/* The following must be called with asynManagerLock held */
+static connectStats *getConnectStats(dpCommon *pdpCommon)
+{
+    if(!pdpCommon->pconnectStats)
+        pdpCommon->pconnectStats = callocMustSucceed(1,sizeof(connectStats),
+            "asynManager:getConnectStats");
+    return pdpCommon->pconnectStats;
+}
+
+/* Update the backoff after an autoConnect attempt.
+ * Without backoff attempts are DEFAULT_SECONDS_BETWEEN_DEVICE_CONNECT apart and
+ * the port timer uses DEFAULT_SECONDS_BETWEEN_PORT_CONNECT.
+ * With backoff each consecutive failure doubles the delay from backoffMin up to
+ * backoffMax, randomized by +-backoffJitter so that many ports do not retry in step. */
+static void connectAttemptDone(dpCommon *pdpCommon,BOOL success)
+{
+    connectStats *pstats = getConnectStats(pdpCommon);
+    epicsTimeStamp now;
+    double delay;
+
+    epicsTimeGetCurrent(&now);
+    pstats->attempts++;
+    pdpCommon->nextConnectAttempt = now;
+    if(success) {
+        pdpCommon->backoffDelay = 0.0;
+        return;
+    }
+    pstats->failures++;
+    if(!pdpCommon->backoffEnabled) return;
+    delay = 2.0*pdpCommon->backoffDelay;
+    if(delay < pdpCommon->backoffMin) delay = pdpCommon->backoffMin;
+    if(delay > pdpCommon->backoffMax) delay = pdpCommon->backoffMax;
+    if(delay < MIN_CONNECT_BACKOFF) delay = MIN_CONNECT_BACKOFF;
+    pdpCommon->backoffDelay = delay;
+    if(pdpCommon->backoffJitter > 0.0)
+        delay *= 1.0 + pdpCommon->backoffJitter*(2.0*rand()/RAND_MAX - 1.0);
+    if(delay < MIN_CONNECT_BACKOFF) delay = MIN_CONNECT_BACKOFF;
+    epicsTimeAddSeconds(&pdpCommon->nextConnectAttempt,delay);
+}
+
+/* Seconds until the next autoConnect attempt is allowed */
+static double connectBackoffLeft(dpCommon *pdpCommon)
+{
+    epicsTimeStamp now;
+    double left, sinceLast;
+
+    epicsTimeGetCurrent(&now);
+    sinceLast = epicsTimeDiffInSeconds(&now,&pdpCommon->lastConnectDisconnect);
+    left = pdpCommon->backoffMin - sinceLast;
+    if(pdpCommon->backoffDelay > 0.0) {
+        double untilNext = epicsTimeDiffInSeconds(
+            &pdpCommon->nextConnectAttempt,&now);
+        if(untilNext > left) left = untilNext;
+    }
+    return (left > 0.0) ? left : 0.0;
+}
+
+static void connectTimeRecord(dpCommon *pdpCommon)
+{
+    connectStats *pstats = getConnectStats(pdpCommon);
+    epicsTimeStamp now;
+    double t;
+    int i;
+
+    epicsTimeGetCurrent(&now);
+    t = epicsTimeDiffInSeconds(&now,&pdpCommon->disconnectTime);
+    for(i=0; i<NUM_CONNECT_TIME_BINS-1; i++)
+        if(t < connectTimeLimit[i]) break;
+    pstats->timeBins[i]++;
+    pstats->nConnects++;
+    pstats->sumTime += t;
+    if(t > pstats->maxTime) pstats->maxTime = t;
+}
+
+/* Upper limit of the bin that holds the given fraction of times to connect */
+static double connectTimePercentile(connectStats *pstats,double fraction)
+{
+    double target = fraction*pstats->nConnects;
+    unsigned long sum = 0;
+    int i;
+
+    for(i=0; i<NUM_CONNECT_TIME_BINS-1; i++) {
+        sum += pstats->timeBins[i];
+        if(sum >= target) break;
+    }
+    if(i == NUM_CONNECT_TIME_BINS-1 || connectTimeLimit[i] > pstats->maxTime)
+        return pstats->maxTime;
+    return connectTimeLimit[i];
+}
+
+static void reportConnectStats(FILE *fp,dpCommon *pdpCommon,const char *indent)
+{
+    connectStats *pstats = pdpCommon->pconnectStats;
+
+    if(!pdpCommon->backoffEnabled)
+        fprintf(fp,"%sbackoff off",indent);
+    else
+        fprintf(fp,"%sbackoff min %.3f max %.3f jitter %.2f failFast:%s",
+            indent, pdpCommon->backoffMin, pdpCommon->backoffMax,
+            pdpCommon->backoffJitter, (pdpCommon->backoffFailFast ? "Yes" : "No"));
+    if(pdpCommon->backoffDelay > 0.0)
+        fprintf(fp," next attempt in %.3f s",connectBackoffLeft(pdpCommon));
+    fprintf(fp,"\n");
+    if(!pstats) return;
+    fprintf(fp,"%sconnect attempts %lu failures %lu\n",
+        indent, pstats->attempts, pstats->failures);
+    if(pstats->nConnects == 0) return;
+    fprintf(fp,"%stime to connect mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f s\n",
+        indent, pstats->sumTime/pstats->nConnects,
+        connectTimePercentile(pstats,.5), connectTimePercentile(pstats,.9),
+        connectTimePercentile(pstats,.99), pstats->maxTime);
 }
 
 static dpCommon *findDpCommon(userPvt *puserPvt)
@@ -555,54 +825,108 @@ static tracePvt *findTracePvt(userPvt *puserPvt)
 /*locatePort returns 0 if portName is not registered*/
 static port *locatePort(const char *portName)
 {
-    port *pport;
+    GPHENTRY *pentry;
 
     if(!pasynBase) asynInit();
-    epicsMutexMustLock(pasynBase->lock);
-    pport = (port *)ellFirst(&pasynBase->asynPortList);
-    while(pport) {
-        if(strcmp(pport->portName,portName)==0) break;
-        pport = (port *)ellNext(&pport->node);
+    pentry = gphFind(pasynBase->portHash,portName,NULL);
+    /* registerPort publishes userPvt only when the port is complete */
+    return pentry ? (port *)epicsAtomicGetPtrT(&pentry->userPvt) : 0;
+}
+
+static unsigned int deviceHashIndex(int addr,int size)
+{
+    return ((unsigned int)addr * 2654435761u) & (unsigned int)(size - 1);
+}
+
+/* Called with asynManagerLock held. The table is doubled when it is full */
+static void deviceHashAdd(port *pport,device *pdevice)
+{
+    int nDevices = ellCount(&pport->deviceList);
+    unsigned int i;
+
+    if(nDevices >= pport->deviceHashSize) {
+        int newSize = pport->deviceHashSize ?
+            2*pport->deviceHashSize : INITIAL_DEVICE_HASH_SIZE;
+        device *pd;
+
+        free(pport->deviceHash);
+        pport->deviceHash = callocMustSucceed(newSize,sizeof(device *),
+            "asynManager:deviceHashAdd");
+        pport->deviceHashSize = newSize;
+        for(pd = (device *)ellFirst(&pport->deviceList); pd;
+            pd = (device *)ellNext(&pd->node)) {
+            i = deviceHashIndex(pd->addr,newSize);
+            pd->hashNext = pport->deviceHash[i];
+            pport->deviceHash[i] = pd;
+        }
     }
-    epicsMutexUnlock(pasynBase->lock);
-    return pport;
+    i = deviceHashIndex(pdevice->addr,pport->deviceHashSize);
+    pdevice->hashNext = pport->deviceHash[i];
+    pport->deviceHash[i] = pdevice;
 }
 
 static device *locateDevice(port *pport,int addr,BOOL allocNew)
 {
-    device *pdevice;
+    device *pdevice = 0;
 
     assert(pport);
     if(!(pport->attributes&ASYN_MULTIDEVICE) || addr < 0) return(0);
-    pdevice = (device *)ellFirst(&pport->deviceList);
-    while(pdevice) {
-        if(pdevice->addr == addr) return pdevice;
-        pdevice = (device *)ellNext(&pdevice->node);
+    if(pport->deviceHash) {
+        pdevice = pport->deviceHash[deviceHashIndex(addr,pport->deviceHashSize)];
+        while(pdevice) {
+            if(pdevice->addr == addr) return pdevice;
+            pdevice = pdevice->hashNext;
+        }
     }
-    if(!pdevice && allocNew) {
+    if(allocNew) {
         pdevice = callocMustSucceed(1,sizeof(device),
             "asynManager:locateDevice");
         pdevice->addr = addr;
+        pdevice->queueWeight = 1;
         dpCommonInit(pport,pdevice,pport->dpc.autoConnect);
+        deviceHashAdd(pport,pdevice);
         ellAdd(&pport->deviceList,&pdevice->node);
     }
     return pdevice;
 }
 
+/* Returns the interned copy of interfaceType, 0 if it was never interned
+ * and intern is FALSE. Interned strings are never freed. */
+static const char *internInterfaceType(const char *interfaceType,BOOL intern)
+{
+    GPHENTRY *pentry;
+    char     *copy;
+
+    pentry = gphFind(pasynBase->interfaceTypeHash,interfaceType,NULL);
+    if(pentry) return pentry->name;
+    if(!intern) return 0;
+    copy = epicsStrDup(interfaceType);
+    pentry = gphAdd(pasynBase->interfaceTypeHash,copy,NULL);
+    if(!pentry) {
+        /* Another thread interned it first */
+        free(copy);
+        pentry = gphFind(pasynBase->interfaceTypeHash,interfaceType,NULL);
+    }
+    return pentry->name;
+}
+
 static interfaceNode *locateInterfaceNode(
             ELLLIST *plist,const char *interfaceType,BOOL allocNew)
 {
-    interfaceNode *pinterfaceNode;
+    interfaceNode *pinterfaceNode = 0;
+    const char    *interned;
 
+    interned = internInterfaceType(interfaceType,allocNew);
+    if(!interned) return 0;
     pinterfaceNode = (interfaceNode *)ellFirst(plist);
     while(pinterfaceNode) {
-        asynInterface *pif = pinterfaceNode->pasynInterface;
-        if(strcmp(pif->interfaceType,interfaceType)==0) break;
+        if(pinterfaceNode->interfaceType == interned) break;
         pinterfaceNode = (interfaceNode *)ellNext(&pinterfaceNode->node);
     }
     if(!pinterfaceNode && allocNew) {
         pinterfaceNode = callocMustSucceed(1,sizeof(interfaceNode),
             "asynManager::locateInterfaceNode");
+        pinterfaceNode->interfaceType = interned;
         ellAdd(plist,&pinterfaceNode->node);
     }
     return pinterfaceNode;
@@ -646,6 +970,144 @@ static void exceptionOccurred(asynUser *pasynUser,asynException exception)
     announceExceptionOccurred(pport, pdevice, exception);
 }
 
+static int statBin(double seconds)
+{
+    unsigned long us;
+    int octave = 0;
+
+    if(seconds >= 4000.0) return NUM_STAT_BINS - 1;
+    us = (seconds > 0.0) ? (unsigned long)(seconds*1e6) : 0;
+    if(us < STAT_SUB_BINS) return (int)us;
+    while((us >> octave) >= 2*STAT_SUB_BINS) octave++;
+    if(octave >= 30) return NUM_STAT_BINS - 1;
+    return STAT_SUB_BINS*(octave + 1) + (int)((us >> octave) - STAT_SUB_BINS);
+}
+
+/* Upper limit in seconds of a bin */
+static double statBinLimit(int bin)
+{
+    int octave;
+
+    if(bin < STAT_SUB_BINS) return (bin + 1)*1e-6;
+    octave = bin/STAT_SUB_BINS - 1;
+    return (STAT_SUB_BINS + bin%STAT_SUB_BINS + 1)*(double)(1UL << octave)*1e-6;
+}
+
+static void statRecord(statHistogram *phist,double seconds)
+{
+    phist->bins[statBin(seconds)]++;
+    phist->count++;
+    phist->sum += seconds;
+    if(seconds > phist->max) phist->max = seconds;
+}
+
+static double statPercentile(const statHistogram *phist,double fraction)
+{
+    double target = fraction*phist->count;
+    unsigned long sum = 0;
+    double limit;
+    int i;
+
+    if(phist->count == 0) return 0.0;
+    for(i=0; i<NUM_STAT_BINS-1; i++) {
+        sum += phist->bins[i];
+        if(sum >= target) break;
+    }
+    limit = statBinLimit(i);
+    return (i == NUM_STAT_BINS-1 || limit > phist->max) ? phist->max : limit;
+}
+
+/* Called with asynManagerLock held */
+static queueStats *getQueueStats(port *pport)
+{
+    if(!pport->pqueueStats)
+        pport->pqueueStats = callocMustSucceed(NUMBER_QUEUE_PRIORITIES,
+            sizeof(queueStats),"asynManager:getQueueStats");
+    return pport->pqueueStats;
+}
+
+/*Takes lock and counts it in *pstats, which must be protected by lock*/
+static void lockCounted(epicsMutexId lock,lockStats *pstats)
+{
+    if(epicsMutexTryLock(lock)!=epicsMutexLockOK) {
+        epicsMutexMustLock(lock);
+        pstats->nContended++;
+    }
+    pstats->nLocks++;
+}
+
+static void queueStatsWait(port *pport,userPvt *puserPvt,asynQueuePriority priority)
+{
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    statRecord(&getQueueStats(pport)[priority].wait,
+        epicsTimeDiffInSeconds(&now,&puserPvt->queueTime));
+}
+
+static BOOL requestIsQueued(userPvt *puserPvt)
+{
+    return epicsAtomicGetIntT(&puserPvt->queueState)==requestQueued;
+}
+
+/*unlinkRequest must be called with asynManagerLock held*/
+static void unlinkRequest(port *pport,userPvt *puserPvt)
+{
+    ellDelete(&pport->queueList[puserPvt->priority],&puserPvt->node);
+    epicsAtomicSetIntT(&puserPvt->queueState,requestIdle);
+}
+
+/* Removes a canceled request from its queue. The port thread may be scanning
+ * the queue with asynManagerLock released in autoConnectDevice, so it is
+ * told to scan again. unlinkCanceled must be called with asynManagerLock held*/
+static void unlinkCanceled(port *pport,userPvt *puserPvt)
+{
+    if(epicsAtomicGetIntT(&puserPvt->queueState)!=requestCanceled) return;
+    unlinkRequest(pport,puserPvt);
+    pport->queueStateChange = TRUE;
+}
+
+/* Called by the port thread before it scans a queue, so the scan need not
+ * start again. pruneCanceled must be called with asynManagerLock held*/
+static void pruneCanceled(port *pport,int priority)
+{
+    userPvt *puserPvt = (userPvt *)ellFirst(&pport->queueList[priority]);
+
+    while(puserPvt) {
+        userPvt *pnext = (userPvt *)ellNext(&puserPvt->node);
+
+        if(epicsAtomicGetIntT(&puserPvt->queueState)==requestCanceled)
+            unlinkRequest(pport,puserPvt);
+        puserPvt = pnext;
+    }
+}
+
+/* Number of requests on a queue that are not canceled.
+ * queuedCount must be called with asynManagerLock held*/
+static unsigned long queuedCount(port *pport,int priority)
+{
+    userPvt *puserPvt = (userPvt *)ellFirst(&pport->queueList[priority]);
+    unsigned long count = 0;
+
+    for(; puserPvt; puserPvt = (userPvt *)ellNext(&puserPvt->node))
+        if(requestIsQueued(puserPvt)) count++;
+    return count;
+}
+
+/* Removes a queued request from its queue. Returns FALSE if cancelRequest
+ * got it first; the port thread is then told to scan the queues again.
+ * takeRequest must be called with asynManagerLock held */
+static BOOL takeRequest(port *pport,int priority,userPvt *puserPvt)
+{
+    ellDelete(&pport->queueList[priority],&puserPvt->node);
+    if(epicsAtomicCmpAndSwapIntT(&puserPvt->queueState,
+        requestQueued,requestIdle)==requestQueued) return TRUE;
+    epicsAtomicSetIntT(&puserPvt->queueState,requestIdle);
+    pport->queueStateChange = TRUE;
+    epicsEventSignal(pport->notifyPortThread);
+    return FALSE;
+}
+
 static void queueTimeoutCallback(void *pvt)
 {
     userPvt  *puserPvt = (userPvt *)pvt;
@@ -653,35 +1115,24 @@ static void queueTimeoutCallback(void *pvt)
     port     *pport = puserPvt->pport;
     int      i;
 
+    if(!pport) return;
     epicsMutexMustLock(pport->asynManagerLock);
-    if(!puserPvt->isQueued) {
+    unlinkCanceled(pport,puserPvt);
+    /* cancelRequest leaves the timer running. If the request was queued
+     * again without a timeout this is the old timer, so timeout is 0.
+     * With a timeout queueRequest has stopped the old timer first. */
+    i = puserPvt->priority;
+    if(!requestIsQueued(puserPvt) || puserPvt->timeout<=0.0
+    || !takeRequest(pport,i,puserPvt)) {
         epicsMutexUnlock(pport->asynManagerLock);
         asynPrint(pasynUser,ASYN_TRACE_FLOW,
             "%s asynManager:queueTimeoutCallback but not queued\n",
             pport->portName );
         return;
     }
-    for(i=asynQueuePriorityConnect; i>=asynQueuePriorityLow; i--) {
-        puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
-        while(puserPvt) {
-            if(pasynUser == &puserPvt->user) {
-                ellDelete(&pport->queueList[i],&puserPvt->node);
-                break;
-            }
-            puserPvt = (userPvt *)ellNext(&puserPvt->node);
-        }
-        if (puserPvt) break;
-    }
-    if(!puserPvt) {
-        epicsMutexUnlock(pport->asynManagerLock);
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,
-            "%s asynManager:queueTimeoutCallback LOGIC ERROR\n",
-            pport->portName);
-        return;
-    }
+    getQueueStats(pport)[i].nTimeouts++;
     asynPrint(pasynUser,ASYN_TRACE_FLOW,
         "%s asynManager:queueTimeoutCallback\n", pport->portName);
-    puserPvt->isQueued = FALSE;
     pport->queueStateChange = TRUE;
     if(puserPvt->timeoutUser) {
         puserPvt->state = callbackActive;
@@ -708,16 +1159,13 @@ static BOOL autoConnectDevice(port *pport,device *pdevice)
     if(!pport->dpc.connected
     &&  pport->dpc.autoConnect
     && !pport->dpc.autoConnectActive) {
-        epicsTimeStamp now;
-
-        epicsTimeGetCurrent(&now);
-        if(epicsTimeDiffInSeconds(
-             &now,&pport->dpc.lastConnectDisconnect) < 2.0) return FALSE;
+        if(connectBackoffLeft(&pport->dpc) > 0.0) return FALSE;
         pport->dpc.autoConnectActive = TRUE;
         epicsMutexUnlock(pport->asynManagerLock);
         connectAttempt(&pport->dpc);
         epicsMutexMustLock(pport->asynManagerLock);
         epicsTimeGetCurrent(&pport->dpc.lastConnectDisconnect);
+        connectAttemptDone(&pport->dpc,pport->dpc.connected);
         pport->dpc.autoConnectActive = FALSE;
     }
     if(!pport->dpc.connected) return FALSE;
@@ -725,16 +1173,13 @@ static BOOL autoConnectDevice(port *pport,device *pdevice)
     if(!pdevice->dpc.connected
     &&  pdevice->dpc.autoConnect
     && !pdevice->dpc.autoConnectActive) {
-        epicsTimeStamp now;
-
-        epicsTimeGetCurrent(&now);
-        if(epicsTimeDiffInSeconds(
-            &now,&pdevice->dpc.lastConnectDisconnect) < 2.0) return FALSE;
+        if(connectBackoffLeft(&pdevice->dpc) > 0.0) return FALSE;
         pdevice->dpc.autoConnectActive = TRUE;
         epicsMutexUnlock(pport->asynManagerLock);
         connectAttempt(&pdevice->dpc);
         epicsMutexMustLock(pport->asynManagerLock);
         epicsTimeGetCurrent(&pdevice->dpc.lastConnectDisconnect);
+        connectAttemptDone(&pdevice->dpc,pdevice->dpc.connected);
         pdevice->dpc.autoConnectActive = FALSE;
     }
     return pdevice->dpc.connected;
@@ -794,17 +1239,100 @@ disconnect:
     }
 }
 
+static const char *queuePolicyName(asynQueuePolicy policy)
+{
+    switch(policy) {
+    case asynQueuePolicyRoundRobin: return "roundRobin";
+    case asynQueuePolicyDeadline:   return "deadline";
+    default:                        return "fifo";
+    }
+}
+
+/* Keeps requests with a deadline in deadline order, ahead of those without.
+ * Requests with the same deadline stay in the order they were queued. */
+static void queueAddByDeadline(ELLLIST *plist,userPvt *puserPvt)
+{
+    userPvt *pprev = (userPvt *)ellLast(plist);
+
+    while(pprev && (!pprev->hasDeadline
+    || epicsTimeGreaterThan(&pprev->deadline,&puserPvt->deadline)))
+        pprev = (userPvt *)ellPrevious(&pprev->node);
+    ellInsert(plist,(pprev ? &pprev->node : 0),&puserPvt->node);
+}
+
+/* Returns how long ago the deadline passed if the request must be dropped, else 0 */
+static double deadlineMissed(userPvt *puserPvt)
+{
+    epicsTimeStamp now;
+    double late;
+
+    if(!puserPvt->hasDeadline || !puserPvt->dropExpired) return 0.0;
+    epicsTimeGetCurrent(&now);
+    late = epicsTimeDiffInSeconds(&now,&puserPvt->deadline);
+    return (late > 0.0) ? late : 0.0;
+}
+
+static int requestAddr(userPvt *puserPvt)
+{
+    return puserPvt->pdevice ? puserPvt->pdevice->addr : -1;
+}
+
+/* Called for each request that could be processed, in queue order */
+static void roundRobinCandidate(port *pport,int priority,userPvt *puserPvt,
+    roundRobinScan *pscan)
+{
+    int addr = requestAddr(puserPvt);
+    int last = pport->rrAddr[priority];
+    int weight = puserPvt->pdevice ? puserPvt->pdevice->queueWeight : 1;
+
+    if(addr == last) {
+        if(!pscan->sameDevice && pport->rrCount[priority] < weight)
+            pscan->sameDevice = puserPvt;
+    } else if(addr > last) {
+        if(!pscan->next || addr < requestAddr(pscan->next))
+            pscan->next = puserPvt;
+    }
+    if(!pscan->lowest || addr < requestAddr(pscan->lowest))
+        pscan->lowest = puserPvt;
+}
+
+/* Each address gets queueWeight requests in turn, then the next address with a request */
+static userPvt *roundRobinSelect(roundRobinScan *pscan)
+{
+    if(pscan->sameDevice) return pscan->sameDevice;
+    if(pscan->next) return pscan->next;
+    return pscan->lowest;
+}
+
+/* Called when the request from roundRobinSelect has been taken from the queue */
+static void roundRobinServed(port *pport,int priority,userPvt *puserPvt)
+{
+    int addr = requestAddr(puserPvt);
+
+    if(addr == pport->rrAddr[priority]) {
+        pport->rrCount[priority]++;
+    } else {
+        pport->rrAddr[priority] = addr;
+        pport->rrCount[priority] = 1;
+    }
+}
+
 static void portThread(port *pport)
 {
     userPvt  *puserPvt;
     asynUser *pasynUser;
     double   timeout;
     BOOL     callTimeoutUser = FALSE;
+    double   late = 0.0;
+    epicsTimeStamp start, end;
 
     taskwdInsert(epicsThreadGetIdSelf(),0,0);
+    if(asynThreadPlacementAttach(pport->pplacement))
+        printf("%s portThread can not apply CPU affinity or scheduling policy\n",
+            pport->portName);
     while(1) {
         epicsEventMustWait(pport->notifyPortThread);
-        epicsMutexMustLock(pport->asynManagerLock);
+        lockCounted(pport->asynManagerLock,&pport->managerLockStats);
         if(!pport->dpc.enabled) {
             epicsMutexUnlock(pport->asynManagerLock);
             continue;
@@ -814,10 +1342,8 @@ static void portThread(port *pport)
         &pport->queueList[asynQueuePriorityConnect]))) {
             asynStatus status = asynSuccess;
 
-            assert(puserPvt->isQueued);
-            ellDelete(&pport->queueList[asynQueuePriorityConnect],
-               &puserPvt->node);
-            puserPvt->isQueued = FALSE;
+            if(!takeRequest(pport,asynQueuePriorityConnect,puserPvt)) continue;
+            queueStatsWait(pport,puserPvt,asynQueuePriorityConnect);
             pasynUser = userPvtToAsynUser(puserPvt);
             pasynUser->errorMessage[0] = '\0';
             asynPrint(pasynUser,ASYN_TRACE_FLOW,
@@ -835,7 +1361,9 @@ static void portThread(port *pport)
                         "%s queueCallback pasynLockPortNotify:lock error %s\n",
                          pport->portName,pasynUser->errorMessage);
             }
+            epicsTimeGetCurrent(&start);
             puserPvt->processUser(pasynUser);
+            epicsTimeGetCurrent(&end);
             if(pport->pasynLockPortNotify) {
                 status = pport->pasynLockPortNotify->unlock(
                    pport->lockPortNotifyPvt,pasynUser);
@@ -845,6 +1373,8 @@ static void portThread(port *pport)
             }
             epicsMutexUnlock(pport->synchronousLock);
             epicsMutexMustLock(pport->asynManagerLock);
+            statRecord(&getQueueStats(pport)[asynQueuePriorityConnect].service,
+                epicsTimeDiffInSeconds(&end,&start));
             if (puserPvt->state==callbackCanceled)
                 epicsEventSignal(puserPvt->callbackDone);
             puserPvt->state = callbackIdle;
@@ -865,17 +1395,23 @@ static void portThread(port *pport)
             int i;
             dpCommon *pdpCommon = 0;
             asynStatus status = asynSuccess;
+            BOOL roundRobin = (pport->queuePolicy == asynQueuePolicyRoundRobin);
 
             callTimeoutUser = FALSE;
             pport->queueStateChange = FALSE;
             for(i=asynQueuePriorityHigh; i>=asynQueuePriorityLow; i--) {
+                roundRobinScan scan = {0, 0, 0};
+
+                pruneCanceled(pport,i);
                 for(puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
                 puserPvt; puserPvt = (userPvt *)ellNext(&puserPvt->node)) {
                     pdpCommon = findDpCommon(puserPvt);
                     assert(pdpCommon);
 
                     if(!pdpCommon->enabled) continue;
-                    if(!pdpCommon->connected) {
+                    /* With roundRobin only the selected request gets a
+                     * connect attempt, below */
+                    if(!pdpCommon->connected && !roundRobin) {
                         autoConnectDevice(pdpCommon->pport,
                             pdpCommon->pdevice);
                         if(pport->queueStateChange) {
@@ -890,17 +1426,50 @@ static void portThread(port *pport)
                         || pport->pblockProcessHolder==puserPvt)
                     && (pdpCommon->pblockProcessHolder==NULL
                         || pdpCommon->pblockProcessHolder==puserPvt)) {
-                        assert(puserPvt->isQueued);
-                        ellDelete(&pport->queueList[i],&puserPvt->node);
-                        puserPvt->isQueued = FALSE;
+                        if(roundRobin) {
+                            roundRobinCandidate(pport,i,puserPvt,&scan);
+                            continue;
+                        }
+                        if(!takeRequest(pport,i,puserPvt)) {
+                            puserPvt = 0;
+                            pport->queueStateChange = TRUE;
+                            break;
+                        }
+                        queueStatsWait(pport,puserPvt,i);
                         break;
                     }
                 }
+                if(roundRobin && !pport->queueStateChange
+                && (puserPvt = roundRobinSelect(&scan))) {
+                    pdpCommon = findDpCommon(puserPvt);
+                    if(!pdpCommon->connected)
+                        autoConnectDevice(pdpCommon->pport,pdpCommon->pdevice);
+                    if(pport->queueStateChange) {
+                        puserPvt = 0;
+                    } else if(takeRequest(pport,i,puserPvt)) {
+                        roundRobinServed(pport,i,puserPvt);
+                        callTimeoutUser =
+                            (!pdpCommon->connected && puserPvt->timeoutUser!=0);
+                        queueStatsWait(pport,puserPvt,i);
+                    } else {
+                        puserPvt = 0;
+                        pport->queueStateChange = TRUE;
+                    }
+                }
                 if(puserPvt || pport->queueStateChange) break; /*for*/
             }
             if(!puserPvt) break; /*while(1)*/
             pasynUser = userPvtToAsynUser(puserPvt);
             pasynUser->errorMessage[0] = '\0';
+            late = callTimeoutUser ? 0.0 : deadlineMissed(puserPvt);
+            if(late > 0.0) {
+                callTimeoutUser = TRUE;
+                epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                    "%s deadline missed by %.3f s",pport->portName,late);
+                asynPrint(pasynUser,ASYN_TRACE_FLOW,
+                    "asynManager::portThread port=%s deadline missed by %f seconds\n",
+                    pport->portName,late);
+            }
             asynPrint(pasynUser,ASYN_TRACE_FLOW,"asynManager::portThread port=%s callback\n",pport->portName);
             puserPvt->state = callbackActive;
             timeout = puserPvt->timeout;
@@ -914,11 +1483,13 @@ static void portThread(port *pport)
                         "%s queueCallback pasynLockPortNotify:lock error %s\n",
                          pport->portName,pasynUser->errorMessage);
             }
+            epicsTimeGetCurrent(&start);
             if(callTimeoutUser) {
                 puserPvt->timeoutUser(pasynUser);
             } else {
                 puserPvt->processUser(pasynUser);
             }
+            epicsTimeGetCurrent(&end);
             if(pport->pasynLockPortNotify) {
                 status = pport->pasynLockPortNotify->unlock(
                    pport->lockPortNotifyPvt,pasynUser);
@@ -928,6 +1499,14 @@ static void portThread(port *pport)
             }
             epicsMutexUnlock(pport->synchronousLock);
             epicsMutexMustLock(pport->asynManagerLock);
+            if(late > 0.0) {
+                getQueueStats(pport)[i].nExpired++;
+            } else if(callTimeoutUser) {
+                getQueueStats(pport)[i].nTimeouts++;
+            } else {
+                statRecord(&getQueueStats(pport)[i].service,
+                    epicsTimeDiffInSeconds(&end,&start));
+            }
             if(puserPvt->blockPortCount>0)
                 pport->pblockProcessHolder = puserPvt;
             if(puserPvt->blockDeviceCount>0)
@@ -1035,8 +1614,10 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
         showDevices = 0;
         details = -details;
     }
+    epicsMutexMustLock(pport->asynManagerLock);
     for(i=asynQueuePriorityLow; i<=asynQueuePriorityConnect; i++)
-        nQueued += ellCount(&pport->queueList[i]);
+        nQueued += queuedCount(pport,i);
+    epicsMutexUnlock(pport->asynManagerLock);
     pdpc = &pport->dpc;
     if (pdpc->defunct) {
         fprintf(fp,"%s destroyed\n", pport->portName);
@@ -1060,10 +1641,11 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
             (pdpc->enabled ? "Yes" : "No"),
             (pdpc->connected ? "Yes" : "No"),
              pdpc->numberConnects);
-        fprintf(fp,"    nDevices %d nQueued %d blocked:%s\n",
+        fprintf(fp,"    nDevices %d nQueued %d blocked:%s queuePolicy:%s\n",
             ellCount(&pport->deviceList),
             nQueued,
-            (pport->pblockProcessHolder ? "Yes" : "No"));
+            (pport->pblockProcessHolder ? "Yes" : "No"),
+            queuePolicyName(pport->queuePolicy));
         fprintf(fp,"    asynManagerLock:%s synchronousLock:%s\n",
             ((mgrStatus==epicsMutexLockOK) ? "No" : "Yes"),
             ((syncStatus==epicsMutexLockOK) ? "No" : "Yes"));
@@ -1074,6 +1656,7 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
             ellCount(&pdpc->exceptionNotifyList));
         fprintf(fp,"    traceMask:0x%x traceIOMask:0x%x traceInfoMask:0x%x\n",
             pdpc->trace.traceMask, pdpc->trace.traceIOMask, pdpc->trace.traceInfoMask);
+        reportConnectStats(fp,pdpc,"    ");
     }
     if(details>=2) {
         reportPrintInterfaceList(fp,&pdpc->interposeInterfaceList,
@@ -1098,10 +1681,12 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
                     (pdpc->exceptionActive ? "Yes" : "No"),
                     ellCount(&pdpc->exceptionUserList),
                     ellCount(&pdpc->exceptionNotifyList));
-                fprintf(fp,"        blocked %s\n",
-                    (pdpc->pblockProcessHolder ? "Yes" : "No"));
+                fprintf(fp,"        blocked %s queueWeight %d\n",
+                    (pdpc->pblockProcessHolder ? "Yes" : "No"),
+                    pdevice->queueWeight);
                 fprintf(fp,"        traceMask:0x%x traceIOMask:0x%x traceInfoMask:0x%x\n",
                     pdpc->trace.traceMask, pdpc->trace.traceIOMask, pdpc->trace.traceInfoMask);
+                reportConnectStats(fp,pdpc,"        ");
             }
             if(details>=2) {
                 reportPrintInterfaceList(fp,&pdpc->interposeInterfaceList,
@@ -1205,7 +1790,7 @@ static asynUser *createAsynUser(userCallback process, userCallback timeout)
     assert(puserPvt->blockDeviceCount==0);
     assert(puserPvt->freeAfterCallback==FALSE);
     assert(puserPvt->pexceptionUser==0);
-    puserPvt->isQueued = FALSE;
+    puserPvt->queueState = requestIdle;
     pasynUser->errorMessage[0] = 0;
     pasynUser->timeout = 0.0;
     pasynUser->userPvt = 0;
@@ -1369,7 +1954,8 @@ static asynStatus disconnect(asynUser *pasynUser)
         return asynError;
     }
     epicsMutexMustLock(pport->asynManagerLock);
-    if(puserPvt->isQueued) {
+    unlinkCanceled(pport,puserPvt);
+    if(requestIsQueued(puserPvt)) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager::disconnect request queued");
         status = asynError; goto unlock;
@@ -1386,6 +1972,10 @@ static asynStatus disconnect(asynUser *pasynUser)
     }
     puserPvt->pport = 0;
     puserPvt->pdevice = 0;
+    epicsMutexUnlock(pport->asynManagerLock);
+    /*The timer of a request canceled by cancelRequest may still be running*/
+    if(puserPvt->timer) epicsTimerCancel(puserPvt->timer);
+    return status;
 unlock:
     epicsMutexUnlock(pport->asynManagerLock);
     return status;
@@ -1515,6 +2105,13 @@ retif:
 
 static asynStatus queueRequest(asynUser *pasynUser,
     asynQueuePriority priority,double timeout)
+{
+    return queueRequestDeadline(pasynUser,priority,timeout,0,0);
+}
+
+static asynStatus queueRequestDeadline(asynUser *pasynUser,
+    asynQueuePriority priority,double timeout,
+    const epicsTimeStamp *pdeadline,int dropExpired)
 {
     userPvt  *puserPvt = asynUserToUserPvt(pasynUser);
     port     *pport = puserPvt->pport;
@@ -1523,6 +2120,9 @@ static asynStatus queueRequest(asynUser *pasynUser,
     dpCommon *pdpCommon = findDpCommon(puserPvt);
     BOOL     addToFront = FALSE;
     BOOL     checkPortConnect = TRUE;
+    queueStats *pstats;
+    unsigned long depth;
+    epicsTimeStamp start, end;
 
     assert(priority>=asynQueuePriorityLow && priority<=asynQueuePriorityConnect);
     if(!pport) {
@@ -1535,11 +2135,23 @@ static asynStatus queueRequest(asynUser *pasynUser,
                 "asynManager::queueRequest no processCallback");
         return asynError;
     }
+    if(pdeadline && dropExpired && !puserPvt->timeoutUser) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager::queueRequest dropExpired requested but no "
+            "timeout callback was passed to createAsynUser");
+        return asynError;
+    }
     if((priority==asynQueuePriorityConnect)
     && (addr==-1 || pasynUser->reason==ASYN_REASON_QUEUE_EVEN_IF_NOT_CONNECTED)) {
         checkPortConnect = FALSE;
     }
-    epicsMutexMustLock(pport->asynManagerLock);
+    /* The timer of a canceled request may still be running, waiting for
+     * asynManagerLock. It must finish before the timer is started again,
+     * or it would time out the new request. epicsTimerCancel waits for it,
+     * so asynManagerLock must not be held here. */
+    if(timeout>0.0 && puserPvt->timer && !requestIsQueued(puserPvt))
+        epicsTimerCancel(puserPvt->timer);
+    lockCounted(pport->asynManagerLock,&pport->managerLockStats);
     if(!pport->dpc.enabled) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
             "port %s disabled",pport->portName);
@@ -1577,18 +2189,53 @@ static asynStatus queueRequest(asynUser *pasynUser,
                 return asynDisconnected;
             }
         }
+        pstats = &getQueueStats(pport)[priority];
+        pstats->nRequests++;
+        epicsTimeGetCurrent(&puserPvt->queueTime);
+        /* As in portThread an expired request gets its timeout callback */
+        if(pdeadline && dropExpired
+        && epicsTimeGreaterThan(&puserPvt->queueTime,pdeadline)) {
+            pstats->nExpired++;
+            epicsMutexUnlock(pport->asynManagerLock);
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                "%s deadline missed by %.3f s",pport->portName,
+                epicsTimeDiffInSeconds(&puserPvt->queueTime,pdeadline));
+            epicsMutexMustLock(pport->synchronousLock);
+            puserPvt->timeoutUser(pasynUser);
+            epicsMutexUnlock(pport->synchronousLock);
+            return asynSuccess;
+        }
         epicsMutexUnlock(pport->asynManagerLock);
         epicsMutexMustLock(pport->synchronousLock);
+        epicsTimeGetCurrent(&start);
         puserPvt->processUser(pasynUser);
+        epicsTimeGetCurrent(&end);
+        statRecord(&pstats->wait,epicsTimeDiffInSeconds(&start,&puserPvt->queueTime));
+        statRecord(&pstats->service,epicsTimeDiffInSeconds(&end,&start));
         epicsMutexUnlock(pport->synchronousLock);
         return asynSuccess;
     }
-    if(puserPvt->isQueued) {
+    unlinkCanceled(pport,puserPvt);
+    if(requestIsQueued(puserPvt)) {
         epicsMutexUnlock(pport->asynManagerLock);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager::queueRequest is already queued");
         return asynError;
     }
+    if(priority<asynQueuePriorityConnect
+    && pdpCommon->backoffFailFast
+    && pdpCommon->autoConnect && !pdpCommon->connected
+    && pasynUser->reason!=ASYN_REASON_QUEUE_EVEN_IF_NOT_CONNECTED) {
+        double left = connectBackoffLeft(pdpCommon);
+
+        if(left > 0.0) {
+            epicsMutexUnlock(pport->asynManagerLock);
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                "port %s device %d not connected, next connect attempt in %.3f s",
+                pport->portName,addr,left);
+            return asynDisconnected;
+        }
+    }
     if(timeout>0.0 && !puserPvt->timeoutUser) {
         epicsMutexUnlock(pport->asynManagerLock);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
@@ -1602,6 +2249,9 @@ static asynStatus queueRequest(asynUser *pasynUser,
         if(pdpCommon->pblockProcessHolder
         && pdpCommon->pblockProcessHolder==puserPvt) addToFront = TRUE;
     }
+    puserPvt->hasDeadline = (pdeadline ? TRUE : FALSE);
+    puserPvt->dropExpired = (pdeadline && dropExpired) ? TRUE : FALSE;
+    if(pdeadline) puserPvt->deadline = *pdeadline;
     if(addToFront) {
         asynPrint(pasynUser,ASYN_TRACE_FLOW,
             "%s addr %d queueRequest priority %d from lockHolder\n",
@@ -1611,11 +2261,24 @@ static asynStatus queueRequest(asynUser *pasynUser,
         asynPrint(pasynUser,ASYN_TRACE_FLOW,
             "%s addr %d queueRequest priority %d not lockHolder\n",
             pport->portName,addr,priority);
-        /*Add to end of list*/
-        ellAdd(&pport->queueList[priority],&puserPvt->node);
+        if(pport->queuePolicy==asynQueuePolicyDeadline && puserPvt->hasDeadline
+        && priority<asynQueuePriorityConnect) {
+            queueAddByDeadline(&pport->queueList[priority],puserPvt);
+        } else {
+            /*Add to end of list*/
+            ellAdd(&pport->queueList[priority],&puserPvt->node);
+        }
     }
     pport->queueStateChange = TRUE;
-    puserPvt->isQueued = TRUE;
+    puserPvt->priority = priority;
+    epicsAtomicSetIntT(&puserPvt->queueState,requestQueued);
+    epicsTimeGetCurrent(&puserPvt->queueTime);
+    pstats = &getQueueStats(pport)[priority];
+    pstats->nRequests++;
+    /* so maxDepth does not count canceled requests */
+    pruneCanceled(pport,priority);
+    depth = ellCount(&pport->queueList[priority]);
+    if(depth > pstats->maxDepth) pstats->maxDepth = depth;
     if(timeout<=0.0) {
         puserPvt->timeout = 0.0;
     } else {
@@ -1634,60 +2297,38 @@ static asynStatus cancelRequest(asynUser *pasynUser,int *wasQueued)
     userPvt  *puserPvt = asynUserToUserPvt(pasynUser);
     port     *pport = puserPvt->pport;
     device   *pdevice = puserPvt->pdevice;
-    double   timeout;
     int      addr = (pdevice ? pdevice->addr : -1);
-    int      i;
     *wasQueued = 0; /*Initialize to not removed*/
     if(!pport) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "asynManager:cancelRequest but not connected\n");
         return asynError;
     }
-    epicsMutexMustLock(pport->asynManagerLock);
-    if(!puserPvt->isQueued) {
-        if(puserPvt->state==callbackActive) {
-            asynPrint(pasynUser,ASYN_TRACE_FLOW,
-                "%s addr %d asynManager:cancelRequest wait for callback\n",
-                 pport->portName,addr);
-            puserPvt->state = callbackCanceled;
-            epicsMutexUnlock(pport->asynManagerLock);
-            epicsEventMustWait(puserPvt->callbackDone);
-        } else {
-            epicsMutexUnlock(pport->asynManagerLock);
-            asynPrint(pasynUser,ASYN_TRACE_FLOW,
-                "%s addr %d asynManager:cancelRequest but not queued\n",
-                 pport->portName,addr);
-        }
+    /* A request that is still queued is canceled without asynManagerLock.
+     * It is unlinked from the queue later by the port thread, the timeout
+     * callback, disconnect or the next queueRequest. */
+    if(epicsAtomicCmpAndSwapIntT(&puserPvt->queueState,
+        requestQueued,requestCanceled)==requestQueued) {
+        *wasQueued = 1;
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,
+                 "%s addr %d asynManager:cancelRequest\n",
+                  pport->portName,addr);
         return asynSuccess;
     }
-    for(i=asynQueuePriorityConnect; i>=asynQueuePriorityLow; i--) {
-        puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
-        while(puserPvt) {
-            if(pasynUser == &puserPvt->user) {
-                ellDelete(&pport->queueList[i],&puserPvt->node);
-                *wasQueued = 1;
-                break;
-            }
-            puserPvt = (userPvt *)ellNext(&puserPvt->node);
-        }
-        if(puserPvt) break;
-    }
-    if(!puserPvt) {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,
-            "%s addr %d asynManager:cancelRequest LOGIC ERROR\n",
-            pport->portName, addr);
+    epicsMutexMustLock(pport->asynManagerLock);
+    if(puserPvt->state==callbackActive) {
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,
+            "%s addr %d asynManager:cancelRequest wait for callback\n",
+             pport->portName,addr);
+        puserPvt->state = callbackCanceled;
         epicsMutexUnlock(pport->asynManagerLock);
-        return asynError;
+        epicsEventMustWait(puserPvt->callbackDone);
+    } else {
+        epicsMutexUnlock(pport->asynManagerLock);
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,
+            "%s addr %d asynManager:cancelRequest but not queued\n",
+             pport->portName,addr);
     }
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,
-             "%s addr %d asynManager:cancelRequest\n",
-              pport->portName,addr);
-    puserPvt->isQueued = FALSE;
-    pport->queueStateChange = TRUE;
-    timeout = puserPvt->timeout;
-    epicsMutexUnlock(pport->asynManagerLock);
-    if(puserPvt->timer && timeout>0.0) epicsTimerCancel(puserPvt->timer);
-    epicsEventSignal(pport->notifyPortThread);
     return asynSuccess;
 }
 
@@ -1710,7 +2351,7 @@ static asynStatus blockProcessCallback(asynUser *pasynUser, int allDevices)
         return asynError;
     }
     epicsMutexMustLock(pport->asynManagerLock);
-    if(puserPvt->isQueued) {
+    if(requestIsQueued(puserPvt)) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager::blockProcessCallback is queued");
         epicsMutexUnlock(pport->asynManagerLock);
@@ -1742,7 +2383,7 @@ static asynStatus unblockProcessCallback(asynUser *pasynUser, int allDevices)
         return asynError;
     }
     epicsMutexMustLock(pport->asynManagerLock);
-    if(puserPvt->isQueued) {
+    if(requestIsQueued(puserPvt)) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager::unblockProcessCallback is queued");
         epicsMutexUnlock(pport->asynManagerLock);
@@ -2048,31 +2689,46 @@ static asynStatus registerPort(const char *portName,
     int attributes,int autoConnect,
     unsigned int priority,unsigned int stackSize)
 {
-    port    *pport = locatePort(portName);
+    port    *pport;
+    GPHENTRY *pentry;
     int     i;
     size_t  len;
 
-    if(pport) {
-        printf("asynCommon:registerDriver %s already registered\n",portName);
-        return asynError;
-    }
+    if(!pasynBase) asynInit();
     len = sizeof(port) + strlen(portName) + 1;
-    pport = callocMustSucceed(len,sizeof(char),"asynCommon:registerDriver");
+    pport = callocMustSucceed(len,sizeof(char),"asynManager:registerPort");
     pport->portName = (char *)(pport + 1);
     strcpy(pport->portName,portName);
+    /* Reserve the name, keyed by the copy the port owns, before anything
+     * else is created. locatePort ignores the entry until userPvt is set */
+    epicsMutexMustLock(pasynBase->lock);
+    pentry = gphFind(pasynBase->portHash,portName,NULL);
+    if(!pentry) pentry = gphAdd(pasynBase->portHash,pport->portName,NULL);
+    else pentry = 0;
+    epicsMutexUnlock(pasynBase->lock);
+    if(!pentry) {
+        printf("asynManager:registerPort %s already registered\n",portName);
+        free(pport);
+        return asynError;
+    }
     pport->attributes = attributes;
     pport->asynManagerLock = epicsMutexMustCreate();
     pport->synchronousLock = epicsMutexMustCreate();
+    pport->interruptLock = epicsMutexMustCreate();
     pport->queueLockPortId = epicsThreadPrivateCreate();
     pport->timeStampSource = defaultTimeStampSource;
     dpCommonInit(pport,0,autoConnect);
     pport->pasynUser = createAsynUser(0,0);
     pport->previousConnectStatus = portConnectSuccess;
     pport->queueLockPortTimeout = DEFAULT_QUEUE_LOCK_PORT_TIMEOUT;
+    pport->pplacement = asynThreadPlacementCreate();
     ellInit(&pport->deviceList);
     ellInit(&pport->interfaceList);
     if((attributes&ASYN_CANBLOCK)) {
-        for(i=0; i<NUMBER_QUEUE_PRIORITIES; i++) ellInit(&pport->queueList[i]);
+        for(i=0; i<NUMBER_QUEUE_PRIORITIES; i++) {
+            ellInit(&pport->queueList[i]);
+            pport->rrAddr[i] = -2;
+        }
         pport->notifyPortThread = epicsEventMustCreate(epicsEventEmpty);
         priority = priority ? priority : epicsThreadPriorityMedium;
         stackSize = stackSize ?
@@ -2081,18 +2737,25 @@ static asynStatus registerPort(const char *portName,
         pport->threadid = epicsThreadCreate(portName,priority,stackSize,
              (EPICSTHREADFUNC)portThread,pport);
         if(!pport->threadid){
-            printf("asynCommon:registerDriver %s epicsThreadCreate failed \n",
+            printf("asynManager:registerPort %s epicsThreadCreate failed \n",
                 portName);
             epicsEventDestroy(pport->notifyPortThread);
             freeAsynUser(pport->pasynUser);
             dpCommonFree(&pport->dpc);
+            epicsMutexDestroy(pport->interruptLock);
             epicsMutexDestroy(pport->synchronousLock);
             epicsMutexDestroy(pport->asynManagerLock);
+            epicsThreadPrivateDelete(pport->queueLockPortId);
+            asynThreadPlacementDestroy(pport->pplacement);
+            epicsMutexMustLock(pasynBase->lock);
+            gphDelete(pasynBase->portHash,portName,NULL);
+            epicsMutexUnlock(pasynBase->lock);
             free(pport);
             return asynError;
         }
     }
     epicsMutexMustLock(pasynBase->lock);
+    epicsAtomicSetPtrT(&pentry->userPvt,pport);
     ellAdd(&pasynBase->asynPortList,&pport->node);
     epicsMutexUnlock(pasynBase->lock);
     if (attributes & ASYN_DESTRUCTIBLE) {
@@ -2131,10 +2794,16 @@ static asynStatus registerInterface(const char *portName,
     pinterfaceNode->pasynInterface = pasynInterface;
     epicsMutexUnlock(pport->asynManagerLock);
     if(strcmp(pasynInterface->interfaceType,asynCommonType)==0) {
+        epicsMutexMustLock(pport->asynManagerLock);
+        epicsTimeGetCurrent(&pport->connectStart);
+        pport->connectDuration = -1.0;
+        epicsMutexUnlock(pport->asynManagerLock);
         initPortConnect(pport);
         portConnectTimerCallback(pport);
-        /* Wait for the default time for the port to connect */
-        if (pport->dpc.autoConnect) waitConnect(pport->pconnectUser, pasynBase->autoConnectTimeout);
+        /* Wait for the default time for the port to connect.
+         * With parallel connect waitAllConnected waits for all ports at once */
+        if (pport->dpc.autoConnect && !pasynBase->parallelConnect)
+            waitConnect(pport->pconnectUser, pasynBase->autoConnectTimeout);
     }
     return asynSuccess;
 }
@@ -2158,6 +2827,15 @@ static asynStatus exceptionConnect(asynUser *pasynUser)
     }
     pdpCommon->connected = TRUE;
     ++pdpCommon->numberConnects;
+    epicsMutexMustLock(pport->asynManagerLock);
+    connectTimeRecord(pdpCommon);
+    if(pdpCommon == &pport->dpc && pport->connectDuration < 0) {
+        epicsTimeStamp now;
+
+        epicsTimeGetCurrent(&now);
+        pport->connectDuration = epicsTimeDiffInSeconds(&now, &pport->connectStart);
+    }
+    epicsMutexUnlock(pport->asynManagerLock);
     exceptionOccurred(pasynUser,asynExceptionConnect);
     return asynSuccess;
 }
@@ -2184,6 +2862,7 @@ static asynStatus exceptionDisconnect(asynUser *pasynUser)
         epicsTimerStartDelay(pport->connectTimer,.01);
     }
     epicsTimeGetCurrent(&pdpCommon->lastConnectDisconnect);
+    pdpCommon->disconnectTime = pdpCommon->lastConnectDisconnect;
     exceptionOccurred(pasynUser,asynExceptionConnect);
     return asynSuccess;
 
@@ -2390,6 +3069,404 @@ static asynStatus getAutoConnectTimeout(double *timeout)
     return asynSuccess;
 }
 
+static asynStatus setParallelConnect(int yesNo, double timeout)
+{
+    static int hookRegistered = 0;
+
+    if(!pasynBase) asynInit();
+    epicsMutexMustLock(pasynBase->lock);
+    pasynBase->parallelConnect = yesNo ? TRUE : FALSE;
+    pasynBase->parallelConnectTimeout = timeout;
+    epicsMutexUnlock(pasynBase->lock);
+    if(yesNo && !hookRegistered) {
+        hookRegistered = 1;
+        initHookRegister(parallelConnectHook);
+    }
+    return asynSuccess;
+}
+
+static port *nextPort(port *pport)
+{
+    epicsMutexMustLock(pasynBase->lock);
+    pport = pport ? (port *)ellNext(&pport->node)
+                  : (port *)ellFirst(&pasynBase->asynPortList);
+    epicsMutexUnlock(pasynBase->lock);
+    return pport;
+}
+
+/* Wait for all ports that are connecting, with one timeout for all of them */
+static asynStatus waitAllConnected(double timeout)
+{
+    epicsTimeStamp start, now;
+    port *pport;
+    int nPorts = 0, nConnected = 0;
+
+    if(!pasynBase) asynInit();
+    if(timeout <= 0) timeout = pasynBase->autoConnectTimeout;
+    epicsTimeGetCurrent(&start);
+    for(pport = nextPort(0); pport; pport = nextPort(pport)) {
+        double remaining;
+
+        if(!pport->pcommonInterface || !pport->dpc.autoConnect
+        || pport->dpc.defunct) continue;
+        epicsTimeGetCurrent(&now);
+        remaining = timeout - epicsTimeDiffInSeconds(&now, &start);
+        if(remaining < 0) remaining = 0;
+        nPorts++;
+        if(waitConnect(pport->pconnectUser, remaining) == asynSuccess)
+            nConnected++;
+    }
+    epicsTimeGetCurrent(&now);
+    printf("asynManager: %d of %d ports connected after waiting %.3f s\n",
+        nConnected, nPorts, epicsTimeDiffInSeconds(&now, &start));
+    if(nConnected == nPorts) return asynSuccess;
+    for(pport = nextPort(0); pport; pport = nextPort(pport)) {
+        if(pport->pcommonInterface && pport->dpc.autoConnect &&
+           !pport->dpc.defunct && !pport->dpc.connected)
+            printf("    %s not connected\n", pport->portName);
+    }
+    return asynError;
+}
+
+static void connectReport(FILE *fp)
+{
+    port *pport;
+
+    if(!pasynBase) asynInit();
+    for(pport = nextPort(0); pport; pport = nextPort(pport)) {
+        epicsTimeStamp now;
+        double duration;
+        BOOL connected;
+
+        if(!pport->pcommonInterface) continue;
+        epicsMutexMustLock(pport->asynManagerLock);
+        duration = pport->connectDuration;
+        connected = pport->dpc.connected;
+        epicsMutexUnlock(pport->asynManagerLock);
+        if(duration >= 0) {
+            fprintf(fp, "%s connected after %.3f s%s\n", pport->portName,
+                duration, connected ? "" : ", now disconnected");
+        } else {
+            epicsTimeGetCurrent(&now);
+            fprintf(fp, "%s not connected after %.3f s%s\n", pport->portName,
+                epicsTimeDiffInSeconds(&now, &pport->connectStart),
+                pport->dpc.autoConnect ? "" : ", autoConnect is off");
+        }
+    }
+}
+
+static void setBackoff(dpCommon *pdpCommon,
+    double minDelay, double maxDelay, double jitter, int failFast)
+{
+    pdpCommon->backoffEnabled = TRUE;
+    pdpCommon->backoffMin = minDelay;
+    pdpCommon->backoffMax = maxDelay;
+    pdpCommon->backoffJitter = jitter;
+    pdpCommon->backoffFailFast = failFast ? TRUE : FALSE;
+    if(pdpCommon->backoffDelay > maxDelay) pdpCommon->backoffDelay = maxDelay;
+}
+
+/* With addr -1 the settings apply to the port and all of its devices */
+static asynStatus setConnectBackoff(asynUser *pasynUser,
+    double minDelay, double maxDelay, double jitter, int failFast)
+{
+    userPvt  *puserPvt = asynUserToUserPvt(pasynUser);
+    port     *pport = puserPvt->pport;
+    dpCommon *pdpCommon = findDpCommon(puserPvt);
+
+    if(!pport || !pdpCommon) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setConnectBackoff not connected");
+        return asynError;
+    }
+    if(minDelay < 0.0 || maxDelay < minDelay || jitter < 0.0 || jitter > 1.0) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setConnectBackoff need 0 <= minDelay <= maxDelay and 0 <= jitter <= 1");
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    setBackoff(pdpCommon,minDelay,maxDelay,jitter,failFast);
+    if(pdpCommon == &pport->dpc) {
+        device *pdevice;
+
+        for(pdevice = (device *)ellFirst(&pport->deviceList); pdevice;
+            pdevice = (device *)ellNext(&pdevice->node))
+            setBackoff(&pdevice->dpc,minDelay,maxDelay,jitter,failFast);
+    }
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+static asynStatus setQueuePolicy(asynUser *pasynUser, asynQueuePolicy policy)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueuePolicy not connected");
+        return asynError;
+    }
+    if(policy!=asynQueuePolicyFifo && policy!=asynQueuePolicyRoundRobin
+    && policy!=asynQueuePolicyDeadline) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueuePolicy illegal policy %d",policy);
+        return asynError;
+    }
+    if(policy==asynQueuePolicyDeadline && !(pport->attributes&ASYN_CANBLOCK)) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueuePolicy port %s can not block",pport->portName);
+        return asynError;
+    }
+    if(policy==asynQueuePolicyRoundRobin
+    && (!(pport->attributes&ASYN_MULTIDEVICE) || !(pport->attributes&ASYN_CANBLOCK))) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueuePolicy port %s is not a multiDevice port that can block",
+            pport->portName);
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    pport->queuePolicy = policy;
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+static asynStatus setQueueWeight(asynUser *pasynUser, int weight)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+    device  *pdevice = puserPvt->pdevice;
+
+    if(!pport || !pdevice) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueueWeight not connected to a device");
+        return asynError;
+    }
+    if(weight < 1) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setQueueWeight weight must be at least 1");
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    pdevice->queueWeight = weight;
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+/* synchronousLock is taken first, as by a driver that calls asynManager
+ * while it holds synchronousLock */
+static void lockQueueStats(port *pport)
+{
+    if(!(pport->attributes&ASYN_CANBLOCK))
+        epicsMutexMustLock(pport->synchronousLock);
+    epicsMutexMustLock(pport->asynManagerLock);
+}
+
+static void unlockQueueStats(port *pport)
+{
+    epicsMutexUnlock(pport->asynManagerLock);
+    if(!(pport->attributes&ASYN_CANBLOCK))
+        epicsMutexUnlock(pport->synchronousLock);
+}
+
+/*fillQueueStatistics must be called between lockQueueStats and unlockQueueStats*/
+static void fillQueueStatistics(port *pport,int priority,
+    asynQueueStatistics *pstats)
+{
+    queueStats *pqueueStats;
+
+    memset(pstats,0,sizeof(*pstats));
+    pstats->depth = queuedCount(pport,priority);
+    if(!pport->pqueueStats) return;
+    pqueueStats = &pport->pqueueStats[priority];
+    pstats->nRequests = pqueueStats->nRequests;
+    pstats->nTimeouts = pqueueStats->nTimeouts;
+    pstats->nExpired = pqueueStats->nExpired;
+    pstats->maxDepth = pqueueStats->maxDepth;
+    if(pqueueStats->wait.count) {
+        pstats->waitMean = pqueueStats->wait.sum/pqueueStats->wait.count;
+        pstats->waitP50 = statPercentile(&pqueueStats->wait,.5);
+        pstats->waitP90 = statPercentile(&pqueueStats->wait,.9);
+        pstats->waitP99 = statPercentile(&pqueueStats->wait,.99);
+        pstats->waitMax = pqueueStats->wait.max;
+    }
+    if(pqueueStats->service.count) {
+        pstats->serviceMean = pqueueStats->service.sum/pqueueStats->service.count;
+        pstats->serviceP50 = statPercentile(&pqueueStats->service,.5);
+        pstats->serviceP90 = statPercentile(&pqueueStats->service,.9);
+        pstats->serviceP99 = statPercentile(&pqueueStats->service,.99);
+        pstats->serviceMax = pqueueStats->service.max;
+    }
+}
+
+static asynStatus getQueueStatistics(asynUser *pasynUser,
+    asynQueuePriority priority, asynQueueStatistics *pstats)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:getQueueStatistics not connected");
+        return asynError;
+    }
+    if(priority<asynQueuePriorityLow || priority>asynQueuePriorityConnect) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:getQueueStatistics illegal priority %d",priority);
+        return asynError;
+    }
+    lockQueueStats(pport);
+    fillQueueStatistics(pport,priority,pstats);
+    unlockQueueStats(pport);
+    return asynSuccess;
+}
+
+static asynStatus resetQueueStatistics(asynUser *pasynUser)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:resetQueueStatistics not connected");
+        return asynError;
+    }
+    lockQueueStats(pport);
+    if(pport->pqueueStats)
+        memset(pport->pqueueStats,0,NUMBER_QUEUE_PRIORITIES*sizeof(queueStats));
+    memset(&pport->managerLockStats,0,sizeof(lockStats));
+    unlockQueueStats(pport);
+    epicsMutexMustLock(pport->interruptLock);
+    memset(&pport->interruptLockStats,0,sizeof(lockStats));
+    epicsMutexUnlock(pport->interruptLock);
+    return asynSuccess;
+}
+
+static void lockStatsReport(FILE *fp, port *pport)
+{
+    lockStats manager, interrupt;
+
+    epicsMutexMustLock(pport->asynManagerLock);
+    manager = pport->managerLockStats;
+    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexMustLock(pport->interruptLock);
+    interrupt = pport->interruptLockStats;
+    epicsMutexUnlock(pport->interruptLock);
+    if(manager.nLocks==0 && interrupt.nLocks==0) return;
+    fprintf(fp,"    locks   asynManager %lu contended %lu, interrupt %lu contended %lu\n",
+        manager.nLocks, manager.nContended, interrupt.nLocks, interrupt.nContended);
+}
+
+static void queueStatisticsReport(FILE *fp, const char *portName)
+{
+    static const char *priorityName[NUMBER_QUEUE_PRIORITIES] = {
+        "low", "medium", "high", "connect"};
+    port *pport;
+    int i;
+
+    if(!pasynBase) asynInit();
+    for(pport = nextPort(0); pport; pport = nextPort(pport)) {
+        if(portName && *portName && strcmp(portName,pport->portName)!=0) continue;
+        if(!pport->pqueueStats) {
+            if(portName && *portName) {
+                fprintf(fp,"%s no requests queued\n",pport->portName);
+                lockStatsReport(fp,pport);
+            }
+            continue;
+        }
+        fprintf(fp,"%s\n",pport->portName);
+        lockStatsReport(fp,pport);
+        for(i=asynQueuePriorityLow; i<=asynQueuePriorityConnect; i++) {
+            asynQueueStatistics stats;
+
+            lockQueueStats(pport);
+            fillQueueStatistics(pport,i,&stats);
+            unlockQueueStats(pport);
+            if(stats.nRequests == 0) continue;
+            fprintf(fp,"    %-7s requests %lu timeouts %lu expired %lu depth %lu maxDepth %lu\n",
+                priorityName[i], stats.nRequests, stats.nTimeouts, stats.nExpired,
+                stats.depth, stats.maxDepth);
+            fprintf(fp,"        wait    mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f ms\n",
+                stats.waitMean*1e3, stats.waitP50*1e3, stats.waitP90*1e3,
+                stats.waitP99*1e3, stats.waitMax*1e3);
+            fprintf(fp,"        service mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f ms\n",
+                stats.serviceMean*1e3, stats.serviceP50*1e3, stats.serviceP90*1e3,
+                stats.serviceP99*1e3, stats.serviceMax*1e3);
+        }
+    }
+}
+
+static asynStatus setThreadAffinity(asynUser *pasynUser, const char *cpuList)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setThreadAffinity not connected");
+        return asynError;
+    }
+    return asynThreadPlacementSetAffinity(pport->pplacement,pport->portName,
+        cpuList,pasynUser);
+}
+
+static asynStatus setThreadScheduler(asynUser *pasynUser,
+    const char *policy, int priority)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setThreadScheduler not connected");
+        return asynError;
+    }
+    return asynThreadPlacementSetScheduler(pport->pplacement,pport->portName,
+        policy,priority,pasynUser);
+}
+
+static asynStatus placeThread(asynUser *pasynUser)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+    int     status;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:placeThread not connected");
+        return asynError;
+    }
+    status = asynThreadPlacementApply(pport->pplacement);
+    if(status) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "%s placeThread %s",pport->portName,strerror(status));
+        return asynError;
+    }
+    return asynSuccess;
+}
+
+static void threadReport(FILE *fp, const char *portName)
+{
+    port *pport;
+
+    if(!pasynBase) asynInit();
+    for(pport = nextPort(0); pport; pport = nextPort(pport)) {
+        if(portName && *portName && strcmp(portName,pport->portName)!=0) continue;
+        if(!pport->threadid) {
+            if(portName && *portName)
+                fprintf(fp,"%s has no port thread\n",pport->portName);
+            continue;
+        }
+        asynThreadPlacementReport(pport->pplacement,fp,pport->portName,pport->threadid);
+    }
+}
+
+static void parallelConnectHook(initHookState state)
+{
+    if(state != initHookAtBeginning || !pasynBase->parallelConnect) return;
+    waitAllConnected(pasynBase->parallelConnectTimeout);
+}
+
 static asynStatus setQueueLockPortTimeout(asynUser *pasynUser, double timeout)
 {
     userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
@@ -2535,14 +3612,14 @@ static asynStatus freeInterruptNode(asynUser *pasynUser,interruptNode *pinterrup
     interruptBase    *pinterruptBase = pinterruptNodePvt->pinterruptBase;
     port             *pport = pinterruptBase->pport;
 
-    epicsMutexMustLock(pport->asynManagerLock);
+    lockCounted(pport->interruptLock,&pport->interruptLockStats);
     if(pinterruptNodePvt->isOnList) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
             "freeInterruptNode requested but it is on a list");
         return asynError;
     }
-    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->interruptLock);
     epicsMutexMustLock(pasynBase->lock);
     ellAdd(&pasynBase->interruptNodeFree,&pinterruptNode->node);
     epicsMutexUnlock(pasynBase->lock);
@@ -2556,24 +3633,24 @@ static asynStatus addInterruptUser(asynUser *pasynUser,
     interruptBase    *pinterruptBase = pinterruptNodePvt->pinterruptBase;
     port             *pport = pinterruptBase->pport;
 
-    epicsMutexMustLock(pport->asynManagerLock);
+    lockCounted(pport->interruptLock,&pport->interruptLockStats);
 
     if (pport->dpc.defunct) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager:assInterruptUser: port shut down");
         return asynDisabled;
     }
 
     if(pinterruptNodePvt->isOnList) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
             "asynManager:addInterruptUser already on list");
         return asynError;
     }
     while(pinterruptBase->callbackActive) {
         if(pinterruptNodePvt->isOnAddRemoveList) {
-            epicsMutexUnlock(pport->asynManagerLock);
+            epicsMutexUnlock(pport->interruptLock);
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                 "asynManager:addInterruptUser already on addRemove list");
             return asynError;
@@ -2581,13 +3658,13 @@ static asynStatus addInterruptUser(asynUser *pasynUser,
         ellAdd(&pinterruptBase->addRemoveList,&pinterruptNodePvt->addRemoveNode);
         pinterruptNodePvt->isOnAddRemoveList = TRUE;
         pinterruptBase->listModified = TRUE;
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsEventMustWait(pinterruptNodePvt->callbackDone);
-        epicsMutexMustLock(pport->asynManagerLock);
+        lockCounted(pport->interruptLock,&pport->interruptLockStats);
     }
     ellAdd(&pinterruptBase->callbackList,&pinterruptNode->node);
     pinterruptNodePvt->isOnList = TRUE;
-    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->interruptLock);
     return asynSuccess;
 }
 
@@ -2598,24 +3675,24 @@ static asynStatus removeInterruptUser(asynUser *pasynUser,
     interruptBase    *pinterruptBase = pinterruptNodePvt->pinterruptBase;
     port             *pport = pinterruptBase->pport;
 
-    epicsMutexMustLock(pport->asynManagerLock);
+    lockCounted(pport->interruptLock,&pport->interruptLockStats);
 
     if (pport->dpc.defunct) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                 "asynManager:removeInterruptUser: port shut down");
         return asynDisabled;
     }
 
     if(!pinterruptNodePvt->isOnList) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
             "asynManager:removeInterruptUser not on list");
         return asynError;
     }
     while(pinterruptBase->callbackActive) {
         if(pinterruptNodePvt->isOnAddRemoveList) {
-            epicsMutexUnlock(pport->asynManagerLock);
+            epicsMutexUnlock(pport->interruptLock);
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                 "asynManager:removeInterruptUser already on addRemove list");
             return asynError;
@@ -2623,25 +3700,28 @@ static asynStatus removeInterruptUser(asynUser *pasynUser,
         ellAdd(&pinterruptBase->addRemoveList,&pinterruptNodePvt->addRemoveNode);
         pinterruptNodePvt->isOnAddRemoveList = TRUE;
         pinterruptBase->listModified = TRUE;
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         epicsEventMustWait(pinterruptNodePvt->callbackDone);
-        epicsMutexMustLock(pport->asynManagerLock);
+        lockCounted(pport->interruptLock,&pport->interruptLockStats);
     }
     ellDelete(&pinterruptBase->callbackList,&pinterruptNode->node);
     pinterruptNodePvt->isOnList = FALSE;
-    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->interruptLock);
     return asynSuccess;
 }
 
+/* interruptStart and interruptEnd only take interruptLock, so callbacks do
+ * not wait for queueRequest or the port thread. shutdownPort sets
+ * dpc.defunct with asynManagerLock, add/removeInterruptUser only read it. */
 static asynStatus interruptStart(void *pasynPvt,ELLLIST **plist)
 {
     interruptBase  *pinterruptBase = (interruptBase *)pasynPvt;
     port *pport = pinterruptBase->pport;
 
-    epicsMutexMustLock(pport->asynManagerLock);
+    lockCounted(pport->interruptLock,&pport->interruptLockStats);
     pinterruptBase->callbackActive = TRUE;
     pinterruptBase->listModified = FALSE;
-    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->interruptLock);
     *plist = (&pinterruptBase->callbackList);
     return asynSuccess;
 }
@@ -2652,10 +3732,10 @@ static asynStatus interruptEnd(void *pasynPvt)
     port *pport = pinterruptBase->pport;
     interruptNodePvt *pinterruptNodePvt;
 
-    epicsMutexMustLock(pport->asynManagerLock);
+    lockCounted(pport->interruptLock,&pport->interruptLockStats);
     pinterruptBase->callbackActive = FALSE;
     if(!pinterruptBase->listModified) {
-        epicsMutexUnlock(pport->asynManagerLock);
+        epicsMutexUnlock(pport->interruptLock);
         return asynSuccess;
     }
     while((pinterruptNodePvt = (interruptNodePvt *)ellFirst(
@@ -2666,7 +3746,7 @@ static asynStatus interruptEnd(void *pasynPvt)
         pinterruptNodePvt->isOnAddRemoveList = FALSE;
         epicsEventSignal(pinterruptNodePvt->callbackDone);
     }
-    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->interruptLock);
     return asynSuccess;
 }
 
@@ -3277,7 +4357,6 @@ static void initPortConnect(port *pport)
     pport->connectTimer = epicsTimerQueueCreateTimer(
         pasynBase->connectPortTimerQueue,
         portConnectTimerCallback, pport);
-    pport->secondsBetweenPortConnect = DEFAULT_SECONDS_BETWEEN_PORT_CONNECT;
 }
 
 static void portConnectTimerCallback(void *pvt)
@@ -3305,11 +4384,19 @@ static void portConnectProcessCallback(asynUser *pasynUser)
     asynCommon *pasynCommon = (asynCommon *)pasynInterface->pinterface;
     void *drvPvt = pasynInterface->drvPvt;
     int isConnected;
+    double delay;
     /* We were not connected when the request was queued, but we could have connected since then */
     status = pasynManager->isConnected(pasynUser, &isConnected);
-    if (!isConnected) status = pasynCommon->connect(drvPvt,pasynUser);
+    if (isConnected) return;
+    status = pasynCommon->connect(drvPvt,pasynUser);
+    epicsMutexMustLock(pport->asynManagerLock);
+    epicsTimeGetCurrent(&pport->dpc.lastConnectDisconnect);
+    connectAttemptDone(&pport->dpc, status==asynSuccess && pport->dpc.connected);
+    delay = pport->dpc.backoffEnabled ?
+        connectBackoffLeft(&pport->dpc) : DEFAULT_SECONDS_BETWEEN_PORT_CONNECT;
+    epicsMutexUnlock(pport->asynManagerLock);
     if(status!=asynSuccess) {
-        epicsTimerStartDelay(pport->connectTimer,pport->secondsBetweenPortConnect);
+        epicsTimerStartDelay(pport->connectTimer,delay);
     }
 }
 static void waitConnectExceptionHandler(asynUser *pasynUser, asynException exception)
@@ -0,0 +1,51 @@
+/* asynThreadPlacement.h */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/* CPU affinity and scheduling policy of a port thread and of the driver
+ * threads that call placeThread. Used only by asynManager.
+ * os/Linux implements it with pthreads, os/default reports that it is
+ * not supported.
+ */
+
+#ifndef INCasynThreadPlacementh
+#define INCasynThreadPlacementh
+
+#include <stdio.h>
+
+#include <epicsThread.h>
+
+#include "asynDriver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct asynThreadPlacement asynThreadPlacement;
+
+asynThreadPlacement *asynThreadPlacementCreate(void);
+void asynThreadPlacementDestroy(asynThreadPlacement *pplacement);
+/* Called by the port thread itself. It becomes the thread that later
+ * settings apply to, and gets what was requested so far.
+ * Returns 0 or an errno value */
+int asynThreadPlacementAttach(asynThreadPlacement *pplacement);
+/* Apply the settings to the calling thread. Returns 0 or an errno value */
+int asynThreadPlacementApply(asynThreadPlacement *pplacement);
+/* These set errorMessage on failure. A null or empty cpuList means all CPUs */
+asynStatus asynThreadPlacementSetAffinity(asynThreadPlacement *pplacement,
+    const char *portName, const char *cpuList, asynUser *pasynUser);
+asynStatus asynThreadPlacementSetScheduler(asynThreadPlacement *pplacement,
+    const char *portName, const char *policy, int priority, asynUser *pasynUser);
+void asynThreadPlacementReport(asynThreadPlacement *pplacement, FILE *fp,
+    const char *portName, epicsThreadId threadid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCasynThreadPlacementh */
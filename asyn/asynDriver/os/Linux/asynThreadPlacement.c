@@ -0,0 +1,292 @@
+/* asynThreadPlacement.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/* CPU affinity and scheduling policy with pthreads */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for pthread_setaffinity_np */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <cantProceed.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <epicsThread.h>
+
+#include "asynThreadPlacement.h"
+
+struct asynThreadPlacement {
+    epicsMutexId  lock;
+    char          *cpuList;     /* as given to setThreadAffinity, 0 for all */
+    int           policy;       /* -1 until setThreadScheduler is called */
+    int           priority;
+    cpu_set_t     cpuSet;
+    pthread_t     thread;       /* the port thread */
+    pid_t         tid;          /* its kernel thread id, 0 until it runs */
+};
+
+/* cpuList is e.g. "2,3,8-11" */
+static int parseCpuList(const char *cpuList,cpu_set_t *pcpuSet)
+{
+    const char *p = cpuList;
+
+    CPU_ZERO(pcpuSet);
+    while(*p) {
+        char *end;
+        long first, last;
+
+        while(isspace((int)*p)) p++;
+        first = last = strtol(p,&end,10);
+        if(end==p) return -1;
+        p = end;
+        if(*p=='-') {
+            p++;
+            last = strtol(p,&end,10);
+            if(end==p) return -1;
+            p = end;
+        }
+        if(first<0 || last<first || last>=CPU_SETSIZE) return -1;
+        for(; first<=last; first++) CPU_SET((int)first,pcpuSet);
+        while(isspace((int)*p)) p++;
+        if(*p==',') p++;
+        else if(*p) return -1;
+    }
+    return 0;
+}
+
+static void formatCpuSet(const cpu_set_t *pcpuSet,char *buf,size_t size)
+{
+    size_t len = 0;
+    int first, last;
+
+    buf[0] = 0;
+    for(first=0; first<CPU_SETSIZE && len<size; first++) {
+        if(!CPU_ISSET(first,pcpuSet)) continue;
+        for(last=first; last+1<CPU_SETSIZE && CPU_ISSET(last+1,pcpuSet); last++) ;
+        if(last==first)
+            len += epicsSnprintf(buf+len,size-len,"%s%d",len ? "," : "",first);
+        else
+            len += epicsSnprintf(buf+len,size-len,"%s%d-%d",len ? "," : "",first,last);
+        first = last;
+    }
+}
+
+static const char *schedPolicyName(int policy)
+{
+    switch(policy) {
+    case SCHED_OTHER: return "other";
+    case SCHED_FIFO:  return "fifo";
+    case SCHED_RR:    return "rr";
+    default:          return "unknown";
+    }
+}
+
+/* The CPU the thread last ran on, from /proc/self/task/<tid>/stat */
+static int lastCpu(pid_t tid)
+{
+    char name[64], buf[1024];
+    const char *p;
+    FILE *fp;
+    size_t n;
+    int field, cpu = -1;
+
+    epicsSnprintf(name,sizeof(name),"/proc/self/task/%d/stat",(int)tid);
+    fp = fopen(name,"r");
+    if(!fp) return -1;
+    n = fread(buf,1,sizeof(buf)-1,fp);
+    fclose(fp);
+    buf[n] = 0;
+    /* The thread name may contain spaces; fields are counted after it */
+    p = strrchr(buf,')');
+    if(!p) return -1;
+    /* p is at the end of field 2; the processor is field 39 */
+    for(field=2; field<39 && p; field++) p = strchr(p+1,' ');
+    if(p) cpu = atoi(p+1);
+    return cpu;
+}
+
+/*applyPlacement must be called with lock held, returns 0 or an errno value*/
+static int applyPlacement(pthread_t thread,const asynThreadPlacement *pplacement)
+{
+    int status;
+
+    if(pplacement->cpuList) {
+        status = pthread_setaffinity_np(thread,sizeof(cpu_set_t),&pplacement->cpuSet);
+        if(status) return status;
+    }
+    if(pplacement->policy>=0) {
+        struct sched_param param;
+
+        memset(&param,0,sizeof(param));
+        param.sched_priority = pplacement->priority;
+        status = pthread_setschedparam(thread,pplacement->policy,&param);
+        if(status) return status;
+    }
+    return 0;
+}
+
+asynThreadPlacement *asynThreadPlacementCreate(void)
+{
+    asynThreadPlacement *pplacement = callocMustSucceed(1,
+        sizeof(asynThreadPlacement),"asynThreadPlacementCreate");
+
+    pplacement->lock = epicsMutexMustCreate();
+    pplacement->policy = -1;
+    return pplacement;
+}
+
+void asynThreadPlacementDestroy(asynThreadPlacement *pplacement)
+{
+    epicsMutexDestroy(pplacement->lock);
+    free(pplacement->cpuList);
+    free(pplacement);
+}
+
+int asynThreadPlacementAttach(asynThreadPlacement *pplacement)
+{
+    int status;
+
+    epicsMutexMustLock(pplacement->lock);
+    pplacement->thread = pthread_self();
+    pplacement->tid = (pid_t)syscall(SYS_gettid);
+    /* setThreadAffinity or setThreadScheduler may have been called already */
+    status = applyPlacement(pthread_self(),pplacement);
+    epicsMutexUnlock(pplacement->lock);
+    return status;
+}
+
+int asynThreadPlacementApply(asynThreadPlacement *pplacement)
+{
+    int status;
+
+    epicsMutexMustLock(pplacement->lock);
+    status = applyPlacement(pthread_self(),pplacement);
+    epicsMutexUnlock(pplacement->lock);
+    return status;
+}
+
+asynStatus asynThreadPlacementSetAffinity(asynThreadPlacement *pplacement,
+    const char *portName, const char *cpuList, asynUser *pasynUser)
+{
+    int       all = (!cpuList || !*cpuList);
+    cpu_set_t cpuSet;
+    int       i, status = 0;
+
+    if(all) {
+        CPU_ZERO(&cpuSet);
+        for(i=0; i<CPU_SETSIZE; i++) CPU_SET(i,&cpuSet);
+    } else if(parseCpuList(cpuList,&cpuSet)) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setThreadAffinity illegal CPU list \"%s\"",cpuList);
+        return asynError;
+    }
+    epicsMutexMustLock(pplacement->lock);
+    free(pplacement->cpuList);
+    pplacement->cpuList = all ? 0 : epicsStrDup(cpuList);
+    pplacement->cpuSet = cpuSet;
+    if(pplacement->tid)
+        status = pthread_setaffinity_np(pplacement->thread,sizeof(cpuSet),&cpuSet);
+    epicsMutexUnlock(pplacement->lock);
+    if(status) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "%s setThreadAffinity %s",portName,strerror(status));
+        return asynError;
+    }
+    return asynSuccess;
+}
+
+asynStatus asynThreadPlacementSetScheduler(asynThreadPlacement *pplacement,
+    const char *portName, const char *policy, int priority, asynUser *pasynUser)
+{
+    int schedPolicy;
+    int status = 0;
+
+    if(policy && epicsStrCaseCmp(policy,"other")==0) {
+        schedPolicy = SCHED_OTHER;
+        priority = 0;
+    } else if(policy && epicsStrCaseCmp(policy,"fifo")==0) {
+        schedPolicy = SCHED_FIFO;
+    } else if(policy && epicsStrCaseCmp(policy,"rr")==0) {
+        schedPolicy = SCHED_RR;
+    } else {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setThreadScheduler policy must be other, fifo or rr");
+        return asynError;
+    }
+    if(priority<sched_get_priority_min(schedPolicy)
+    || priority>sched_get_priority_max(schedPolicy)) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setThreadScheduler priority %d out of range %d to %d",
+            priority,sched_get_priority_min(schedPolicy),
+            sched_get_priority_max(schedPolicy));
+        return asynError;
+    }
+    epicsMutexMustLock(pplacement->lock);
+    pplacement->policy = schedPolicy;
+    pplacement->priority = priority;
+    if(pplacement->tid) {
+        struct sched_param param;
+
+        memset(&param,0,sizeof(param));
+        param.sched_priority = priority;
+        status = pthread_setschedparam(pplacement->thread,schedPolicy,&param);
+    }
+    epicsMutexUnlock(pplacement->lock);
+    if(status) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "%s setThreadScheduler %s",portName,strerror(status));
+        return asynError;
+    }
+    return asynSuccess;
+}
+
+void asynThreadPlacementReport(asynThreadPlacement *pplacement, FILE *fp,
+    const char *portName, epicsThreadId threadid)
+{
+    cpu_set_t cpuSet;
+    struct sched_param param;
+    int policy = -1;
+    char cpus[256];
+    pid_t tid;
+
+    CPU_ZERO(&cpuSet);
+    memset(&param,0,sizeof(param));
+    epicsMutexMustLock(pplacement->lock);
+    tid = pplacement->tid;
+    if(tid) {
+        pthread_getaffinity_np(pplacement->thread,sizeof(cpuSet),&cpuSet);
+        pthread_getschedparam(pplacement->thread,&policy,&param);
+    }
+    epicsMutexUnlock(pplacement->lock);
+    if(!tid) {
+        fprintf(fp,"%s port thread not started\n",portName);
+        return;
+    }
+    formatCpuSet(&cpuSet,cpus,sizeof(cpus));
+    fprintf(fp,"%s tid %d cpus %s policy %s priority %d last cpu %d\n",
+        portName,(int)tid,cpus,schedPolicyName(policy),
+        param.sched_priority,lastCpu(tid));
+    epicsMutexMustLock(pplacement->lock);
+    if(pplacement->cpuList || pplacement->policy>=0) {
+        fprintf(fp,"    requested cpus %s policy %s priority %d\n",
+            pplacement->cpuList ? pplacement->cpuList : "all",
+            pplacement->policy>=0 ? schedPolicyName(pplacement->policy) : "default",
+            pplacement->priority);
+    }
+    epicsMutexUnlock(pplacement->lock);
+}
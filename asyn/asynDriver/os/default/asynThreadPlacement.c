@@ -0,0 +1,67 @@
+/* asynThreadPlacement.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/* CPU affinity and scheduling policy are not supported on this OS.
+ * The port thread keeps the EPICS priority it was created with. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cantProceed.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
+
+#include "asynThreadPlacement.h"
+
+struct asynThreadPlacement {
+    int unused;
+};
+
+asynThreadPlacement *asynThreadPlacementCreate(void)
+{
+    return callocMustSucceed(1,sizeof(asynThreadPlacement),
+        "asynThreadPlacementCreate");
+}
+
+void asynThreadPlacementDestroy(asynThreadPlacement *pplacement)
+{
+    free(pplacement);
+}
+
+int asynThreadPlacementAttach(asynThreadPlacement *pplacement)
+{
+    return 0;
+}
+
+int asynThreadPlacementApply(asynThreadPlacement *pplacement)
+{
+    return 0;
+}
+
+asynStatus asynThreadPlacementSetAffinity(asynThreadPlacement *pplacement,
+    const char *portName, const char *cpuList, asynUser *pasynUser)
+{
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+        "asynManager:setThreadAffinity not supported on this OS");
+    return asynError;
+}
+
+asynStatus asynThreadPlacementSetScheduler(asynThreadPlacement *pplacement,
+    const char *portName, const char *policy, int priority, asynUser *pasynUser)
+{
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+        "asynManager:setThreadScheduler not supported on this OS");
+    return asynError;
+}
+
+void asynThreadPlacementReport(asynThreadPlacement *pplacement, FILE *fp,
+    const char *portName, epicsThreadId threadid)
+{
+    fprintf(fp,"%s epics priority %u\n",portName,epicsThreadGetPriority(threadid));
+}
@@ -38,6 +38,17 @@
 #endif
 #define SRQTIMEOUT .01
 #define MAX_POLL 5
+#define NUM_POLL_NODES (NUM_GPIB_ADDRESSES*(NUM_GPIB_ADDRESSES+1))
+#define NUM_LATENCY_BINS 10
+
+/*Upper limits of the SRQ latency histogram bins. The last bin has no limit*/
+static const double latencyLimit[NUM_LATENCY_BINS-1] = {
+    1e-4, 3e-4, 1e-3, 3e-3, 1e-2, 3e-2, 1e-1, 3e-1, 1.0
+};
+static const char *latencyName[NUM_LATENCY_BINS] = {
+    "<100us", "<300us", "<1ms", "<3ms", "<10ms",
+    "<30ms", "<100ms", "<300ms", "<1s", ">=1s"
+};
 
 typedef struct gpibBase {
     ELLLIST gpibPvtList;
@@ -45,12 +56,22 @@ typedef struct gpibBase {
 }gpibBase;
 static gpibBase *pgpibBase = 0;
 
+typedef struct srqStats {
+    unsigned long nPolls;
+    unsigned long nSrqs;
+    double        sumLatency;
+    double        maxLatency;
+    unsigned long latency[NUM_LATENCY_BINS];
+}srqStats;
+
 typedef struct pollNode {
     int                    pollIt;
     int                    statusByte;
+    int                    addr;
     asynUser               *pasynUser;
     asynCommon             *pasynCommon;
     void                   *drvPvt;
+    srqStats               *pstats; /*allocated by first pollAddr on*/
 }pollNode;
 
 typedef struct pollListPrimary {
@@ -65,7 +86,15 @@ typedef struct gpibPvt {
     epicsMutexId lock;
     int         attributes;
     pollListPrimary pollList[NUM_GPIB_ADDRESSES];
+    /*Polled addresses, most recent SRQ first. pollSweep is srqPoll's copy*/
+    pollNode    *pollOrder[NUM_POLL_NODES];
+    pollNode    *pollSweep[NUM_POLL_NODES];
+    int         nPollOrder;
     int pollRequestIsQueued;
+    epicsTimeStamp srqTime;
+    unsigned long nSrqPolls;
+    unsigned long nSerialPolls;
+    unsigned long nEarlyStops;
     asynGpibPort *pasynGpibPort;
     void *asynGpibPortPvt;
     asynUser *pasynUser;
@@ -92,9 +121,13 @@ static gpibPvt *locateGpibPvt(const char *portName);
 static asynStatus getAddr(gpibPvt *pgpibPvt,asynUser *pasynUser,
            int *addr, int *primary,int *secondary, BOOL *isPrimary);
 static void exceptionHandler(asynUser *pasynUser,asynException exception);
-static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
-    asynGpibPort *pasynGpibPort,pollNode *ppollNode,int addr);
+static void pollOrderRemove(gpibPvt *pgpibPvt,pollNode *ppollNode);
+static void pollOrderFront(gpibPvt *pgpibPvt,pollNode *ppollNode);
+static int pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
+    asynGpibPort *pasynGpibPort,pollNode *ppollNode,
+    const epicsTimeStamp *srqTime);
 static void srqPoll(asynUser *pasynUser);
+static void srqReport(gpibPvt *pgpibPvt,FILE *fd,int details);
 /*asynCommon methods */
 static void report(void *drvPvt,FILE *fd,int details);
 static asynStatus connect(void *drvPvt,asynUser *pasynUser);
@@ -213,13 +246,44 @@ static void exceptionHandler(asynUser *pasynUser,asynException exception)
     }
 }
 
+/* Called with pgpibPvt->lock held */
+static void pollOrderRemove(gpibPvt *pgpibPvt,pollNode *ppollNode)
+{
+    int i;
+
+    for(i=0; i<pgpibPvt->nPollOrder; i++) {
+        if(pgpibPvt->pollOrder[i]!=ppollNode) continue;
+        pgpibPvt->nPollOrder--;
+        memmove(&pgpibPvt->pollOrder[i],&pgpibPvt->pollOrder[i+1],
+            (pgpibPvt->nPollOrder-i)*sizeof(pollNode *));
+        return;
+    }
+}
+
+/* Called with pgpibPvt->lock held */
+static void pollOrderFront(gpibPvt *pgpibPvt,pollNode *ppollNode)
+{
+    int i;
+
+    for(i=0; i<pgpibPvt->nPollOrder; i++) {
+        if(pgpibPvt->pollOrder[i]!=ppollNode) continue;
+        memmove(&pgpibPvt->pollOrder[1],&pgpibPvt->pollOrder[0],
+            i*sizeof(pollNode *));
+        pgpibPvt->pollOrder[0] = ppollNode;
+        return;
+    }
+}
+
 /* NOTE FOR SINGLE ADDRESS CONTROLLER
 * The asynUser must specify addr = 0 or SRQs will not work.
+* Returns TRUE if the device requested service.
 */
-static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
-    asynGpibPort *pasynGpibPort,pollNode *ppollNode,int addr)
+static int pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
+    asynGpibPort *pasynGpibPort,pollNode *ppollNode,
+    const epicsTimeStamp *srqTime)
 {
     asynStatus status;
+    int addr = ppollNode->addr;
     int statusByte = 0;
     int isConnected=0, isEnabled=0, isAutoConnect = 0;
 
@@ -232,7 +296,7 @@ static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s addr %d asynGpib:srqPoll %s\n",
             pgpibPvt->portName,addr,pasynUser->errorMessage);
-        return;
+        return FALSE;
     }
     if(isEnabled && (!isConnected && isAutoConnect)) {
         status = ppollNode->pasynCommon->connect(
@@ -243,23 +307,27 @@ static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
             asynPrint(pasynUser,ASYN_TRACE_ERROR,
                 "%s addr %d asynGpib:srqPoll %s\n",
                 pgpibPvt->portName,addr,pasynUser->errorMessage);
-            return;
+            return FALSE;
         }
     }
     if(!isEnabled || !isConnected) {
         asynPrint(pasynUser,ASYN_TRACE_FLOW,
             "%s addr %d asynGpib:srqPoll but can not connect\n",
             pgpibPvt->portName,addr);
-        return;
+        return FALSE;
     }
     status = pasynGpibPort->serialPoll(
         pgpibPvt->asynGpibPortPvt,addr,SRQTIMEOUT,&statusByte);
+    epicsMutexMustLock(pgpibPvt->lock);
+    pgpibPvt->nSerialPolls++;
+    ppollNode->pstats->nPolls++;
+    epicsMutexUnlock(pgpibPvt->lock);
     if(status!=asynSuccess) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s addr %d asynGpib:srqPoll serialPoll %s\n",
             pgpibPvt->portName,addr,
             (status==asynTimeout ? "timeout" : "error"));
-        return;
+        return FALSE;
     }
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
         "%s asynGpib:srqPoll serialPoll addr %d statusByte %2.2x\n",
@@ -268,13 +336,31 @@ static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
         ELLLIST            *pclientList;
         interruptNode      *pnode;
         asynInt32Interrupt *pinterrupt;
-
+        srqStats           *pstats = ppollNode->pstats;
+        epicsTimeStamp     now;
+        double             latency;
+        int                bin;
+
+        epicsTimeGetCurrent(&now);
+        latency = epicsTimeDiffInSeconds(&now,srqTime);
+        if(latency<0.0) latency = 0.0;
+        for(bin=0; bin<NUM_LATENCY_BINS-1; bin++) {
+            if(latency<latencyLimit[bin]) break;
+        }
+        epicsMutexMustLock(pgpibPvt->lock);
+        pstats->nSrqs++;
+        pstats->sumLatency += latency;
+        if(latency>pstats->maxLatency) pstats->maxLatency = latency;
+        pstats->latency[bin]++;
+        /*Devices that asserted SRQ recently are polled first next time*/
+        pollOrderFront(pgpibPvt,ppollNode);
+        epicsMutexUnlock(pgpibPvt->lock);
         status = pasynManager->interruptStart(pgpibPvt->asynInt32Pvt,&pclientList);
         if(status!=asynSuccess) {
             asynPrint(pasynUser,ASYN_TRACE_ERROR,
                 "%s addr %d asynGpib:srqPoll interruptStart\n",
                 pgpibPvt->portName,addr);
-            return;
+            return FALSE;
         }
         pnode = (interruptNode *)ellFirst(pclientList);
         while (pnode) {
@@ -297,7 +383,9 @@ static void pollOne(asynUser *pasynUser,gpibPvt *pgpibPvt,
             pnode = (interruptNode *)ellNext(&pnode->node);
         }
         pasynManager->interruptEnd(pgpibPvt->asynInt32Pvt);
+        return TRUE;
     }
+    return FALSE;
 }
 
 static void srqPoll(asynUser *pasynUser)
@@ -305,7 +393,8 @@ static void srqPoll(asynUser *pasynUser)
     void       *drvPvt = pasynUser->userPvt;
     asynStatus status;
     int        srqStatus= 0;
-    int        primary,secondary,ntrys;
+    int        i,nPoll,ntrys;
+    epicsTimeStamp srqTime;
     GETgpibPvtasynGpibPort
 
     epicsMutexMustLock(pgpibPvt->lock);
@@ -314,6 +403,8 @@ static void srqPoll(asynUser *pasynUser)
             "%s asynGpib:srqPoll but !pollRequestIsQueued. Why?\n",
             pgpibPvt->portName);
     pgpibPvt->pollRequestIsQueued = 0;
+    srqTime = pgpibPvt->srqTime;
+    pgpibPvt->nSrqPolls++;
     epicsMutexUnlock(pgpibPvt->lock);
     for(ntrys=0; ntrys<MAX_POLL; ntrys++) {
         status = pasynGpibPort->srqStatus(pgpibPvt->asynGpibPortPvt,&srqStatus);
@@ -327,21 +418,30 @@ static void srqPoll(asynUser *pasynUser)
         if(!srqStatus) break;
         asynPrint(pasynUser, ASYN_TRACE_FLOW,
             "%s asynGpib:srqPoll serialPollBegin\n",pgpibPvt->portName);
+        epicsMutexMustLock(pgpibPvt->lock);
+        nPoll = pgpibPvt->nPollOrder;
+        memcpy(pgpibPvt->pollSweep,pgpibPvt->pollOrder,nPoll*sizeof(pollNode *));
+        epicsMutexUnlock(pgpibPvt->lock);
         pasynGpibPort->serialPollBegin(pgpibPvt->asynGpibPortPvt);
-        for(primary=0; primary<NUM_GPIB_ADDRESSES; primary++) {
-            pollListPrimary *ppollListPrimary = &pgpibPvt->pollList[primary];
-            pollNode *ppollNode = &ppollListPrimary->primary;
-            if(ppollNode->pollIt) {
-                pollOne(pasynUser,pgpibPvt,pasynGpibPort,ppollNode,primary);
-            }
-            if(ppollListPrimary->pollSecondary) {
-                for(secondary=0; secondary<NUM_GPIB_ADDRESSES; secondary++) {
-                    int addr = primary*100+secondary;
-                    ppollNode = &ppollListPrimary->secondary[secondary];
-                    if(ppollNode->pollIt) {
-                        pollOne(pasynUser,pgpibPvt,pasynGpibPort,ppollNode,addr);
-                    }
-                }
+        for(i=0; i<nPoll; i++) {
+            pollNode *ppollNode = pgpibPvt->pollSweep[i];
+            int      srqLevel = 1;
+
+            if(!ppollNode->pollIt) continue;
+            if(!pollOne(pasynUser,pgpibPvt,pasynGpibPort,ppollNode,&srqTime))
+                continue;
+            /*If the controller can report the SRQ line and nobody else is
+             *asserting it, the rest of the devices need not be polled*/
+            if(i==nPoll-1 || !pasynGpibPort->srqLevel) continue;
+            status = pasynGpibPort->srqLevel(pgpibPvt->asynGpibPortPvt,&srqLevel);
+            if(status==asynSuccess && !srqLevel) {
+                asynPrint(pasynUser, ASYN_TRACE_FLOW,
+                    "%s asynGpib:srqPoll SRQ released after %d of %d polls\n",
+                    pgpibPvt->portName,i+1,nPoll);
+                epicsMutexMustLock(pgpibPvt->lock);
+                pgpibPvt->nEarlyStops++;
+                epicsMutexUnlock(pgpibPvt->lock);
+                break;
             }
         }
         asynPrint(pasynUser, ASYN_TRACE_FLOW,
@@ -360,6 +460,47 @@ static void report(void *drvPvt,FILE *fd,int details)
 {
     GETgpibPvtasynGpibPort
     pasynGpibPort->report(pgpibPvt->asynGpibPortPvt,fd,details);
+    if(details>=1) srqReport(pgpibPvt,fd,details);
+}
+
+static void srqReport(gpibPvt *pgpibPvt,FILE *fd,int details)
+{
+    int primary,secondary,bin,i;
+
+    epicsMutexMustLock(pgpibPvt->lock);
+    fprintf(fd,"    SRQ polls %lu serial polls %lu stopped early %lu\n",
+        pgpibPvt->nSrqPolls,pgpibPvt->nSerialPolls,pgpibPvt->nEarlyStops);
+    if(pgpibPvt->nPollOrder>0) {
+        fprintf(fd,"    poll order");
+        for(i=0; i<pgpibPvt->nPollOrder; i++)
+            fprintf(fd," %d",pgpibPvt->pollOrder[i]->addr);
+        fprintf(fd,"\n");
+    }
+    for(primary=0; primary<NUM_GPIB_ADDRESSES; primary++) {
+        for(secondary=-1; secondary<NUM_GPIB_ADDRESSES; secondary++) {
+            pollListPrimary *ppollListPrimary = &pgpibPvt->pollList[primary];
+            pollNode *ppollNode = (secondary<0) ? &ppollListPrimary->primary
+                                   : &ppollListPrimary->secondary[secondary];
+            srqStats *pstats = ppollNode->pstats;
+
+            if(!pstats) continue;
+            fprintf(fd,"    addr %d polls %lu SRQs %lu",
+                ppollNode->addr,pstats->nPolls,pstats->nSrqs);
+            if(pstats->nSrqs>0) {
+                fprintf(fd," latency mean %.3f ms max %.3f ms",
+                    pstats->sumLatency/pstats->nSrqs*1e3,pstats->maxLatency*1e3);
+            }
+            fprintf(fd,"\n");
+            if(pstats->nSrqs==0) continue;
+            fprintf(fd,"       ");
+            for(bin=0; bin<NUM_LATENCY_BINS; bin++) {
+                if(pstats->latency[bin]==0 && details<2) continue;
+                fprintf(fd," %s %lu",latencyName[bin],pstats->latency[bin]);
+            }
+            fprintf(fd,"\n");
+        }
+    }
+    epicsMutexUnlock(pgpibPvt->lock);
 }
 
 static asynStatus connect(void *drvPvt,asynUser *pasynUser)
@@ -544,9 +685,19 @@ static asynStatus pollAddr(void *drvPvt,asynUser *pasynUser, int onOff)
         }
         pnode->pasynCommon = (asynCommon *)pasynInterface->pinterface;
         pnode->drvPvt = pasynInterface->drvPvt;
+        pnode->addr = addr;
+        if(!pnode->pstats)
+            pnode->pstats = callocMustSucceed(1,sizeof(srqStats),
+                "asynGpib:pollAddr");
+        epicsMutexMustLock(pgpibPvt->lock);
+        pgpibPvt->pollOrder[pgpibPvt->nPollOrder++] = pnode;
+        epicsMutexUnlock(pgpibPvt->lock);
         pnode->pollIt = 1;
     } else {
         pnode->pollIt = 0;
+        epicsMutexMustLock(pgpibPvt->lock);
+        pollOrderRemove(pgpibPvt,pnode);
+        epicsMutexUnlock(pgpibPvt->lock);
         status = pasynManager->freeAsynUser(pnode->pasynUser);
         if(status!=asynSuccess) {
             asynPrint(pasynUser, ASYN_TRACE_ERROR,
@@ -645,6 +796,7 @@ static void srqHappened(void *drvPvt)
         return;
     }
     pgpibPvt->pollRequestIsQueued = 1;
+    epicsTimeGetCurrent(&pgpibPvt->srqTime);
     epicsMutexUnlock(pgpibPvt->lock);
     status = pasynManager->queueRequest(pgpibPvt->pasynUser,
         asynQueuePriorityMedium,0.0);
@@ -90,6 +90,10 @@ struct asynGpibPort {
     asynStatus (*serialPollBegin) (void *drvPvt);
     asynStatus (*serialPoll) (void *drvPvt, int addr, double timeout,int *status);
     asynStatus (*serialPollEnd) (void *drvPvt);
+    /*srqLevel is optional. It reports whether the SRQ line is asserted now
+     *without clearing anything that srqStatus reports.
+     *It was added in R4-46, drivers built against older releases must be rebuilt*/
+    asynStatus (*srqLevel) (void *drvPvt,int *isSet);
 };
 
 #ifdef __cplusplus
@@ -69,6 +69,8 @@ static char *drto_choices[NUM_DRTO_CHOICES] = {"Unknown", "N", "Y"};
 #define ERR_SIZE 100    /* Size of buffer for error message */
 #define HOST_SIZE MAX_STRING_SIZE
 #define QUEUE_TIMEOUT 10.0    /* Timeout for queueRequest */
+/* dbGet and dbPut use a pfield changed by get_array_info since 3.16.1 */
+#define CAN_RESIZE !LT_EPICSBASE(3,16,1,0)
 
 /* Create RSET - Record Support Entry Table*/
 #define report NULL
@@ -123,6 +125,8 @@ static void getEos(asynUser * pasynUser);
 static void reportError(asynRecord * pasynRec, asynStatus status,
             const char *pformat,...);
 static void resetError(asynRecord * pasynRec);
+static asynStatus resizeBuffers(asynRecord * pasynRec, epicsInt32 omax,
+            epicsInt32 imax);
 rset asynRSET = {
     RSETNUMBER,
     report,
@@ -250,6 +254,10 @@ typedef struct asynRecPvt {
     asynDrvUser *pasynDrvUser;
     void *asynDrvUserPvt;
     char *outbuff;
+    epicsInt32 omaxAlloc;   /* Allocated size of optr and outbuff */
+    epicsInt32 imaxAlloc;   /* Allocated size of iptr */
+    epicsInt32 omax;        /* OMAX and IMAX before a put to them */
+    epicsInt32 imax;
     oldValues old;
 }   asynRecPvt;
 
@@ -298,6 +306,9 @@ static long init_record(dbCommon *pRec, int pass)
                                  pasynRec->imax, sizeof(char), "asynRecord");
     pasynRecPvt->outbuff = (char *) callocMustSucceed(
                                  pasynRec->omax, sizeof(char), "asynRecord");
+    pasynRecPvt->omaxAlloc = pasynRec->omax;
+    pasynRecPvt->imaxAlloc = pasynRec->imax;
+    if(pasynRec->bmax < 0) pasynRec->bmax = 0;
     pasynRec->errs = (char *) callocMustSucceed(
                                    ERR_SIZE, sizeof(char), "asynRecord");
     pasynRec->udf = 0;
@@ -339,6 +350,19 @@ static long process(dbCommon *pRec)
             resetError(pasynRec);
             /* If we got value from interrupt no need to read */
             if(pasynRecPvt->gotValue) goto done;
+            /* Grow BINP if more bytes are requested than it holds */
+            if((pasynRec->iface == asynINTERFACE_OCTET) &&
+               (pasynRec->ifmt != asynFMT_ASCII) &&
+               ((pasynRec->tmod == asynTMOD_Read) ||
+                (pasynRec->tmod == asynTMOD_Write_Read)) &&
+               (pasynRec->nrrd > pasynRec->imax) &&
+               (pasynRec->bmax > pasynRec->imax)) {
+                epicsInt32 imax = pasynRec->nrrd;
+
+                if(imax > pasynRec->bmax) imax = pasynRec->bmax;
+                if(resizeBuffers(pasynRec, pasynRec->omax, imax) == asynSuccess)
+                    db_post_events(pasynRec, &pasynRec->imax, DBE_VALUE | DBE_LOG);
+            }
             status = pasynManager->queueRequest(pasynRecPvt->pasynUser,
                                     asynQueuePriorityLow, QUEUE_TIMEOUT);
             if(status==asynSuccess) {
@@ -385,9 +409,25 @@ static long special(struct dbAddr * paddr, int after)
     asynQueuePriority priority;
 
     if(!after) {
+        pasynRecPvt->omax = pasynRec->omax;
+        pasynRecPvt->imax = pasynRec->imax;
         return 0;
     }
     resetError(pasynRec);
+    if(fieldIndex == asynRecordOMAX || fieldIndex == asynRecordIMAX) {
+        /* The buffers can only be resized while no I/O is using them */
+        epicsInt32 omax = pasynRec->omax;
+        epicsInt32 imax = pasynRec->imax;
+
+        pasynRec->omax = pasynRecPvt->omax;
+        pasynRec->imax = pasynRecPvt->imax;
+        if(pasynRec->pact || pasynRecPvt->state == stateIO) {
+            reportError(pasynRec, asynError, "Can't resize buffers during I/O");
+        } else {
+            resizeBuffers(pasynRec, omax, imax);
+        }
+        return 0;
+    }
     /* The first set of fields can be handled even if state != stateIdle */
     switch (fieldIndex) {
     case asynRecordAQR:
@@ -937,19 +977,28 @@ static void queueTimeoutCallbackSpecial(asynUser * pasynUser)
     pasynManager->freeAsynUser(pasynUser);
 }
 
+/* With base 3.16.1 and later pfield is left pointing at the BOUT or BINP
+ * field and get_array_info sets it to the buffer for each access, so the
+ * buffers can be reallocated. no_elements is fixed when a client connects,
+ * so it is the allocated size, which never shrinks */
 static long cvt_dbaddr(struct dbAddr * paddr)
 {
     asynRecord *pasynRec = (asynRecord *) paddr->precord;
+    asynRecPvt *pasynRecPvt = pasynRec->dpvt;
     int fieldIndex = dbGetFieldIndex(paddr);
     if(fieldIndex == asynRecordBOUT) {
+#if !CAN_RESIZE
         paddr->pfield = (void *) (pasynRec->optr);
-        paddr->no_elements = pasynRec->omax;
+#endif
+        paddr->no_elements = pasynRecPvt->omaxAlloc;
         paddr->field_type = DBF_CHAR;
         paddr->field_size = sizeof(char);
         paddr->dbr_field_type = DBF_CHAR;
     } else if(fieldIndex == asynRecordBINP) {
+#if !CAN_RESIZE
         paddr->pfield = (unsigned char *) (pasynRec->iptr);
-        paddr->no_elements = pasynRec->imax;
+#endif
+        paddr->no_elements = pasynRecPvt->imaxAlloc;
         paddr->field_type = DBF_CHAR;
         paddr->field_size = sizeof(char);
         paddr->dbr_field_type = DBF_CHAR;
@@ -969,9 +1018,15 @@ static long get_array_info(struct dbAddr * paddr, long *no_elements,
     asynRecord *pasynRec = (asynRecord *) paddr->precord;
     int fieldIndex = dbGetFieldIndex(paddr);
     if(fieldIndex == asynRecordBOUT) {
+#if CAN_RESIZE
+        paddr->pfield = pasynRec->optr;
+#endif
         *no_elements = pasynRec->nowt;
         *offset = 0;
     } else if(fieldIndex == asynRecordBINP) {
+#if CAN_RESIZE
+        paddr->pfield = pasynRec->iptr;
+#endif
         *no_elements = pasynRec->nord;
         *offset = 0;
     } else if(fieldIndex == asynRecordERRS) {
@@ -984,10 +1039,12 @@ static long put_array_info(struct dbAddr * paddr, long nNew)
 {
     asynRecord *pasynRec = (asynRecord *) paddr->precord;
     int fieldIndex = dbGetFieldIndex(paddr);
+    /* A client that connected before OMAX or IMAX was reduced can put
+     * more elements than they allow */
     if(fieldIndex == asynRecordBOUT) {
-        pasynRec->nowt = nNew;
+        pasynRec->nowt = (nNew > pasynRec->omax) ? pasynRec->omax : nNew;
     } else if(fieldIndex == asynRecordBINP) {
-        pasynRec->nord = nNew;
+        pasynRec->nord = (nNew > pasynRec->imax) ? pasynRec->imax : nNew;
     }
     return (0);
 }
@@ -1014,7 +1071,11 @@ static void monitor(asynRecord * pasynRec)
         if(pasynRec->ifmt == asynFMT_ASCII)
             db_post_events(pasynRec, pasynRec->ainp, monitor_mask);
         else
+#if CAN_RESIZE
+            db_post_events(pasynRec, &pasynRec->binp, monitor_mask);
+#else
             db_post_events(pasynRec, pasynRec->iptr, monitor_mask);
+#endif
         db_post_events(pasynRec, pasynRec->tinp, monitor_mask);
     }
     POST_IF_NEW(nrrd);
@@ -1556,8 +1617,9 @@ static void performOctetIO(asynUser * pasynUser)
     }
     if((pasynRec->tmod == asynTMOD_Read) ||
         (pasynRec->tmod == asynTMOD_Write_Read)) {
-        /* Set the input buffer to all zeros */
-        memset(inptr, 0, inlen);
+        /* Set the ASCII input buffer to all zeros.  BINP can be large,
+         * it is terminated after the read instead */
+        if(pasynRec->ifmt == asynFMT_ASCII) memset(inptr, 0, inlen);
         /* Read the message  */
         nbytesTransferred = 0;
         status = asynSuccess;
@@ -1619,16 +1681,19 @@ static void performOctetIO(asynUser * pasynUser)
             reportError(pasynRec, status, "Overflow nread %d %s",
                 nbytesTransferred, pasynUser->errorMessage);
             recGblSetSevr(pasynRec,READ_ALARM, MINOR_ALARM);
-        } else if(pasynRec->ifmt != asynFMT_Binary) {
-            /* Not binary and no input buffer overflow has occurred */
+        } else if((pasynRec->ifmt != asynFMT_Binary) ||
+                   ((int)nbytesTransferred < pasynRec->imax)) {
+            /* No input buffer overflow has occurred */
             /* Add null at end of input.  This is safe because of tests above */
             inptr[nbytesTransferred] = '\0';
         }
         pasynRec->nord = (int)nbytesTransferred;    /* Number of bytes read */
-        /* Copy to tinp with dbTranslateEscape */
+        /* Copy to tinp with dbTranslateEscape.  Only the start of a large
+         * binary input can be shown, so don't translate the rest */
         ntranslate = epicsStrSnPrintEscaped(pasynRec->tinp,
-                                           sizeof(pasynRec->tinp),
-                                           inptr, inlen);
+                                           sizeof(pasynRec->tinp), inptr,
+                                           (inlen < sizeof(pasynRec->tinp)) ?
+                                           inlen : sizeof(pasynRec->tinp));
         asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
              "%s: inlen=%lu, nbytesTransferred=%lu, ntranslate=%d\n",
              pasynRec->name, (unsigned long)inlen, (unsigned long)nbytesTransferred, ntranslate);
@@ -2025,6 +2090,69 @@ static void getEos(asynUser * pasynUser)
 }
 
 
+static asynStatus resizeBuffers(asynRecord * pasynRec, epicsInt32 omax,
+    epicsInt32 imax)
+{
+    asynRecPvt *pasynRecPvt = pasynRec->dpvt;
+    char *optr = NULL, *outbuff = NULL, *iptr = NULL;
+
+#if CAN_RESIZE
+    if(omax == pasynRec->omax && imax == pasynRec->imax)
+        return asynSuccess;
+    if((omax != pasynRec->omax &&
+        (omax < MAX_STRING_SIZE || omax > pasynRec->bmax)) ||
+       (imax != pasynRec->imax &&
+        (imax < MAX_STRING_SIZE || imax > pasynRec->bmax))) {
+        reportError(pasynRec, asynError,
+            "OMAX and IMAX must be between %d and BMAX=%d",
+            MAX_STRING_SIZE, pasynRec->bmax);
+        return asynError;
+    }
+    /* The buffers are only reallocated to grow them. A client may put as
+     * many elements as the allocation had when it connected */
+    if(omax > pasynRecPvt->omaxAlloc) {
+        optr = calloc(omax, sizeof(char));
+        outbuff = calloc(omax, sizeof(char));
+    }
+    if(imax > pasynRecPvt->imaxAlloc) iptr = calloc(imax, sizeof(char));
+    if((omax > pasynRecPvt->omaxAlloc && (!optr || !outbuff)) ||
+       (imax > pasynRecPvt->imaxAlloc && !iptr)) {
+        free(optr); free(outbuff); free(iptr);
+        reportError(pasynRec, asynError, "Can't allocate buffers");
+        return asynError;
+    }
+    if(optr) {
+        memcpy(optr, pasynRec->optr, pasynRecPvt->omaxAlloc);
+        free(pasynRec->optr);
+        free(pasynRecPvt->outbuff);
+        pasynRec->optr = optr;
+        pasynRecPvt->outbuff = outbuff;
+        pasynRecPvt->omaxAlloc = omax;
+    }
+    if(iptr) {
+        memcpy(iptr, pasynRec->iptr, pasynRec->nord);
+        free(pasynRec->iptr);
+        pasynRec->iptr = iptr;
+        pasynRecPvt->imaxAlloc = imax;
+    }
+    /* Keep the output data, Hybrid mode needs it terminated */
+    ((char *)pasynRec->optr)[omax - 1] = '\0';
+    pasynRec->omax = omax;
+    if(pasynRec->nowt > omax) pasynRec->nowt = omax;
+    pasynRec->imax = imax;
+    if(pasynRec->nord > imax) pasynRec->nord = imax;
+    asynPrint(pasynRecPvt->pasynUser, ASYN_TRACE_FLOW,
+        "%s: resized buffers OMAX=%d IMAX=%d\n", pasynRec->name, omax, imax);
+    return asynSuccess;
+#else
+    if(omax == pasynRecPvt->omaxAlloc && imax == pasynRecPvt->imaxAlloc)
+        return asynSuccess;
+    reportError(pasynRec, asynError,
+        "Resizing OMAX and IMAX requires EPICS base 3.16.1 or later");
+    return asynError;
+#endif
+}
+
 static void reportError(asynRecord * pasynRec, asynStatus status,
     const char *pformat,...)
 {
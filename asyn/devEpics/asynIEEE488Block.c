@@ -0,0 +1,488 @@
+/*  asynIEEE488Block.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+ * Read IEEE-488.2 definite length arbitrary block response data
+ * directly into an array of record elements.
+ *
+ * The input EOS is disabled while the block is read since the binary
+ * data may contain the EOS characters, and restored before the message
+ * terminator that follows the data is read.
+ * The header is read with one read where possible, and the data that
+ * read got is used before more is read.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <epicsTypes.h>
+#include <epicsEndian.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <menuFtype.h>
+
+#include <epicsExport.h>
+#include "asynDriver.h"
+#include "asynOctet.h"
+#include "asynIEEE488Block.h"
+
+/* Characters that may precede the '#', for example a response header */
+#define MAX_PREAMBLE    256
+/* The preamble, '#', the number of digits and up to 9 digits */
+#define HEADER_SIZE     (MAX_PREAMBLE + 11)
+/* Size of the staging buffer used when the data has to be converted */
+#define CHUNK_SIZE      8192
+
+typedef struct blockTypeInfo {
+    const char    *name;
+    asynBlockType type;
+    int           size;
+    int           isFloat;
+    int           ftvl;
+} blockTypeInfo;
+
+/*
+ * The header is read with as few reads as possible into buf.
+ * What these reads got beyond the header is used before reading again.
+ */
+typedef struct blockReader {
+    asynOctet *pasynOctet;
+    void      *octetPvt;
+    asynUser  *pasynUser;
+    char      buf[HEADER_SIZE];
+    size_t    pos;
+    size_t    len;
+    int       eomReason;  /* of the last read */
+} blockReader;
+
+/* Longer names first so that "INT16" is not taken as "INT1..." */
+static const blockTypeInfo blockTypes[] = {
+    {"FLOAT32", asynBlockFloat32, 4, 1, menuFtypeFLOAT},
+    {"FLOAT64", asynBlockFloat64, 8, 1, menuFtypeDOUBLE},
+    {"UINT16",  asynBlockUInt16,  2, 0, menuFtypeUSHORT},
+    {"UINT32",  asynBlockUInt32,  4, 0, menuFtypeULONG},
+    {"INT16",   asynBlockInt16,   2, 0, menuFtypeSHORT},
+    {"INT32",   asynBlockInt32,   4, 0, menuFtypeLONG},
+    {"UINT8",   asynBlockUInt8,   1, 0, menuFtypeUCHAR},
+    {"INT8",    asynBlockInt8,    1, 0, menuFtypeCHAR},
+};
+#define NUM_BLOCK_TYPES (sizeof blockTypes / sizeof blockTypes[0])
+
+static const blockTypeInfo *findType(asynBlockType type)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_BLOCK_TYPES; i++)
+        if (blockTypes[i].type == type) return &blockTypes[i];
+    return NULL;
+}
+
+static int ftvlSupported(int ftvl)
+{
+    switch (ftvl) {
+    case menuFtypeCHAR:
+    case menuFtypeUCHAR:
+    case menuFtypeSHORT:
+    case menuFtypeUSHORT:
+    case menuFtypeLONG:
+    case menuFtypeULONG:
+#ifdef HAVE_DEVINT64
+    case menuFtypeINT64:
+    case menuFtypeUINT64:
+#endif
+    case menuFtypeFLOAT:
+    case menuFtypeDOUBLE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+asynStatus asynIEEE488BlockParseFormat(asynUser *pasynUser,
+                const char *str, int ftvl, asynBlockFormat *pformat)
+{
+    size_t i;
+
+    if (!ftvlSupported(ftvl)) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "FTVL %d is not supported for block data", ftvl);
+        return asynError;
+    }
+    pformat->bigEndian = 1;
+    while (str && isspace((unsigned char)*str)) str++;
+    if (!str || !*str) {
+        for (i = 0; i < NUM_BLOCK_TYPES; i++) {
+            if (blockTypes[i].ftvl == ftvl) {
+                pformat->type = blockTypes[i].type;
+                return asynSuccess;
+            }
+        }
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "No default block format for FTVL %d", ftvl);
+        return asynError;
+    }
+    for (i = 0; i < NUM_BLOCK_TYPES; i++) {
+        size_t len = strlen(blockTypes[i].name);
+        const char *suffix = str + len;
+
+        if (epicsStrnCaseCmp(str, blockTypes[i].name, len) != 0)
+            continue;
+        while ((*suffix == ' ') || (*suffix == '_')) suffix++;
+        if ((*suffix == '\0') || (epicsStrCaseCmp(suffix, "BE") == 0)) {
+            pformat->bigEndian = 1;
+        } else if (epicsStrCaseCmp(suffix, "LE") == 0) {
+            pformat->bigEndian = 0;
+        } else {
+            break;
+        }
+        pformat->type = blockTypes[i].type;
+        return asynSuccess;
+    }
+    epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                  "Invalid block format \"%s\"", str);
+    return asynError;
+}
+
+static asynStatus readDevice(blockReader *preader, char *buf, size_t n, size_t *nread)
+{
+    if (preader->eomReason & ASYN_EOM_END) {
+        epicsSnprintf(preader->pasynUser->errorMessage,
+                      preader->pasynUser->errorMessageSize,
+                      "Message ended %lu bytes before the end of the block",
+                      (unsigned long)n);
+        return asynError;
+    }
+    preader->eomReason = 0;
+    return preader->pasynOctet->read(preader->octetPvt, preader->pasynUser,
+                                     buf, n, nread, &preader->eomReason);
+}
+
+/*
+ * Read exactly n bytes, first those left over from the header read
+ */
+static asynStatus readExactly(blockReader *preader, char *buf, size_t n, int *eom)
+{
+    asynStatus status;
+    size_t nread;
+
+    if (preader->pos < preader->len) {
+        nread = preader->len - preader->pos;
+        if (nread > n) nread = n;
+        memcpy(buf, preader->buf + preader->pos, nread);
+        preader->pos += nread;
+        buf += nread;
+        n -= nread;
+    }
+    while (n) {
+        status = readDevice(preader, buf, n, &nread);
+        if (status != asynSuccess)
+            return status;
+        buf += nread;
+        n -= nread;
+    }
+    if (eom) *eom = (preader->pos < preader->len) ? 0 : preader->eomReason;
+    return asynSuccess;
+}
+
+static asynStatus readHeader(blockReader *preader, size_t *length)
+{
+    asynUser *pasynUser = preader->pasynUser;
+    asynStatus status;
+    size_t nread;
+
+    for (;;) {
+        const char *start = preader->buf + preader->pos;
+        const char *hash = memchr(start, '#', preader->len - preader->pos);
+
+        if (!hash && (preader->len >= MAX_PREAMBLE)) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "Didn't find '#' to begin arbitrary block data");
+            return asynError;
+        }
+        if (hash && (hash + 1 < preader->buf + preader->len)) {
+            const char *digits = hash + 2;
+            char c = hash[1];
+            int i, nDigits;
+
+            if (c == '0') {
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                              "Indefinite length arbitrary block data is not supported");
+                return asynError;
+            }
+            if ((c < '1') || (c > '9')) {
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                    "Arbitrary block data number of digits ('\\%.2x') is not numeric",
+                    (unsigned char)c);
+                return asynError;
+            }
+            nDigits = c - '0';
+            if (digits + nDigits <= preader->buf + preader->len) {
+                *length = 0;
+                for (i = 0; i < nDigits; i++) {
+                    if (!isdigit((unsigned char)digits[i])) {
+                        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                            "Arbitrary block data number of bytes (%.*s) is not numeric",
+                            nDigits, digits);
+                        return asynError;
+                    }
+                    *length = *length * 10 + (digits[i] - '0');
+                }
+                preader->pos = digits + nDigits - preader->buf;
+                return asynSuccess;
+            }
+        }
+        if (preader->eomReason & ASYN_EOM_END) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "Message ended before the arbitrary block data header");
+            return asynError;
+        }
+        status = readDevice(preader, preader->buf + preader->len,
+                            sizeof preader->buf - preader->len, &nread);
+        if (status != asynSuccess)
+            return status;
+        preader->len += nread;
+    }
+}
+
+static void swapElements(unsigned char *p, size_t nElements, int size)
+{
+    size_t i;
+    int j;
+
+    for (i = 0; i < nElements; i++, p += size) {
+        for (j = 0; j < size / 2; j++) {
+            unsigned char t = p[j];
+            p[j] = p[size - 1 - j];
+            p[size - 1 - j] = t;
+        }
+    }
+}
+
+/*
+ * Convert nElements elements of block data to ftvl elements
+ * starting at element index of pdest.
+ */
+static asynStatus convertElements(asynUser *pasynUser,
+                const unsigned char *src, size_t nElements,
+                const blockTypeInfo *pinfo, int swap,
+                void *pdest, int ftvl, size_t index)
+{
+    size_t i;
+
+    for (i = 0; i < nElements; i++, src += pinfo->size, index++) {
+        union {
+            epicsInt8    i8;  epicsUInt8  u8;
+            epicsInt16   i16; epicsUInt16 u16;
+            epicsInt32   i32; epicsUInt32 u32;
+            epicsFloat32 f32; epicsFloat64 f64;
+            unsigned char b[8];
+        } raw;
+        epicsFloat64 dval = 0;
+        epicsInt64 ival = 0;
+        int j;
+
+        if (swap)
+            for (j = 0; j < pinfo->size; j++) raw.b[j] = src[pinfo->size - 1 - j];
+        else
+            memcpy(raw.b, src, pinfo->size);
+        switch (pinfo->type) {
+        case asynBlockInt8:    ival = raw.i8;  break;
+        case asynBlockUInt8:   ival = raw.u8;  break;
+        case asynBlockInt16:   ival = raw.i16; break;
+        case asynBlockUInt16:  ival = raw.u16; break;
+        case asynBlockInt32:   ival = raw.i32; break;
+        case asynBlockUInt32:  ival = raw.u32; break;
+        case asynBlockFloat32: dval = raw.f32; break;
+        case asynBlockFloat64: dval = raw.f64; break;
+        }
+        if (!pinfo->isFloat) {
+            dval = (epicsFloat64)ival;
+        } else if ((ftvl != menuFtypeFLOAT) && (ftvl != menuFtypeDOUBLE)) {
+            /* Only values in the epicsInt64 range can be cast */
+            if (!(dval >= -9223372036854775808.0 && dval < 9223372036854775808.0)) {
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                    "Block element %lu (%g) is out of range for an integer record",
+                    (unsigned long)index, dval);
+                return asynError;
+            }
+            ival = (epicsInt64)dval;
+        }
+        switch (ftvl) {
+        case menuFtypeCHAR:   ((epicsInt8 *)pdest)[index]    = (epicsInt8)ival;    break;
+        case menuFtypeUCHAR:  ((epicsUInt8 *)pdest)[index]   = (epicsUInt8)ival;   break;
+        case menuFtypeSHORT:  ((epicsInt16 *)pdest)[index]   = (epicsInt16)ival;   break;
+        case menuFtypeUSHORT: ((epicsUInt16 *)pdest)[index]  = (epicsUInt16)ival;  break;
+        case menuFtypeLONG:   ((epicsInt32 *)pdest)[index]   = (epicsInt32)ival;   break;
+        case menuFtypeULONG:  ((epicsUInt32 *)pdest)[index]  = (epicsUInt32)ival;  break;
+#ifdef HAVE_DEVINT64
+        case menuFtypeINT64:  ((epicsInt64 *)pdest)[index]   = ival;               break;
+        case menuFtypeUINT64: ((epicsUInt64 *)pdest)[index]  = (epicsUInt64)ival;  break;
+#endif
+        case menuFtypeFLOAT:  ((epicsFloat32 *)pdest)[index] = (epicsFloat32)dval; break;
+        case menuFtypeDOUBLE: ((epicsFloat64 *)pdest)[index] = dval;               break;
+        }
+    }
+    return asynSuccess;
+}
+
+static asynStatus readData(blockReader *preader, const asynBlockFormat *pformat,
+                const blockTypeInfo *pinfo, size_t length,
+                void *pdest, int ftvl, size_t maxElements,
+                size_t *nElements, int *eom)
+{
+    double chunk[CHUNK_SIZE / sizeof(double)];
+    size_t nBlock = length / pinfo->size;
+    size_t nKeep = (nBlock < maxElements) ? nBlock : maxElements;
+    size_t nDiscard = length - nKeep * pinfo->size;
+    size_t chunkElements = CHUNK_SIZE / pinfo->size;
+    size_t done = 0;
+    int swap = (pformat->bigEndian != (EPICS_BYTE_ORDER == EPICS_ENDIAN_BIG));
+    asynUser *pasynUser = preader->pasynUser;
+    asynStatus status;
+
+    *eom = 0;
+    if (length % pinfo->size) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+            "Block length %lu is not a multiple of the %s element size",
+            (unsigned long)length, pinfo->name);
+        return asynError;
+    }
+    if (ftvl == pinfo->ftvl) {
+        /* Same type: straight into the record */
+        status = readExactly(preader, (char *)pdest, nKeep * pinfo->size, eom);
+        if (status != asynSuccess)
+            return status;
+        if (swap && (pinfo->size > 1))
+            swapElements((unsigned char *)pdest, nKeep, pinfo->size);
+        done = nKeep;
+    } else {
+        while (done < nKeep) {
+            size_t n = nKeep - done;
+
+            if (n > chunkElements) n = chunkElements;
+            status = readExactly(preader, (char *)chunk, n * pinfo->size, eom);
+            if (status != asynSuccess)
+                return status;
+            status = convertElements(pasynUser, (unsigned char *)chunk, n, pinfo,
+                                     swap, pdest, ftvl, done);
+            if (status != asynSuccess)
+                return status;
+            done += n;
+        }
+    }
+    *nElements = done;
+    while (nDiscard) {
+        size_t n = (nDiscard < sizeof chunk) ? nDiscard : sizeof chunk;
+
+        status = readExactly(preader, (char *)chunk, n, eom);
+        if (status != asynSuccess)
+            return status;
+        nDiscard -= n;
+    }
+    if (nKeep < nBlock) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Block has %lu elements, only %lu stored",
+                      (unsigned long)nBlock, (unsigned long)nKeep);
+        return asynOverflow;
+    }
+    return asynSuccess;
+}
+
+/*
+ * Consume the message terminator that follows the data.
+ * Nothing is read if the message has ended, or if there is no EOS, since
+ * the read could then only end with a timeout.
+ */
+static asynStatus readTrailer(blockReader *preader, const char *eos, int eosLen, int eom)
+{
+    asynUser *pasynUser = preader->pasynUser;
+    const char *rest = preader->buf + preader->pos;
+    size_t nRest = preader->len - preader->pos;
+    char buf[16];
+    size_t nread, i;
+    int eomReason;
+    asynStatus status;
+
+    /* Left over from the header read, read while the EOS was disabled */
+    for (i = 0; i < nRest; i++) {
+        if (!isspace((unsigned char)rest[i])) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                "Unexpected characters between arbitrary block data and terminator");
+            return asynError;
+        }
+    }
+    preader->pos = preader->len;
+    if (nRest) eom = preader->eomReason;
+    if ((eom & (ASYN_EOM_END | ASYN_EOM_EOS)) || (eosLen == 0))
+        return asynSuccess;
+    if ((nRest >= (size_t)eosLen) && (memcmp(rest + nRest - eosLen, eos, eosLen) == 0))
+        return asynSuccess;
+    status = preader->pasynOctet->read(preader->octetPvt, pasynUser, buf, sizeof buf,
+                                       &nread, &eomReason);
+    if (status != asynSuccess) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Error reading terminator after arbitrary block data");
+        return status;
+    }
+    for (i = 0; i < nread; i++) {
+        if (!isspace((unsigned char)buf[i])) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                "Unexpected characters between arbitrary block data and terminator");
+            return asynError;
+        }
+    }
+    return asynSuccess;
+}
+
+asynStatus asynIEEE488BlockRead(asynOctet *pasynOctet, void *octetPvt,
+                asynUser *pasynUser, const asynBlockFormat *pformat,
+                void *pdest, int ftvl, size_t maxElements, size_t *nElements)
+{
+    const blockTypeInfo *pinfo = findType(pformat->type);
+    blockReader reader;
+    char saveEos[5];
+    int saveEosLen = 0;
+    size_t length = 0;
+    int eom = 0;
+    asynStatus status, trailerStatus;
+
+    *nElements = 0;
+    if (!pinfo || !ftvlSupported(ftvl)) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Unsupported block or record element type");
+        return asynError;
+    }
+    reader.pasynOctet = pasynOctet;
+    reader.octetPvt = octetPvt;
+    reader.pasynUser = pasynUser;
+    reader.pos = reader.len = 0;
+    reader.eomReason = 0;
+    if (pasynOctet->getInputEos(octetPvt, pasynUser, saveEos, sizeof saveEos,
+                                &saveEosLen) != asynSuccess)
+        saveEosLen = 0;
+    if (saveEosLen)
+        pasynOctet->setInputEos(octetPvt, pasynUser, NULL, 0);
+    status = readHeader(&reader, &length);
+    if (status == asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACE_FLOW,
+                  "asynIEEE488BlockRead %lu bytes of %s\n",
+                  (unsigned long)length, pinfo->name);
+        status = readData(&reader, pformat, pinfo,
+                          length, pdest, ftvl, maxElements, nElements, &eom);
+    }
+    if (saveEosLen)
+        pasynOctet->setInputEos(octetPvt, pasynUser, saveEos, saveEosLen);
+    if ((status != asynSuccess) && (status != asynOverflow))
+        return status;
+    trailerStatus = readTrailer(&reader, saveEos, saveEosLen, eom);
+    if (trailerStatus != asynSuccess)
+        return trailerStatus;
+    return status;
+}
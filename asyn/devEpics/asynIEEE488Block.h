@@ -0,0 +1,66 @@
+/*  asynIEEE488Block.h */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+ * Read IEEE-488.2 definite length arbitrary block response data
+ * (#<n><length><data>) directly into an array of record elements.
+ */
+
+#ifndef asynIEEE488BlockH
+#define asynIEEE488BlockH
+
+#include <stddef.h>
+#include "asynDriver.h"
+#include "asynOctet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/* Element type of the binary data in a block */
+typedef enum {
+    asynBlockInt8, asynBlockUInt8,
+    asynBlockInt16, asynBlockUInt16,
+    asynBlockInt32, asynBlockUInt32,
+    asynBlockFloat32, asynBlockFloat64
+} asynBlockType;
+
+typedef struct asynBlockFormat {
+    asynBlockType type;
+    int           bigEndian;
+} asynBlockFormat;
+
+/*
+ * Parse a block format such as "INT16", "UINT16LE" or "FLOAT32 BE".
+ * The byte order defaults to big endian, the IEEE-488.2 normal order.
+ * An empty or NULL string selects the type that matches ftvl.
+ */
+ASYN_API asynStatus asynIEEE488BlockParseFormat(asynUser *pasynUser,
+                const char *str, int ftvl, asynBlockFormat *pformat);
+
+/*
+ * Read one block and store up to maxElements elements of type ftvl (a menuFtype)
+ * at pdest.  Any characters before the '#' are skipped and the message
+ * terminator after the data is consumed, unless the data ended the message
+ * or the port has no input EOS.
+ * Float data can only be stored in integer elements if it is in the
+ * epicsInt64 range, otherwise asynError is returned.
+ * When the block and destination types are the same the data is read
+ * straight into pdest, otherwise it is converted in small chunks.
+ * Elements that don't fit are read and discarded, and asynOverflow returned.
+ */
+ASYN_API asynStatus asynIEEE488BlockRead(asynOctet *pasynOctet, void *octetPvt,
+                asynUser *pasynUser, const asynBlockFormat *pformat,
+                void *pdest, int ftvl, size_t maxElements, size_t *nElements);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* asynIEEE488BlockH */
@@ -0,0 +1,122 @@
+/* devAsynCoalesce.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+    Coalescing of reads for scalar input records on ports that can block.
+
+    Normally every input record that processes queues its own request, and
+    the port thread does one driver read for each of them.
+    Records with info(asyn:COALESCE, "1") that use the same port, address,
+    drvInfo, interface and mask instead share one asynUser.  A record that
+    processes while a read for the group is queued but not yet started waits
+    for that read instead of queuing another one.  When the read is done its
+    value, status and time stamp are given to every waiting record.
+    A record that processes after the read has started queues a new read,
+    so a record never gets a value that was read before it processed.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
+#include <dbCommon.h>
+
+#include "asynDriver.h"
+#include "devEpicsPvt.h"
+
+struct devAsynCoalesce {
+    devAsynGroup        group;     /* must be first */
+    asynUser            *pasynUser;
+    devAsynCoalesceRead readUser;
+    epicsMutexId        lock;
+    ELLLIST             waitList;  /* devAsynCoalesceWaiter of the queued read */
+    int                 queued;
+};
+
+static devAsynGroupList coalesceList = DEV_ASYN_GROUP_LIST_INIT;
+
+/* Called by the port thread: one read for all records that were waiting */
+static void coalesceCallback(asynUser *pasynUser)
+{
+    devAsynCoalesce *pgroup = (devAsynCoalesce *)pasynUser->userPvt;
+    devAsynCoalesceWaiter *pwaiter;
+    devAsynSharedScanValue result;
+    ELLLIST waitList = ELLLIST_INIT;
+
+    epicsMutexMustLock(pgroup->lock);
+    ellConcat(&waitList, &pgroup->waitList);
+    pgroup->queued = 0;
+    epicsMutexUnlock(pgroup->lock);
+    memset(&result, 0, sizeof(result));
+    result.status = pgroup->readUser(pgroup->group.pinterface, pgroup->group.drvPvt,
+        pasynUser, pgroup->group.mask, &result.value);
+    result.time = pasynUser->timestamp;
+    result.alarmStatus = pasynUser->alarmStatus;
+    result.alarmSeverity = pasynUser->alarmSeverity;
+    while ((pwaiter = (devAsynCoalesceWaiter *)ellGet(&waitList))) {
+        pwaiter->done(pwaiter->userPvt, pasynUser, &result);
+    }
+}
+
+int devAsynCoalesceEnabled(struct dbCommon *prec)
+{
+    const char *coalesceString = asynDbGetInfo(prec, "asyn:COALESCE");
+
+    return coalesceString ? atoi(coalesceString) : 0;
+}
+
+devAsynCoalesce *devAsynCoalesceAttach(struct dbCommon *prec, asynUser *pasynUser,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt, devAsynCoalesceRead readUser)
+{
+    devAsynCoalesce *pgroup;
+    int created;
+
+    pgroup = (devAsynCoalesce *)devAsynGroupFind(&coalesceList, sizeof(*pgroup),
+        portName, addr, userParam, interfaceType, mask, pinterface, drvPvt, &created);
+    if (created) {
+        /* The duplicate keeps the reason, drvUser and timeout of the record's asynUser */
+        pgroup->pasynUser = pasynManager->duplicateAsynUser(pasynUser, coalesceCallback, 0);
+        pgroup->pasynUser->userPvt = pgroup;
+        pgroup->readUser = readUser;
+        pgroup->lock = epicsMutexMustCreate();
+    }
+    devAsynGroupListUnlock(&coalesceList);
+    return pgroup;
+}
+
+/* Called when the record processes. pwaiter->done is called when the value
+ * has been read. The errorMessage of pasynUser is set if this fails. */
+asynStatus devAsynCoalesceQueue(devAsynCoalesce *pgroup, devAsynCoalesceWaiter *pwaiter,
+    asynUser *pasynUser)
+{
+    asynStatus status = asynSuccess;
+
+    epicsMutexMustLock(pgroup->lock);
+    if (pgroup->queued) {
+        ellAdd(&pgroup->waitList, &pwaiter->node);
+        asynPrint(pasynUser, ASYN_TRACE_FLOW,
+            "%s devAsynCoalesceQueue merged with queued read\n", pgroup->group.portName);
+    } else {
+        status = pasynManager->queueRequest(pgroup->pasynUser, asynQueuePriorityLow, 0);
+        if (status == asynSuccess) {
+            ellAdd(&pgroup->waitList, &pwaiter->node);
+            pgroup->queued = 1;
+        } else {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                "%s", pgroup->pasynUser->errorMessage);
+        }
+    }
+    epicsMutexUnlock(pgroup->lock);
+    return status;
+}
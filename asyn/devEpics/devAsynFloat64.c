@@ -87,6 +87,14 @@ typedef struct devPvt{
     int               newOutputCallbackValue;
     int               numDeferredOutputCallbacks;
     IOSCANPVT         ioScanPvt;
+    devAsynSharedScan *pSharedScan;
+    unsigned int      sharedScanSeq;
+    devAsynCoalesce   *pCoalesce;
+    devAsynCoalesceWaiter coalesceWaiter;
+    int               pipeline;
+    int               writeQueued;
+    epicsFloat64      pipelineValue;
+    asynStatus        pipelineStatus;
     char              *portName;
     char              *userParam;
     int               addr;
@@ -98,9 +106,22 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
 static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt);
 static long createRingBuffer(dbCommon *pr);
 static void processCallbackInput(asynUser *pasynUser);
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser);
 static void processCallbackOutput(asynUser *pasynUser);
+static void processCallbackPipelined(devPvt *pPvt);
 static void outputCallbackCallback(CALLBACK *pcb);
 static int  getCallbackValue(devPvt *pPvt);
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsFloat64 value);
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt);
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt);
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue);
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsFloat64 value);
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
@@ -210,6 +231,21 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
 
     scanIoInit(&pPvt->ioScanPvt);
     pPvt->interruptCallback = interruptCallback;
+    /* Records with asyn:COALESCE share the reads that are queued at the same time */
+    if ((processCallback == processCallbackInput) && pPvt->canBlock &&
+        devAsynCoalesceEnabled(pr)) {
+        pPvt->pCoalesce = devAsynCoalesceAttach(pr, pPvt->pasynUser,
+            pPvt->portName, pPvt->addr, pPvt->userParam, asynFloat64Type, 0,
+            pPvt->pfloat64, pPvt->float64Pvt, readCoalesced);
+        pPvt->coalesceWaiter.done = coalesceDone;
+        pPvt->coalesceWaiter.userPvt = pPvt;
+    }
+    /* If the info field "asyn:PIPELINE" is 1 then output records on asynchronous ports
+     * complete without waiting for the write, see queuePipelinedWrite */
+    if ((processCallback == processCallbackOutput) && pPvt->canBlock) {
+        const char *pipelineString = asynDbGetInfo(pr, "asyn:PIPELINE");
+        if (pipelineString) pPvt->pipeline = atoi(pipelineString);
+    }
 
     /* If the info field "asyn:READBACK" is 1 and interruptCallback is not NULL
      * then register for callbacks on output records */
@@ -269,6 +305,16 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s registering interrupt\n",
             pr->name, driverName, functionName);
+        /* Records with asyn:SHARED_SCAN share one callback and one IOSCANPVT */
+        if ((pPvt->interruptCallback == interruptCallbackInput) &&
+            devAsynSharedScanEnabled(pr)) {
+            pPvt->pSharedScan = devAsynSharedScanAttach(pr, pPvt->pasynUser,
+                pPvt->portName, pPvt->addr, pPvt->userParam, asynFloat64Type, 0,
+                pPvt->pfloat64, pPvt->float64Pvt, registerSharedScan, cancelSharedScan,
+                &pPvt->sharedScanSeq);
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            return 0;
+        }
         createRingBuffer(pr);
         /* Set a flag indicating that we are in I/O Intr scan mode. Used in aiAverage mode. */
          pPvt->isIOIntrScan = 1;
@@ -286,6 +332,12 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s cancelling interrupt\n",
              pr->name, driverName, functionName);
+        if (pPvt->pSharedScan) {
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            devAsynSharedScanDetach(pPvt->pSharedScan);
+            pPvt->pSharedScan = NULL;
+            return 0;
+        }
         /* Set a flag indicating that we are not in I/O Intr scan mode. Used in aiAverage mode. */
         pPvt->isIOIntrScan = 0;
         /* For aiAverage we don't disable callbacks here, because they are always enabled in any scan mode. */
@@ -302,16 +354,12 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
     return 0;
 }
 
-static void processCallbackInput(asynUser *pasynUser)
+/* Traces the result of a read and completes the record */
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser)
 {
-    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = (dbCommon *)pPvt->pr;
-    static const char *functionName="processCallbackInput";
+    static const char *functionName="processReadResult";
 
-    pPvt->result.status = pPvt->pfloat64->read(pPvt->float64Pvt, pPvt->pasynUser, &pPvt->result.value);
-    pPvt->result.time = pPvt->pasynUser->timestamp;
-    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
-    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
     if (pPvt->result.status == asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
             "%s %s::%s process value=%f\n", pr->name, driverName, functionName,
@@ -327,12 +375,27 @@ static void processCallbackInput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackInput(asynUser *pasynUser)
+{
+    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
+
+    pPvt->result.status = pPvt->pfloat64->read(pPvt->float64Pvt, pPvt->pasynUser, &pPvt->result.value);
+    pPvt->result.time = pPvt->pasynUser->timestamp;
+    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
+    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = pPvt->pr;
     static const char *functionName="processCallbackOutput";
 
+    if (pPvt->pipeline) {
+        processCallbackPipelined(pPvt);
+        return;
+    }
     pPvt->result.status = pPvt->pfloat64->write(pPvt->float64Pvt, pPvt->pasynUser,pPvt->result.value);
     pPvt->result.time = pPvt->pasynUser->timestamp;
     pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
@@ -351,6 +414,92 @@ static void processCallbackOutput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackPipelined(devPvt *pPvt)
+{
+    dbCommon *pr = pPvt->pr;
+    asynUser *pasynUser = pPvt->pasynUser;
+    epicsFloat64 value;
+    asynStatus status;
+    static const char *functionName="processCallbackPipelined";
+
+    /* Values written while this request was queued replaced pipelineValue,
+     * so only the most recent one is written */
+    epicsMutexLock(pPvt->devPvtLock);
+    value = pPvt->pipelineValue;
+    pPvt->writeQueued = 0;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pPvt->pfloat64->write(pPvt->float64Pvt, pasynUser, value);
+    if (status == asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+            "%s %s::%s process value %f\n", pr->name, driverName, functionName,
+            value);
+    } else {
+        epicsMutexLock(pPvt->devPvtLock);
+        pPvt->pipelineStatus = status;
+        epicsMutexUnlock(pPvt->devPvtLock);
+        if (status != pPvt->lastStatus) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s %s::%s process write error %s\n",
+                pr->name, driverName, functionName, pasynUser->errorMessage);
+        }
+    }
+    pPvt->lastStatus = status;
+}
+
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsFloat64 value)
+{
+    devAsynScalarValue scalar;
+
+    scalar.float64 = value;
+    devAsynSharedScanPost((devAsynSharedScan *)userPvt, pasynUser, &scalar);
+}
+
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt)
+{
+    asynFloat64 *pfloat64 = (asynFloat64 *)pinterface;
+
+    return pfloat64->registerInterruptUser(drvPvt, pasynUser,
+        sharedScanCallback, pscan, registrarPvt);
+}
+
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt)
+{
+    asynFloat64 *pfloat64 = (asynFloat64 *)pinterface;
+
+    return pfloat64->cancelInterruptUser(drvPvt, pasynUser, registrarPvt);
+}
+
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue)
+{
+    asynFloat64 *pfloat64 = (asynFloat64 *)pinterface;
+
+    return pfloat64->read(drvPvt, pasynUser, &pvalue->float64);
+}
+
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+
+    pPvt->result.value = presult->value.float64;
+    pPvt->result.time = presult->time;
+    pPvt->result.status = presult->status;
+    pPvt->result.alarmStatus = presult->alarmStatus;
+    pPvt->result.alarmSeverity = presult->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    if (pPvt->pCoalesce)
+        return devAsynCoalesceQueue(pPvt->pCoalesce, &pPvt->coalesceWaiter, pPvt->pasynUser);
+    return pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+}
+
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsFloat64 value)
 {
@@ -411,6 +560,11 @@ static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
         pr->name, driverName, functionName,value);
     if (!interruptAccept) return;
     epicsMutexLock(pPvt->devPvtLock);
+    if (pPvt->writeQueued) {
+        /* A newer value is queued to be written, so this readback is already stale */
+        epicsMutexUnlock(pPvt->devPvtLock);
+        return;
+    }
     rp = &pPvt->ringBuffer[pPvt->ringHead];
     rp->value = value;
     rp->time = pasynUser->timestamp;
@@ -525,6 +679,17 @@ static int getCallbackValue(devPvt *pPvt)
     int ret = 0;
     static const char *functionName="getCallbackValue";
 
+    if (pPvt->pSharedScan) {
+        devAsynSharedScanValue shared;
+
+        if (!devAsynSharedScanGet(pPvt->pSharedScan, &pPvt->sharedScanSeq, &shared)) return 0;
+        pPvt->result.value = shared.value.float64;
+        pPvt->result.time = shared.time;
+        pPvt->result.status = shared.status;
+        pPvt->result.alarmStatus = shared.alarmStatus;
+        pPvt->result.alarmSeverity = shared.alarmSeverity;
+        return 1;
+    }
     epicsMutexLock(pPvt->devPvtLock);
     if (pPvt->ringTail != pPvt->ringHead) {
         if (pPvt->ringBufferOverflows > 0) {
@@ -563,6 +728,32 @@ static void reportQueueRequestStatus(devPvt *pPvt, asynStatus status)
     }
 }
 
+/* Called with devPvtLock held.  The record completes without waiting for the write.
+ * If the previous write has not executed yet this value replaces it, so the port queue
+ * holds at most one write for the record.  Errors are reported the next time the record
+ * processes. */
+static void queuePipelinedWrite(devPvt *pPvt, epicsFloat64 value)
+{
+    asynStatus status;
+    static const char *functionName="queuePipelinedWrite";
+
+    pPvt->pipelineValue = value;
+    pPvt->result.status = pPvt->pipelineStatus;
+    pPvt->pipelineStatus = asynSuccess;
+    if (pPvt->writeQueued) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
+            "%s %s::%s merged with queued write, value=%f\n",
+            pPvt->pr->name, driverName, functionName, value);
+        return;
+    }
+    pPvt->writeQueued = 1;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    epicsMutexLock(pPvt->devPvtLock);
+    if (status != asynSuccess) pPvt->writeQueued = 0;
+    reportQueueRequestStatus(pPvt, status);
+}
+
 
 static long initAi(aiRecord *pai)
 {
@@ -580,7 +771,7 @@ static long processAi(aiRecord *pr)
 
     if (!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -648,6 +839,11 @@ static long processAo(aoRecord *pr)
             val64 += pr->aoff;
             pr->val = val64;
         }
+    } else if (pPvt->pipeline) {
+        /* ASLO/AOFF conversion */
+        epicsFloat64 val64 = pr->oval - pr->aoff;
+        if (pr->aslo != 0.0) val64 /= pr->aslo;
+        queuePipelinedWrite(pPvt, val64);
     } else if(pr->pact == 0) {
         /* ASLO/AOFF conversion */
         epicsFloat64 val64 = pr->oval - pr->aoff;
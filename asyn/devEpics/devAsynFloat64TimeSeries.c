@@ -39,11 +39,13 @@
 #include "asynDrvUser.h"
 #include "asynEpicsUtils.h"
 #include "asynFloat64.h"
+#include "asynFloat64Array.h"
 #include "devAsynXXXTimeSeries.h"
 
 /* The code for this driver is generated by the macro in the include file with macro substitution */
 
 ASYN_XXX_TIME_SERIES_FUNCS("devAsynFloat64TimeSeries", asynFloat64, asynFloat64Type,
                             interruptCallbackFloat64, epicsFloat64, asynFloat64TimeSeries,
-                            menuFtypeDOUBLE, menuFtypeDOUBLE)
+                            menuFtypeDOUBLE, menuFtypeDOUBLE,
+                            asynFloat64Array, asynFloat64ArrayType)
 
@@ -108,6 +108,14 @@ typedef struct devPvt{
     int               newOutputCallbackValue;
     int               numDeferredOutputCallbacks;
     IOSCANPVT         ioScanPvt;
+    devAsynSharedScan *pSharedScan;
+    unsigned int      sharedScanSeq;
+    devAsynCoalesce   *pCoalesce;
+    devAsynCoalesceWaiter coalesceWaiter;
+    int               pipeline;
+    int               writeQueued;
+    epicsInt32        pipelineValue;
+    asynStatus        pipelineStatus;
     char              *portName;
     char              *userParam;
     int               addr;
@@ -125,9 +133,22 @@ static long createRingBuffer(dbCommon *pr);
 static long convertAi(aiRecord *pai, int pass);
 static long convertAo(aoRecord *pao, int pass);
 static void processCallbackInput(asynUser *pasynUser);
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser);
 static void processCallbackOutput(asynUser *pasynUser);
+static void processCallbackPipelined(devPvt *pPvt);
 static void outputCallbackCallback(CALLBACK *pcb);
 static int  getCallbackValue(devPvt *pPvt);
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsInt32 value);
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt);
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt);
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue);
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsInt32 value);
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
@@ -286,6 +307,21 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
     pPvt->int32Pvt = pasynInterface->drvPvt;
     scanIoInit(&pPvt->ioScanPvt);
     pPvt->interruptCallback = interruptCallback;
+    /* Records with asyn:COALESCE share the reads that are queued at the same time */
+    if ((processCallback == processCallbackInput) && pPvt->canBlock &&
+        devAsynCoalesceEnabled(pr)) {
+        pPvt->pCoalesce = devAsynCoalesceAttach(pr, pPvt->pasynUser,
+            pPvt->portName, pPvt->addr, pPvt->userParam, asynInt32Type, 0,
+            pPvt->pint32, pPvt->int32Pvt, readCoalesced);
+        pPvt->coalesceWaiter.done = coalesceDone;
+        pPvt->coalesceWaiter.userPvt = pPvt;
+    }
+    /* If the info field "asyn:PIPELINE" is 1 then output records on asynchronous ports
+     * complete without waiting for the write, see queuePipelinedWrite */
+    if ((processCallback == processCallbackOutput) && pPvt->canBlock) {
+        const char *pipelineString = asynDbGetInfo(pr, "asyn:PIPELINE");
+        if (pipelineString) pPvt->pipeline = atoi(pipelineString);
+    }
     /* Initialize synchronous interface */
     status = pasynInt32SyncIO->connect(pPvt->portName, pPvt->addr,
                  &pPvt->pasynUserSync, pPvt->userParam);
@@ -379,6 +415,16 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s registering interrupt\n",
             pr->name, driverName, functionName);
+        /* Records with asyn:SHARED_SCAN share one callback and one IOSCANPVT */
+        if ((pPvt->interruptCallback == interruptCallbackInput) &&
+            devAsynSharedScanEnabled(pr)) {
+            pPvt->pSharedScan = devAsynSharedScanAttach(pr, pPvt->pasynUser,
+                pPvt->portName, pPvt->addr, pPvt->userParam, asynInt32Type, 0,
+                pPvt->pint32, pPvt->int32Pvt, registerSharedScan, cancelSharedScan,
+                &pPvt->sharedScanSeq);
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            return 0;
+        }
         status = createRingBuffer(pr);
         /* Set a flag indicating that we are in I/O Intr scan mode. Used in aiAverage mode. */
          pPvt->isIOIntrScan = 1;
@@ -396,6 +442,12 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s cancelling interrupt\n",
              pr->name, driverName, functionName);
+        if (pPvt->pSharedScan) {
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            devAsynSharedScanDetach(pPvt->pSharedScan);
+            pPvt->pSharedScan = NULL;
+            return 0;
+        }
         /* Set a flag indicating that we are not in I/O Intr scan mode. Used in aiAverage mode. */
         pPvt->isIOIntrScan = 0;
         /* For aiAverage we don't disable callbacks here, because they are always enabled in any scan mode. */
@@ -472,16 +524,12 @@ static long convertAo(aoRecord *precord, int pass)
     return 0;
 }
 
-static void processCallbackInput(asynUser *pasynUser)
+/* Traces the result of a read and completes the record */
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser)
 {
-    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = (dbCommon *)pPvt->pr;
-    static const char *functionName="processCallbackInput";
+    static const char *functionName="processReadResult";
 
-    pPvt->result.status = pPvt->pint32->read(pPvt->int32Pvt, pPvt->pasynUser, &pPvt->result.value);
-    pPvt->result.time = pPvt->pasynUser->timestamp;
-    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
-    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
     if (pPvt->mask) {
         pPvt->result.value &= pPvt->mask;
         if (pPvt->bipolar && (pPvt->result.value & pPvt->signBit)) pPvt->result.value |= ~pPvt->mask;
@@ -501,12 +549,27 @@ static void processCallbackInput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackInput(asynUser *pasynUser)
+{
+    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
+
+    pPvt->result.status = pPvt->pint32->read(pPvt->int32Pvt, pPvt->pasynUser, &pPvt->result.value);
+    pPvt->result.time = pPvt->pasynUser->timestamp;
+    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
+    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = pPvt->pr;
     static const char *functionName="processCallbackOutput";
 
+    if (pPvt->pipeline) {
+        processCallbackPipelined(pPvt);
+        return;
+    }
     pPvt->result.status = pPvt->pint32->write(pPvt->int32Pvt, pPvt->pasynUser,pPvt->result.value);
     pPvt->result.time = pPvt->pasynUser->timestamp;
     pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
@@ -526,6 +589,92 @@ static void processCallbackOutput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackPipelined(devPvt *pPvt)
+{
+    dbCommon *pr = pPvt->pr;
+    asynUser *pasynUser = pPvt->pasynUser;
+    epicsInt32 value;
+    asynStatus status;
+    static const char *functionName="processCallbackPipelined";
+
+    /* Values written while this request was queued replaced pipelineValue,
+     * so only the most recent one is written */
+    epicsMutexLock(pPvt->devPvtLock);
+    value = pPvt->pipelineValue;
+    pPvt->writeQueued = 0;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pPvt->pint32->write(pPvt->int32Pvt, pasynUser, value);
+    if (status == asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+            "%s %s::%s process value %d\n", pr->name, driverName, functionName,
+            value);
+    } else {
+        epicsMutexLock(pPvt->devPvtLock);
+        pPvt->pipelineStatus = status;
+        epicsMutexUnlock(pPvt->devPvtLock);
+        if (status != pPvt->lastStatus) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s %s::%s process write error %s\n",
+                pr->name, driverName, functionName, pasynUser->errorMessage);
+        }
+    }
+    pPvt->lastStatus = status;
+}
+
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsInt32 value)
+{
+    devAsynScalarValue scalar;
+
+    scalar.int32 = value;
+    devAsynSharedScanPost((devAsynSharedScan *)userPvt, pasynUser, &scalar);
+}
+
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt)
+{
+    asynInt32 *pint32 = (asynInt32 *)pinterface;
+
+    return pint32->registerInterruptUser(drvPvt, pasynUser,
+        sharedScanCallback, pscan, registrarPvt);
+}
+
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt)
+{
+    asynInt32 *pint32 = (asynInt32 *)pinterface;
+
+    return pint32->cancelInterruptUser(drvPvt, pasynUser, registrarPvt);
+}
+
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue)
+{
+    asynInt32 *pint32 = (asynInt32 *)pinterface;
+
+    return pint32->read(drvPvt, pasynUser, &pvalue->int32);
+}
+
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+
+    pPvt->result.value = presult->value.int32;
+    pPvt->result.time = presult->time;
+    pPvt->result.status = presult->status;
+    pPvt->result.alarmStatus = presult->alarmStatus;
+    pPvt->result.alarmSeverity = presult->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    if (pPvt->pCoalesce)
+        return devAsynCoalesceQueue(pPvt->pCoalesce, &pPvt->coalesceWaiter, pPvt->pasynUser);
+    return pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+}
+
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsInt32 value)
 {
@@ -594,6 +743,11 @@ static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
         pr->name, driverName, functionName, value);
     if (!interruptAccept) return;
     epicsMutexLock(pPvt->devPvtLock);
+    if (pPvt->writeQueued) {
+        /* A newer value is queued to be written, so this readback is already stale */
+        epicsMutexUnlock(pPvt->devPvtLock);
+        return;
+    }
     rp = &pPvt->ringBuffer[pPvt->ringHead];
     rp->value = value;
     rp->time = pasynUser->timestamp;
@@ -770,6 +924,23 @@ static int getCallbackValue(devPvt *pPvt)
     int ret = 0;
     static const char *functionName="getCallbackValue";
 
+    if (pPvt->pSharedScan) {
+        devAsynSharedScanValue shared;
+
+        if (!devAsynSharedScanGet(pPvt->pSharedScan, &pPvt->sharedScanSeq, &shared)) return 0;
+        pPvt->result.value = shared.value.int32;
+        /* The mask is per record, so it is applied here rather than in the callback */
+        if (pPvt->mask) {
+            pPvt->result.value &= pPvt->mask;
+            if (pPvt->bipolar && (pPvt->result.value & pPvt->signBit))
+                pPvt->result.value |= ~pPvt->mask;
+        }
+        pPvt->result.time = shared.time;
+        pPvt->result.status = shared.status;
+        pPvt->result.alarmStatus = shared.alarmStatus;
+        pPvt->result.alarmSeverity = shared.alarmSeverity;
+        return 1;
+    }
     epicsMutexLock(pPvt->devPvtLock);
     if (pPvt->ringTail != pPvt->ringHead) {
         if (pPvt->ringBufferOverflows > 0) {
@@ -808,6 +979,32 @@ static void reportQueueRequestStatus(devPvt *pPvt, asynStatus status)
     }
 }
 
+/* Called with devPvtLock held.  The record completes without waiting for the write.
+ * If the previous write has not executed yet this value replaces it, so the port queue
+ * holds at most one write for the record.  Errors are reported the next time the record
+ * processes. */
+static void queuePipelinedWrite(devPvt *pPvt, epicsInt32 value)
+{
+    asynStatus status;
+    static const char *functionName="queuePipelinedWrite";
+
+    pPvt->pipelineValue = value;
+    pPvt->result.status = pPvt->pipelineStatus;
+    pPvt->pipelineStatus = asynSuccess;
+    if (pPvt->writeQueued) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
+            "%s %s::%s merged with queued write, value=%d\n",
+            pPvt->pr->name, driverName, functionName, value);
+        return;
+    }
+    pPvt->writeQueued = 1;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    epicsMutexLock(pPvt->devPvtLock);
+    if (status != asynSuccess) pPvt->writeQueued = 0;
+    reportQueueRequestStatus(pPvt, status);
+}
+
 
 static long initAi(aiRecord *pr)
 {
@@ -835,7 +1032,7 @@ static long processAi(aiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -993,6 +1190,8 @@ static long processAo(aoRecord *pr)
             pr->val = value;
             pr->udf = isnan(value);
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;
         if(pPvt->canBlock) {
@@ -1044,7 +1243,7 @@ static long processLi(longinRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -1097,6 +1296,8 @@ static long processLo(longoutRecord *pr)
         if (pPvt->result.status == asynSuccess) {
             pr->val = pPvt->result.value;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->val);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->val;
         if(pPvt->canBlock) {
@@ -1148,7 +1349,7 @@ static long processBi(biRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -1202,6 +1403,8 @@ static long processBo(boRecord *pr)
             pr->rval = pPvt->result.value;
             pr->val = (pr->rval) ? 1 : 0;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;
         if(pPvt->canBlock) {
@@ -1255,7 +1458,7 @@ static long processMbbi(mbbiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -1330,6 +1533,8 @@ static long processMbbo(mbboRecord *pr)
             }
             pr->udf = FALSE;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;
         if(pPvt->canBlock) {
@@ -39,11 +39,13 @@
 #include "asynDrvUser.h"
 #include "asynEpicsUtils.h"
 #include "asynInt32.h"
+#include "asynInt32Array.h"
 #include "devAsynXXXTimeSeries.h"
 
 /* The code for this driver is generated by the macro in the include file with macro substitution */
 
 ASYN_XXX_TIME_SERIES_FUNCS("devAsynInt32TimeSeries", asynInt32, asynInt32Type,
                             interruptCallbackInt32, epicsInt32, asynInt32TimeSeries,
-                            menuFtypeLONG, menuFtypeULONG)
+                            menuFtypeLONG, menuFtypeULONG,
+                            asynInt32Array, asynInt32ArrayType)
 
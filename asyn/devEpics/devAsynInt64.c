@@ -102,6 +102,14 @@ typedef struct devPvt{
     int               newOutputCallbackValue;
     int               numDeferredOutputCallbacks;
     IOSCANPVT         ioScanPvt;
+    devAsynSharedScan *pSharedScan;
+    unsigned int      sharedScanSeq;
+    devAsynCoalesce   *pCoalesce;
+    devAsynCoalesceWaiter coalesceWaiter;
+    int               pipeline;
+    int               writeQueued;
+    epicsInt64        pipelineValue;
+    asynStatus        pipelineStatus;
     char              *portName;
     char              *userParam;
     int               addr;
@@ -113,9 +121,22 @@ static long createRingBuffer(dbCommon *pr);
 static long convertAi(aiRecord *pai, int pass);
 static long convertAo(aoRecord *pao, int pass);
 static void processCallbackInput(asynUser *pasynUser);
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser);
 static void processCallbackOutput(asynUser *pasynUser);
+static void processCallbackPipelined(devPvt *pPvt);
 static void outputCallbackCallback(CALLBACK *pcb);
 static int  getCallbackValue(devPvt *pPvt);
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsInt64 value);
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt);
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt);
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue);
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsInt64 value);
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
@@ -242,6 +263,21 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
     pPvt->int64Pvt = pasynInterface->drvPvt;
     scanIoInit(&pPvt->ioScanPvt);
     pPvt->interruptCallback = interruptCallback;
+    /* Records with asyn:COALESCE share the reads that are queued at the same time */
+    if ((processCallback == processCallbackInput) && pPvt->canBlock &&
+        devAsynCoalesceEnabled(pr)) {
+        pPvt->pCoalesce = devAsynCoalesceAttach(pr, pPvt->pasynUser,
+            pPvt->portName, pPvt->addr, pPvt->userParam, asynInt64Type, 0,
+            pPvt->pint64, pPvt->int64Pvt, readCoalesced);
+        pPvt->coalesceWaiter.done = coalesceDone;
+        pPvt->coalesceWaiter.userPvt = pPvt;
+    }
+    /* If the info field "asyn:PIPELINE" is 1 then output records on asynchronous ports
+     * complete without waiting for the write, see queuePipelinedWrite */
+    if ((processCallback == processCallbackOutput) && pPvt->canBlock) {
+        const char *pipelineString = asynDbGetInfo(pr, "asyn:PIPELINE");
+        if (pipelineString) pPvt->pipeline = atoi(pipelineString);
+    }
     /* Initialize synchronous interface */
     status = pasynInt64SyncIO->connect(pPvt->portName, pPvt->addr,
                  &pPvt->pasynUserSync, pPvt->userParam);
@@ -307,6 +343,16 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s registering interrupt\n",
             pr->name, driverName, functionName);
+        /* Records with asyn:SHARED_SCAN share one callback and one IOSCANPVT */
+        if ((pPvt->interruptCallback == interruptCallbackInput) &&
+            devAsynSharedScanEnabled(pr)) {
+            pPvt->pSharedScan = devAsynSharedScanAttach(pr, pPvt->pasynUser,
+                pPvt->portName, pPvt->addr, pPvt->userParam, asynInt64Type, 0,
+                pPvt->pint64, pPvt->int64Pvt, registerSharedScan, cancelSharedScan,
+                &pPvt->sharedScanSeq);
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            return 0;
+        }
         status = createRingBuffer(pr);
         status = pPvt->pint64->registerInterruptUser(
            pPvt->int64Pvt,pPvt->pasynUser,
@@ -319,6 +365,12 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s canceling interrupt\n",
              pr->name, driverName, functionName);
+        if (pPvt->pSharedScan) {
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            devAsynSharedScanDetach(pPvt->pSharedScan);
+            pPvt->pSharedScan = NULL;
+            return 0;
+        }
         status = pPvt->pint64->cancelInterruptUser(pPvt->int64Pvt,
              pPvt->pasynUser,pPvt->registrarPvt);
         if(status!=asynSuccess) {
@@ -368,16 +420,12 @@ static long convertAo(aoRecord *precord, int pass)
     return 0;
 }
 
-static void processCallbackInput(asynUser *pasynUser)
+/* Traces the result of a read and completes the record */
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser)
 {
-    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = (dbCommon *)pPvt->pr;
-    static const char *functionName="processCallbackInput";
+    static const char *functionName="processReadResult";
 
-    pPvt->result.status = pPvt->pint64->read(pPvt->int64Pvt, pPvt->pasynUser, &pPvt->result.value);
-    pPvt->result.time = pPvt->pasynUser->timestamp;
-    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
-    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
     if (pPvt->result.status == asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
             "%s %s::%s process value=%lld\n",
@@ -393,12 +441,27 @@ static void processCallbackInput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackInput(asynUser *pasynUser)
+{
+    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
+
+    pPvt->result.status = pPvt->pint64->read(pPvt->int64Pvt, pPvt->pasynUser, &pPvt->result.value);
+    pPvt->result.time = pPvt->pasynUser->timestamp;
+    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
+    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = pPvt->pr;
     static const char *functionName="processCallbackOutput";
 
+    if (pPvt->pipeline) {
+        processCallbackPipelined(pPvt);
+        return;
+    }
     pPvt->result.status = pPvt->pint64->write(pPvt->int64Pvt, pPvt->pasynUser,pPvt->result.value);
     pPvt->result.time = pPvt->pasynUser->timestamp;
     pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
@@ -418,6 +481,92 @@ static void processCallbackOutput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackPipelined(devPvt *pPvt)
+{
+    dbCommon *pr = pPvt->pr;
+    asynUser *pasynUser = pPvt->pasynUser;
+    epicsInt64 value;
+    asynStatus status;
+    static const char *functionName="processCallbackPipelined";
+
+    /* Values written while this request was queued replaced pipelineValue,
+     * so only the most recent one is written */
+    epicsMutexLock(pPvt->devPvtLock);
+    value = pPvt->pipelineValue;
+    pPvt->writeQueued = 0;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pPvt->pint64->write(pPvt->int64Pvt, pasynUser, value);
+    if (status == asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+            "%s %s::%s process value %lld\n", pr->name, driverName, functionName,
+            (long long)value);
+    } else {
+        epicsMutexLock(pPvt->devPvtLock);
+        pPvt->pipelineStatus = status;
+        epicsMutexUnlock(pPvt->devPvtLock);
+        if (status != pPvt->lastStatus) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s %s::%s process write error %s\n",
+                pr->name, driverName, functionName, pasynUser->errorMessage);
+        }
+    }
+    pPvt->lastStatus = status;
+}
+
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsInt64 value)
+{
+    devAsynScalarValue scalar;
+
+    scalar.int64 = value;
+    devAsynSharedScanPost((devAsynSharedScan *)userPvt, pasynUser, &scalar);
+}
+
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt)
+{
+    asynInt64 *pint64 = (asynInt64 *)pinterface;
+
+    return pint64->registerInterruptUser(drvPvt, pasynUser,
+        sharedScanCallback, pscan, registrarPvt);
+}
+
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt)
+{
+    asynInt64 *pint64 = (asynInt64 *)pinterface;
+
+    return pint64->cancelInterruptUser(drvPvt, pasynUser, registrarPvt);
+}
+
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue)
+{
+    asynInt64 *pint64 = (asynInt64 *)pinterface;
+
+    return pint64->read(drvPvt, pasynUser, &pvalue->int64);
+}
+
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+
+    pPvt->result.value = presult->value.int64;
+    pPvt->result.time = presult->time;
+    pPvt->result.status = presult->status;
+    pPvt->result.alarmStatus = presult->alarmStatus;
+    pPvt->result.alarmSeverity = presult->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    if (pPvt->pCoalesce)
+        return devAsynCoalesceQueue(pPvt->pCoalesce, &pPvt->coalesceWaiter, pPvt->pasynUser);
+    return pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+}
+
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsInt64 value)
 {
@@ -478,6 +627,11 @@ static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
         pr->name, driverName, functionName, (long long)value);
     if (!interruptAccept) return;
     epicsMutexLock(pPvt->devPvtLock);
+    if (pPvt->writeQueued) {
+        /* A newer value is queued to be written, so this readback is already stale */
+        epicsMutexUnlock(pPvt->devPvtLock);
+        return;
+    }
     rp = &pPvt->ringBuffer[pPvt->ringHead];
     rp->value = value;
     rp->time = pasynUser->timestamp;
@@ -598,6 +752,17 @@ static int getCallbackValue(devPvt *pPvt)
     int ret = 0;
     static const char *functionName="getCallbackValue";
 
+    if (pPvt->pSharedScan) {
+        devAsynSharedScanValue shared;
+
+        if (!devAsynSharedScanGet(pPvt->pSharedScan, &pPvt->sharedScanSeq, &shared)) return 0;
+        pPvt->result.value = shared.value.int64;
+        pPvt->result.time = shared.time;
+        pPvt->result.status = shared.status;
+        pPvt->result.alarmStatus = shared.alarmStatus;
+        pPvt->result.alarmSeverity = shared.alarmSeverity;
+        return 1;
+    }
     epicsMutexLock(pPvt->devPvtLock);
     if (pPvt->ringTail != pPvt->ringHead) {
         if (pPvt->ringBufferOverflows > 0) {
@@ -636,6 +801,32 @@ static void reportQueueRequestStatus(devPvt *pPvt, asynStatus status)
     }
 }
 
+/* Called with devPvtLock held.  The record completes without waiting for the write.
+ * If the previous write has not executed yet this value replaces it, so the port queue
+ * holds at most one write for the record.  Errors are reported the next time the record
+ * processes. */
+static void queuePipelinedWrite(devPvt *pPvt, epicsInt64 value)
+{
+    asynStatus status;
+    static const char *functionName="queuePipelinedWrite";
+
+    pPvt->pipelineValue = value;
+    pPvt->result.status = pPvt->pipelineStatus;
+    pPvt->pipelineStatus = asynSuccess;
+    if (pPvt->writeQueued) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
+            "%s %s::%s merged with queued write, value=%lld\n",
+            pPvt->pr->name, driverName, functionName, (long long)value);
+        return;
+    }
+    pPvt->writeQueued = 1;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    epicsMutexLock(pPvt->devPvtLock);
+    if (status != asynSuccess) pPvt->writeQueued = 0;
+    reportQueueRequestStatus(pPvt, status);
+}
+
 #ifdef HAVE_DEVINT64
 static long initLLi(int64inRecord *pr)
 {
@@ -654,7 +845,7 @@ static long processLLi(int64inRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -706,6 +897,8 @@ static long processLLo(int64outRecord *pr)
         if (pPvt->result.status == asynSuccess) {
             pr->val = pPvt->result.value;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->val);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->val;
         if(pPvt->canBlock) {
@@ -765,7 +958,7 @@ static long processAi(aiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -906,6 +1099,8 @@ static long processAo(aoRecord *pr)
             pr->val = value;
             pr->udf = isnan(value);
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, (epicsInt64)pr->val);
     } else if(pr->pact == 0) {
         pPvt->result.value = (epicsInt64)pr->val;
         if(pPvt->canBlock) {
@@ -956,7 +1151,7 @@ static long processLi(longinRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -1008,6 +1203,8 @@ static long processLo(longoutRecord *pr)
         if (pPvt->result.status == asynSuccess) {
             pr->val = (epicsInt32)pPvt->result.value;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->val);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->val;
         if(pPvt->canBlock) {
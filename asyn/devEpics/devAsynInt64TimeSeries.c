@@ -39,11 +39,13 @@
 #include "asynDrvUser.h"
 #include "asynEpicsUtils.h"
 #include "asynInt64.h"
+#include "asynInt64Array.h"
 #include "devAsynXXXTimeSeries.h"
 
 /* The code for this driver is generated by the macro in the include file with macro substitution */
 
 ASYN_XXX_TIME_SERIES_FUNCS("devAsynInt64TimeSeries", asynInt64, asynInt64Type,
                             interruptCallbackInt64, epicsInt64, asynInt64TimeSeries,
-                            menuFtypeINT64, menuFtypeUINT64)
+                            menuFtypeINT64, menuFtypeUINT64,
+                            asynInt64Array, asynInt64ArrayType)
 
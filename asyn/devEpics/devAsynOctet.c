@@ -25,6 +25,13 @@
     asynSoOctetWrite,asynWfOctetWrite
         INP contains <drvUser> which is passed to asynDrvUser.create
         VAL is sent
+    asynWfOctetBlockRead
+        INP has an optional command string which is sent first.
+        An IEEE-488.2 definite length arbitrary block is read into the
+        waveform, which may have any numeric FTVL.  The info field
+        asyn:BLOCK_FORMAT gives the data type and byte order of the block,
+        for example "INT16" or "FLOAT32 LE".  It defaults to the FTVL type,
+        big endian.
 */
 
 #include <stdlib.h>
@@ -66,6 +73,7 @@
 #include "asynOctet.h"
 #include "asynOctetSyncIO.h"
 #include "asynEpicsUtils.h"
+#include "asynIEEE488Block.h"
 #include "devEpicsPvt.h"
 
 #define INIT_OK 0
@@ -113,6 +121,8 @@ typedef struct devPvt {
     epicsUInt32         nord;
     /* Following for writeRead */
     DBADDR              dbAddr;
+    /* Following for blockRead */
+    asynBlockFormat     blockFormat;
     /* Following are for I/O Intr*/
     CALLBACK            processCallback;
     CALLBACK            outputCallback;
@@ -163,6 +173,8 @@ static long initWfWrite(waveformRecord *pwf);
 static void callbackWfWrite(asynUser *pasynUser);
 static long initWfWriteBinary(waveformRecord *pwf);
 static void callbackWfWriteBinary(asynUser *pasynUser);
+static long initWfBlockRead(waveformRecord *pwf);
+static void callbackWfBlockRead(asynUser *pasynUser);
 
 #ifdef HAVE_LSREC
 static long initLsiCmdResponse(lsiRecord *plsi);
@@ -210,6 +222,8 @@ commonDset asynWfOctetWrite       = {
     5, 0, 0, (DEVSUPFUN)initWfWrite,        0,                      (DEVSUPFUN)processCommon};
 commonDset asynWfOctetWriteBinary = {
     5, 0, 0, (DEVSUPFUN)initWfWriteBinary,  0,                      (DEVSUPFUN)processCommon};
+commonDset asynWfOctetBlockRead   = {
+    5, 0, 0, (DEVSUPFUN)initWfBlockRead,    0,                      (DEVSUPFUN)processCommon};
 #ifdef HAVE_LSREC
 commonDset asynLsiOctetCmdResponse = {
     5, 0, 0, (DEVSUPFUN)initLsiCmdResponse, 0,                      (DEVSUPFUN)processCommon};
@@ -236,6 +250,7 @@ epicsExportAddress(dset, asynWfOctetWriteRead);
 epicsExportAddress(dset, asynWfOctetRead);
 epicsExportAddress(dset, asynWfOctetWrite);
 epicsExportAddress(dset, asynWfOctetWriteBinary);
+epicsExportAddress(dset, asynWfOctetBlockRead);
 #ifdef HAVE_LSREC
 epicsExportAddress(dset, asynLsiOctetCmdResponse);
 epicsExportAddress(dset, asynLsiOctetWriteRead);
@@ -1092,6 +1107,65 @@ static void callbackWfWriteBinary(asynUser *pasynUser)
     finish((dbCommon *)pwf);
 }
 
+static long initWfBlockRead(waveformRecord *pwf)
+{
+    devPvt     *pPvt;
+    int        status;
+    static const char *functionName="initWfBlockRead";
+
+    /* Not treated as a waveform by initCommon since FTVL need not be CHAR */
+    status = initCommon((dbCommon *)pwf, &pwf->inp, callbackWfBlockRead,
+                        0, 0, 0, pwf->bptr, NULL, pwf->nelm);
+    if (status != INIT_OK) return status;
+    pPvt = (devPvt *)pwf->dpvt;
+    if (asynIEEE488BlockParseFormat(pPvt->pasynUser,
+                asynDbGetInfo((dbCommon *)pwf, "asyn:BLOCK_FORMAT"),
+                pwf->ftvl, &pPvt->blockFormat) != asynSuccess) {
+        printf("%s %s::%s %s\n",
+               pwf->name, driverName, functionName, pPvt->pasynUser->errorMessage);
+        pwf->pact = 1;
+        recGblSetSevr(pwf,LINK_ALARM,INVALID_ALARM);
+        return INIT_ERROR;
+    }
+    if (pPvt->userParam && strlen(pPvt->userParam))
+        return initCmdBuffer(pPvt);
+    return INIT_OK;
+}
+
+static void callbackWfBlockRead(asynUser *pasynUser)
+{
+    devPvt         *pPvt = (devPvt *)pasynUser->userPvt;
+    waveformRecord *pwf = (waveformRecord *)pPvt->precord;
+    asynStatus     status = asynSuccess;
+    size_t         nElements;
+    static const char *functionName="callbackWfBlockRead";
+
+    if (pPvt->bufLen)
+        status = writeIt(pasynUser, pPvt->buffer, pPvt->bufLen);
+    if (status == asynSuccess) {
+        status = asynIEEE488BlockRead(pPvt->poctet, pPvt->octetPvt, pasynUser,
+                    &pPvt->blockFormat, pwf->bptr, pwf->ftvl, pwf->nelm, &nElements);
+        pPvt->result.status = status;
+        pPvt->result.time = pasynUser->timestamp;
+        pPvt->result.alarmStatus = pasynUser->alarmStatus;
+        pPvt->result.alarmSeverity = pasynUser->alarmSeverity;
+        pwf->time = pasynUser->timestamp;
+        if ((status == asynSuccess) || (status == asynOverflow)) {
+            pwf->udf = 0;
+            pwf->nord = (epicsUInt32)nElements;
+            asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+                "%s %s::%s read %lu elements\n",
+                pwf->name, driverName, functionName, (unsigned long)nElements);
+        }
+        if (status != asynSuccess) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s %s::%s failed %s\n",
+                pwf->name, driverName, functionName, pasynUser->errorMessage);
+        }
+    }
+    finish((dbCommon *)pwf);
+}
+
 #ifdef HAVE_LSREC
 
 static long initLsiCmdResponse(lsiRecord *plsi)
@@ -0,0 +1,144 @@
+/* devAsynSharedScan.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+    Shared I/O Intr scanning for scalar input records.
+
+    Normally every I/O Intr input record registers its own interrupt callback,
+    and each driver callback does a scanIoRequest for each record.
+    Records with info(asyn:SHARED_SCAN, "1") that use the same port, address,
+    drvInfo, interface and mask instead share a single interrupt callback,
+    a single value slot and a single IOSCANPVT.  One driver callback then
+    queues one scan that processes all of the records.
+    The shared slot only holds the most recent value, so these records do not use
+    the asyn:FIFO ring buffer.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <dbCommon.h>
+#include <dbScan.h>
+#include <dbAccess.h>
+
+#include "asynDriver.h"
+#include "devEpicsPvt.h"
+
+struct devAsynSharedScan {
+    devAsynGroup            group;     /* must be first */
+    asynUser                *pasynUser;
+    void                    *registrarPvt;
+    devAsynSharedScanCancel cancelUser;
+    IOSCANPVT               ioScanPvt;
+    epicsMutexId            lock;
+    int                     numRecords;
+    unsigned int            seq;
+    devAsynSharedScanValue  latest;
+};
+
+static devAsynGroupList sharedScanList = DEV_ASYN_GROUP_LIST_INIT;
+
+int devAsynSharedScanEnabled(struct dbCommon *prec)
+{
+    const char *sharedString = asynDbGetInfo(prec, "asyn:SHARED_SCAN");
+
+    return sharedString ? atoi(sharedString) : 0;
+}
+
+devAsynSharedScan *devAsynSharedScanAttach(struct dbCommon *prec, asynUser *pasynUser,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt,
+    devAsynSharedScanRegister registerUser, devAsynSharedScanCancel cancelUser,
+    unsigned int *pseq)
+{
+    devAsynSharedScan *pscan;
+    asynStatus status;
+    int created;
+
+    pscan = (devAsynSharedScan *)devAsynGroupFind(&sharedScanList, sizeof(*pscan),
+        portName, addr, userParam, interfaceType, mask, pinterface, drvPvt, &created);
+    if (created) {
+        /* The duplicate keeps the reason and drvUser of the record's asynUser */
+        pscan->pasynUser = pasynManager->duplicateAsynUser(pasynUser, 0, 0);
+        pscan->pasynUser->userPvt = pscan;
+        pscan->cancelUser = cancelUser;
+        pscan->lock = epicsMutexMustCreate();
+        scanIoInit(&pscan->ioScanPvt);
+    }
+    if (pscan->numRecords == 0) {
+        status = registerUser(pscan, pinterface, drvPvt, pscan->pasynUser, mask, &pscan->registrarPvt);
+        if (status != asynSuccess) {
+            printf("%s devAsynSharedScanAttach registerInterruptUser %s\n",
+                   prec->name, pscan->pasynUser->errorMessage);
+        }
+    }
+    pscan->numRecords++;
+    epicsMutexLock(pscan->lock);
+    *pseq = pscan->seq;
+    epicsMutexUnlock(pscan->lock);
+    devAsynGroupListUnlock(&sharedScanList);
+    return pscan;
+}
+
+void devAsynSharedScanDetach(devAsynSharedScan *pscan)
+{
+    asynStatus status;
+
+    /* The shared scan is never freed because dbScan still uses its IOSCANPVT */
+    devAsynGroupListLock(&sharedScanList);
+    if ((pscan->numRecords > 0) && (--pscan->numRecords == 0)) {
+        status = pscan->cancelUser(pscan->group.pinterface, pscan->group.drvPvt,
+                                   pscan->pasynUser, pscan->registrarPvt);
+        if (status != asynSuccess) {
+            printf("devAsynSharedScanDetach %s cancelInterruptUser %s\n",
+                   pscan->group.portName, pscan->pasynUser->errorMessage);
+        }
+    }
+    devAsynGroupListUnlock(&sharedScanList);
+}
+
+IOSCANPVT devAsynSharedScanIoScanPvt(devAsynSharedScan *pscan)
+{
+    return pscan->ioScanPvt;
+}
+
+void devAsynSharedScanPost(devAsynSharedScan *pscan, asynUser *pasynUser,
+    const devAsynScalarValue *pvalue)
+{
+    /* See interruptCallbackInput in devAsynInt32.c for why we return before interruptAccept */
+    if (!interruptAccept) return;
+    epicsMutexLock(pscan->lock);
+    pscan->latest.value = *pvalue;
+    pscan->latest.time = pasynUser->timestamp;
+    pscan->latest.status = pasynUser->auxStatus;
+    pscan->latest.alarmStatus = pasynUser->alarmStatus;
+    pscan->latest.alarmSeverity = pasynUser->alarmSeverity;
+    pscan->seq++;
+    epicsMutexUnlock(pscan->lock);
+    scanIoRequest(pscan->ioScanPvt);
+}
+
+/* Returns 1 and the latest value if it is newer than *pseq */
+int devAsynSharedScanGet(devAsynSharedScan *pscan, unsigned int *pseq,
+    devAsynSharedScanValue *presult)
+{
+    int ret = 0;
+
+    epicsMutexLock(pscan->lock);
+    if (pscan->seq != *pseq) {
+        *presult = pscan->latest;
+        *pseq = pscan->seq;
+        ret = 1;
+    }
+    epicsMutexUnlock(pscan->lock);
+    return ret;
+}
@@ -0,0 +1,761 @@
+/* devAsynTimeSeriesGroup.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+    Correlated multi-channel time series.
+
+    A group is created with asynTimeSeriesGroupConfigure.  Each waveform record
+    using one of the asynXXXTimeSeriesGroup device supports is a column of the group.
+    Columns receive values from asynInt32, asynInt64 or asynFloat64 interrupt callbacks
+    and hold the most recent value.  Each callback on the clock column adds one row,
+    i.e. the current value of every column plus the timestamp of the clock callback.
+    The asynTimeSeriesGroupTime waveform record controls acquisition with RARM and
+    publishes the timestamps of the rows relative to the trigger.
+*/
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <alarm.h>
+#include <recGbl.h>
+#include <dbAccess.h>
+#include <callback.h>
+#include <dbDefs.h>
+#include <link.h>
+#include <ellLib.h>
+#include <errlog.h>
+#include <epicsMutex.h>
+#include <epicsString.h>
+#include <epicsTime.h>
+#include <epicsStdioRedirect.h>
+#include <cantProceed.h>
+#include <iocsh.h>
+#include <dbCommon.h>
+#include <dbScan.h>
+#include <waveformRecord.h>
+#include <boRecord.h>
+#include <recSup.h>
+#include <devSup.h>
+#include <menuFtype.h>
+#include <dbEvent.h>
+
+#include <epicsExport.h>
+#include "asynDriver.h"
+#include "asynDrvUser.h"
+#include "asynEpicsUtils.h"
+#include "asynInt32.h"
+#include "asynInt64.h"
+#include "asynFloat64.h"
+#include "devEpicsPvt.h"
+#include "devAsynTimeSeriesGroup.h"
+
+static const char *driverName = "devAsynTimeSeriesGroup";
+
+typedef enum {
+    tsGroupIdle,
+    tsGroupArmed,       /* Keeping up to preTrigger rows, waiting for trigger */
+    tsGroupTriggered    /* Collecting post-trigger rows */
+} tsGroupState;
+
+static const char *tsGroupStateNames[] = {"idle", "armed", "triggered"};
+
+typedef enum {
+    tsColumnInt32,
+    tsColumnInt64,
+    tsColumnFloat64
+} tsColumnType;
+
+typedef union {
+    epicsInt32   int32Value;
+    epicsInt64   int64Value;
+    epicsFloat64 float64Value;
+} tsColumnValue;
+
+struct tsGroup;
+
+typedef struct tsColumn {
+    ELLNODE         node;
+    struct tsGroup  *pgroup;
+    dbCommon        *pr;
+    asynUser        *pasynUser;
+    tsColumnType    type;
+    void            *pInterface;
+    void            *ifacePvt;
+    void            *registrarPvt;
+    size_t          elementSize;
+    char            *data;          /* numPoints elements, indexed like the group ring */
+    tsColumnValue   latest;
+    int             numCallbacks;
+    asynStatus      status;
+    CALLBACK        callback;
+    char            *portName;
+    char            *userParam;
+    int             addr;
+} tsColumn;
+
+typedef struct tsGroup {
+    ELLNODE         node;
+    char            *name;
+    epicsMutexId    lock;
+    ELLLIST         columnList;
+    tsColumn        *pclock;
+    int             clockExplicit;
+    dbCommon        *ptimeRecord;
+    CALLBACK        timeCallback;
+    size_t          numPoints;
+    size_t          preTrigger;
+    int             decimation;
+    int             decimationCount;
+    tsGroupState    state;
+    epicsTimeStamp  *times;
+    size_t          head;           /* Ring index of the next row */
+    size_t          numRows;        /* Valid rows in the ring */
+    size_t          preRows;        /* Rows that were acquired before the trigger */
+    size_t          postRows;
+    size_t          postTarget;
+    int             numAcquisitions;
+    int             numTriggersIgnored;
+} tsGroup;
+
+/* Groups are created from the startup script before iocInit and never deleted,
+ * so the list itself does not need a lock */
+static ELLLIST tsGroupList = ELLLIST_INIT;
+
+typedef struct tsGroupDset {
+    long          number;
+    DEVSUPFUN     dev_report;
+    DEVSUPFUN     init;
+    DEVSUPFUN     init_record;
+    DEVSUPFUN     get_ioint_info;
+    DEVSUPFUN     process;
+} tsGroupDset;
+
+static long reportTime(int details);
+static long initTime(dbCommon *pr);
+static long processTime(dbCommon *pr);
+static long initInt32Column(dbCommon *pr);
+#ifdef HAVE_DEVINT64
+static long initInt64Column(dbCommon *pr);
+#endif
+static long initFloat64Column(dbCommon *pr);
+static long processColumn(dbCommon *pr);
+static long initTrigger(dbCommon *pr);
+static long processTrigger(dbCommon *pr);
+
+tsGroupDset asynTimeSeriesGroupTime = {
+    5, (DEVSUPFUN)reportTime, 0, (DEVSUPFUN)initTime, 0, (DEVSUPFUN)processTime};
+tsGroupDset asynInt32TimeSeriesGroup = {
+    5, 0, 0, (DEVSUPFUN)initInt32Column, 0, (DEVSUPFUN)processColumn};
+tsGroupDset asynFloat64TimeSeriesGroup = {
+    5, 0, 0, (DEVSUPFUN)initFloat64Column, 0, (DEVSUPFUN)processColumn};
+tsGroupDset asynTimeSeriesGroupTriggerBo = {
+    5, 0, 0, (DEVSUPFUN)initTrigger, 0, (DEVSUPFUN)processTrigger};
+
+epicsExportAddress(dset, asynTimeSeriesGroupTime);
+epicsExportAddress(dset, asynInt32TimeSeriesGroup);
+epicsExportAddress(dset, asynFloat64TimeSeriesGroup);
+epicsExportAddress(dset, asynTimeSeriesGroupTriggerBo);
+
+#ifdef HAVE_DEVINT64
+tsGroupDset asynInt64TimeSeriesGroup = {
+    5, 0, 0, (DEVSUPFUN)initInt64Column, 0, (DEVSUPFUN)processColumn};
+epicsExportAddress(dset, asynInt64TimeSeriesGroup);
+#endif
+
+static tsGroup *findGroup(const char *groupName)
+{
+    tsGroup *pgroup;
+
+    if (!groupName) return NULL;
+    for (pgroup = (tsGroup *)ellFirst(&tsGroupList); pgroup;
+         pgroup = (tsGroup *)ellNext(&pgroup->node)) {
+        if (strcmp(pgroup->name, groupName) == 0) return pgroup;
+    }
+    return NULL;
+}
+
+static tsGroup *findGroupFromLink(dbCommon *pr, DBLINK *plink)
+{
+    tsGroup *pgroup;
+    const char *groupName;
+
+    if (plink->type != INST_IO) {
+        errlogPrintf("%s %s link must be INST_IO\n", pr->name, driverName);
+        return NULL;
+    }
+    groupName = plink->value.instio.string;
+    while (*groupName == ' ') groupName++;
+    pgroup = findGroup(groupName);
+    if (!pgroup) {
+        errlogPrintf("%s %s group \"%s\" not found, call asynTimeSeriesGroupConfigure first\n",
+                     pr->name, driverName, groupName);
+    }
+    return pgroup;
+}
+
+/* Copies n elements of a ring of numPoints elements starting at ring index start */
+static void copyFromRing(void *pdest, const void *psrc, size_t elementSize,
+                         size_t start, size_t n, size_t numPoints)
+{
+    size_t first = numPoints - start;
+
+    if (first > n) first = n;
+    memcpy(pdest, (const char *)psrc + start*elementSize, first*elementSize);
+    if (n > first) {
+        memcpy((char *)pdest + first*elementSize, psrc, (n - first)*elementSize);
+    }
+}
+
+static size_t ringStart(tsGroup *pgroup)
+{
+    return (pgroup->head + pgroup->numPoints - pgroup->numRows) % pgroup->numPoints;
+}
+
+/* The following functions must be called with the group lock held */
+
+static void requestPublish(tsGroup *pgroup)
+{
+    tsColumn *pcol;
+
+    if (!interruptAccept) return;
+    if (pgroup->ptimeRecord) {
+        callbackRequestProcessCallback(&pgroup->timeCallback,
+                                       pgroup->ptimeRecord->prio, pgroup->ptimeRecord);
+    }
+    for (pcol = (tsColumn *)ellFirst(&pgroup->columnList); pcol;
+         pcol = (tsColumn *)ellNext(&pcol->node)) {
+        callbackRequestProcessCallback(&pcol->callback, pcol->pr->prio, pcol->pr);
+    }
+}
+
+static void finishAcquisition(tsGroup *pgroup)
+{
+    if (pgroup->state == tsGroupArmed) pgroup->preRows = pgroup->numRows;
+    pgroup->state = tsGroupIdle;
+    pgroup->numAcquisitions++;
+    requestPublish(pgroup);
+}
+
+static void triggerAcquisition(tsGroup *pgroup)
+{
+    pgroup->state = tsGroupTriggered;
+    pgroup->preRows = pgroup->numRows;
+    pgroup->postRows = 0;
+    pgroup->postTarget = pgroup->numPoints - pgroup->preRows;
+    if (pgroup->postTarget == 0) finishAcquisition(pgroup);
+}
+
+static void armAcquisition(tsGroup *pgroup, int clear)
+{
+    if (clear) {
+        pgroup->head = 0;
+        pgroup->numRows = 0;
+    }
+    pgroup->preRows = 0;
+    pgroup->decimationCount = 0;
+    if (pgroup->preTrigger > 0) {
+        if (pgroup->numRows > pgroup->preTrigger) pgroup->numRows = pgroup->preTrigger;
+        pgroup->state = tsGroupArmed;
+    } else {
+        triggerAcquisition(pgroup);
+    }
+}
+
+static void addRow(tsGroup *pgroup, epicsTimeStamp *ptime)
+{
+    tsColumn *pcol;
+    size_t row;
+
+    if (pgroup->state == tsGroupIdle) return;
+    if (++pgroup->decimationCount < pgroup->decimation) return;
+    pgroup->decimationCount = 0;
+    row = pgroup->head;
+    for (pcol = (tsColumn *)ellFirst(&pgroup->columnList); pcol;
+         pcol = (tsColumn *)ellNext(&pcol->node)) {
+        memcpy(pcol->data + row*pcol->elementSize, &pcol->latest, pcol->elementSize);
+    }
+    pgroup->times[row] = *ptime;
+    pgroup->head = (row + 1 == pgroup->numPoints) ? 0 : row + 1;
+    if (pgroup->numRows < pgroup->numPoints) pgroup->numRows++;
+    if (pgroup->state == tsGroupArmed) {
+        /* Only the most recent preTrigger rows are kept until the trigger arrives */
+        if (pgroup->numRows > pgroup->preTrigger) pgroup->numRows = pgroup->preTrigger;
+    } else if (++pgroup->postRows >= pgroup->postTarget) {
+        finishAcquisition(pgroup);
+    }
+}
+
+static void newValue(tsColumn *pcol, asynUser *pasynUser, const tsColumnValue *pvalue)
+{
+    tsGroup *pgroup = pcol->pgroup;
+    epicsTimeStamp timeStamp;
+
+    epicsMutexLock(pgroup->lock);
+    pcol->latest = *pvalue;
+    pcol->numCallbacks++;
+    if (pcol->status == asynSuccess) pcol->status = pasynUser->auxStatus;
+    if (pcol == pgroup->pclock) {
+        timeStamp = pasynUser->timestamp;
+        if ((timeStamp.secPastEpoch == 0) && (timeStamp.nsec == 0)) epicsTimeGetCurrent(&timeStamp);
+        addRow(pgroup, &timeStamp);
+    }
+    epicsMutexUnlock(pgroup->lock);
+}
+
+static void columnCallbackInt32(void *userPvt, asynUser *pasynUser, epicsInt32 value)
+{
+    tsColumnValue v;
+
+    v.int32Value = value;
+    newValue((tsColumn *)userPvt, pasynUser, &v);
+}
+
+static void columnCallbackInt64(void *userPvt, asynUser *pasynUser, epicsInt64 value)
+{
+    tsColumnValue v;
+
+    v.int64Value = value;
+    newValue((tsColumn *)userPvt, pasynUser, &v);
+}
+
+static void columnCallbackFloat64(void *userPvt, asynUser *pasynUser, epicsFloat64 value)
+{
+    tsColumnValue v;
+
+    v.float64Value = value;
+    newValue((tsColumn *)userPvt, pasynUser, &v);
+}
+
+static long initColumn(dbCommon *pr, tsColumnType type)
+{
+    waveformRecord *pwf = (waveformRecord *)pr;
+    tsColumn *pcol;
+    tsGroup *pgroup;
+    asynStatus status;
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+    const char *interfaceType;
+    const char *groupName;
+    const char *clockString;
+    int ftvlOK;
+    static const char *functionName = "initColumn";
+
+    pcol = callocMustSucceed(1, sizeof(*pcol), "devAsynTimeSeriesGroup::initColumn");
+    pr->dpvt = pcol;
+    pcol->pr = pr;
+    pcol->type = type;
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynUser->userPvt = pcol;
+    pcol->pasynUser = pasynUser;
+    switch (type) {
+      case tsColumnInt32:
+        interfaceType = asynInt32Type;
+        pcol->elementSize = sizeof(epicsInt32);
+        ftvlOK = (pwf->ftvl == menuFtypeLONG) || (pwf->ftvl == menuFtypeULONG);
+        break;
+#ifdef HAVE_DEVINT64
+      case tsColumnInt64:
+        interfaceType = asynInt64Type;
+        pcol->elementSize = sizeof(epicsInt64);
+        ftvlOK = (pwf->ftvl == menuFtypeINT64) || (pwf->ftvl == menuFtypeUINT64);
+        break;
+#endif
+      case tsColumnFloat64:
+        interfaceType = asynFloat64Type;
+        pcol->elementSize = sizeof(epicsFloat64);
+        ftvlOK = (pwf->ftvl == menuFtypeDOUBLE);
+        break;
+      default:
+        errlogPrintf("%s %s::%s unsupported column type %d\n",
+                     pr->name, driverName, functionName, type);
+        goto bad;
+    }
+    if (!ftvlOK) {
+        errlogPrintf("%s %s::%s FTVL does not match %s interface\n",
+                     pr->name, driverName, functionName, interfaceType);
+        goto bad;
+    }
+    groupName = asynDbGetInfo(pr, "asyn:TSGROUP");
+    pgroup = findGroup(groupName);
+    if (!pgroup) {
+        errlogPrintf("%s %s::%s info(asyn:TSGROUP) missing or group \"%s\" not configured\n",
+                     pr->name, driverName, functionName, groupName ? groupName : "");
+        goto bad;
+    }
+    pcol->pgroup = pgroup;
+    /* Parse the link to get addr and port */
+    status = pasynEpicsUtils->parseLink(pasynUser, &pwf->inp,
+                &pcol->portName, &pcol->addr, &pcol->userParam);
+    if (status != asynSuccess) {
+        errlogPrintf("%s %s::%s error in link %s\n",
+                     pr->name, driverName, functionName, pasynUser->errorMessage);
+        goto bad;
+    }
+    status = pasynManager->connectDevice(pasynUser, pcol->portName, pcol->addr);
+    if (status != asynSuccess) {
+        errlogPrintf("%s %s::%s connectDevice failed %s\n",
+                     pr->name, driverName, functionName, pasynUser->errorMessage);
+        goto bad;
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynDrvUserType, 1);
+    if (pasynInterface && pcol->userParam) {
+        asynDrvUser *pasynDrvUser;
+        void       *drvPvt;
+
+        pasynDrvUser = (asynDrvUser *)pasynInterface->pinterface;
+        drvPvt = pasynInterface->drvPvt;
+        status = pasynDrvUser->create(drvPvt, pasynUser, pcol->userParam, 0, 0);
+        if (status != asynSuccess) {
+            errlogPrintf("%s %s::%s drvUserCreate failed %s\n",
+                         pr->name, driverName, functionName, pasynUser->errorMessage);
+            goto bad;
+        }
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, interfaceType, 1);
+    if (!pasynInterface) {
+        errlogPrintf("%s %s::%s find %s interface failed %s\n",
+                     pr->name, driverName, functionName, interfaceType, pasynUser->errorMessage);
+        goto bad;
+    }
+    pcol->pInterface = pasynInterface->pinterface;
+    pcol->ifacePvt = pasynInterface->drvPvt;
+    pcol->data = callocMustSucceed(pgroup->numPoints, pcol->elementSize,
+                                   "devAsynTimeSeriesGroup::initColumn");
+
+    epicsMutexLock(pgroup->lock);
+    ellAdd(&pgroup->columnList, &pcol->node);
+    /* The first column becomes the clock unless a column has info(asyn:TSGROUP_CLOCK, "1") */
+    clockString = asynDbGetInfo(pr, "asyn:TSGROUP_CLOCK");
+    if (clockString && atoi(clockString)) {
+        if (pgroup->clockExplicit) {
+            errlogPrintf("%s %s::%s group %s already has clock column %s, ignoring\n",
+                         pr->name, driverName, functionName, pgroup->name, pgroup->pclock->pr->name);
+        } else {
+            pgroup->pclock = pcol;
+            pgroup->clockExplicit = 1;
+        }
+    } else if (!pgroup->pclock) {
+        pgroup->pclock = pcol;
+    }
+    epicsMutexUnlock(pgroup->lock);
+
+    /* Callbacks are enabled for the life of the record so that every column always
+     * holds its latest value when a row is added */
+    switch (type) {
+      case tsColumnInt32:
+        status = ((asynInt32 *)pcol->pInterface)->registerInterruptUser(
+            pcol->ifacePvt, pasynUser, columnCallbackInt32, pcol, &pcol->registrarPvt);
+        break;
+      case tsColumnInt64:
+        status = ((asynInt64 *)pcol->pInterface)->registerInterruptUser(
+            pcol->ifacePvt, pasynUser, columnCallbackInt64, pcol, &pcol->registrarPvt);
+        break;
+      case tsColumnFloat64:
+        status = ((asynFloat64 *)pcol->pInterface)->registerInterruptUser(
+            pcol->ifacePvt, pasynUser, columnCallbackFloat64, pcol, &pcol->registrarPvt);
+        break;
+    }
+    if (status != asynSuccess) {
+        errlogPrintf("%s %s::%s registerInterruptUser failed %s\n",
+                     pr->name, driverName, functionName, pasynUser->errorMessage);
+    }
+    return 0;
+bad:
+    recGblSetSevr(pr, LINK_ALARM, INVALID_ALARM);
+    pr->pact = 1;
+    return -1;
+}
+
+static long initInt32Column(dbCommon *pr)
+{
+    return initColumn(pr, tsColumnInt32);
+}
+
+#ifdef HAVE_DEVINT64
+static long initInt64Column(dbCommon *pr)
+{
+    return initColumn(pr, tsColumnInt64);
+}
+#endif
+
+static long initFloat64Column(dbCommon *pr)
+{
+    return initColumn(pr, tsColumnFloat64);
+}
+
+static long processColumn(dbCommon *pr)
+{
+    tsColumn *pcol = (tsColumn *)pr->dpvt;
+    tsGroup *pgroup = pcol->pgroup;
+    waveformRecord *pwf = (waveformRecord *)pr;
+    epicsUInt32 nord;
+    asynStatus status;
+    epicsAlarmCondition alarmStat;
+    epicsAlarmSeverity alarmSevr;
+
+    epicsMutexLock(pgroup->lock);
+    nord = (epicsUInt32)pgroup->numRows;
+    if (nord > pwf->nelm) nord = pwf->nelm;
+    copyFromRing(pwf->bptr, pcol->data, pcol->elementSize,
+                 ringStart(pgroup), nord, pgroup->numPoints);
+    status = pcol->status;
+    pcol->status = asynSuccess;
+    epicsMutexUnlock(pgroup->lock);
+    if (pwf->nord != nord) {
+        pwf->nord = nord;
+        db_post_events(pwf, &pwf->nord, DBE_VALUE | DBE_LOG);
+    }
+    pwf->udf = 0;
+    if (status != asynSuccess) {
+        pasynEpicsUtils->asynStatusToEpicsAlarm(status, READ_ALARM, &alarmStat,
+                                                INVALID_ALARM, &alarmSevr);
+        recGblSetSevr(pr, alarmStat, alarmSevr);
+    }
+    return 0;
+}
+
+static long initTime(dbCommon *pr)
+{
+    waveformRecord *pwf = (waveformRecord *)pr;
+    tsGroup *pgroup;
+
+    if (pwf->ftvl != menuFtypeDOUBLE) {
+        errlogPrintf("%s %s::initTime FTVL must be DOUBLE\n", pr->name, driverName);
+        goto bad;
+    }
+    pgroup = findGroupFromLink(pr, &pwf->inp);
+    if (!pgroup) goto bad;
+    if (pgroup->ptimeRecord) {
+        errlogPrintf("%s %s::initTime group %s already has time record %s\n",
+                     pr->name, driverName, pgroup->name, pgroup->ptimeRecord->name);
+        goto bad;
+    }
+    pgroup->ptimeRecord = pr;
+    pr->dpvt = pgroup;
+    return 0;
+bad:
+    recGblSetSevr(pr, LINK_ALARM, INVALID_ALARM);
+    pr->pact = 1;
+    return -1;
+}
+
+static long processTime(dbCommon *pr)
+{
+    tsGroup *pgroup = (tsGroup *)pr->dpvt;
+    waveformRecord *pwf = (waveformRecord *)pr;
+    epicsFloat64 *pData = (epicsFloat64 *)pwf->bptr;
+    epicsTimeStamp *pref;
+    size_t start, ref, i, n;
+    int busy;
+    tsColumn *pcol;
+
+    epicsMutexLock(pgroup->lock);
+    switch (pwf->rarm) {
+      case 1:
+        armAcquisition(pgroup, 1);
+        memset(pwf->bptr, 0, pwf->nelm*sizeof(epicsFloat64));
+        for (pcol = (tsColumn *)ellFirst(&pgroup->columnList); pcol;
+             pcol = (tsColumn *)ellNext(&pcol->node)) {
+            memset(pcol->data, 0, pgroup->numPoints*pcol->elementSize);
+        }
+        break;
+      case 2:
+        if (pgroup->state != tsGroupIdle) finishAcquisition(pgroup);
+        break;
+      case 3:
+        if (pgroup->state == tsGroupIdle) armAcquisition(pgroup, 0);
+        break;
+    }
+    pwf->rarm = 0;
+    busy = (pgroup->state != tsGroupIdle);
+    /* Times are relative to the first row after the trigger */
+    n = pgroup->numRows;
+    if (n > pwf->nelm) n = pwf->nelm;
+    if (n > 0) {
+        start = ringStart(pgroup);
+        ref = (pgroup->state == tsGroupArmed) ? pgroup->numRows : pgroup->preRows;
+        if (ref >= pgroup->numRows) ref = pgroup->numRows - 1;
+        pref = &pgroup->times[(start + ref) % pgroup->numPoints];
+        for (i=0; i<n; i++) {
+            pData[i] = epicsTimeDiffInSeconds(&pgroup->times[(start + i) % pgroup->numPoints], pref);
+        }
+    }
+    epicsMutexUnlock(pgroup->lock);
+    if (pwf->nord != n) {
+        pwf->nord = (epicsUInt32)n;
+        db_post_events(pwf, &pwf->nord, DBE_VALUE | DBE_LOG);
+    }
+    if (pwf->busy != busy) {
+        pwf->busy = busy;
+        db_post_events(pwf, &pwf->busy, DBE_VALUE | DBE_LOG);
+    }
+    pwf->udf = 0;
+    return 0;
+}
+
+static long reportTime(int details)
+{
+    tsGroup *pgroup;
+
+    for (pgroup = (tsGroup *)ellFirst(&tsGroupList); pgroup;
+         pgroup = (tsGroup *)ellNext(&pgroup->node)) {
+        asynTimeSeriesGroupReport(pgroup->name, details);
+    }
+    return 0;
+}
+
+static long initTrigger(dbCommon *pr)
+{
+    boRecord *pbo = (boRecord *)pr;
+    tsGroup *pgroup;
+
+    pgroup = findGroupFromLink(pr, &pbo->out);
+    if (!pgroup) {
+        recGblSetSevr(pr, LINK_ALARM, INVALID_ALARM);
+        pr->pact = 1;
+        return -1;
+    }
+    pr->dpvt = pgroup;
+    /* Do not convert */
+    return 2;
+}
+
+static long processTrigger(dbCommon *pr)
+{
+    boRecord *pbo = (boRecord *)pr;
+
+    if (pbo->val) asynTimeSeriesGroupTrigger(((tsGroup *)pr->dpvt)->name);
+    return 0;
+}
+
+int asynTimeSeriesGroupConfigure(const char *groupName, int numPoints,
+                                 int preTrigger, int decimation)
+{
+    tsGroup *pgroup;
+
+    if (!groupName || !*groupName) {
+        printf("asynTimeSeriesGroupConfigure: groupName must be specified\n");
+        return -1;
+    }
+    if (findGroup(groupName)) {
+        printf("asynTimeSeriesGroupConfigure: group %s already exists\n", groupName);
+        return -1;
+    }
+    if (numPoints <= 0) {
+        printf("asynTimeSeriesGroupConfigure: numPoints must be > 0\n");
+        return -1;
+    }
+    if ((preTrigger < 0) || (preTrigger >= numPoints)) {
+        printf("asynTimeSeriesGroupConfigure: preTrigger must be >= 0 and < numPoints\n");
+        return -1;
+    }
+    if (decimation < 1) decimation = 1;
+    pgroup = callocMustSucceed(1, sizeof(*pgroup), "asynTimeSeriesGroupConfigure");
+    pgroup->name = epicsStrDup(groupName);
+    pgroup->lock = epicsMutexMustCreate();
+    ellInit(&pgroup->columnList);
+    pgroup->numPoints = numPoints;
+    pgroup->preTrigger = preTrigger;
+    pgroup->decimation = decimation;
+    pgroup->state = tsGroupIdle;
+    pgroup->times = callocMustSucceed(numPoints, sizeof(*pgroup->times), "asynTimeSeriesGroupConfigure");
+    ellAdd(&tsGroupList, &pgroup->node);
+    return 0;
+}
+
+int asynTimeSeriesGroupTrigger(const char *groupName)
+{
+    tsGroup *pgroup = findGroup(groupName);
+
+    if (!pgroup) {
+        printf("asynTimeSeriesGroupTrigger: group %s not found\n", groupName ? groupName : "");
+        return -1;
+    }
+    epicsMutexLock(pgroup->lock);
+    if (pgroup->state == tsGroupArmed) {
+        triggerAcquisition(pgroup);
+    } else {
+        pgroup->numTriggersIgnored++;
+    }
+    epicsMutexUnlock(pgroup->lock);
+    return 0;
+}
+
+int asynTimeSeriesGroupReport(const char *groupName, int details)
+{
+    tsGroup *pgroup;
+    tsColumn *pcol;
+
+    for (pgroup = (tsGroup *)ellFirst(&tsGroupList); pgroup;
+         pgroup = (tsGroup *)ellNext(&pgroup->node)) {
+        if (groupName && *groupName && strcmp(groupName, pgroup->name)) continue;
+        epicsMutexLock(pgroup->lock);
+        printf("Time series group %s: state=%s numPoints=%lu preTrigger=%lu decimation=%d\n",
+               pgroup->name, tsGroupStateNames[pgroup->state],
+               (unsigned long)pgroup->numPoints, (unsigned long)pgroup->preTrigger,
+               pgroup->decimation);
+        printf("    columns=%d rows=%lu acquisitions=%d triggersIgnored=%d timeRecord=%s\n",
+               ellCount(&pgroup->columnList), (unsigned long)pgroup->numRows,
+               pgroup->numAcquisitions, pgroup->numTriggersIgnored,
+               pgroup->ptimeRecord ? pgroup->ptimeRecord->name : "(none)");
+        if (details > 0) {
+            for (pcol = (tsColumn *)ellFirst(&pgroup->columnList); pcol;
+                 pcol = (tsColumn *)ellNext(&pcol->node)) {
+                printf("    %s%s port=%s addr=%d drvInfo=%s callbacks=%d\n",
+                       pcol->pr->name, (pcol == pgroup->pclock) ? " (clock)" : "",
+                       pcol->portName, pcol->addr,
+                       pcol->userParam ? pcol->userParam : "", pcol->numCallbacks);
+            }
+        }
+        epicsMutexUnlock(pgroup->lock);
+    }
+    return 0;
+}
+
+static const iocshArg asynTimeSeriesGroupConfigureArg0 = {"groupName", iocshArgString};
+static const iocshArg asynTimeSeriesGroupConfigureArg1 = {"numPoints", iocshArgInt};
+static const iocshArg asynTimeSeriesGroupConfigureArg2 = {"preTrigger", iocshArgInt};
+static const iocshArg asynTimeSeriesGroupConfigureArg3 = {"decimation", iocshArgInt};
+static const iocshArg *const asynTimeSeriesGroupConfigureArgs[] = {
+    &asynTimeSeriesGroupConfigureArg0, &asynTimeSeriesGroupConfigureArg1,
+    &asynTimeSeriesGroupConfigureArg2, &asynTimeSeriesGroupConfigureArg3};
+static const iocshFuncDef asynTimeSeriesGroupConfigureDef =
+    {"asynTimeSeriesGroupConfigure", 4, asynTimeSeriesGroupConfigureArgs};
+static void asynTimeSeriesGroupConfigureCall(const iocshArgBuf * args) {
+    asynTimeSeriesGroupConfigure(args[0].sval, args[1].ival, args[2].ival, args[3].ival);
+}
+
+static const iocshArg asynTimeSeriesGroupTriggerArg0 = {"groupName", iocshArgString};
+static const iocshArg *const asynTimeSeriesGroupTriggerArgs[] = {
+    &asynTimeSeriesGroupTriggerArg0};
+static const iocshFuncDef asynTimeSeriesGroupTriggerDef =
+    {"asynTimeSeriesGroupTrigger", 1, asynTimeSeriesGroupTriggerArgs};
+static void asynTimeSeriesGroupTriggerCall(const iocshArgBuf * args) {
+    asynTimeSeriesGroupTrigger(args[0].sval);
+}
+
+static const iocshArg asynTimeSeriesGroupReportArg0 = {"groupName", iocshArgString};
+static const iocshArg asynTimeSeriesGroupReportArg1 = {"details", iocshArgInt};
+static const iocshArg *const asynTimeSeriesGroupReportArgs[] = {
+    &asynTimeSeriesGroupReportArg0, &asynTimeSeriesGroupReportArg1};
+static const iocshFuncDef asynTimeSeriesGroupReportDef =
+    {"asynTimeSeriesGroupReport", 2, asynTimeSeriesGroupReportArgs};
+static void asynTimeSeriesGroupReportCall(const iocshArgBuf * args) {
+    asynTimeSeriesGroupReport(args[0].sval, args[1].ival);
+}
+
+static void asynTimeSeriesGroupRegister(void)
+{
+    iocshRegister(&asynTimeSeriesGroupConfigureDef, asynTimeSeriesGroupConfigureCall);
+    iocshRegister(&asynTimeSeriesGroupTriggerDef, asynTimeSeriesGroupTriggerCall);
+    iocshRegister(&asynTimeSeriesGroupReportDef, asynTimeSeriesGroupReportCall);
+}
+epicsExportRegistrar(asynTimeSeriesGroupRegister);
@@ -0,0 +1,32 @@
+/* devAsynTimeSeriesGroup.h */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+#ifndef INCdevAsynTimeSeriesGroupH
+#define INCdevAsynTimeSeriesGroupH
+
+#include <asynAPI.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+ASYN_API int
+ asynTimeSeriesGroupConfigure(const char *groupName, int numPoints,
+                              int preTrigger, int decimation);
+ASYN_API int
+ asynTimeSeriesGroupTrigger(const char *groupName);
+ASYN_API int
+ asynTimeSeriesGroupReport(const char *groupName, int details);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*INCdevAsynTimeSeriesGroupH*/
@@ -97,6 +97,14 @@ typedef struct devPvt{
     int               numDeferredOutputCallbacks;
     int               asyncProcessingActive;
     IOSCANPVT         ioScanPvt;
+    devAsynSharedScan *pSharedScan;
+    unsigned int      sharedScanSeq;
+    devAsynCoalesce   *pCoalesce;
+    devAsynCoalesceWaiter coalesceWaiter;
+    int               pipeline;
+    int               writeQueued;
+    epicsUInt32       pipelineValue;
+    asynStatus        pipelineStatus;
     char              *portName;
     char              *userParam;
     int               addr;
@@ -114,9 +122,22 @@ static void setEnums(char *outStrings, int *outVals, epicsEnum16 *outSeverities,
 static long createRingBuffer(dbCommon *pr);
 static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt);
 static void processCallbackInput(asynUser *pasynUser);
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser);
 static void processCallbackOutput(asynUser *pasynUser);
+static void processCallbackPipelined(devPvt *pPvt);
 static void outputCallbackCallback(CALLBACK *pcb);
 static int  getCallbackValue(devPvt *pPvt);
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsUInt32 value);
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt);
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt);
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue);
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsUInt32 value);
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
@@ -249,6 +270,21 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
         goto bad;
     }
     pPvt->interruptCallback = interruptCallback;
+    /* Records with asyn:COALESCE share the reads that are queued at the same time */
+    if ((processCallback == processCallbackInput) && pPvt->canBlock &&
+        devAsynCoalesceEnabled(pr)) {
+        pPvt->pCoalesce = devAsynCoalesceAttach(pr, pPvt->pasynUser,
+            pPvt->portName, pPvt->addr, pPvt->userParam, asynUInt32DigitalType, pPvt->mask,
+            pPvt->puint32, pPvt->uint32Pvt, readCoalesced);
+        pPvt->coalesceWaiter.done = coalesceDone;
+        pPvt->coalesceWaiter.userPvt = pPvt;
+    }
+    /* If the info field "asyn:PIPELINE" is 1 then output records on asynchronous ports
+     * complete without waiting for the write, see queuePipelinedWrite */
+    if ((processCallback == processCallbackOutput) && pPvt->canBlock) {
+        const char *pipelineString = asynDbGetInfo(pr, "asyn:PIPELINE");
+        if (pipelineString) pPvt->pipeline = atoi(pipelineString);
+    }
     scanIoInit(&pPvt->ioScanPvt);
 
     /* Initialize asynEnum interfaces */
@@ -337,6 +373,16 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s registering interrupt\n",
             pr->name, driverName, functionName);
+        /* Records with asyn:SHARED_SCAN share one callback and one IOSCANPVT */
+        if ((pPvt->interruptCallback == interruptCallbackInput) &&
+            devAsynSharedScanEnabled(pr)) {
+            pPvt->pSharedScan = devAsynSharedScanAttach(pr, pPvt->pasynUser,
+                pPvt->portName, pPvt->addr, pPvt->userParam, asynUInt32DigitalType, pPvt->mask,
+                pPvt->puint32, pPvt->uint32Pvt, registerSharedScan, cancelSharedScan,
+                &pPvt->sharedScanSeq);
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            return 0;
+        }
         createRingBuffer(pr);
         status = pPvt->puint32->registerInterruptUser(
             pPvt->uint32Pvt,pPvt->pasynUser,
@@ -349,6 +395,12 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt)
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
             "%s %s::%s cancelling interrupt\n",
              pr->name, driverName, functionName);
+        if (pPvt->pSharedScan) {
+            *iopvt = devAsynSharedScanIoScanPvt(pPvt->pSharedScan);
+            devAsynSharedScanDetach(pPvt->pSharedScan);
+            pPvt->pSharedScan = NULL;
+            return 0;
+        }
         status = pPvt->puint32->cancelInterruptUser(pPvt->uint32Pvt,
              pPvt->pasynUser,pPvt->registrarPvt);
         if(status!=asynSuccess) {
@@ -382,17 +434,12 @@ static void setEnums(char *outStrings, int *outVals, epicsEnum16 *outSeverities,
     }
 }
 
-static void processCallbackInput(asynUser *pasynUser)
+/* Traces the result of a read and completes the record */
+static void processReadResult(devPvt *pPvt, asynUser *pasynUser)
 {
-    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = (dbCommon *)pPvt->pr;
-    static const char *functionName="processCallbackInput";
+    static const char *functionName="processReadResult";
 
-    pPvt->result.status = pPvt->puint32->read(pPvt->uint32Pvt, pPvt->pasynUser,
-        &pPvt->result.value,pPvt->mask);
-    pPvt->result.time = pPvt->pasynUser->timestamp;
-    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
-    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
     if (pPvt->result.status == asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
             "%s %s::%s process value=%u\n", pr->name, driverName, functionName,
@@ -408,12 +455,28 @@ static void processCallbackInput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackInput(asynUser *pasynUser)
+{
+    devPvt *pPvt = (devPvt *)pasynUser->userPvt;
+
+    pPvt->result.status = pPvt->puint32->read(pPvt->uint32Pvt, pPvt->pasynUser,
+        &pPvt->result.value,pPvt->mask);
+    pPvt->result.time = pPvt->pasynUser->timestamp;
+    pPvt->result.alarmStatus = pPvt->pasynUser->alarmStatus;
+    pPvt->result.alarmSeverity = pPvt->pasynUser->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
     dbCommon *pr = pPvt->pr;
     static const char *functionName="processCallbackOutput";
 
+    if (pPvt->pipeline) {
+        processCallbackPipelined(pPvt);
+        return;
+    }
     pPvt->result.status = pPvt->puint32->write(pPvt->uint32Pvt, pPvt->pasynUser,
         pPvt->result.value,pPvt->mask);
     pPvt->result.time = pPvt->pasynUser->timestamp;
@@ -434,6 +497,92 @@ static void processCallbackOutput(asynUser *pasynUser)
     if(pr->pact) callbackRequestProcessCallback(&pPvt->processCallback,pr->prio,pr);
 }
 
+static void processCallbackPipelined(devPvt *pPvt)
+{
+    dbCommon *pr = pPvt->pr;
+    asynUser *pasynUser = pPvt->pasynUser;
+    epicsUInt32 value;
+    asynStatus status;
+    static const char *functionName="processCallbackPipelined";
+
+    /* Values written while this request was queued replaced pipelineValue,
+     * so only the most recent one is written */
+    epicsMutexLock(pPvt->devPvtLock);
+    value = pPvt->pipelineValue;
+    pPvt->writeQueued = 0;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pPvt->puint32->write(pPvt->uint32Pvt, pasynUser, value, pPvt->mask);
+    if (status == asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+            "%s %s::%s process value %u\n", pr->name, driverName, functionName,
+            value);
+    } else {
+        epicsMutexLock(pPvt->devPvtLock);
+        pPvt->pipelineStatus = status;
+        epicsMutexUnlock(pPvt->devPvtLock);
+        if (status != pPvt->lastStatus) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s %s::%s process write error %s\n",
+                pr->name, driverName, functionName, pasynUser->errorMessage);
+        }
+    }
+    pPvt->lastStatus = status;
+}
+
+static void sharedScanCallback(void *userPvt, asynUser *pasynUser,
+                epicsUInt32 value)
+{
+    devAsynScalarValue scalar;
+
+    scalar.uint32 = value;
+    devAsynSharedScanPost((devAsynSharedScan *)userPvt, pasynUser, &scalar);
+}
+
+static asynStatus registerSharedScan(devAsynSharedScan *pscan, void *pinterface,
+                void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt)
+{
+    asynUInt32Digital *puint32 = (asynUInt32Digital *)pinterface;
+
+    return puint32->registerInterruptUser(drvPvt, pasynUser,
+        sharedScanCallback, pscan, mask, registrarPvt);
+}
+
+static asynStatus cancelSharedScan(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, void *registrarPvt)
+{
+    asynUInt32Digital *puint32 = (asynUInt32Digital *)pinterface;
+
+    return puint32->cancelInterruptUser(drvPvt, pasynUser, registrarPvt);
+}
+
+static asynStatus readCoalesced(void *pinterface, void *drvPvt,
+                asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue)
+{
+    asynUInt32Digital *puint32 = (asynUInt32Digital *)pinterface;
+
+    return puint32->read(drvPvt, pasynUser, &pvalue->uint32, mask);
+}
+
+static void coalesceDone(void *userPvt, asynUser *pasynUser,
+                const devAsynSharedScanValue *presult)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+
+    pPvt->result.value = presult->value.uint32;
+    pPvt->result.time = presult->time;
+    pPvt->result.status = presult->status;
+    pPvt->result.alarmStatus = presult->alarmStatus;
+    pPvt->result.alarmSeverity = presult->alarmSeverity;
+    processReadResult(pPvt, pasynUser);
+}
+
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    if (pPvt->pCoalesce)
+        return devAsynCoalesceQueue(pPvt->pCoalesce, &pPvt->coalesceWaiter, pPvt->pasynUser);
+    return pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+}
+
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsUInt32 value)
 {
@@ -494,6 +643,11 @@ static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,
         pr->name, driverName, functionName, value);
     if (!interruptAccept) return;
     epicsMutexLock(pPvt->devPvtLock);
+    if (pPvt->writeQueued) {
+        /* A newer value is queued to be written, so this readback is already stale */
+        epicsMutexUnlock(pPvt->devPvtLock);
+        return;
+    }
     rp = &pPvt->ringBuffer[pPvt->ringHead];
     rp->value = value;
     rp->time = pasynUser->timestamp;
@@ -605,6 +759,17 @@ static int getCallbackValue(devPvt *pPvt)
     int ret = 0;
     static const char *functionName="getCallbackValue";
 
+    if (pPvt->pSharedScan) {
+        devAsynSharedScanValue shared;
+
+        if (!devAsynSharedScanGet(pPvt->pSharedScan, &pPvt->sharedScanSeq, &shared)) return 0;
+        pPvt->result.value = shared.value.uint32;
+        pPvt->result.time = shared.time;
+        pPvt->result.status = shared.status;
+        pPvt->result.alarmStatus = shared.alarmStatus;
+        pPvt->result.alarmSeverity = shared.alarmSeverity;
+        return 1;
+    }
     epicsMutexLock(pPvt->devPvtLock);
     if (pPvt->ringTail != pPvt->ringHead) {
         if (pPvt->ringBufferOverflows > 0) {
@@ -654,6 +819,32 @@ static void reportQueueRequestStatus(devPvt *pPvt, asynStatus status)
     }
 }
 
+/* Called with devPvtLock held.  The record completes without waiting for the write.
+ * If the previous write has not executed yet this value replaces it, so the port queue
+ * holds at most one write for the record.  Errors are reported the next time the record
+ * processes. */
+static void queuePipelinedWrite(devPvt *pPvt, epicsUInt32 value)
+{
+    asynStatus status;
+    static const char *functionName="queuePipelinedWrite";
+
+    pPvt->pipelineValue = value;
+    pPvt->result.status = pPvt->pipelineStatus;
+    pPvt->pipelineStatus = asynSuccess;
+    if (pPvt->writeQueued) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
+            "%s %s::%s merged with queued write, value=%u\n",
+            pPvt->pr->name, driverName, functionName, value);
+        return;
+    }
+    pPvt->writeQueued = 1;
+    epicsMutexUnlock(pPvt->devPvtLock);
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    epicsMutexLock(pPvt->devPvtLock);
+    if (status != asynSuccess) pPvt->writeQueued = 0;
+    reportQueueRequestStatus(pPvt, status);
+}
+
 
 static long initBi(biRecord *pr)
 {
@@ -675,7 +866,7 @@ static long processBi(biRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -731,6 +922,8 @@ static long processBo(boRecord *pr)
             pr->rval = pPvt->result.value & pr->mask;
             pr->val = (pr->rval) ? 1 : 0;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;;
         if(pPvt->canBlock) {
@@ -782,7 +975,7 @@ static long processLi(longinRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -835,6 +1028,8 @@ static long processLo(longoutRecord *pr)
         if (pPvt->result.status == asynSuccess) {
             pr->val = pPvt->result.value & pPvt->mask;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->val & pPvt->mask);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->val & pPvt->mask;
         if(pPvt->canBlock) {
@@ -889,7 +1084,7 @@ static long processMbbi(mbbiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -963,6 +1158,8 @@ static long processMbbo(mbboRecord *pr)
             }
             pr->udf = FALSE;
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;
         if(pPvt->canBlock) {
@@ -1018,7 +1215,7 @@ static long processMbbiDirect(mbbiDirectRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         reportQueueRequestStatus(pPvt, status);
@@ -1092,6 +1289,8 @@ static long processMbboDirect(mbboDirectRecord *pr)
                 *bit = pr->val & offset;
             }
         }
+    } else if (pPvt->pipeline) {
+        queuePipelinedWrite(pPvt, pr->rval);
     } else if(pr->pact == 0) {
         pPvt->result.value = pr->rval;
         if(pPvt->canBlock) {
@@ -12,6 +12,11 @@
     30-Sept-2022
 */
 
+#include <cmath>
+#include <limits>
+#include <stdlib.h>
+#include <string.h>
+
 #include <alarm.h>
 #include <callback.h>
 #include <devSup.h>
@@ -51,6 +56,94 @@ static const char *driverName = "devAsynXXXArray";
 // We use an anonymous namespace to hide these definitions
 namespace {
 
+/* Conversion between the element type of the asyn interface and the FTVL of the record.
+ * record = native*scale + offset.  Values are clamped to the range of integer destinations,
+ * with or without scale and offset, and NaN becomes 0.
+ * The loops are kept simple so that the compiler can vectorize them. */
+typedef void (*convertFunc)(void *pDest, const void *pSrc, size_t n, double scale, double offset);
+
+template <typename DEST>
+inline DEST fromDouble(double value)
+{
+    if (std::numeric_limits<DEST>::is_integer) {
+        /* max()+1 is a power of 2 and exact as a double, max() itself may be rounded up */
+        const double limit = std::ldexp(1.0, std::numeric_limits<DEST>::digits);
+        if (value != value) return 0;
+        if (value <= (double)std::numeric_limits<DEST>::min()) return std::numeric_limits<DEST>::min();
+        if (value >= limit) return std::numeric_limits<DEST>::max();
+    }
+    return (DEST)value;
+}
+
+/* Integer to integer without a round trip through double, which is not exact for 64 bits */
+template <typename DEST, typename SRC, bool DEST_IS_INTEGER = std::numeric_limits<DEST>::is_integer>
+struct fromInteger {
+    static DEST convert(SRC value) { return (DEST)value; }
+};
+
+template <typename DEST, typename SRC>
+struct fromInteger<DEST, SRC, true> {
+    static DEST convert(SRC value)
+    {
+        typedef std::numeric_limits<DEST> destLimits;
+        typedef std::numeric_limits<SRC> srcLimits;
+
+        if (srcLimits::is_signed && (value < (SRC)0)) {
+            if (!destLimits::is_signed) return 0;
+            if ((srcLimits::digits > destLimits::digits) && (value < (SRC)destLimits::min()))
+                return destLimits::min();
+        } else if ((srcLimits::digits > destLimits::digits) && (value > (SRC)destLimits::max())) {
+            return destLimits::max();
+        }
+        return (DEST)value;
+    }
+};
+
+template <typename DEST, typename SRC>
+void convertKernel(void *pDest, const void *pSrc, size_t n, double scale, double offset)
+{
+    DEST *pd = (DEST *)pDest;
+    const SRC *ps = (const SRC *)pSrc;
+    size_t i;
+
+    if ((scale != 1.0) || (offset != 0.0)) {
+        for (i=0; i<n; i++) pd[i] = fromDouble<DEST>(ps[i]*scale + offset);
+    } else if (std::numeric_limits<SRC>::is_integer) {
+        for (i=0; i<n; i++) pd[i] = fromInteger<DEST, SRC>::convert(ps[i]);
+    } else {
+        for (i=0; i<n; i++) pd[i] = fromDouble<DEST>((double)ps[i]);
+    }
+}
+
+template <typename NATIVE, typename RECORD>
+size_t setConverters(convertFunc *pToRecord, convertFunc *pToNative)
+{
+    *pToRecord = convertKernel<RECORD, NATIVE>;
+    *pToNative = convertKernel<NATIVE, RECORD>;
+    return sizeof(RECORD);
+}
+
+/* Returns the size of the record element, 0 if the FTVL cannot be converted */
+template <typename NATIVE>
+size_t selectConverters(int ftvl, convertFunc *pToRecord, convertFunc *pToNative)
+{
+    switch (ftvl) {
+        case menuFtypeCHAR:   return setConverters<NATIVE, epicsInt8>(pToRecord, pToNative);
+        case menuFtypeUCHAR:  return setConverters<NATIVE, epicsUInt8>(pToRecord, pToNative);
+        case menuFtypeSHORT:  return setConverters<NATIVE, epicsInt16>(pToRecord, pToNative);
+        case menuFtypeUSHORT: return setConverters<NATIVE, epicsUInt16>(pToRecord, pToNative);
+        case menuFtypeLONG:   return setConverters<NATIVE, epicsInt32>(pToRecord, pToNative);
+        case menuFtypeULONG:  return setConverters<NATIVE, epicsUInt32>(pToRecord, pToNative);
+#ifdef HAVE_DEVINT64
+        case menuFtypeINT64:  return setConverters<NATIVE, epicsInt64>(pToRecord, pToNative);
+        case menuFtypeUINT64: return setConverters<NATIVE, epicsUInt64>(pToRecord, pToNative);
+#endif
+        case menuFtypeFLOAT:  return setConverters<NATIVE, epicsFloat32>(pToRecord, pToNative);
+        case menuFtypeDOUBLE: return setConverters<NATIVE, epicsFloat64>(pToRecord, pToNative);
+        default:              return 0;
+    }
+}
+
 template <typename RECORD_TYPE, typename INTERFACE, typename INTERRUPT, typename EPICS_TYPE>
 class devAsynXXXArray
 {
@@ -91,6 +184,19 @@ private:
     int                 signedType_;
     int                 unsignedType_;
     asynStatus          previousQueueRequestStatus_;
+    bool                convert_;
+    convertFunc         convertToRecord_;
+    convertFunc         convertToNative_;
+    size_t              recordElementSize_;
+    double              scale_;
+    double              offset_;
+    EPICS_TYPE          *convertBuffer_;
+    bool                pipeline_;
+    bool                writeQueued_;
+    EPICS_TYPE          *pipelineBuffer_;
+    EPICS_TYPE          *writeBuffer_;
+    size_t              pipelineLen_;
+    asynStatus          pipelineStatus_;
 
 public:
 
@@ -110,10 +216,25 @@ public:
         interfaceType_(epicsStrDup(interfaceType)),
         signedType_(signedType),
         unsignedType_(unsignedType),
-        previousQueueRequestStatus_(asynSuccess)
+        previousQueueRequestStatus_(asynSuccess),
+        convert_(false),
+        convertToRecord_(0),
+        convertToNative_(0),
+        recordElementSize_(sizeof(EPICS_TYPE)),
+        scale_(1.0),
+        offset_(0.0),
+        convertBuffer_(0),
+        pipeline_(false),
+        writeQueued_(false),
+        pipelineBuffer_(0),
+        writeBuffer_(0),
+        pipelineLen_(0),
+        pipelineStatus_(asynSuccess)
     {
         int status;
         asynInterface *pasynInterface;
+        const char *scaleString;
+        const char *offsetString;
 
         static const char *functionName = "devAsynXXXArray";
 
@@ -121,12 +242,30 @@ public:
         pasynUser_ = pasynManager->createAsynUser(qrCallback, 0);
         pasynUser_->userPvt = this;
         ringBufferLock_ = epicsMutexCreate();
-        /* This device support only supports signed and unsigned versions of the EPICS data type  */
-        if ((pRecord_->ftvl != this->signedType_) && (pRecord_->ftvl != this->unsignedType_)) {
-            errlogPrintf("%s::%s, %s field type must be SIGNED_TYPE or UNSIGNED_TYPE\n",
+        /* If FTVL is not the signed or unsigned version of the EPICS data type, or the info fields
+         * "asyn:SCALE" or "asyn:OFFSET" are present, then the data is converted in device support */
+        scaleString = asynDbGetInfo((dbCommon*)pRecord_, "asyn:SCALE");
+        if (scaleString) scale_ = atof(scaleString);
+        offsetString = asynDbGetInfo((dbCommon*)pRecord_, "asyn:OFFSET");
+        if (offsetString) offset_ = atof(offsetString);
+        if (scale_ == 0.0) {
+            errlogPrintf("%s::%s, %s asyn:SCALE must not be 0\n",
                          driverName, functionName, pRecord_->name);
             goto bad;
         }
+        if (((pRecord_->ftvl != this->signedType_) && (pRecord_->ftvl != this->unsignedType_)) ||
+            (scale_ != 1.0) || (offset_ != 0.0)) {
+            recordElementSize_ = selectConverters<EPICS_TYPE>(pRecord_->ftvl,
+                                                              &convertToRecord_, &convertToNative_);
+            if (recordElementSize_ == 0) {
+                errlogPrintf("%s::%s, %s field type %d cannot be converted to or from %s\n",
+                             driverName, functionName, pRecord_->name, pRecord_->ftvl, interfaceType);
+                goto bad;
+            }
+            convert_ = true;
+            convertBuffer_ = (EPICS_TYPE *)callocMustSucceed(pRecord_->nelm, sizeof(EPICS_TYPE),
+                                                             "devAsynXXXArray creating conversion buffer");
+        }
         /* Parse the link to get addr and port */
         status = pasynEpicsUtils->parseLink(pasynUser_, plink,
                     &portName_, &addr_, &userParam_);
@@ -186,12 +325,34 @@ public:
         scanIoInit(&ioScanPvt_);
         /* Determine if device can block */
         pasynManager->canBlock(pasynUser_, &canBlock_);
+        /* If this is an output record on an asynchronous port and the info field "asyn:PIPELINE" is 1
+         * then the record completes without waiting for the write, see queuePipelinedWrite */
+        if (isOutput_ && canBlock_) {
+            const char *pipelineString = asynDbGetInfo((dbCommon*)pRecord_, "asyn:PIPELINE");
+            if (pipelineString && atoi(pipelineString)) {
+                pipeline_ = true;
+                pipelineBuffer_ = (EPICS_TYPE *)callocMustSucceed(pRecord_->nelm, sizeof(EPICS_TYPE),
+                                                                  "devAsynXXXArray creating pipeline buffer");
+                writeBuffer_ = (EPICS_TYPE *)callocMustSucceed(pRecord_->nelm, sizeof(EPICS_TYPE),
+                                                               "devAsynXXXArray creating pipeline buffer");
+            }
+        }
         return;
     bad:
         recGblSetSevr(pRecord_, LINK_ALARM, INVALID_ALARM);
         pRecord_->pact=1;
     }
 
+    /* Copies native data from the driver into the record, converting if necessary */
+    void copyToRecord(const EPICS_TYPE *pValue, size_t len)
+    {
+        if (convert_) {
+            convertToRecord_(pRecord_->bptr, pValue, len, scale_, offset_);
+        } else {
+            memcpy(pRecord_->bptr, pValue, len*sizeof(EPICS_TYPE));
+        }
+    }
+
     long createRingBuffer()
     {
         int status;
@@ -279,6 +440,75 @@ public:
         }
     }
 
+    /* The record completes without waiting for the write.  If the previous write has not
+     * executed yet this array replaces it, so the port queue holds at most one write for the
+     * record.  Errors are reported the next time the record processes. */
+    void queuePipelinedWrite()
+    {
+        asynStatus status;
+        bool merged;
+        static const char *functionName = "queuePipelinedWrite";
+
+        epicsMutexLock(ringBufferLock_);
+        if (convert_) {
+            convertToNative_(pipelineBuffer_, pRecord_->bptr, pRecord_->nord, 1.0/scale_, -offset_/scale_);
+        } else {
+            memcpy(pipelineBuffer_, pRecord_->bptr, pRecord_->nord*sizeof(EPICS_TYPE));
+        }
+        pipelineLen_ = pRecord_->nord;
+        result_.status = pipelineStatus_;
+        pipelineStatus_ = asynSuccess;
+        merged = writeQueued_;
+        writeQueued_ = true;
+        epicsMutexUnlock(ringBufferLock_);
+        if (merged) {
+            asynPrint(pasynUser_, ASYN_TRACE_FLOW,
+                "%s %s::%s merged with queued write, nord=%d\n",
+                pRecord_->name, driverName, functionName, (int)pRecord_->nord);
+            return;
+        }
+        status = pasynManager->queueRequest(pasynUser_, asynQueuePriorityLow, 0);
+        if (status != asynSuccess) {
+            epicsMutexLock(ringBufferLock_);
+            writeQueued_ = false;
+            epicsMutexUnlock(ringBufferLock_);
+            result_.status = status;
+        }
+        reportQueueRequestStatus(status);
+    }
+
+    void processPipelinedWrite()
+    {
+        static const char *functionName = "processPipelinedWrite";
+        EPICS_TYPE *pTemp;
+        size_t len;
+        asynStatus status;
+
+        /* Swap the buffers so the record can queue the next array while this one is written */
+        epicsMutexLock(ringBufferLock_);
+        pTemp = writeBuffer_;
+        writeBuffer_ = pipelineBuffer_;
+        pipelineBuffer_ = pTemp;
+        len = pipelineLen_;
+        writeQueued_ = false;
+        epicsMutexUnlock(ringBufferLock_);
+        status = pInterface_->write(pInterfacePvt_, pasynUser_, writeBuffer_, len);
+        if (status == asynSuccess) {
+            asynPrint(pasynUser_, ASYN_TRACEIO_DEVICE,
+                "%s %s::%s OK\n", pRecord_->name, driverName, functionName);
+        } else {
+            epicsMutexLock(ringBufferLock_);
+            pipelineStatus_ = status;
+            epicsMutexUnlock(ringBufferLock_);
+            if (status != lastStatus_) {
+                asynPrint(pasynUser_, ASYN_TRACE_ERROR,
+                    "%s %s::%s write error %s\n",
+                    pRecord_->name, driverName, functionName, pasynUser_->errorMessage);
+            }
+        }
+        lastStatus_ = status;
+    }
+
     long process()
     {
         int newInputData;
@@ -290,7 +520,9 @@ public:
         } else {
             newInputData = getRingBufferValue();
         }
-        if (!newInputData && !pRecord_->pact) {   /* This is an initial call from record */
+        if (!newInputData && pipeline_) {
+            queuePipelinedWrite();
+        } else if (!newInputData && !pRecord_->pact) {   /* This is an initial call from record */
             if(canBlock_) pRecord_->pact = 1;
             status = pasynManager->queueRequest(pasynUser_, asynQueuePriorityLow, 0);
             if ((status == asynSuccess) && canBlock_) return 0;
@@ -309,18 +541,16 @@ public:
                 }
             } else {
                 /* Copy data from ring buffer */
-                EPICS_TYPE *pData = (EPICS_TYPE *)pRecord_->bptr;
                 ringBufferElement *rp = &result_;
-                int i;
                 /* Need to copy the array with the lock because that is shared even though
                    result_ is a copy */
                 if (rp->status == asynSuccess) {
                     epicsMutexLock(ringBufferLock_);
-                    for (i=0; i<(int)rp->len; i++) pData[i] = rp->pValue[i];
+                    copyToRecord(rp->pValue, rp->len);
                     epicsMutexUnlock(ringBufferLock_);
                     pRecord_->nord = (epicsUInt32)rp->len;
                     asynPrintIO(pasynUser_, ASYN_TRACEIO_DEVICE,
-                        (char *)pRecord_->bptr, pRecord_->nord*sizeof(EPICS_TYPE),
+                        (char *)pRecord_->bptr, pRecord_->nord*recordElementSize_,
                         "%s %s::%s nord=%d, pRecord_->bptr data:",
                         pRecord_->name, driverName, driverName, pRecord_->nord);
                 }
@@ -345,12 +575,22 @@ public:
         static const char *functionName = "queueRequestCallback";
         size_t nread;
 
+        if (pipeline_) {
+            processPipelinedWrite();
+            return;
+        }
         if (isOutput_) {
-            result_.status = pInterface_->write(pInterfacePvt_, pasynUser_,
-                                                (EPICS_TYPE *) pRecord_->bptr, pRecord_->nord);
+            EPICS_TYPE *pValue = (EPICS_TYPE *) pRecord_->bptr;
+            if (convert_) {
+                convertToNative_(convertBuffer_, pRecord_->bptr, pRecord_->nord, 1.0/scale_, -offset_/scale_);
+                pValue = convertBuffer_;
+            }
+            result_.status = pInterface_->write(pInterfacePvt_, pasynUser_, pValue, pRecord_->nord);
         } else {
-            result_.status = pInterface_->read(pInterfacePvt_, pasynUser_, (EPICS_TYPE *) pRecord_->bptr,
+            EPICS_TYPE *pValue = convert_ ? convertBuffer_ : (EPICS_TYPE *) pRecord_->bptr;
+            result_.status = pInterface_->read(pInterfacePvt_, pasynUser_, pValue,
                                                pRecord_->nelm, &nread);
+            if (convert_ && (result_.status == asynSuccess)) copyToRecord(pValue, nread);
         }
         result_.time = pasynUser_->timestamp;
         result_.alarmStatus = (epicsAlarmCondition) pasynUser_->alarmStatus;
@@ -396,8 +636,6 @@ public:
 
     void interruptCallback(asynUser *pasynUser, EPICS_TYPE *value, size_t len)
     {
-        int i;
-        EPICS_TYPE *pData = (EPICS_TYPE *)pRecord_->bptr;
         static const char *functionName = "interruptCallback";
 
         asynPrintIO(pasynUser_, ASYN_TRACEIO_DEVICE,
@@ -409,12 +647,20 @@ public:
          * read will do a read from the driver, which should be OK. */
         if (!interruptAccept) return;
 
+        if (pipeline_) {
+            bool stale;
+            epicsMutexLock(ringBufferLock_);
+            stale = writeQueued_;
+            epicsMutexUnlock(ringBufferLock_);
+            /* A newer array is queued to be written, so this readback is already stale */
+            if (stale) return;
+        }
         if (ringSize_ == 0) {
             /* Not using a ring buffer */
             dbScanLock((dbCommon *)pRecord_);
             if (len > pRecord_->nelm) len = pRecord_->nelm;
             if (pasynUser->auxStatus == asynSuccess) {
-                for (i=0; i<(int)len; i++) pData[i] = value[i];
+                copyToRecord(value, len);
                 pRecord_->nord = (epicsUInt32)len;
             }
             pRecord_->time = pasynUser->timestamp;
@@ -434,7 +680,7 @@ public:
             rp = &ringBuffer_[ringHead_];
             if (len > pRecord_->nelm) len = pRecord_->nelm;
             rp->len = len;
-            for (i=0; i<(int)len; i++) rp->pValue[i] = value[i];
+            memcpy(rp->pValue, value, len*sizeof(EPICS_TYPE));
             rp->time = pasynUser->timestamp;
             rp->status = (asynStatus) pasynUser->auxStatus;
             rp->alarmStatus = (epicsAlarmCondition) pasynUser->alarmStatus;
@@ -1,6 +1,7 @@
 #define ASYN_XXX_TIME_SERIES_FUNCS(DRIVER_NAME, INTERFACE, INTERFACE_TYPE, \
                                    INTERRUPT, EPICS_TYPE, DSET, \
-                                   SIGNED_TYPE, UNSIGNED_TYPE) \
+                                   SIGNED_TYPE, UNSIGNED_TYPE, \
+                                   ARRAY_INTERFACE, ARRAY_INTERFACE_TYPE) \
 /* devAsynXXXTimeSeries.h */ \
 /*********************************************************************** \
 * Copyright (c) 2002 The University of Chicago, as Operator of Argonne \
@@ -22,6 +23,9 @@ typedef struct devAsynWfPvt{ \
     INTERFACE       *pInterface; \
     void            *ifacePvt; \
     void            *registrarPvt; \
+    ARRAY_INTERFACE *pArrayInterface; \
+    void            *arrayIfacePvt; \
+    void            *arrayRegistrarPvt; \
     CALLBACK        callback; \
     int             busy; \
     epicsUInt32     nord; \
@@ -36,6 +40,8 @@ static long initRecord(dbCommon *pr); \
 static long process(dbCommon *pr); \
 static void interruptCallback(void *drvPvt, asynUser *pasynUser,  \
                 EPICS_TYPE value); \
+static void interruptCallbackArray(void *drvPvt, asynUser *pasynUser,  \
+                EPICS_TYPE *value, size_t nelements); \
  \
 typedef struct analogDset { /* analog  dset */ \
     long        number; \
@@ -105,15 +111,24 @@ static long initRecord(dbCommon *pr) \
             goto bad; \
         } \
     } \
+    /* The driver can append one value per callback on the scalar interface, \
+     * a block of values per callback on the array interface, or both */ \
     pasynInterface = pasynManager->findInterface(pasynUser,INTERFACE_TYPE,1); \
-    if(!pasynInterface) { \
+    if(pasynInterface) { \
+        pPvt->pInterface = pasynInterface->pinterface; \
+        pPvt->ifacePvt = pasynInterface->drvPvt; \
+    } \
+    pasynInterface = pasynManager->findInterface(pasynUser,ARRAY_INTERFACE_TYPE,1); \
+    if(pasynInterface) { \
+        pPvt->pArrayInterface = pasynInterface->pinterface; \
+        pPvt->arrayIfacePvt = pasynInterface->drvPvt; \
+    } \
+    if(!pPvt->pInterface && !pPvt->pArrayInterface) { \
         errlogPrintf( \
-            "%s::initCommon, %s find %s interface failed %s\n", \
-            driverName, pr->name, INTERFACE_TYPE,pasynUser->errorMessage); \
+            "%s::initCommon, %s find %s or %s interface failed %s\n", \
+            driverName, pr->name, INTERFACE_TYPE, ARRAY_INTERFACE_TYPE, pasynUser->errorMessage); \
         goto bad; \
     } \
-    pPvt->pInterface = pasynInterface->pinterface; \
-    pPvt->ifacePvt = pasynInterface->drvPvt; \
     return 0; \
 bad: \
    pr->pact=1; \
@@ -156,22 +171,45 @@ static long process(dbCommon *pr) \
       db_post_events(pwf, &pwf->busy, DBE_VALUE | DBE_LOG); \
       /* BUSY has changed state so either register or cancel callbacks */ \
       if (busy) { \
-        status = pPvt->pInterface->registerInterruptUser( \
-           pPvt->ifacePvt, pPvt->pasynUser, \
-           interruptCallback, pPvt, &pPvt->registrarPvt); \
-        if(status!=asynSuccess) { \
-            asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
-                "%s %s registerInterruptUser %s\n", \
-                pr->name, driverName, pPvt->pasynUser->errorMessage); \
+        if (pPvt->pInterface) { \
+          status = pPvt->pInterface->registerInterruptUser( \
+             pPvt->ifacePvt, pPvt->pasynUser, \
+             interruptCallback, pPvt, &pPvt->registrarPvt); \
+          if(status!=asynSuccess) { \
+              asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
+                  "%s %s registerInterruptUser %s\n", \
+                  pr->name, driverName, pPvt->pasynUser->errorMessage); \
+          } \
+        } \
+        if (pPvt->pArrayInterface) { \
+          status = pPvt->pArrayInterface->registerInterruptUser( \
+             pPvt->arrayIfacePvt, pPvt->pasynUser, \
+             interruptCallbackArray, pPvt, &pPvt->arrayRegistrarPvt); \
+          if(status!=asynSuccess) { \
+              asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
+                  "%s %s registerInterruptUser array %s\n", \
+                  pr->name, driverName, pPvt->pasynUser->errorMessage); \
+          } \
         } \
       } \
       else {\
-        status = pPvt->pInterface->cancelInterruptUser( \
-           pPvt->ifacePvt, pPvt->pasynUser, pPvt->registrarPvt); \
-        if(status!=asynSuccess) { \
-            asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
-                "%s %s cancelInterruptUser %s\n", \
-                pr->name, driverName, pPvt->pasynUser->errorMessage); \
+        if (pPvt->pInterface) { \
+          status = pPvt->pInterface->cancelInterruptUser( \
+             pPvt->ifacePvt, pPvt->pasynUser, pPvt->registrarPvt); \
+          if(status!=asynSuccess) { \
+              asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
+                  "%s %s cancelInterruptUser %s\n", \
+                  pr->name, driverName, pPvt->pasynUser->errorMessage); \
+          } \
+        } \
+        if (pPvt->pArrayInterface) { \
+          status = pPvt->pArrayInterface->cancelInterruptUser( \
+             pPvt->arrayIfacePvt, pPvt->pasynUser, pPvt->arrayRegistrarPvt); \
+          if(status!=asynSuccess) { \
+              asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR, \
+                  "%s %s cancelInterruptUser array %s\n", \
+                  pr->name, driverName, pPvt->pasynUser->errorMessage); \
+          } \
         } \
       } \
     } \
@@ -213,4 +251,32 @@ static void interruptCallback(void *drvPvt, asynUser *pasynUser, EPICS_TYPE valu
     if (pPvt->status == asynSuccess) pPvt->status = pasynUser->auxStatus; \
     epicsMutexUnlock(pPvt->lock); \
 } \
+ \
+static void interruptCallbackArray(void *drvPvt, asynUser *pasynUser, \
+                EPICS_TYPE *value, size_t nelements) \
+{ \
+    devAsynWfPvt *pPvt = (devAsynWfPvt *)drvPvt; \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    EPICS_TYPE *pData = (EPICS_TYPE *)pwf->bptr; \
+    size_t nCopy; \
+ \
+    epicsMutexLock(pPvt->lock); \
+    asynPrint(pPvt->pasynUser, ASYN_TRACEIO_DEVICE, \
+        "%s %s::interruptCallbackArray, nelements=%lu, nord=%d\n", \
+        pwf->name, driverName, (unsigned long)nelements, pPvt->nord); \
+    /* Append the whole block with a single copy. \
+     * As with scalar callbacks acquisition completes when a value does not fit. */ \
+    if (pPvt->busy) { \
+      nCopy = pwf->nelm - pPvt->nord; \
+      if (nCopy > nelements) nCopy = nelements; \
+      memcpy(&pData[pPvt->nord], value, nCopy*sizeof(EPICS_TYPE)); \
+      pPvt->nord += (epicsUInt32)nCopy; \
+      if (nCopy < nelements) { \
+        pPvt->busy = 0; \
+        callbackRequestProcessCallback(&pPvt->callback,pwf->prio,pwf); \
+      } \
+    } \
+    if (pPvt->status == asynSuccess) pPvt->status = pasynUser->auxStatus; \
+    epicsMutexUnlock(pPvt->lock); \
+} \
 
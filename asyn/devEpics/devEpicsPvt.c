@@ -4,11 +4,16 @@
 * found in file LICENSE that is included with this distribution.
 ***********************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <epicsAssert.h>
 
 #include <epicsVersion.h>
 #include <dbStaticLib.h>
 #include <dbAccess.h>
+#include <cantProceed.h>
+#include <epicsString.h>
 
 #include <asynDriver.h>
 #include "devEpicsPvt.h"
@@ -34,3 +39,57 @@ const char* asynDbGetInfo(struct dbCommon *prec, const char *infoname)
     dbFinishEntry(&ent);
     return ret;
 }
+
+static int sameString(const char *s1, const char *s2)
+{
+    if (!s1) s1 = "";
+    if (!s2) s2 = "";
+    return strcmp(s1, s2) == 0;
+}
+
+static void groupListInit(void *arg)
+{
+    devAsynGroupList *plist = (devAsynGroupList *)arg;
+
+    plist->lock = epicsMutexMustCreate();
+}
+
+void devAsynGroupListLock(devAsynGroupList *plist)
+{
+    epicsThreadOnce(&plist->onceId, groupListInit, plist);
+    epicsMutexMustLock(plist->lock);
+}
+
+void devAsynGroupListUnlock(devAsynGroupList *plist)
+{
+    epicsMutexUnlock(plist->lock);
+}
+
+devAsynGroup *devAsynGroupFind(devAsynGroupList *plist, size_t size,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt, int *pcreated)
+{
+    devAsynGroup *pgroup;
+
+    devAsynGroupListLock(plist);
+    *pcreated = 0;
+    for (pgroup = (devAsynGroup *)ellFirst(&plist->list); pgroup;
+         pgroup = (devAsynGroup *)ellNext(&pgroup->node)) {
+        if ((pgroup->addr == addr) && (pgroup->mask == mask) &&
+            (pgroup->pinterface == pinterface) && (pgroup->drvPvt == drvPvt) &&
+            sameString(pgroup->portName, portName) &&
+            sameString(pgroup->userParam, userParam) &&
+            sameString(pgroup->interfaceType, interfaceType)) return pgroup;
+    }
+    pgroup = callocMustSucceed(1, size, "devAsynGroupFind");
+    pgroup->portName = epicsStrDup(portName);
+    pgroup->addr = addr;
+    pgroup->userParam = epicsStrDup(userParam ? userParam : "");
+    pgroup->interfaceType = epicsStrDup(interfaceType);
+    pgroup->mask = mask;
+    pgroup->pinterface = pinterface;
+    pgroup->drvPvt = drvPvt;
+    ellAdd(&plist->list, &pgroup->node);
+    *pcreated = 1;
+    return pgroup;
+}
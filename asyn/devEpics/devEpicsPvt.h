@@ -7,6 +7,14 @@
 #ifndef DEVEPICSPVT_H
 #define DEVEPICSPVT_H
 
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <dbScan.h>
+#include <alarm.h>
+#include <asynDriver.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +23,100 @@ struct dbCommon;
 
 const char* asynDbGetInfo(struct dbCommon *prec, const char *infoname);
 
+/* Records that use the same port, address, drvInfo, interface and mask,
+ * shared by devAsynSharedScan.c and devAsynCoalesce.c */
+
+typedef struct devAsynGroup {
+    ELLNODE     node;
+    char        *portName;
+    int         addr;
+    char        *userParam;
+    char        *interfaceType;
+    epicsUInt32 mask;
+    void        *pinterface;
+    void        *drvPvt;
+} devAsynGroup;
+
+typedef struct devAsynGroupList {
+    ELLLIST           list;
+    epicsMutexId      lock;
+    epicsThreadOnceId onceId;
+} devAsynGroupList;
+#define DEV_ASYN_GROUP_LIST_INIT {ELLLIST_INIT, 0, EPICS_THREAD_ONCE_INIT}
+
+/* Locks the list and returns the group with this key. If there is none a
+ * group of size bytes, which must start with a devAsynGroup, is allocated,
+ * added and *pcreated set. The caller initializes the rest of a new group
+ * and then calls devAsynGroupListUnlock. */
+devAsynGroup *devAsynGroupFind(devAsynGroupList *plist, size_t size,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt, int *pcreated);
+void devAsynGroupListLock(devAsynGroupList *plist);
+void devAsynGroupListUnlock(devAsynGroupList *plist);
+
+/* Shared I/O Intr scanning for scalar input records, see devAsynSharedScan.c */
+
+typedef union devAsynScalarValue {
+    epicsInt32   int32;
+    epicsInt64   int64;
+    epicsUInt32  uint32;
+    epicsFloat64 float64;
+} devAsynScalarValue;
+
+typedef struct devAsynSharedScanValue {
+    devAsynScalarValue  value;
+    epicsTimeStamp      time;
+    asynStatus          status;
+    epicsAlarmCondition alarmStatus;
+    epicsAlarmSeverity  alarmSeverity;
+} devAsynSharedScanValue;
+
+typedef struct devAsynSharedScan devAsynSharedScan;
+
+/* Registers or cancels the interrupt callback of the shared scan on its interface.
+ * The callback must call devAsynSharedScanPost with the value. */
+typedef asynStatus (*devAsynSharedScanRegister)(devAsynSharedScan *pscan,
+    void *pinterface, void *drvPvt, asynUser *pasynUser, epicsUInt32 mask, void **registrarPvt);
+typedef asynStatus (*devAsynSharedScanCancel)(
+    void *pinterface, void *drvPvt, asynUser *pasynUser, void *registrarPvt);
+
+int devAsynSharedScanEnabled(struct dbCommon *prec);
+devAsynSharedScan *devAsynSharedScanAttach(struct dbCommon *prec, asynUser *pasynUser,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt,
+    devAsynSharedScanRegister registerUser, devAsynSharedScanCancel cancelUser,
+    unsigned int *pseq);
+void devAsynSharedScanDetach(devAsynSharedScan *pscan);
+IOSCANPVT devAsynSharedScanIoScanPvt(devAsynSharedScan *pscan);
+void devAsynSharedScanPost(devAsynSharedScan *pscan, asynUser *pasynUser,
+    const devAsynScalarValue *pvalue);
+int devAsynSharedScanGet(devAsynSharedScan *pscan, unsigned int *pseq,
+    devAsynSharedScanValue *presult);
+
+/* Coalescing of reads for scalar input records, see devAsynCoalesce.c */
+
+typedef struct devAsynCoalesce devAsynCoalesce;
+
+/* Reads the value with the asynUser of the group, from the port thread */
+typedef asynStatus (*devAsynCoalesceRead)(void *pinterface, void *drvPvt,
+    asynUser *pasynUser, epicsUInt32 mask, devAsynScalarValue *pvalue);
+/* Gives the value that was read to one waiting record */
+typedef void (*devAsynCoalesceDone)(void *userPvt, asynUser *pasynUser,
+    const devAsynSharedScanValue *presult);
+
+typedef struct devAsynCoalesceWaiter {
+    ELLNODE             node;
+    devAsynCoalesceDone done;
+    void                *userPvt;
+} devAsynCoalesceWaiter;
+
+int devAsynCoalesceEnabled(struct dbCommon *prec);
+devAsynCoalesce *devAsynCoalesceAttach(struct dbCommon *prec, asynUser *pasynUser,
+    const char *portName, int addr, const char *userParam, const char *interfaceType,
+    epicsUInt32 mask, void *pinterface, void *drvPvt, devAsynCoalesceRead readUser);
+asynStatus devAsynCoalesceQueue(devAsynCoalesce *pgroup, devAsynCoalesceWaiter *pwaiter,
+    asynUser *pasynUser);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -37,6 +37,7 @@
 #include "asynGpibDriver.h"
 #include "devSupportGpib.h"
 #include "devCommonGpib.h"
+#include "asynIEEE488Block.h"
 
 typedef long(*special_linconv_t)(void*, int);
 
@@ -1104,6 +1105,16 @@ long  devGpib_initWf(waveformRecord * pwf)
             pwf->pact = 1;
             return S_db_badField;
         }
+    } else if(cmdType&GPIBBLOCKREAD) {
+        asynBlockFormat format;
+
+        if(asynIEEE488BlockParseFormat(pgpibDpvt->pasynUser,
+                pgpibCmd->format,pwf->ftvl,&format)!=asynSuccess) {
+            asynPrint(pgpibDpvt->pasynUser,ASYN_TRACE_ERROR,
+                "%s %s\n", pwf->name, pgpibDpvt->pasynUser->errorMessage);
+            pwf->pact = 1;
+            return S_db_badField;
+        }
     } else if(!(cmdType&(GPIBSOFT|GPIBCVTIO|GPIBWRITE|GPIBCMD|GPIBACMD))) {
         asynPrint(pgpibDpvt->pasynUser,ASYN_TRACE_ERROR,
             "%s invalid command type for WF record in param %d\n",
@@ -1124,7 +1135,7 @@ long  devGpib_readWf(waveformRecord * pwf)
         pdevSupportGpib->processGPIBSOFT(pgpibDpvt);
         return 0;
     }
-    if(cmdType&(GPIBREAD|GPIBREADW|GPIBRAWREAD)) {
+    if(cmdType&(GPIBREAD|GPIBREADW|GPIBRAWREAD|GPIBBLOCKREAD)) {
         pdevSupportGpib->queueReadRequest(pgpibDpvt,0,wfFinish);
     } else { /*Must be Output Operation*/
         pdevSupportGpib->queueWriteRequest(pgpibDpvt,wfStart,wfFinish);
@@ -1158,7 +1169,13 @@ static void wfFinish(gpibDpvt * pgpibDpvt,int failure)
     int cnvrtStat;
     asynUser *pasynUser = pgpibDpvt->pasynUser;
 
-    if(failure) {; /*do nothing*/
+    if(cmdType&GPIBBLOCKREAD) {
+        /* gpibRead read the block into the record, also after an overflow */
+        if(pgpibDpvt->msgInputLen>0) {
+            pwf->udf = FALSE;
+            pwf->nord = (epicsUInt32)pgpibDpvt->msgInputLen;
+        }
+    } else if(failure) {; /*do nothing*/
     } else if(cmdType&(GPIBREAD|GPIBREADW|GPIBRAWREAD)) {
         if(pgpibCmd->convert) {
         cnvrtStat = pgpibCmd->convert(pgpibDpvt,
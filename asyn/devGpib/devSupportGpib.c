@@ -42,6 +42,7 @@
 #include "asynGpibDriver.h"
 
 #include "devSupportGpib.h"
+#include "asynIEEE488Block.h"
 
 #define DEFAULT_QUEUE_TIMEOUT 60.0
 #define DEFAULT_SRQ_WAIT_TIMEOUT 5.0
@@ -127,6 +128,8 @@ static int readArbitraryBlockProgramData(gpibDpvt *pgpibDpvt);
 static int setEos(gpibDpvt *pgpibDpvt, gpibCmd *pgpibCmd);
 static int restoreEos(gpibDpvt *pgpibDpvt, gpibCmd *pgpibCmd);
 static void completeProcess(gpibDpvt *pgpibDpvt);
+static int readBlock(gpibDpvt *pgpibDpvt,void *pdest,int ftvl,
+    size_t maxElements,size_t *nElements);
 
 static devSupportGpib gpibSupport = {
     initRecord,
@@ -142,7 +145,8 @@ static devSupportGpib gpibSupport = {
     readArbitraryBlockProgramData,
     setEos,
     restoreEos,
-    completeProcess
+    completeProcess,
+    readBlock
 };
 devSupportGpib *pdevSupportGpib = &gpibSupport;
 
@@ -584,6 +588,56 @@ static int readArbitraryBlockProgramData(gpibDpvt *pgpibDpvt)
     return pgpibDpvt->msgInputLen;
 }
 
+/*
+ * Read an IEEE-488.2 definite length arbitrary block into pdest.
+ * The EOS of the command must already be set.
+ */
+static int readBlockData(gpibDpvt *pgpibDpvt,void *pdest,int ftvl,
+    size_t maxElements,size_t *nElements)
+{
+    asynUser *pasynUser = pgpibDpvt->pasynUser;
+    dbCommon *precord = pgpibDpvt->precord;
+    gpibCmd *pgpibCmd = gpibCmdGet(pgpibDpvt);
+    asynBlockFormat format;
+    asynStatus status;
+
+    *nElements = 0;
+    status = asynIEEE488BlockParseFormat(pasynUser,pgpibCmd->format,ftvl,&format);
+    if(status!=asynSuccess) {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,
+            "%s readBlock %s\n",precord->name,pasynUser->errorMessage);
+        return -1;
+    }
+    status = asynIEEE488BlockRead(pgpibDpvt->pasynOctet,pgpibDpvt->asynOctetPvt,
+        pasynUser,&format,pdest,ftvl,maxElements,nElements);
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"%s readBlock nElements %lu\n",
+        precord->name,(unsigned long)*nElements);
+    if(status!=asynSuccess) {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,
+            "%s readBlock %s\n",precord->name,pasynUser->errorMessage);
+        if(status!=asynOverflow) gpibErrorHappened(pgpibDpvt);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Read GPIBBLOCKREAD data into an array other than the record's, after the
+ * command was sent. GPIBBLOCKREAD records are read by gpibRead.
+ */
+static int readBlock(gpibDpvt *pgpibDpvt,void *pdest,int ftvl,
+    size_t maxElements,size_t *nElements)
+{
+    gpibCmd *pgpibCmd = gpibCmdGet(pgpibDpvt);
+    int failure;
+
+    *nElements = 0;
+    if(setEos(pgpibDpvt,pgpibCmd) < 0) return -1;
+    failure = readBlockData(pgpibDpvt,pdest,ftvl,maxElements,nElements);
+    restoreEos(pgpibDpvt,pgpibCmd);
+    return failure;
+}
+
 static int setEos(gpibDpvt *pgpibDpvt, gpibCmd *pgpibCmd)
 {
     deviceInstance *pdeviceInstance = pgpibDpvt->pdevGpibPvt->pdeviceInstance;
@@ -883,6 +937,7 @@ static void prepareToRead(gpibDpvt *pgpibDpvt,int failure)
     case GPIBEFASTIW:
     case GPIBREAD:
     case GPIBEFASTI:
+    case GPIBBLOCKREAD:
         if(!pgpibCmd->cmd) {
             asynPrint(pasynUser,ASYN_TRACE_ERROR,
                 "%s pgpibCmd->cmd is null\n",precord->name);
@@ -965,8 +1020,19 @@ static void gpibRead(gpibDpvt *pgpibDpvt,int failure)
     void *asynOctetPvt = pgpibDpvt->asynOctetPvt;
     size_t nchars = 0;
 
+    if(cmdType&GPIBBLOCKREAD) pgpibDpvt->msgInputLen = 0;
     if(failure) goto done;
     if(cmdType&GPIBCVTIO) goto done;
+    if(cmdType&GPIBBLOCKREAD) {
+        /* Straight into the waveform, the only record type that allows it.
+         * msgInputLen is set to the number of elements read. */
+        waveformRecord *pwf = (waveformRecord *)precord;
+        size_t nElements = 0;
+
+        failure = readBlockData(pgpibDpvt,pwf->bptr,pwf->ftvl,pwf->nelm,&nElements);
+        pgpibDpvt->msgInputLen = (int)nElements;
+        goto done;
+    }
     if(!pgpibDpvt->msg) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s pgpibDpvt->msg is null\n",precord->name);
@@ -1336,7 +1402,7 @@ static int gpibCmdIsConsistant(gpibDpvt *pgpibDpvt)
             return 0;
         }
     }
-    if(pgpibCmd->type&(GPIBREAD|GPIBREADW)) {
+    if(pgpibCmd->type&(GPIBREAD|GPIBREADW|GPIBBLOCKREAD)) {
         if(!pgpibCmd->cmd) {
             asynPrint(pasynUser,ASYN_TRACE_ERROR,
                 "%s parm %d requires cmd\n",
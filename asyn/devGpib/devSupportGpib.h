@@ -59,7 +59,7 @@ typedef struct devSupportGpib devSupportGpib;
 
 struct gpibCmd {
     gDset *dset; /* used to indicate record type supported */
-    int type;    /* enum - GPIBREAD...GPIBSRQHANDLER */
+    int type;    /* enum - GPIBREAD...GPIBBLOCKREAD */
     short pri;   /* request priority IB_Q_LOW, IB_G_MEDIUM, or IB_Q_HIGH */
     char *cmd;   /* CONSTANT STRING to send to instrument */
     char *format;/* string used to generate or interpret msg */
@@ -97,6 +97,7 @@ struct gpibCmd {
 #define GPIBSDC         0x00008000
 #define GPIBGTL         0x00010000
 #define GPIBSRQHANDLER  0x00020000
+#define GPIBBLOCKREAD   0x00040000
 #define IB_Q_LOW     asynQueuePriorityLow
 #define IB_Q_MEDIUM  asynQueuePriorityMedium
 #define IB_Q_HIGH    asynQueuePriorityHigh
@@ -174,6 +175,8 @@ struct devSupportGpib {
     int (*setEos)(gpibDpvt *pgpibDpvt,gpibCmd *pgpibCmd);
     int (*restoreEos)(gpibDpvt *pgpibDpvt,gpibCmd *pgpibCmd);
     void (*completeProcess)(gpibDpvt *pgpibDpvt);
+    int (*readBlock)(gpibDpvt *pgpibDpvt,void *pdest,int ftvl,
+                     size_t maxElements,size_t *nElements);
 };
 ASYN_API extern devSupportGpib *pdevSupportGpib;
 
@@ -227,6 +230,15 @@ ASYN_API extern devSupportGpib *pdevSupportGpib;
  *
  * GPIBSRQHANDLER: longin only. Register SRQ handler. val is status byte
  *
+ * GPIBBLOCKREAD: waveform only.
+ *           (1) gpibDpvt.cmd is sent to the instrument
+ *           (2) an IEEE-488.2 definite length arbitrary block is read
+ *               directly into the waveform. gpibCmd.format gives the data
+ *               type and byte order, e.g. "INT16" or "FLOAT32 LE". If it
+ *               is null the FTVL type, big endian, is assumed.
+ *               gpibCmd.msgLen is not used. gpibDpvt.msgInputLen is set
+ *               to the number of elements read.
+ *
  * If a particular GPIB message does not fit one of these formats, a custom
  * routine may be provided. Store a pointer to this routine in the
  * gpibCmd.convert field to use it rather than the above approaches.
@@ -307,7 +319,7 @@ ASYN_API extern devSupportGpib *pdevSupportGpib;
 /* devSupportGpib - support methods for dbCommonGpib of special support
  * initRecord - Perform common initialization for a record instance
  * processGPIBSOFT - Perform operation for GPIBSOFT
- * queueReadRequest - Handle READ, READW, EFASTI, EFASTIW, and RAWREAD
+ * queueReadRequest - Handle READ, READW, EFASTI, EFASTIW, RAWREAD and BLOCKREAD
  * queueWriteRequest - Handle WRITE, CMD, ACMD, EFSTO
  * queueRequest - queue a request that caller will process
  * report - issue a report about this instrument
@@ -317,6 +329,8 @@ ASYN_API extern devSupportGpib *pdevSupportGpib;
  * writeMsgDouble - write gpibDpvt.msg with a double value
  * writeMsgString - write gpibDpvt.msg with a char * value
  * readArbitraryBlockProgramData - read IEEE-488.2 arbitrary block program data
+ * readBlock - read block data into an array of ftvl elements after the
+ *             command was sent, e.g. by a convert routine
  ****************************************************************************/
 
 #ifdef __cplusplus
@@ -39,6 +39,7 @@ typedef struct {
     int               FTDIproduct;
     int               FTDIbaudrate;
     int               FTDIlatency;
+    int               FTDIreadChunkSize;
     int               FTDImode;          /* UART = 0; SPI = 1 */
     char              *portName;
     FTDIDriver         *driver;
@@ -264,6 +265,9 @@ asynCommonReport(void *drvPvt, FILE *fp, int details)
     if (details >= 2) {
         fprintf(fp, "    Characters written: %lu\n", ftdi->nWritten);
         fprintf(fp, "       Characters read: %lu\n", ftdi->nRead);
+        fprintf(fp, "       Read chunk size: %d\n", ftdi->FTDIreadChunkSize);
+        if (ftdi->driver)
+            fprintf(fp, "    Characters buffered: %d\n", ftdi->driver->getBufferedBytes());
     }
 }
 
@@ -330,6 +334,12 @@ connectIt(void *drvPvt, asynUser *pasynUser)
     // Set the latency
     ftdi->driver->setLatency(ftdi->FTDIlatency);
 
+    // Set the size of the USB reads
+    ftdi->driver->setReadChunkSize(ftdi->FTDIreadChunkSize);
+
+    // Name the reader thread after the port
+    ftdi->driver->setPortName(ftdi->portName);
+
     // Connect to the remote host
     if (ftdi->driver->connectFTDI() != FTDIDriverSuccess){
       epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
@@ -515,7 +525,8 @@ drvAsynFTDIPortConfigure(const char *portName,
                          unsigned int priority,
                          int noAutoConnect,
                          int noProcessEos,
-                         int mode)
+                         int mode,
+                         int readChunkSize)
 {
     int SPI = ((mode & UART_SPI_BIT)==UART_SPI_BIT)? 1:0;
 
@@ -525,6 +536,10 @@ drvAsynFTDIPortConfigure(const char *portName,
     printf("drvAsynFTDIPortConfigure: noProcessEos=%d\n", noProcessEos);
     printf("drvAsynFTDIPortConfigure: mode="); SPI ? printf("SPI\n") : printf("UART\n");
 
+    if (readChunkSize <= 0)
+        readChunkSize = FTDI_DEFAULT_READ_CHUNK_SIZE;
+    printf("drvAsynFTDIPortConfigure: readChunkSize=%d\n", readChunkSize);
+
     ftdiController_t *ftdi;
     asynInterface *pasynInterface;
     asynStatus status;
@@ -569,6 +584,7 @@ drvAsynFTDIPortConfigure(const char *portName,
     ftdi->FTDIproduct = product;
     ftdi->FTDIbaudrate = baudrate;
     ftdi->FTDIlatency = latency;
+    ftdi->FTDIreadChunkSize = readChunkSize;
     ftdi->FTDImode = SPI;
     ftdi->portName = epicsStrDup(portName);
 
@@ -647,17 +663,18 @@ static const iocshArg drvAsynFTDIPortConfigureArg5 = { "priority",iocshArgInt};
 static const iocshArg drvAsynFTDIPortConfigureArg6 = { "disable auto-connect",iocshArgInt};
 static const iocshArg drvAsynFTDIPortConfigureArg7 = { "noProcessEos",iocshArgInt};
 static const iocshArg drvAsynFTDIPortConfigureArg8 = { "mode",iocshArgInt};
+static const iocshArg drvAsynFTDIPortConfigureArg9 = { "read chunk size",iocshArgInt};
 static const iocshArg *drvAsynFTDIPortConfigureArgs[] = {
     &drvAsynFTDIPortConfigureArg0, &drvAsynFTDIPortConfigureArg1,
     &drvAsynFTDIPortConfigureArg2, &drvAsynFTDIPortConfigureArg3,
     &drvAsynFTDIPortConfigureArg4, &drvAsynFTDIPortConfigureArg5,
     &drvAsynFTDIPortConfigureArg6, &drvAsynFTDIPortConfigureArg7,
-    &drvAsynFTDIPortConfigureArg8};
+    &drvAsynFTDIPortConfigureArg8, &drvAsynFTDIPortConfigureArg9};
 static const iocshFuncDef drvAsynFTDIPortConfigureFuncDef =
-                      {"drvAsynFTDIPortConfigure",9,drvAsynFTDIPortConfigureArgs};
+                      {"drvAsynFTDIPortConfigure",10,drvAsynFTDIPortConfigureArgs};
 static void drvAsynFTDIPortConfigureCallFunc(const iocshArgBuf *args)
 {
-    drvAsynFTDIPortConfigure(args[0].sval, args[1].ival, args[2].ival, args[3].ival, args[4].ival, args[5].ival, args[6].ival, args[7].ival, args[8].ival);
+    drvAsynFTDIPortConfigure(args[0].sval, args[1].ival, args[2].ival, args[3].ival, args[4].ival, args[5].ival, args[6].ival, args[7].ival, args[8].ival, args[9].ival);
 }
 
 /*
@@ -18,7 +18,8 @@ ASYN_API int drvAsynFTDIPortConfigure(const char *portname,
                                            unsigned int priority,
                                            int noAutoConnect,
                                            int noProcessEos,
-                                           int mode); // UART = 0x00; SPI = 0x01;
+                                           int mode, // UART = 0x00; SPI = 0x01;
+                                           int readChunkSize); // 0 = default (8192)
 
 #ifdef __cplusplus
 }
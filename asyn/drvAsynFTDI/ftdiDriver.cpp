@@ -66,6 +66,9 @@ FTDIDriver::FTDIDriver(int mode)
   // Baudrate and latency set to 12 Mb and 2 msecs.
   baudrate_ = 12000000;
   latency_ = 2;
+  readChunkSize_ = FTDI_DEFAULT_READ_CHUNK_SIZE;
+  strcpy(readerName_, "FTDIReader");
+  reader_ = 0;
   // Reasonable defaults for line properties and flow control
   bits_ = BITS_8;
   sbits_ = STOP_BIT_1;
@@ -194,8 +197,11 @@ FTDIDriverStatus FTDIDriver::setBaudrate(const int baudrate)
   static const char *functionName = "FTDIDriver::setBaudrate";
   debugPrint("%s : Method called\n", functionName);
 
-  int f;
-  if (ftdi_ && (f = ftdi_set_baudrate(ftdi_, baudrate))) {
+  int f = 0;
+  pauseReader();
+  if (ftdi_) f = ftdi_set_baudrate(ftdi_, baudrate);
+  resumeReader();
+  if (f) {
       debugPrint("Failed to set FTDI baudrate: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
       return FTDIDriverError;
   }
@@ -262,8 +268,11 @@ FTDIDriverStatus FTDIDriver::setLineProperties(enum ftdi_bits_type bits,
   static const char *functionName = "FTDIDriver::setLineProperties";
   debugPrint("%s : Method called\n", functionName);
 
-  int f;
-  if (ftdi_ && (f = ftdi_set_line_property2(ftdi_, bits, sbits, parity, brk)))
+  int f = 0;
+  pauseReader();
+  if (ftdi_) f = ftdi_set_line_property2(ftdi_, bits, sbits, parity, brk);
+  resumeReader();
+  if (f)
   {
       debugPrint("Failed to set FTDI line parameters: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
       return FTDIDriverError;
@@ -290,8 +299,11 @@ FTDIDriverStatus FTDIDriver::setFlowControl(int flowctrl)
   static const char *functionName = "FTDIDriver::setFlowControl";
   debugPrint("%s : Method called\n", functionName);
 
-  int f;
-  if (ftdi_ && (f = ftdi_setflowctrl(ftdi_, flowctrl)))
+  int f = 0;
+  pauseReader();
+  if (ftdi_) f = ftdi_setflowctrl(ftdi_, flowctrl);
+  resumeReader();
+  if (f)
   {
       debugPrint("Failed to set FTDI flow control: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
       return FTDIDriverError;
@@ -316,8 +328,11 @@ FTDIDriverStatus FTDIDriver::setLatency(const int latency)
   static const char *functionName = "FTDIDriver::setLatency";
   debugPrint("%s : Method called\n", functionName);
 
-  int f;
-  if (ftdi_ && (f = ftdi_set_latency_timer (ftdi_, latency))) {
+  int f = 0;
+  pauseReader();
+  if (ftdi_) f = ftdi_set_latency_timer (ftdi_, latency);
+  resumeReader();
+  if (f) {
      debugPrint("Failed to set FTDI latency: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
      return FTDIDriverError;
   }
@@ -326,6 +341,42 @@ FTDIDriverStatus FTDIDriver::setLatency(const int latency)
   return FTDIDriverSuccess;
 }
 
+/**
+ * Setup the size of the USB reads. Must be called before connectFTDI.
+ * Larger chunks need fewer USB transfers for long responses, smaller ones
+ * hand data over sooner when the device sends more than one packet.
+ *
+ * @param chunkSize - Read chunk size in bytes.
+ * @return - Success or failure.
+ */
+FTDIDriverStatus FTDIDriver::setReadChunkSize(const int chunkSize)
+{
+  static const char *functionName = "FTDIDriver::setReadChunkSize";
+  debugPrint("%s : Method called\n", functionName);
+
+  if (chunkSize <= 0)
+    return FTDIDriverError;
+  readChunkSize_ = chunkSize;
+  return FTDIDriverSuccess;
+}
+
+/**
+ * Set the name of the asyn port, used to name the reader thread.
+ *
+ * @param portName - The asyn port name.
+ * @return - Success or failure.
+ */
+FTDIDriverStatus FTDIDriver::setPortName(const char *portName)
+{
+  static const char *functionName = "FTDIDriver::setPortName";
+  debugPrint("%s : Method called\n", functionName);
+
+  if (!portName || !*portName)
+    return FTDIDriverError;
+  snprintf(readerName_, sizeof(readerName_), "%sReader", portName);
+  return FTDIDriverSuccess;
+}
+
 /**
  * Get the Baud rate.
  *
@@ -386,6 +437,52 @@ int FTDIDriver::getFlowControl(void)
   return flowctrl_;
 }
 
+/**
+ * Get the read chunk size.
+ *
+ * @return - The read chunk size.
+ */
+int FTDIDriver::getReadChunkSize(void)
+{
+  return readChunkSize_;
+}
+
+/**
+ * Get the number of bytes received but not yet read.
+ *
+ * @return - The number of buffered bytes.
+ */
+int FTDIDriver::getBufferedBytes(void)
+{
+  return reader_ ? ftdiReaderUsed(reader_) : 0;
+}
+
+/**
+ * Keep the reader thread out of the ftdi context while it is being
+ * purged or reconfigured.  The thread gives it up within one latency
+ * timer period.
+ */
+void FTDIDriver::pauseReader(void)
+{
+  if (reader_)
+    ftdiReaderPause(reader_);
+}
+
+void FTDIDriver::resumeReader(void)
+{
+  if (reader_)
+    ftdiReaderResume(reader_);
+}
+
+/**
+ * Called by the background reader thread.  ftdi_read_data returns
+ * after at most one latency timer period when there is no data.
+ */
+static int readCallback(void *ctx, unsigned char *buf, int len)
+{
+  return ftdi_read_data((struct ftdi_context *)ctx, buf, len);
+}
+
 /**
  * Attempt to create a connection  Once the connection has
  * been established.
@@ -472,7 +569,7 @@ FTDIDriverStatus FTDIDriver::connectFTDI()
   // Wait 60 ms. for purge to complete
      epicsThreadSleep(0.060);
 
-  if ((f = ftdi_read_data_set_chunksize(ftdi_, 8192)) != 0)
+  if ((f = ftdi_read_data_set_chunksize(ftdi_, readChunkSize_)) != 0)
   {
      debugPrint("Failed to set FTDI read chunk size: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
      return FTDIDriverError;
@@ -491,6 +588,16 @@ FTDIDriverStatus FTDIDriver::connectFTDI()
     debugPrint("INIT SPI-\n");
     FTDIDriver::initSPI();
     }
+  else {
+    // SPI reads follow their writes; UART data is collected in the background
+    reader_ = ftdiReaderCreate(readerName_, readCallback, ftdi_,
+                               readChunkSize_, FTDI_READ_BUFFER_SIZE);
+    if (!reader_) {
+      debugPrint("%s : Failed to start the reader thread\n", functionName);
+      disconnectFTDI();
+      return FTDIDriverError;
+    }
+  }
 
   return FTDIDriverSuccess;
 }
@@ -512,7 +619,11 @@ FTDIDriverStatus FTDIDriver::flush()
   }
 
   // Clears read & write buffers on the chip and the internal read buffer
+  pauseReader();
   f = ftdi_usb_purge_buffers(ftdi_);
+  if (f >= 0 && reader_)
+    ftdiReaderFlush(reader_);
+  resumeReader();
   if (f < 0){
     debugPrint("Failed to purge FTDI buffers: %d (%s)\n", f, ftdi_get_error_string(ftdi_));
     return FTDIDriverError;
@@ -622,7 +733,8 @@ FTDIDriverStatus FTDIDriver::write(const unsigned char *buffer, int bufferSize,
  * Read data from the connected channel.  A timeout should be
  * specified in milliseconds.  The read method will continue to
  * read data from the channel until either data arrives or the
- * timeout is reached.
+ * timeout is reached.  In UART mode the data comes from the
+ * reader thread and a negative timeout waits forever.
  *
  * @param buffer - A string buffer to hold the read data.
  * @param bufferSize - The maximum number of bytes to read.
@@ -643,6 +755,19 @@ FTDIDriverStatus FTDIDriver::read(unsigned char *buffer, size_t bufferSize, size
   debugPrint("%s : Reading: bufferSize=%llu, timeout=%d\n",
              functionName, (unsigned long long) bufferSize, timeout);
 
+  if (reader_) {
+    int status = ftdiReaderRead(reader_, buffer, bufferSize, bytesRead,
+                                (timeout < 0) ? -1.0 : timeout / 1000.0);
+    if (*bytesRead < bufferSize)
+      buffer[*bytesRead] = '\0';
+    debugPrint("%s %d Bytes, status=%d\n", functionName, (int)*bytesRead, status);
+    if (status == FTDI_READER_ERROR)
+      return FTDIDriverError;
+    if (status == FTDI_READER_TIMEOUT)
+      return FTDIDriverTimeout;
+    return FTDIDriverSuccess;
+  }
+
   timeval stime;
   timeval ctime;
   gettimeofday(&stime, NULL);
@@ -698,6 +823,9 @@ FTDIDriverStatus FTDIDriver::disconnectFTDI()
   debugPrint("%s : Method called\n", functionName);
 
   if (connected_ == 1){
+    // The reader thread must be out of ftdi_read_data before closing
+    ftdiReaderDestroy(reader_);
+    reader_ = 0;
     ftdi_usb_close(ftdi_);
     ftdi_deinit(ftdi_);
     connected_ = 0;
@@ -10,6 +10,8 @@
 
 #include <usb.h>
 
+#include "ftdiReader.h"
+
 # ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -25,6 +27,9 @@
 
 #define UART_SPI_BIT    0x01 // 0 = UART; 1 = SPI
 
+#define FTDI_DEFAULT_READ_CHUNK_SIZE  8192
+#define FTDI_READ_BUFFER_SIZE         0x10000
+
 namespace Pin {
   enum bus_t {
   SK       = 0x01, //SPI clock
@@ -72,6 +77,8 @@ class FTDIDriver {
     FTDIDriverStatus setBreak(enum ftdi_break_type brk);
     FTDIDriverStatus setFlowControl(int flowctrl);
     FTDIDriverStatus setLatency(const int latency);
+    FTDIDriverStatus setReadChunkSize(const int chunkSize);
+    FTDIDriverStatus setPortName(const char *portName);
     FTDIDriverStatus setLineProperties(enum ftdi_bits_type bits,
       enum ftdi_stopbits_type sbits, enum ftdi_parity_type parity,
       enum ftdi_break_type brk);
@@ -81,6 +88,8 @@ class FTDIDriver {
     enum ftdi_parity_type getParity(void);
     enum ftdi_break_type getBreak(void);
     int getFlowControl(void);
+    int getReadChunkSize(void);
+    int getBufferedBytes(void);
     FTDIDriverStatus connectFTDI();
     FTDIDriverStatus flush();
     FTDIDriverStatus write(const unsigned char *buffer, int bufferSize, size_t *bytesWritten, int timeout);
@@ -89,6 +98,9 @@ class FTDIDriver {
     virtual ~FTDIDriver();
 
   private:
+    void pauseReader(void);
+    void resumeReader(void);
+
     struct ftdi_context *ftdi_;
 
     int            spi;
@@ -107,6 +119,9 @@ class FTDIDriver {
     enum ftdi_break_type break_;
     int flowctrl_;
     int latency_;
+    int readChunkSize_;
+    char readerName_[64];
+    ftdiReader *reader_;
     off_t got_;
 
 };
@@ -0,0 +1,193 @@
+/*
+ * Background reader for FTDI ports
+ *
+ * The reader thread only reads when there is room for a whole chunk in the
+ * ring buffer, so a chunk can always be stored without being split.
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsRingBytes.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <cantProceed.h>
+
+#include "ftdiReader.h"
+
+/* How often the reader thread checks for shutdown while the buffer is full
+ * or it is paused */
+#define FULL_POLL_INTERVAL  0.1
+
+struct ftdiReader {
+    ftdiReadFunc        readFunc;
+    void                *ctx;
+    int                 chunkSize;
+    unsigned char       *chunk;
+    epicsRingBytesId    ring;
+    epicsEventId        dataEvent;
+    epicsEventId        spaceEvent;
+    epicsEventId        exitEvent;
+    epicsEventId        resumeEvent;
+    epicsMutexId        ioLock;     /* held while the thread uses ctx */
+    int                 pauseCount;
+    volatile int        stop;
+    volatile int        readError;
+};
+
+static void
+readerThread(void *arg)
+{
+    ftdiReader *preader = (ftdiReader *)arg;
+
+    while (!preader->stop) {
+        int n;
+
+        if (epicsRingBytesFreeBytes(preader->ring) < preader->chunkSize) {
+            epicsEventWaitWithTimeout(preader->spaceEvent, FULL_POLL_INTERVAL);
+            continue;
+        }
+        /* Let a paused caller have the lock instead of taking it again at once */
+        if (epicsAtomicGetIntT(&preader->pauseCount) > 0) {
+            epicsEventWaitWithTimeout(preader->resumeEvent, FULL_POLL_INTERVAL);
+            continue;
+        }
+        epicsMutexMustLock(preader->ioLock);
+        n = preader->readFunc(preader->ctx, preader->chunk, preader->chunkSize);
+        /* Stored under the lock so a flush while paused discards it */
+        if (n > 0)
+            epicsRingBytesPut(preader->ring, (char *)preader->chunk, n);
+        epicsMutexUnlock(preader->ioLock);
+        if (n < 0) {
+            preader->readError = 1;
+            epicsEventSignal(preader->dataEvent);
+            break;
+        }
+        if (n > 0)
+            epicsEventSignal(preader->dataEvent);
+    }
+    epicsEventSignal(preader->exitEvent);
+}
+
+ftdiReader *
+ftdiReaderCreate(const char *name, ftdiReadFunc readFunc, void *ctx,
+                 int chunkSize, int bufferSize)
+{
+    ftdiReader *preader;
+
+    if (chunkSize <= 0) chunkSize = 1;
+    if (bufferSize < 2 * chunkSize) bufferSize = 2 * chunkSize;
+    preader = callocMustSucceed(1, sizeof(*preader), "ftdiReaderCreate");
+    preader->readFunc = readFunc;
+    preader->ctx = ctx;
+    preader->chunkSize = chunkSize;
+    preader->chunk = mallocMustSucceed(chunkSize, "ftdiReaderCreate");
+    preader->ring = epicsRingBytesLockedCreate(bufferSize);
+    preader->dataEvent = epicsEventMustCreate(epicsEventEmpty);
+    preader->spaceEvent = epicsEventMustCreate(epicsEventEmpty);
+    preader->exitEvent = epicsEventMustCreate(epicsEventEmpty);
+    preader->resumeEvent = epicsEventMustCreate(epicsEventEmpty);
+    preader->ioLock = epicsMutexMustCreate();
+    if (!preader->ring
+     || !epicsThreadCreate(name, epicsThreadPriorityHigh,
+                           epicsThreadGetStackSize(epicsThreadStackSmall),
+                           readerThread, preader)) {
+        if (preader->ring) epicsRingBytesDelete(preader->ring);
+        epicsEventDestroy(preader->dataEvent);
+        epicsEventDestroy(preader->spaceEvent);
+        epicsEventDestroy(preader->exitEvent);
+        epicsEventDestroy(preader->resumeEvent);
+        epicsMutexDestroy(preader->ioLock);
+        free(preader->chunk);
+        free(preader);
+        return NULL;
+    }
+    return preader;
+}
+
+int
+ftdiReaderRead(ftdiReader *preader, unsigned char *buf, size_t size,
+               size_t *nRead, double timeout)
+{
+    epicsTimeStamp start;
+
+    *nRead = 0;
+    if (size == 0)
+        return FTDI_READER_OK;
+    if (size > INT_MAX)
+        size = INT_MAX;
+    epicsTimeGetCurrent(&start);
+    for (;;) {
+        int n = epicsRingBytesGet(preader->ring, (char *)buf, (int)size);
+
+        if (n > 0) {
+            epicsEventSignal(preader->spaceEvent);
+            *nRead = n;
+            return FTDI_READER_OK;
+        }
+        if (preader->readError)
+            return FTDI_READER_ERROR;
+        if (timeout < 0) {
+            epicsEventMustWait(preader->dataEvent);
+        }
+        else {
+            epicsTimeStamp now;
+            double left;
+
+            epicsTimeGetCurrent(&now);
+            left = timeout - epicsTimeDiffInSeconds(&now, &start);
+            if (left <= 0)
+                return FTDI_READER_TIMEOUT;
+            epicsEventWaitWithTimeout(preader->dataEvent, left);
+        }
+    }
+}
+
+void
+ftdiReaderFlush(ftdiReader *preader)
+{
+    epicsRingBytesFlush(preader->ring);
+    epicsEventSignal(preader->spaceEvent);
+}
+
+void
+ftdiReaderPause(ftdiReader *preader)
+{
+    epicsAtomicIncrIntT(&preader->pauseCount);
+    epicsMutexMustLock(preader->ioLock);
+}
+
+void
+ftdiReaderResume(ftdiReader *preader)
+{
+    epicsMutexUnlock(preader->ioLock);
+    epicsAtomicDecrIntT(&preader->pauseCount);
+    epicsEventSignal(preader->resumeEvent);
+}
+
+int
+ftdiReaderUsed(ftdiReader *preader)
+{
+    return epicsRingBytesUsedBytes(preader->ring);
+}
+
+void
+ftdiReaderDestroy(ftdiReader *preader)
+{
+    if (!preader)
+        return;
+    preader->stop = 1;
+    epicsEventSignal(preader->spaceEvent);
+    epicsEventMustWait(preader->exitEvent);
+    epicsRingBytesDelete(preader->ring);
+    epicsEventDestroy(preader->dataEvent);
+    epicsEventDestroy(preader->spaceEvent);
+    epicsEventDestroy(preader->exitEvent);
+    epicsEventDestroy(preader->resumeEvent);
+    epicsMutexDestroy(preader->ioLock);
+    free(preader->chunk);
+    free(preader);
+}
@@ -0,0 +1,69 @@
+/*
+ * Background reader for FTDI ports
+ *
+ * A thread keeps reading from the device into a ring buffer, so that a
+ * read waits for data on an event with the asyn timeout instead of polling.
+ */
+#ifndef ftdiReader_H
+#define ftdiReader_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FTDI_READER_OK          0
+#define FTDI_READER_TIMEOUT     1
+#define FTDI_READER_ERROR       (-1)
+
+/*
+ * Read up to len bytes from the device.  Returns the number of bytes read,
+ * which may be 0, or a negative value on error.  The function should block
+ * for a short time when no data is available, as ftdi_read_data does for
+ * one latency timer period, so the reader thread does not spin.
+ */
+typedef int (*ftdiReadFunc)(void *ctx, unsigned char *buf, int len);
+
+typedef struct ftdiReader ftdiReader;
+
+/*
+ * Start a reader thread calling readFunc with chunkSize byte reads.
+ * Data is held in a ring buffer of bufferSize bytes.  When it is full the
+ * thread stops reading, leaving further data in the device.
+ */
+ftdiReader *ftdiReaderCreate(const char *name, ftdiReadFunc readFunc, void *ctx,
+                             int chunkSize, int bufferSize);
+
+/*
+ * Copy whatever data is buffered, up to size bytes, into buf.
+ * If there is none wait up to timeout seconds for some to arrive.
+ * A negative timeout waits forever.
+ * Returns FTDI_READER_OK, FTDI_READER_TIMEOUT with *nRead = 0, or
+ * FTDI_READER_ERROR once the device read has failed and the buffer is empty.
+ */
+int ftdiReaderRead(ftdiReader *preader, unsigned char *buf, size_t size,
+                   size_t *nRead, double timeout);
+
+/* Discard buffered data */
+void ftdiReaderFlush(ftdiReader *preader);
+
+/*
+ * The device context is not thread safe.  ftdiReaderPause waits for the
+ * read in progress, if any, to return and keeps the thread from reading
+ * until ftdiReaderResume is called, so the caller can use the context.
+ */
+void ftdiReaderPause(ftdiReader *preader);
+void ftdiReaderResume(ftdiReader *preader);
+
+/* Number of bytes currently buffered */
+int ftdiReaderUsed(ftdiReader *preader);
+
+/* Stop the thread, waiting for the read in progress to return, and free the reader */
+void ftdiReaderDestroy(ftdiReader *preader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ftdiReader_H */
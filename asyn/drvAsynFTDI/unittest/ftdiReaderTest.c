@@ -0,0 +1,247 @@
+/*
+ * Tests for the FTDI background reader against a mock libftdi backend
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsEvent.h>
+#include <epicsRingBytes.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "ftdiReader.h"
+
+#define CHUNK_SIZE   512
+#define BUFFER_SIZE  (2*CHUNK_SIZE)
+#define LATENCY      0.002
+
+/*
+ * Mock device.  Bytes "received" by the chip wait in a ring buffer.
+ * Like ftdi_read_data, a read returns what is there, or 0 after one
+ * latency timer period when nothing is.
+ */
+typedef struct mockDevice {
+    epicsRingBytesId  input;
+    volatile int      fail;
+    volatile int      maxLen;
+    volatile int      nCalls;
+} mockDevice;
+
+static int
+mockRead(void *ctx, unsigned char *buf, int len)
+{
+    mockDevice *pmock = (mockDevice *)ctx;
+    int n;
+
+    pmock->nCalls++;
+    if (len > pmock->maxLen)
+        pmock->maxLen = len;
+    if (pmock->fail)
+        return -1;
+    n = epicsRingBytesGet(pmock->input, (char *)buf, len);
+    if (n == 0)
+        epicsThreadSleep(LATENCY);
+    return n;
+}
+
+static void
+mockSend(mockDevice *pmock, int first, int n)
+{
+    int i;
+
+    for (i = first; i < first + n; i++) {
+        char c = (char)(i % 251);
+
+        while (epicsRingBytesPut(pmock->input, &c, 1) == 0)
+            epicsThreadSleep(LATENCY);
+    }
+}
+
+typedef struct delayedSend {
+    mockDevice   *pmock;
+    double       delay;
+    int          n;
+    epicsEventId done;
+} delayedSend;
+
+static void
+delayedSendThread(void *arg)
+{
+    delayedSend *pds = (delayedSend *)arg;
+
+    epicsThreadSleep(pds->delay);
+    mockSend(pds->pmock, 0, pds->n);
+    epicsEventSignal(pds->done);
+}
+
+static double
+elapsedSince(const epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    return epicsTimeDiffInSeconds(&now, start);
+}
+
+static int
+streamOk(const unsigned char *buf, int first, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (buf[i] != (unsigned char)((first + i) % 251))
+            return 0;
+    return 1;
+}
+
+/* Read n bytes in as many calls as it takes */
+static int
+readAll(ftdiReader *preader, unsigned char *buf, int n)
+{
+    int total = 0;
+
+    while (total < n) {
+        size_t nRead;
+
+        if (ftdiReaderRead(preader, buf + total, n - total, &nRead, 1.0) != FTDI_READER_OK)
+            break;
+        total += (int)nRead;
+    }
+    return total;
+}
+
+static void
+testTimeout(ftdiReader *preader)
+{
+    unsigned char buf[64];
+    epicsTimeStamp start;
+    size_t nRead;
+    double t;
+    int s;
+
+    testDiag("No data");
+    epicsTimeGetCurrent(&start);
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 0.1);
+    t = elapsedSince(&start);
+    testOk(s == FTDI_READER_TIMEOUT, "status %d", s);
+    testOk(nRead == 0, "read %d bytes", (int)nRead);
+    testOk(t >= 0.09 && t < 0.5, "timed out after %.3f s", t);
+
+    epicsTimeGetCurrent(&start);
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 0.0);
+    t = elapsedSince(&start);
+    testOk(s == FTDI_READER_TIMEOUT, "zero timeout status %d", s);
+    testOk(t < 0.05, "zero timeout returned after %.3f s", t);
+}
+
+static void
+testWakeup(mockDevice *pmock, ftdiReader *preader)
+{
+    unsigned char buf[64];
+    delayedSend ds;
+    epicsTimeStamp start;
+    size_t nRead;
+    double t;
+    int s, total;
+
+    testDiag("Data arriving during the wait");
+    ds.pmock = pmock;
+    ds.delay = 0.05;
+    ds.n = 10;
+    ds.done = epicsEventMustCreate(epicsEventEmpty);
+    epicsTimeGetCurrent(&start);
+    epicsThreadCreate("delayedSend", epicsThreadPriorityHigh,
+                      epicsThreadGetStackSize(epicsThreadStackSmall),
+                      delayedSendThread, &ds);
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 2.0);
+    t = elapsedSince(&start);
+    testOk(s == FTDI_READER_OK, "status %d", s);
+    testOk(t < 0.5, "woke after %.3f s of a 2 s timeout", t);
+    total = (int)nRead;
+    epicsEventMustWait(ds.done);
+    total += readAll(preader, buf + total, ds.n - total);
+    testOk(total == ds.n && streamOk(buf, 0, total), "received %d bytes", total);
+    epicsEventDestroy(ds.done);
+}
+
+static void
+testLongStream(mockDevice *pmock, ftdiReader *preader)
+{
+    int n = 20 * CHUNK_SIZE + 17;
+    unsigned char *buf = malloc(n);
+    int total;
+
+    testDiag("Stream longer than the ring buffer");
+    mockSend(pmock, 0, BUFFER_SIZE);
+    mockSend(pmock, BUFFER_SIZE, CHUNK_SIZE);
+    epicsThreadSleep(0.1);
+    testOk(ftdiReaderUsed(preader) <= BUFFER_SIZE,
+           "%d bytes buffered", ftdiReaderUsed(preader));
+    mockSend(pmock, BUFFER_SIZE + CHUNK_SIZE, n - BUFFER_SIZE - CHUNK_SIZE);
+    total = readAll(preader, buf, n);
+    testOk(total == n, "received %d of %d bytes", total, n);
+    testOk(streamOk(buf, 0, total), "no bytes lost or reordered");
+    testOk(pmock->maxLen == CHUNK_SIZE, "reads of %d bytes", pmock->maxLen);
+    free(buf);
+}
+
+static void
+testFlush(mockDevice *pmock, ftdiReader *preader)
+{
+    unsigned char buf[64];
+    size_t nRead;
+    int s, i;
+
+    testDiag("Flush");
+    mockSend(pmock, 0, 20);
+    for (i = 0; (i < 100) && (ftdiReaderUsed(preader) < 20); i++)
+        epicsThreadSleep(0.01);
+    testOk(ftdiReaderUsed(preader) == 20, "%d bytes buffered", ftdiReaderUsed(preader));
+    ftdiReaderFlush(preader);
+    testOk(ftdiReaderUsed(preader) == 0, "%d bytes after flush", ftdiReaderUsed(preader));
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 0.05);
+    testOk(s == FTDI_READER_TIMEOUT, "status %d", s);
+}
+
+static void
+testError(mockDevice *pmock, ftdiReader *preader)
+{
+    unsigned char buf[64];
+    size_t nRead;
+    int s;
+
+    testDiag("Device read fails");
+    mockSend(pmock, 0, 5);
+    epicsThreadSleep(0.05);
+    pmock->fail = 1;
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 1.0);
+    testOk(s == FTDI_READER_OK && nRead == 5, "buffered data still read, status %d", s);
+    s = ftdiReaderRead(preader, buf, sizeof buf, &nRead, 1.0);
+    testOk(s == FTDI_READER_ERROR, "then status %d", s);
+}
+
+MAIN(ftdiReaderTest)
+{
+    mockDevice mock;
+    ftdiReader *preader;
+
+    testPlan(18);
+    memset(&mock, 0, sizeof mock);
+    mock.input = epicsRingBytesLockedCreate(64 * 1024);
+    preader = ftdiReaderCreate("ftdiReaderTest", mockRead, &mock,
+                               CHUNK_SIZE, BUFFER_SIZE);
+    if (!preader)
+        testAbort("Can't create reader");
+    testTimeout(preader);
+    testWakeup(&mock, preader);
+    testLongStream(&mock, preader);
+    testFlush(&mock, preader);
+    testError(&mock, preader);
+    ftdiReaderDestroy(preader);
+    testOk(1, "reader stopped");
+    epicsRingBytesDelete(mock.input);
+    return testDone();
+}
@@ -0,0 +1,1096 @@
+/*
+ * HiSLIP (IVI-6.1 High Speed LAN Instrument Protocol) driver
+ *
+ * A HiSLIP session uses two TCP connections to the instrument, the
+ * synchronous channel for data and the asynchronous channel for
+ * device clear, status queries, remote/local control and service requests.
+ * Each connection is a drvAsynIPPort port, and this driver registers
+ * itself with asynGpib, so it provides asynCommon, asynOctet and asynGpib.
+ *
+ * The session is run in synchronized mode: every query is written as a
+ * DataEnd message and the response is read until the matching DataEnd.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTypes.h>
+#include <epicsExport.h>
+#include <cantProceed.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <asynGpibDriver.h>
+#include <asynCommonSyncIO.h>
+#include <asynOctetSyncIO.h>
+#include <asynOctet.h>
+#include <drvAsynIPPort.h>
+
+#define HISLIP_DEFAULT_PORT         4880
+#define HISLIP_HEADER_SIZE          16
+#define HISLIP_PROTOCOL_VERSION     0x0100
+#define HISLIP_VENDOR_ID            (('A' << 8) | 'S')
+#define HISLIP_INITIAL_MESSAGE_ID   0xffffff00U
+#define HISLIP_UNKNOWN_MESSAGE_ID   0xffffffffU
+#define HISLIP_MAX_RECEIVE_SIZE     (1 << 30)
+#define HISLIP_ASYNC_PAYLOAD_SIZE   256
+#define ASYNC_TIMEOUT               2.0
+#define ASYNC_POLL_TIME             0.1
+
+/*
+ * Message types
+ */
+enum {
+    hislipInitialize                        = 0,
+    hislipInitializeResponse                = 1,
+    hislipFatalError                        = 2,
+    hislipError                             = 3,
+    hislipAsyncLock                         = 4,
+    hislipAsyncLockResponse                 = 5,
+    hislipData                              = 6,
+    hislipDataEnd                           = 7,
+    hislipDeviceClearComplete               = 8,
+    hislipDeviceClearAcknowledge            = 9,
+    hislipAsyncRemoteLocalControl           = 10,
+    hislipAsyncRemoteLocalResponse          = 11,
+    hislipTrigger                           = 12,
+    hislipInterrupted                       = 13,
+    hislipAsyncInterrupted                  = 14,
+    hislipAsyncMaximumMessageSize           = 15,
+    hislipAsyncMaximumMessageSizeResponse   = 16,
+    hislipAsyncInitialize                   = 17,
+    hislipAsyncInitializeResponse           = 18,
+    hislipAsyncDeviceClear                  = 19,
+    hislipAsyncServiceRequest               = 20,
+    hislipAsyncStatusQuery                  = 21,
+    hislipAsyncStatusResponse               = 22,
+    hislipAsyncDeviceClearAcknowledge       = 23
+};
+
+/*
+ * AsyncRemoteLocalControl control codes
+ */
+enum {
+    hislipRemoteDisable         = 0,
+    hislipRemoteEnable          = 1,
+    hislipLocalLockout          = 4,
+    hislipGoToLocal             = 6
+};
+
+typedef struct hislipHeader {
+    int          messageType;
+    int          controlCode;
+    epicsUInt32  parameter;
+    epicsUInt64  payloadLength;
+} hislipHeader;
+
+/*
+ * Driver private storage
+ */
+typedef struct dPvt {
+    char        *portName;
+    void        *asynGpibPvt;
+
+    /*
+     * Links to lower-level drivers, one for each channel
+     */
+    char        *host;
+    char        *subAddress;
+    char        *portNameSync;
+    char        *portNameAsync;
+    asynUser    *pasynUserSyncCommon;
+    asynUser    *pasynUserSyncOctet;
+    asynUser    *pasynUserAsyncCommon;
+    asynUser    *pasynUserAsyncOctet;
+    asynUser    *pasynUserSerialPoll;   /* serialPoll has no caller asynUser */
+
+    /*
+     * Session state
+     */
+    int          sessionId;
+    int          serverProtocolVersion;
+    int          serverVendorId;
+    int          overlapMode;
+    epicsUInt64  maxMessageSize;
+    epicsUInt32  messageId;
+    epicsUInt32  lastMessageId;
+    int          rmtDelivered;
+    int          eos;
+
+    /*
+     * Input staging buffer
+     */
+    char        *buf;
+    size_t       bufCapacity;
+    size_t       bufCount;
+    size_t       bufIndex;
+    int          bufEnd;
+
+    /*
+     * Asynchronous channel reader.
+     * asyncReadLock is held by asyncThread while it reads a message and by
+     * (re)connect and disconnect, so the reader never consumes the replies
+     * of the initialization sequence or reads a channel being torn down.
+     */
+    epicsMutexId asyncReadLock;
+    epicsMutexId lock;
+    epicsEventId asyncActiveEvent;
+    epicsEventId asyncResponseEvent;
+    int          asyncActive;
+    int          srqEnabled;
+    int          srqPending;
+    hislipHeader asyncResponse;
+    char         asyncPayload[HISLIP_ASYNC_PAYLOAD_SIZE];
+
+    /*
+     * Statistics
+     */
+    unsigned long nTransactions;
+    unsigned long nMessagesSent;
+    unsigned long nMessagesReceived;
+    unsigned long nDiscarded;
+    unsigned long nSRQ;
+} dPvt;
+
+static const char *driverName = "drvAsynHiSLIP";
+
+static void
+encodeHeader(unsigned char *cp, int messageType, int controlCode,
+             epicsUInt32 parameter, epicsUInt64 payloadLength)
+{
+    int i;
+
+    cp[0] = 'H';
+    cp[1] = 'S';
+    cp[2] = (unsigned char)messageType;
+    cp[3] = (unsigned char)controlCode;
+    for (i = 0 ; i < 4 ; i++)
+        cp[4+i] = (unsigned char)(parameter >> (8 * (3 - i)));
+    for (i = 0 ; i < 8 ; i++)
+        cp[8+i] = (unsigned char)(payloadLength >> (8 * (7 - i)));
+}
+
+static epicsUInt64
+decodeUInt64(const unsigned char *cp)
+{
+    epicsUInt64 v = 0;
+    int i;
+
+    for (i = 0 ; i < 8 ; i++)
+        v = (v << 8) | cp[i];
+    return v;
+}
+
+/*
+ * Read exactly n bytes.
+ * If nothing arrives within firstTimeout return asynTimeout with *nRead = 0,
+ * once the first byte has arrived wait up to timeout for the rest.
+ */
+static asynStatus
+readBytes(asynUser *pasynUserOctet, char *buf, size_t n,
+          double firstTimeout, double timeout, size_t *nRead)
+{
+    size_t nt;
+    int eom;
+    asynStatus status;
+
+    *nRead = 0;
+    while (*nRead < n) {
+        status = pasynOctetSyncIO->read(pasynUserOctet, buf + *nRead, n - *nRead,
+                                        (*nRead == 0) ? firstTimeout : timeout,
+                                        &nt, &eom);
+        if (status != asynSuccess)
+            return status;
+        *nRead += nt;
+    }
+    return asynSuccess;
+}
+
+static asynStatus
+readHeader(asynUser *pasynUserOctet, asynUser *pasynUser, hislipHeader *phdr,
+           double firstTimeout, double timeout)
+{
+    unsigned char cp[HISLIP_HEADER_SIZE];
+    size_t nRead;
+    asynStatus status;
+
+    status = readBytes(pasynUserOctet, (char *)cp, sizeof cp, firstTimeout, timeout, &nRead);
+    if (status != asynSuccess) {
+        if (pasynUser && (status != asynTimeout))
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "%s", pasynUserOctet->errorMessage);
+        return ((status == asynTimeout) && (nRead > 0)) ? asynError : status;
+    }
+    if ((cp[0] != 'H') || (cp[1] != 'S')) {
+        if (pasynUser)
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "Invalid HiSLIP message prologue %#x %#x", cp[0], cp[1]);
+        return asynError;
+    }
+    phdr->messageType = cp[2];
+    phdr->controlCode = cp[3];
+    phdr->parameter = ((epicsUInt32)cp[4] << 24) | ((epicsUInt32)cp[5] << 16) |
+                      ((epicsUInt32)cp[6] << 8) | cp[7];
+    phdr->payloadLength = decodeUInt64(cp + 8);
+    return asynSuccess;
+}
+
+/*
+ * Read a payload, keeping at most size bytes and discarding the rest
+ */
+static asynStatus
+readPayload(asynUser *pasynUserOctet, char *buf, size_t size,
+            epicsUInt64 payloadLength, double timeout)
+{
+    char discard[256];
+    size_t n, nRead;
+    asynStatus status;
+
+    n = (payloadLength < size) ? (size_t)payloadLength : size;
+    if (n) {
+        status = readBytes(pasynUserOctet, buf, n, timeout, timeout, &nRead);
+        if (status != asynSuccess)
+            return status;
+        payloadLength -= n;
+    }
+    while (payloadLength) {
+        n = (payloadLength < sizeof discard) ? (size_t)payloadLength : sizeof discard;
+        status = readBytes(pasynUserOctet, discard, n, timeout, timeout, &nRead);
+        if (status != asynSuccess)
+            return status;
+        payloadLength -= n;
+    }
+    return asynSuccess;
+}
+
+static asynStatus
+sendMessage(dPvt *pdpvt, asynUser *pasynUserOctet, asynUser *pasynUser,
+            int messageType, int controlCode, epicsUInt32 parameter,
+            const char *payload, size_t payloadLength, double timeout)
+{
+    unsigned char hdr[HISLIP_HEADER_SIZE];
+    size_t nt;
+    asynStatus status;
+
+    encodeHeader(hdr, messageType, controlCode, parameter, payloadLength);
+    status = pasynOctetSyncIO->write(pasynUserOctet, (char *)hdr, sizeof hdr, timeout, &nt);
+    if ((status == asynSuccess) && payloadLength)
+        status = pasynOctetSyncIO->write(pasynUserOctet, payload, payloadLength, timeout, &nt);
+    if (status != asynSuccess) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "%s", pasynUserOctet->errorMessage);
+        return status;
+    }
+    pdpvt->nMessagesSent++;
+    return asynSuccess;
+}
+
+/*
+ * Send a message on the asynchronous channel and wait for its response.
+ * The response is received by the asynchronous channel reader thread.
+ */
+static asynStatus
+asyncTransaction(dPvt *pdpvt, asynUser *pasynUser,
+                 int messageType, int controlCode, epicsUInt32 parameter,
+                 int responseType, hislipHeader *presponse, double timeout)
+{
+    asynStatus status;
+
+    if (!pdpvt->asyncActive) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "%s not connected", pdpvt->portName);
+        return asynDisconnected;
+    }
+    epicsEventTryWait(pdpvt->asyncResponseEvent);
+    status = sendMessage(pdpvt, pdpvt->pasynUserAsyncOctet, pasynUser,
+                         messageType, controlCode, parameter, NULL, 0, timeout);
+    if (status != asynSuccess)
+        return status;
+    for (;;) {
+        if (epicsEventWaitWithTimeout(pdpvt->asyncResponseEvent, timeout) != epicsEventWaitOK) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "Timeout waiting for HiSLIP message type %d", responseType);
+            return asynTimeout;
+        }
+        epicsMutexMustLock(pdpvt->lock);
+        *presponse = pdpvt->asyncResponse;
+        epicsMutexUnlock(pdpvt->lock);
+        if (presponse->messageType == responseType)
+            return asynSuccess;
+        if ((presponse->messageType == hislipError)
+         || (presponse->messageType == hislipFatalError)) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "HiSLIP error %d: %s", presponse->controlCode, pdpvt->asyncPayload);
+            return asynError;
+        }
+        pdpvt->nDiscarded++;
+    }
+}
+
+static void
+asyncThread(void *arg)
+{
+    dPvt *pdpvt = (dPvt *)arg;
+    hislipHeader hdr;
+    char payload[HISLIP_ASYNC_PAYLOAD_SIZE];
+    asynStatus status;
+    int srqEnabled;
+
+    for (;;) {
+        epicsMutexMustLock(pdpvt->asyncReadLock);
+        if (!pdpvt->asyncActive) {
+            epicsMutexUnlock(pdpvt->asyncReadLock);
+            epicsEventMustWait(pdpvt->asyncActiveEvent);
+            continue;
+        }
+        status = readHeader(pdpvt->pasynUserAsyncOctet, NULL, &hdr,
+                            ASYNC_POLL_TIME, ASYNC_TIMEOUT);
+        if (status == asynSuccess) {
+            memset(payload, 0, sizeof payload);
+            status = readPayload(pdpvt->pasynUserAsyncOctet, payload,
+                                 sizeof payload - 1, hdr.payloadLength, ASYNC_TIMEOUT);
+        }
+        if ((status != asynSuccess) && (status != asynTimeout))
+            asynPrint(pdpvt->pasynUserAsyncOctet, ASYN_TRACE_ERROR,
+                      "%s %s asynchronous channel read error %s\n",
+                      pdpvt->portName, driverName, pdpvt->pasynUserAsyncOctet->errorMessage);
+        epicsMutexUnlock(pdpvt->asyncReadLock);
+        if (status == asynTimeout)
+            continue;
+        if (status != asynSuccess) {
+            /* Don't spin while the connection is being torn down */
+            epicsThreadSleep(ASYNC_POLL_TIME);
+            continue;
+        }
+        pdpvt->nMessagesReceived++;
+        if (hdr.messageType == hislipAsyncServiceRequest) {
+            epicsMutexMustLock(pdpvt->lock);
+            pdpvt->srqPending = 1;
+            pdpvt->nSRQ++;
+            srqEnabled = pdpvt->srqEnabled;
+            epicsMutexUnlock(pdpvt->lock);
+            asynPrint(pdpvt->pasynUserAsyncOctet, ASYN_TRACE_FLOW,
+                      "%s %s AsyncServiceRequest\n", pdpvt->portName, driverName);
+            if (srqEnabled)
+                pasynGpib->srqHappened(pdpvt->asynGpibPvt);
+            continue;
+        }
+        epicsMutexMustLock(pdpvt->lock);
+        pdpvt->asyncResponse = hdr;
+        memcpy(pdpvt->asyncPayload, payload, sizeof pdpvt->asyncPayload);
+        epicsMutexUnlock(pdpvt->lock);
+        epicsEventSignal(pdpvt->asyncResponseEvent);
+    }
+}
+
+/*
+ * Get more space for input buffer
+ */
+static asynStatus
+resizeBuffer(dPvt *pdpvt, asynUser *pasynUser, size_t size)
+{
+    char *np;
+
+    if (size <= pdpvt->bufCapacity)
+        return asynSuccess;
+    if ((np = realloc(pdpvt->buf, size)) == NULL) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                      "Can't allocate memory for input buffer");
+        return asynError;
+    }
+    pdpvt->buf = np;
+    pdpvt->bufCapacity = size;
+    return asynSuccess;
+}
+
+static void
+resetSession(dPvt *pdpvt)
+{
+    pdpvt->messageId = HISLIP_INITIAL_MESSAGE_ID;
+    pdpvt->lastMessageId = HISLIP_UNKNOWN_MESSAGE_ID;
+    pdpvt->rmtDelivered = 0;
+    pdpvt->bufCount = 0;
+    pdpvt->bufIndex = 0;
+    pdpvt->bufEnd = 0;
+}
+
+/*
+ * Open both channels and run the HiSLIP initialization sequence
+ */
+static asynStatus
+initializeSession(dPvt *pdpvt, asynUser *pasynUser)
+{
+    hislipHeader hdr;
+    unsigned char size[8];
+    int i;
+    asynStatus status;
+
+    resetSession(pdpvt);
+    status = pasynCommonSyncIO->connectDevice(pdpvt->pasynUserSyncCommon);
+    if (status != asynSuccess) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "%s", pdpvt->pasynUserSyncCommon->errorMessage);
+        return status;
+    }
+    status = sendMessage(pdpvt, pdpvt->pasynUserSyncOctet, pasynUser, hislipInitialize, 0,
+                         ((epicsUInt32)HISLIP_PROTOCOL_VERSION << 16) | HISLIP_VENDOR_ID,
+                         pdpvt->subAddress, strlen(pdpvt->subAddress), ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    status = readHeader(pdpvt->pasynUserSyncOctet, pasynUser, &hdr, ASYNC_TIMEOUT, ASYNC_TIMEOUT);
+    if (status == asynSuccess)
+        status = readPayload(pdpvt->pasynUserSyncOctet, pdpvt->asyncPayload,
+                             sizeof pdpvt->asyncPayload - 1, hdr.payloadLength, ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    if (hdr.messageType != hislipInitializeResponse) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Initialize failed, message type %d control code %d",
+                      hdr.messageType, hdr.controlCode);
+        return asynError;
+    }
+    pdpvt->overlapMode = hdr.controlCode & 0x1;
+    pdpvt->serverProtocolVersion = (int)(hdr.parameter >> 16);
+    pdpvt->sessionId = (int)(hdr.parameter & 0xFFFF);
+
+    status = pasynCommonSyncIO->connectDevice(pdpvt->pasynUserAsyncCommon);
+    if (status != asynSuccess) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "%s", pdpvt->pasynUserAsyncCommon->errorMessage);
+        return status;
+    }
+    status = sendMessage(pdpvt, pdpvt->pasynUserAsyncOctet, pasynUser, hislipAsyncInitialize, 0,
+                         (epicsUInt32)pdpvt->sessionId, NULL, 0, ASYNC_TIMEOUT);
+    if (status == asynSuccess)
+        status = readHeader(pdpvt->pasynUserAsyncOctet, pasynUser, &hdr, ASYNC_TIMEOUT, ASYNC_TIMEOUT);
+    if (status == asynSuccess)
+        status = readPayload(pdpvt->pasynUserAsyncOctet, NULL, 0, hdr.payloadLength, ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    if (hdr.messageType != hislipAsyncInitializeResponse) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "AsyncInitialize failed, message type %d", hdr.messageType);
+        return asynError;
+    }
+    pdpvt->serverVendorId = (int)(hdr.parameter & 0xFFFF);
+
+    /*
+     * Exchange maximum message sizes
+     */
+    for (i = 0 ; i < 8 ; i++)
+        size[i] = (unsigned char)((epicsUInt64)HISLIP_MAX_RECEIVE_SIZE >> (8 * (7 - i)));
+    status = sendMessage(pdpvt, pdpvt->pasynUserAsyncOctet, pasynUser,
+                         hislipAsyncMaximumMessageSize, 0, 0,
+                         (char *)size, sizeof size, ASYNC_TIMEOUT);
+    if (status == asynSuccess)
+        status = readHeader(pdpvt->pasynUserAsyncOctet, pasynUser, &hdr, ASYNC_TIMEOUT, ASYNC_TIMEOUT);
+    if (status == asynSuccess)
+        status = readPayload(pdpvt->pasynUserAsyncOctet, (char *)size, sizeof size,
+                             hdr.payloadLength, ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    if ((hdr.messageType == hislipAsyncMaximumMessageSizeResponse) && (hdr.payloadLength >= 8))
+        pdpvt->maxMessageSize = decodeUInt64(size);
+    if (pdpvt->maxMessageSize == 0)
+        pdpvt->maxMessageSize = HISLIP_MAX_RECEIVE_SIZE;
+
+    /*
+     * From now on the asynchronous channel is read by asyncThread
+     */
+    pdpvt->asyncActive = 1;
+    epicsEventSignal(pdpvt->asyncActiveEvent);
+    return asynSuccess;
+}
+
+static void
+closeSession(dPvt *pdpvt)
+{
+    epicsMutexMustLock(pdpvt->asyncReadLock);
+    pdpvt->asyncActive = 0;
+    pasynCommonSyncIO->disconnectDevice(pdpvt->pasynUserAsyncCommon);
+    pasynCommonSyncIO->disconnectDevice(pdpvt->pasynUserSyncCommon);
+    resetSession(pdpvt);
+    epicsMutexUnlock(pdpvt->asyncReadLock);
+}
+
+/*
+ * Device clear, IVI-6.1 section 6.12
+ */
+static asynStatus
+deviceClear(dPvt *pdpvt, asynUser *pasynUser)
+{
+    hislipHeader hdr;
+    int featurePreference;
+    asynStatus status;
+
+    status = asyncTransaction(pdpvt, pasynUser, hislipAsyncDeviceClear, 0, 0,
+                              hislipAsyncDeviceClearAcknowledge, &hdr, ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    featurePreference = hdr.controlCode;
+    status = sendMessage(pdpvt, pdpvt->pasynUserSyncOctet, pasynUser,
+                         hislipDeviceClearComplete, featurePreference, 0, NULL, 0, ASYNC_TIMEOUT);
+    if (status != asynSuccess)
+        return status;
+    /* Discard anything still in the synchronous channel up to the acknowledge */
+    for (;;) {
+        status = readHeader(pdpvt->pasynUserSyncOctet, pasynUser, &hdr, ASYNC_TIMEOUT, ASYNC_TIMEOUT);
+        if (status == asynSuccess)
+            status = readPayload(pdpvt->pasynUserSyncOctet, NULL, 0, hdr.payloadLength, ASYNC_TIMEOUT);
+        if (status != asynSuccess)
+            return status;
+        if (hdr.messageType == hislipDeviceClearAcknowledge)
+            break;
+        pdpvt->nDiscarded++;
+    }
+    pdpvt->overlapMode = hdr.controlCode & 0x1;
+    resetSession(pdpvt);
+    asynPrint(pasynUser, ASYN_TRACE_FLOW, "%s %s device clear\n", pdpvt->portName, driverName);
+    return asynSuccess;
+}
+
+static asynStatus
+remoteLocalControl(dPvt *pdpvt, asynUser *pasynUser, int code)
+{
+    hislipHeader hdr;
+
+    return asyncTransaction(pdpvt, pasynUser, hislipAsyncRemoteLocalControl, code,
+                            pdpvt->lastMessageId, hislipAsyncRemoteLocalResponse,
+                            &hdr, ASYNC_TIMEOUT);
+}
+
+static void
+hislipReport(void *drvPvt, FILE *fd, int details)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    fprintf(fd, "    HiSLIP host: %s, sub-address: %s, session: %d, mode: %s\n",
+            pdpvt->host, pdpvt->subAddress, pdpvt->sessionId,
+            pdpvt->overlapMode ? "overlapped" : "synchronized");
+    if (details >= 1) {
+        fprintf(fd, "    Server protocol version: %d.%d, vendor ID: %c%c, maximum message size: %llu\n",
+                pdpvt->serverProtocolVersion >> 8, pdpvt->serverProtocolVersion & 0xFF,
+                (pdpvt->serverVendorId >> 8) & 0xFF, pdpvt->serverVendorId & 0xFF,
+                (unsigned long long)pdpvt->maxMessageSize);
+        fprintf(fd, "    Transactions: %lu, messages sent: %lu, received: %lu, discarded: %lu, SRQs: %lu\n",
+                pdpvt->nTransactions, pdpvt->nMessagesSent, pdpvt->nMessagesReceived,
+                pdpvt->nDiscarded, pdpvt->nSRQ);
+    }
+}
+
+static asynStatus
+hislipConnect(void *drvPvt, asynUser *pasynUser)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    int address;
+    asynStatus status;
+
+    if ((status = pasynManager->getAddr(pasynUser, &address)) != asynSuccess)
+        return status;
+    if (address < 0) {
+        /* Keep asyncThread off the asynchronous channel until the session is up */
+        epicsMutexMustLock(pdpvt->asyncReadLock);
+        status = initializeSession(pdpvt, pasynUser);
+        if (status != asynSuccess)
+            closeSession(pdpvt);
+        epicsMutexUnlock(pdpvt->asyncReadLock);
+        if (status != asynSuccess)
+            return status;
+    }
+    pasynManager->exceptionConnect(pasynUser);
+    return asynSuccess;
+}
+
+static asynStatus
+hislipDisconnect(void *drvPvt, asynUser *pasynUser)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    int address;
+    asynStatus status;
+
+    if ((status = pasynManager->getAddr(pasynUser, &address)) != asynSuccess)
+        return status;
+    if (address < 0)
+        closeSession(pdpvt);
+    pasynManager->exceptionDisconnect(pasynUser);
+    return asynSuccess;
+}
+
+/*
+ * Read the response to the last DataEnd into the staging buffer.
+ * Data that belongs to an earlier message, for example the late response to
+ * a query that timed out, is discarded.
+ */
+static asynStatus
+readResponse(dPvt *pdpvt, asynUser *pasynUser)
+{
+    hislipHeader hdr;
+    size_t nRead;
+    asynStatus status;
+
+    pdpvt->bufCount = 0;
+    pdpvt->bufIndex = 0;
+    pdpvt->bufEnd = 0;
+    for (;;) {
+        status = readHeader(pdpvt->pasynUserSyncOctet, pasynUser, &hdr,
+                            pasynUser->timeout, pasynUser->timeout);
+        if (status != asynSuccess) {
+            if (status == asynTimeout)
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                              "Timeout waiting for HiSLIP response");
+            pdpvt->bufCount = 0;
+            return status;
+        }
+        pdpvt->nMessagesReceived++;
+        switch (hdr.messageType) {
+        case hislipData:
+        case hislipDataEnd:
+            if ((hdr.parameter != pdpvt->lastMessageId)
+             && (hdr.parameter != HISLIP_UNKNOWN_MESSAGE_ID)
+             && !pdpvt->overlapMode) {
+                asynPrint(pasynUser, ASYN_TRACE_WARNING,
+                          "%s %s discarding response to message %#x, expected %#x\n",
+                          pdpvt->portName, driverName, hdr.parameter, pdpvt->lastMessageId);
+                status = readPayload(pdpvt->pasynUserSyncOctet, NULL, 0,
+                                     hdr.payloadLength, pasynUser->timeout);
+                pdpvt->nDiscarded++;
+                if (status != asynSuccess)
+                    return status;
+                continue;
+            }
+            if (hdr.payloadLength > (epicsUInt64)(HISLIP_MAX_RECEIVE_SIZE - pdpvt->bufCount)) {
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                              "HiSLIP response too long");
+                pdpvt->bufCount = 0;
+                return asynError;
+            }
+            status = resizeBuffer(pdpvt, pasynUser, pdpvt->bufCount + (size_t)hdr.payloadLength);
+            if (status != asynSuccess) {
+                pdpvt->bufCount = 0;
+                return status;
+            }
+            status = readBytes(pdpvt->pasynUserSyncOctet, pdpvt->buf + pdpvt->bufCount,
+                               (size_t)hdr.payloadLength, pasynUser->timeout,
+                               pasynUser->timeout, &nRead);
+            if (status != asynSuccess) {
+                epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                              "%s", pdpvt->pasynUserSyncOctet->errorMessage);
+                pdpvt->bufCount = 0;
+                return status;
+            }
+            pdpvt->bufCount += nRead;
+            if (hdr.messageType == hislipDataEnd) {
+                pdpvt->bufEnd = 1;
+                pdpvt->rmtDelivered = 1;
+                return asynSuccess;
+            }
+            break;
+        case hislipError:
+        case hislipFatalError:
+            memset(pdpvt->asyncPayload, 0, sizeof pdpvt->asyncPayload);
+            readPayload(pdpvt->pasynUserSyncOctet, pdpvt->asyncPayload,
+                        sizeof pdpvt->asyncPayload - 1, hdr.payloadLength, pasynUser->timeout);
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "HiSLIP %serror %d: %s",
+                          (hdr.messageType == hislipFatalError) ? "fatal " : "",
+                          hdr.controlCode, pdpvt->asyncPayload);
+            pdpvt->bufCount = 0;
+            return asynError;
+        default:
+            /* Interrupted and anything else on this channel carries no data for us */
+            status = readPayload(pdpvt->pasynUserSyncOctet, NULL, 0,
+                                 hdr.payloadLength, pasynUser->timeout);
+            pdpvt->nDiscarded++;
+            if (status != asynSuccess)
+                return status;
+            if (hdr.messageType == hislipInterrupted)
+                pdpvt->bufCount = 0;
+            break;
+        }
+    }
+}
+
+static asynStatus
+hislipRead(void *drvPvt, asynUser *pasynUser,
+           char *data, int maxchars, int *nbytesTransferred, int *eomReason)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    size_t n;
+    int eom = 0;
+    asynStatus status;
+
+    /*
+     * Get the entire response on the first read following a write, flush or connect
+     */
+    *nbytesTransferred = 0;
+    if (pdpvt->bufIndex >= pdpvt->bufCount) {
+        if ((status = readResponse(pdpvt, pasynUser)) != asynSuccess)
+            return status;
+    }
+    n = pdpvt->bufCount - pdpvt->bufIndex;
+    if ((pdpvt->eos >= 0) && (n > 0)) {
+        char *cp = memchr(pdpvt->buf + pdpvt->bufIndex, pdpvt->eos, n);
+        if (cp && ((size_t)(cp - (pdpvt->buf + pdpvt->bufIndex)) < (size_t)maxchars)) {
+            n = cp - (pdpvt->buf + pdpvt->bufIndex) + 1;
+            eom |= ASYN_EOM_EOS;
+        }
+    }
+    if (n >= (size_t)maxchars) {
+        n = maxchars;
+        eom |= ASYN_EOM_CNT;
+    }
+    memcpy(data, pdpvt->buf + pdpvt->bufIndex, n);
+    pdpvt->bufIndex += n;
+    if ((pdpvt->bufIndex == pdpvt->bufCount) && pdpvt->bufEnd)
+        eom |= ASYN_EOM_END;
+    if (eomReason) *eomReason = eom;
+    *nbytesTransferred = (int)n; /* cast is safe: we already know n <= maxchars */
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, n,
+                "%s %s read %d EOM:%#x\n", pdpvt->portName, driverName, (int)n, eom);
+    return asynSuccess;
+}
+
+/*
+ * Write a complete message.  Messages longer than the server's maximum
+ * message size are split into Data messages followed by a DataEnd.
+ */
+static asynStatus
+hislipWrite(void *drvPvt, asynUser *pasynUser,
+            const char *data, int numchars, int *nbytesTransferred)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    size_t remaining = numchars;
+    size_t n;
+    int messageType;
+    asynStatus status;
+
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, numchars,
+                "%s %s write\n", pdpvt->portName, driverName);
+    *nbytesTransferred = 0;
+    pdpvt->bufCount = 0;
+    pdpvt->bufIndex = 0;
+    do {
+        n = (remaining > pdpvt->maxMessageSize) ? (size_t)pdpvt->maxMessageSize : remaining;
+        messageType = (n == remaining) ? hislipDataEnd : hislipData;
+        status = sendMessage(pdpvt, pdpvt->pasynUserSyncOctet, pasynUser,
+                             messageType, pdpvt->rmtDelivered, pdpvt->messageId,
+                             data, n, pasynUser->timeout);
+        if (status != asynSuccess)
+            return status;
+        pdpvt->rmtDelivered = 0;
+        pdpvt->lastMessageId = pdpvt->messageId;
+        pdpvt->messageId += 2;
+        data += n;
+        remaining -= n;
+        *nbytesTransferred += (int)n;
+    } while (remaining);
+    pdpvt->nTransactions++;
+    return asynSuccess;
+}
+
+static asynStatus
+hislipFlush(void *drvPvt, asynUser *pasynUser)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    pdpvt->bufCount = 0;
+    pdpvt->bufIndex = 0;
+    return asynSuccess;
+}
+
+static asynStatus
+hislipGetEos(void *drvPvt, asynUser *pasynUser,
+             char *eos, int eossize, int *eoslen)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    if (pdpvt->eos < 0) {
+        *eoslen = 0;
+    }
+    else {
+        *eoslen = 1;
+        if (eossize > 0)
+            *eos = pdpvt->eos;
+    }
+    return asynSuccess;
+}
+
+static asynStatus
+hislipSetEos(void *drvPvt, asynUser *pasynUser, const char *eos, int eoslen)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    switch (eoslen) {
+    case 0: pdpvt->eos = -1;          break;
+    case 1: pdpvt->eos = *eos & 0xFF; break;
+    default:
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                                                  "Invalid EOS");
+        return asynError;
+    }
+    return asynSuccess;
+}
+
+static asynStatus
+hislipAddressedCmd(void *drvPvt, asynUser *pasynUser,
+                   const char *data, int length)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    asynStatus status;
+
+    if (length != 1) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "hislipAddressedCmd only supports single byte commands");
+        return asynError;
+    }
+    switch (data[0]) {
+    case 0x04:  /* IBSDC */
+        return deviceClear(pdpvt, pasynUser);
+    case 0x08:  /* IBGET */
+        status = sendMessage(pdpvt, pdpvt->pasynUserSyncOctet, pasynUser,
+                             hislipTrigger, pdpvt->rmtDelivered, pdpvt->messageId,
+                             NULL, 0, pasynUser->timeout);
+        if (status == asynSuccess) {
+            pdpvt->rmtDelivered = 0;
+            pdpvt->lastMessageId = pdpvt->messageId;
+            pdpvt->messageId += 2;
+        }
+        return status;
+    case 0x01:  /* IBGTL */
+        return remoteLocalControl(pdpvt, pasynUser, hislipGoToLocal);
+    default:
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "hislipAddressedCmd %#x unimplemented", data[0] & 0xFF);
+        return asynError;
+    }
+}
+
+static asynStatus
+hislipUniversalCmd(void *drvPvt, asynUser *pasynUser, int cmd)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    switch (cmd) {
+    case IBDCL:
+        return deviceClear(pdpvt, pasynUser);
+    case IBLLO:
+        return remoteLocalControl(pdpvt, pasynUser, hislipLocalLockout);
+    default:
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "hislipUniversalCmd %#x unimplemented", cmd);
+        return asynError;
+    }
+}
+
+static asynStatus
+hislipIfc(void *drvPvt, asynUser *pasynUser)
+{
+    /* There is no bus to clear, the closest equivalent is a device clear */
+    return deviceClear((dPvt *)drvPvt, pasynUser);
+}
+
+static asynStatus
+hislipRen(void *drvPvt, asynUser *pasynUser, int onOff)
+{
+    return remoteLocalControl((dPvt *)drvPvt, pasynUser,
+                              onOff ? hislipRemoteEnable : hislipRemoteDisable);
+}
+
+static asynStatus
+hislipSrqStatus(void *drvPvt, int *srqStatus)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    epicsMutexMustLock(pdpvt->lock);
+    *srqStatus = pdpvt->srqPending;
+    epicsMutexUnlock(pdpvt->lock);
+    return asynSuccess;
+}
+
+static asynStatus
+hislipSrqEnable(void *drvPvt, int onOff)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+
+    epicsMutexMustLock(pdpvt->lock);
+    pdpvt->srqEnabled = onOff;
+    epicsMutexUnlock(pdpvt->lock);
+    return asynSuccess;
+}
+
+static asynStatus
+hislipSerialPollBegin(void *drvPvt)
+{
+    return asynSuccess;
+}
+
+static asynStatus
+hislipSerialPoll(void *drvPvt, int addr, double timeout, int *statusByte)
+{
+    dPvt *pdpvt = (dPvt *)drvPvt;
+    hislipHeader hdr;
+    asynStatus status;
+
+    status = asyncTransaction(pdpvt, pdpvt->pasynUserSerialPoll,
+                              hislipAsyncStatusQuery, pdpvt->rmtDelivered,
+                              pdpvt->lastMessageId, hislipAsyncStatusResponse,
+                              &hdr, (timeout > 0) ? timeout : ASYNC_TIMEOUT);
+    if (status != asynSuccess) {
+        asynPrint(pdpvt->pasynUserSerialPoll, ASYN_TRACE_ERROR,
+                  "%s %s serialPoll addr %d %s\n", pdpvt->portName, driverName,
+                  addr, pdpvt->pasynUserSerialPoll->errorMessage);
+        return status;
+    }
+    pdpvt->rmtDelivered = 0;
+    epicsMutexMustLock(pdpvt->lock);
+    pdpvt->srqPending = 0;
+    epicsMutexUnlock(pdpvt->lock);
+    *statusByte = hdr.controlCode & 0xFF;
+    return asynSuccess;
+}
+
+static asynStatus
+hislipSerialPollEnd(void *drvPvt)
+{
+    return asynSuccess;
+}
+
+static asynGpibPort hislipMethods = {
+    hislipReport,
+    hislipConnect,
+    hislipDisconnect,
+    hislipRead,
+    hislipWrite,
+    hislipFlush,
+    hislipSetEos,
+    hislipGetEos,
+    hislipAddressedCmd,
+    hislipUniversalCmd,
+    hislipIfc,
+    hislipRen,
+    hislipSrqStatus,
+    hislipSrqEnable,
+    hislipSerialPollBegin,
+    hislipSerialPoll,
+    hislipSerialPollEnd
+};
+
+static int
+drvAsynHiSLIPConfigure(const char *portName, const char *host,
+                       const char *subAddress, int priority, int noAutoConnect)
+{
+    dPvt *pdpvt;
+    char *hostTCP;
+
+    if ((portName == NULL) || (host == NULL)) {
+        printf("Usage: drvAsynHiSLIPConfigure(port, host, subAddress, priority, noAutoConnect)\n");
+        return -1;
+    }
+    if ((subAddress == NULL) || (subAddress[0] == '\0'))
+        subAddress = "hislip0";
+
+    /*
+     * Set up local storage
+     */
+    pdpvt = (dPvt *)callocMustSucceed(1, sizeof(dPvt), portName);
+    pdpvt->portName = epicsStrDup(portName);
+    pdpvt->host = epicsStrDup(host);
+    pdpvt->subAddress = epicsStrDup(subAddress);
+    pdpvt->bufCapacity = 4096;
+    pdpvt->buf = callocMustSucceed(1, pdpvt->bufCapacity, portName);
+    pdpvt->eos = -1;
+    pdpvt->maxMessageSize = HISLIP_MAX_RECEIVE_SIZE;
+    pdpvt->asyncReadLock = epicsMutexMustCreate();
+    pdpvt->lock = epicsMutexMustCreate();
+    pdpvt->asyncActiveEvent = epicsEventMustCreate(epicsEventEmpty);
+    pdpvt->asyncResponseEvent = epicsEventMustCreate(epicsEventEmpty);
+    resetSession(pdpvt);
+
+    /*
+     * Create the ports for the synchronous and asynchronous channels
+     */
+    hostTCP = callocMustSucceed(1, strlen(host)+20, portName);
+    if (strchr(host, ':'))
+        sprintf(hostTCP, "%s", host);
+    else
+        sprintf(hostTCP, "%s:%d TCP", host, HISLIP_DEFAULT_PORT);
+    pdpvt->portNameSync = callocMustSucceed(1, strlen(portName)+10, portName);
+    sprintf(pdpvt->portNameSync, "%s_SYNC", portName);
+    pdpvt->portNameAsync = callocMustSucceed(1, strlen(portName)+10, portName);
+    sprintf(pdpvt->portNameAsync, "%s_ASYNC", portName);
+    drvAsynIPPortConfigure(pdpvt->portNameSync, hostTCP, priority,
+                           1, /* No auto connect  */
+                           1  /* No process EOS */ );
+    drvAsynIPPortConfigure(pdpvt->portNameAsync, hostTCP, priority,
+                           1, /* No auto connect  */
+                           1  /* No process EOS */ );
+    free(hostTCP);
+    if ((pasynCommonSyncIO->connect(pdpvt->portNameSync, -1,
+                                    &pdpvt->pasynUserSyncCommon, NULL) != asynSuccess)
+     || (pasynOctetSyncIO->connect(pdpvt->portNameSync, -1,
+                                   &pdpvt->pasynUserSyncOctet, NULL) != asynSuccess)) {
+        printf("Can't find ASYN port \"%s\".\n", pdpvt->portNameSync);
+        return -1;
+    }
+    if ((pasynCommonSyncIO->connect(pdpvt->portNameAsync, -1,
+                                    &pdpvt->pasynUserAsyncCommon, NULL) != asynSuccess)
+     || (pasynOctetSyncIO->connect(pdpvt->portNameAsync, -1,
+                                   &pdpvt->pasynUserAsyncOctet, NULL) != asynSuccess)) {
+        printf("Can't find ASYN port \"%s\".\n", pdpvt->portNameAsync);
+        return -1;
+    }
+    epicsThreadMustCreate(pdpvt->portNameAsync,
+                          priority ? priority : epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          asyncThread, pdpvt);
+
+    /*
+     * Register as a GPIB driver
+     */
+    pdpvt->asynGpibPvt = pasynGpib->registerPort(pdpvt->portName,
+                                             ASYN_CANBLOCK | ASYN_MULTIDEVICE,
+                                             !noAutoConnect,
+                                             &hislipMethods,
+                                             pdpvt,
+                                             priority,
+                                             0);
+    if (pdpvt->asynGpibPvt == NULL) {
+        printf("registerPort failed\n");
+        return -1;
+    }
+    pdpvt->pasynUserSerialPoll = pasynManager->createAsynUser(0, 0);
+    if (pasynManager->connectDevice(pdpvt->pasynUserSerialPoll, pdpvt->portName, -1) != asynSuccess) {
+        printf("Can't connect serial poll asynUser to port \"%s\".\n", pdpvt->portName);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * IOC shell command registration
+ */
+static const iocshArg drvAsynHiSLIPConfigureArg0 = { "port",iocshArgString};
+static const iocshArg drvAsynHiSLIPConfigureArg1 = { "host",iocshArgString};
+static const iocshArg drvAsynHiSLIPConfigureArg2 = { "subAddress",iocshArgString};
+static const iocshArg drvAsynHiSLIPConfigureArg3 = { "priority",iocshArgInt};
+static const iocshArg drvAsynHiSLIPConfigureArg4 = { "noAutoConnect",iocshArgInt};
+static const iocshArg *drvAsynHiSLIPConfigureArgs[] = {
+                    &drvAsynHiSLIPConfigureArg0, &drvAsynHiSLIPConfigureArg1,
+                    &drvAsynHiSLIPConfigureArg2, &drvAsynHiSLIPConfigureArg3,
+                    &drvAsynHiSLIPConfigureArg4 };
+static const iocshFuncDef drvAsynHiSLIPConfigureFuncDef =
+      {"drvAsynHiSLIPConfigure", 5, drvAsynHiSLIPConfigureArgs};
+static void drvAsynHiSLIPConfigureCallFunc(const iocshArgBuf *args)
+{
+    drvAsynHiSLIPConfigure(args[0].sval, args[1].sval, args[2].sval,
+                           args[3].ival, args[4].ival);
+}
+
+static void
+drvAsynHiSLIP_RegisterCommands(void)
+{
+    iocshRegister(&drvAsynHiSLIPConfigureFuncDef,drvAsynHiSLIPConfigureCallFunc);
+}
+epicsExportRegistrar(drvAsynHiSLIP_RegisterCommands);
@@ -16,6 +16,7 @@
 #include <epicsMessageQueue.h>
 #include <epicsMutex.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
 #include <epicsExport.h>
 #include <cantProceed.h>
 #include <iocsh.h>
@@ -24,6 +25,7 @@
 #include <asynOctet.h>
 #include <asynInt32.h>
 #include <libusb-1.0/libusb.h>
+#include "usbtmcBulkIn.h"
 
 #define USBTMC_INTERFACE_CLASS    0xFE
 #define USBTMC_INTERFACE_SUBCLASS 0x03
@@ -36,6 +38,8 @@
 #define BULK_IO_PAYLOAD_CAPACITY    (1024*1024)
 #define BULK_IO_OUTPUT_EOS_CAPACITY 2
 #define IDSTRING_CAPACITY           100
+#define BULK_IN_CHUNK_SIZE          (16*1024)
+#define BULK_IN_DEPTH               4
 
 #define ASYN_REASON_SRQ 4345
 #define ASYN_REASON_STB 4346
@@ -117,6 +121,14 @@ typedef struct drvPvt {
     const unsigned char   *bufp;
     unsigned char          bulkInPacketFlags;
 
+    /*
+     * Bulk-IN transfers kept in flight for long responses
+     */
+    struct libusb_transfer *bulkInTransfer[USBTMC_BULK_IN_MAX_DEPTH];
+    int                    bulkInCompleted[USBTMC_BULK_IN_MAX_DEPTH];
+    int                    bulkInChunkSize;
+    int                    bulkInDepth;
+
     /*
      * Output EOS
      */
@@ -130,6 +142,7 @@ typedef struct drvPvt {
     size_t                 interruptCount;
     size_t                 bytesSentCount;
     size_t                 bytesReceivedCount;
+    size_t                 bulkInTransferCount;
 } drvPvt;
 
 static asynStatus disconnect(void *pvt, asynUser *pasynUser);
@@ -340,6 +353,9 @@ report(void *pvt, FILE *fp, int details)
         showCount(fp, "Interrupt", pdpvt->interruptCount);
         showCount(fp, "Send", pdpvt->bytesSentCount);
         showCount(fp, "Receive", pdpvt->bytesReceivedCount);
+        showCount(fp, "Bulk-IN transfer", pdpvt->bulkInTransferCount);
+        fprintf(fp, "%28s: %d x %d bytes\n", "Bulk-IN pipeline",
+                                pdpvt->bulkInDepth, pdpvt->bulkInChunkSize);
     }
     if (details >= 100) {
         int l = details % 100;
@@ -720,6 +736,78 @@ disconnect(void *pvt, asynUser *pasynUser)
 }
 static asynCommon commonMethods = { report, connect, disconnect };
 
+/*
+ * Bulk-IN transport for usbtmcBulkInRead using asynchronous libusb transfers
+ */
+static void LIBUSB_CALL
+bulkInCallback(struct libusb_transfer *transfer)
+{
+    *(int *)transfer->user_data = 1;
+}
+
+static int
+bulkInSubmit(void *pvt, int slot, unsigned char *buf, int len)
+{
+    drvPvt *pdpvt = (drvPvt *)pvt;
+
+    pdpvt->bulkInCompleted[slot] = 0;
+    libusb_fill_bulk_transfer(pdpvt->bulkInTransfer[slot], pdpvt->handle,
+                              pdpvt->bulkInEndpointAddress, buf, len,
+                              bulkInCallback, &pdpvt->bulkInCompleted[slot], 0);
+    pdpvt->bulkInTransferCount++;
+    return libusb_submit_transfer(pdpvt->bulkInTransfer[slot]);
+}
+
+static void
+bulkInCancel(void *pvt, int slot)
+{
+    drvPvt *pdpvt = (drvPvt *)pvt;
+
+    libusb_cancel_transfer(pdpvt->bulkInTransfer[slot]);
+}
+
+static int
+bulkInWait(void *pvt, int slot, double timeout, int *actual)
+{
+    drvPvt *pdpvt = (drvPvt *)pvt;
+    struct libusb_transfer *transfer = pdpvt->bulkInTransfer[slot];
+    epicsTimeStamp start, now;
+
+    epicsTimeGetCurrent(&start);
+    while (!pdpvt->bulkInCompleted[slot]) {
+        struct timeval tv;
+        double t = 1.0;
+
+        if (timeout >= 0) {
+            epicsTimeGetCurrent(&now);
+            t = timeout - epicsTimeDiffInSeconds(&now, &start);
+            if (t <= 0)
+                return USBTMC_BULK_IN_TIMEOUT;
+            if (t > 1.0) t = 1.0;
+        }
+        tv.tv_sec = (long)t;
+        tv.tv_usec = (long)((t - tv.tv_sec) * 1e6);
+        libusb_handle_events_timeout_completed(pdpvt->usb, &tv,
+                                               &pdpvt->bulkInCompleted[slot]);
+    }
+    *actual = transfer->actual_length;
+    switch (transfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED: return USBTMC_BULK_IN_OK;
+    case LIBUSB_TRANSFER_CANCELLED: return USBTMC_BULK_IN_CANCELLED;
+    case LIBUSB_TRANSFER_TIMED_OUT: return USBTMC_BULK_IN_TIMEOUT;
+    case LIBUSB_TRANSFER_STALL:     return LIBUSB_ERROR_PIPE;
+    case LIBUSB_TRANSFER_NO_DEVICE: return LIBUSB_ERROR_NO_DEVICE;
+    case LIBUSB_TRANSFER_OVERFLOW:  return LIBUSB_ERROR_OVERFLOW;
+    default:                        return LIBUSB_ERROR_IO;
+    }
+}
+
+static const usbtmcTransport bulkInTransport = {
+    bulkInSubmit,
+    bulkInCancel,
+    bulkInWait
+};
+
 /*
  * asynOctet methods
  */
@@ -887,9 +975,12 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
         /*
          * Read back
          */
-        s = libusb_bulk_transfer(pdpvt->handle, pdpvt->bulkInEndpointAddress, pdpvt->buf,
-                                            sizeof pdpvt->buf, &ioCount, timeout);
+        s = usbtmcBulkInRead(&bulkInTransport, pdpvt, pdpvt->buf, sizeof pdpvt->buf,
+                             pdpvt->bulkInChunkSize, pdpvt->bulkInDepth,
+                             timeout / 1000.0, &ioCount, NULL);
         if (s) {
+            if (s == USBTMC_BULK_IN_TIMEOUT) s = LIBUSB_ERROR_TIMEOUT;
+            if (s == USBTMC_BULK_IN_CANCELLED) s = LIBUSB_ERROR_INTERRUPTED;
             disconnectIfGone(pdpvt, pasynUser, s);
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                                     "Bulk read failed: %s", libusb_strerror(s));
@@ -1258,6 +1349,21 @@ usbtmcConfigure(const char *portName,
         pdpvt->serialNumber = NULL;
     pdpvt->termChar = -1;
     pdpvt->bTag = 1;
+    if (flags & 0x2) {
+        pdpvt->bulkInChunkSize = sizeof pdpvt->buf;
+        pdpvt->bulkInDepth = 1;
+    }
+    else {
+        pdpvt->bulkInChunkSize = BULK_IN_CHUNK_SIZE;
+        pdpvt->bulkInDepth = BULK_IN_DEPTH;
+    }
+    for (s = 0 ; s < USBTMC_BULK_IN_MAX_DEPTH ; s++) {
+        pdpvt->bulkInTransfer[s] = libusb_alloc_transfer(0);
+        if (pdpvt->bulkInTransfer[s] == NULL) {
+            printf("libusb_alloc_transfer() failed\n");
+            return;
+        }
+    }
     pdpvt->interruptTidMutex = epicsMutexMustCreate();
     pdpvt->pleaseTerminate = epicsEventMustCreate(epicsEventEmpty);
     pdpvt->didTerminate = epicsEventMustCreate(epicsEventEmpty);
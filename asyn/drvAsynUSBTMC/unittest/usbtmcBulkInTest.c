@@ -0,0 +1,272 @@
+/*
+ * Tests for pipelined USBTMC bulk-IN transfers against a mock device
+ *
+ ***************************************************************************
+ * Copyright (c) 2013 W. Eric Norum <wenorum@lbl.gov>                      *
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "usbtmcBulkIn.h"
+
+#define CHUNK_SIZE  1024
+#define CAPACITY    (64*1024)
+
+/*
+ * Mock USBTMC device.  A transfer takes data from the pending response
+ * when it is waited for; a transfer that gets less than it asked for
+ * ends with a short packet.  If zlp is set the response is followed by a
+ * zero-length packet, which ends the transfer that gets the last data if
+ * it asked for more, or else the next one.  With no data left a transfer
+ * stays queued.
+ */
+typedef struct mockDevice {
+    unsigned char *response;
+    int            responseSize;
+    int            position;
+    int            queued[USBTMC_BULK_IN_MAX_DEPTH];
+    int            cancelled[USBTMC_BULK_IN_MAX_DEPTH];
+    unsigned char *buf[USBTMC_BULK_IN_MAX_DEPTH];
+    int            len[USBTMC_BULK_IN_MAX_DEPTH];
+    int            inFlight;
+    int            maxInFlight;
+    int            failSubmit;
+    int            zlp;
+} mockDevice;
+
+static int
+mockSubmit(void *pvt, int slot, unsigned char *buf, int len)
+{
+    mockDevice *pmock = (mockDevice *)pvt;
+
+    if (pmock->failSubmit)
+        return -1;
+    if (pmock->queued[slot])
+        testAbort("Slot %d submitted twice", slot);
+    pmock->queued[slot] = 1;
+    pmock->cancelled[slot] = 0;
+    pmock->buf[slot] = buf;
+    pmock->len[slot] = len;
+    if (++pmock->inFlight > pmock->maxInFlight)
+        pmock->maxInFlight = pmock->inFlight;
+    return USBTMC_BULK_IN_OK;
+}
+
+static void
+mockCancel(void *pvt, int slot)
+{
+    mockDevice *pmock = (mockDevice *)pvt;
+
+    pmock->cancelled[slot] = 1;
+}
+
+static int
+mockWait(void *pvt, int slot, double timeout, int *actual)
+{
+    mockDevice *pmock = (mockDevice *)pvt;
+    int n = pmock->responseSize - pmock->position;
+
+    if (!pmock->queued[slot])
+        testAbort("Wait for slot %d which was not submitted", slot);
+    *actual = 0;
+    if (pmock->cancelled[slot]) {
+        pmock->queued[slot] = 0;
+        pmock->inFlight--;
+        return USBTMC_BULK_IN_CANCELLED;
+    }
+    if ((n == 0) && !pmock->zlp)
+        return USBTMC_BULK_IN_TIMEOUT;
+    if (n > pmock->len[slot])
+        n = pmock->len[slot];
+    memcpy(pmock->buf[slot], pmock->response + pmock->position, n);
+    pmock->position += n;
+    if ((pmock->position == pmock->responseSize) && (n < pmock->len[slot]))
+        pmock->zlp = 0;
+    pmock->queued[slot] = 0;
+    pmock->inFlight--;
+    *actual = n;
+    return USBTMC_BULK_IN_OK;
+}
+
+static const usbtmcTransport mockTransport = {
+    mockSubmit,
+    mockCancel,
+    mockWait
+};
+
+/*
+ * Queue a DEV_DEP_MSG_IN response with a payload of n bytes
+ */
+static void
+mockRespond(mockDevice *pmock, int n)
+{
+    int i, size = USBTMC_BULK_IN_HEADER_SIZE + n;
+
+    while (size & 0x3)
+        size++;
+    free(pmock->response);
+    memset(pmock, 0, sizeof *pmock);
+    pmock->response = calloc(1, size);
+    pmock->responseSize = size;
+    pmock->response[0] = 2;
+    pmock->response[1] = 1;
+    pmock->response[2] = (unsigned char)~1;
+    pmock->response[4] = n;
+    pmock->response[5] = n >> 8;
+    pmock->response[6] = n >> 16;
+    pmock->response[7] = n >> 24;
+    pmock->response[8] = 1;
+    for (i = 0 ; i < n ; i++)
+        pmock->response[USBTMC_BULK_IN_HEADER_SIZE + i] = i % 251;
+}
+
+static int
+payloadOk(const unsigned char *buf, int n)
+{
+    int i;
+
+    for (i = 0 ; i < n ; i++) {
+        if (buf[USBTMC_BULK_IN_HEADER_SIZE + i] != i % 251)
+            return 0;
+    }
+    return 1;
+}
+
+static unsigned char buf[CAPACITY];
+
+static void
+testShortResponse(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+
+    testDiag("Short response");
+    mockRespond(pmock, 100);
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 4,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_OK, "status %d", s);
+    testOk(nRead == 112, "read %d bytes", nRead);
+    testOk(nTransfers == 1, "%d transfers", nTransfers);
+    testOk1(payloadOk(buf, 100));
+}
+
+static void
+testLongResponse(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+    int n = CAPACITY - 1000;
+
+    testDiag("Long response");
+    mockRespond(pmock, n);
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 4,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_OK, "status %d", s);
+    testOk(nRead == pmock->responseSize, "read %d bytes", nRead);
+    testOk(pmock->maxInFlight == 4, "%d transfers in flight", pmock->maxInFlight);
+    testOk(nTransfers > 4, "%d transfers", nTransfers);
+    testOk(pmock->inFlight == 0, "%d transfers left", pmock->inFlight);
+    testOk1(payloadOk(buf, n));
+}
+
+static void
+testChunkBoundary(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+    int n = 3 * CHUNK_SIZE - USBTMC_BULK_IN_HEADER_SIZE;
+
+    testDiag("Response ending on a transfer boundary");
+    mockRespond(pmock, n);
+    pmock->zlp = 1;
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 4,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_OK, "status %d", s);
+    testOk(nRead == 3 * CHUNK_SIZE, "read %d bytes", nRead);
+    testOk(pmock->zlp == 0, "zero-length packet read");
+    testOk(pmock->inFlight == 0, "%d transfers left", pmock->inFlight);
+    testOk1(payloadOk(buf, n));
+}
+
+static void
+testZeroLengthPacket(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+    int n = 2 * CHUNK_SIZE - USBTMC_BULK_IN_HEADER_SIZE;
+
+    testDiag("Zero-length packet after the last transfer");
+    mockRespond(pmock, n);
+    pmock->zlp = 1;
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 1,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_OK, "status %d", s);
+    testOk(nRead == 2 * CHUNK_SIZE, "read %d bytes", nRead);
+    testOk(nTransfers == 3, "%d transfers", nTransfers);
+    testOk(pmock->zlp == 0, "zero-length packet read");
+    testOk1(payloadOk(buf, n));
+}
+
+static void
+testSingleTransfer(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+    int n = 20000;
+
+    testDiag("Pipelining disabled");
+    mockRespond(pmock, n);
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CAPACITY, 1,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_OK, "status %d", s);
+    testOk(nTransfers == 1, "%d transfers", nTransfers);
+    testOk1(payloadOk(buf, n));
+}
+
+static void
+testTimeout(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+
+    testDiag("No response");
+    mockRespond(pmock, 0);
+    pmock->responseSize = 0;
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 4,
+                         0.1, &nRead, &nTransfers);
+    testOk(s == USBTMC_BULK_IN_TIMEOUT, "status %d", s);
+    testOk(nRead == 0, "read %d bytes", nRead);
+    testOk(pmock->inFlight == 0, "%d transfers left", pmock->inFlight);
+}
+
+static void
+testSubmitFailure(mockDevice *pmock)
+{
+    int s, nRead, nTransfers;
+
+    testDiag("Submit fails");
+    mockRespond(pmock, 100);
+    pmock->failSubmit = 1;
+    s = usbtmcBulkInRead(&mockTransport, pmock, buf, CAPACITY, CHUNK_SIZE, 4,
+                         1.0, &nRead, &nTransfers);
+    testOk(s == -1, "status %d", s);
+    testOk(nTransfers == 0, "%d transfers", nTransfers);
+}
+
+MAIN(usbtmcBulkInTest)
+{
+    mockDevice mock;
+
+    testPlan(28);
+    memset(&mock, 0, sizeof mock);
+    testShortResponse(&mock);
+    testLongResponse(&mock);
+    testChunkBoundary(&mock);
+    testZeroLengthPacket(&mock);
+    testSingleTransfer(&mock);
+    testTimeout(&mock);
+    testSubmitFailure(&mock);
+    free(mock.response);
+    return testDone();
+}
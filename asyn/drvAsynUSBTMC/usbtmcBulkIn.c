@@ -0,0 +1,131 @@
+/*
+ * Pipelined bulk-IN transfers for USBTMC devices
+ *
+ ***************************************************************************
+ * Copyright (c) 2013 W. Eric Norum <wenorum@lbl.gov>                      *
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+
+#include <epicsTime.h>
+#include "usbtmcBulkIn.h"
+
+/*
+ * Time to wait for a cancelled transfer to be returned
+ */
+#define CANCEL_TIMEOUT 1.0
+
+static double
+timeLeft(double timeout, const epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+    double t;
+
+    if (timeout < 0)
+        return timeout;
+    epicsTimeGetCurrent(&now);
+    t = timeout - epicsTimeDiffInSeconds(&now, start);
+    return (t > 0) ? t : 0;
+}
+
+int
+usbtmcBulkInRead(const usbtmcTransport *transport, void *pvt,
+                 unsigned char *buf, int capacity, int chunkSize, int depth,
+                 double timeout, int *nRead, int *nTransfers)
+{
+    int requested[USBTMC_BULK_IN_MAX_DEPTH];
+    int submitted = 0, completed = 0;
+    int offset = 0, total = 0, expected = -1;
+    int status = USBTMC_BULK_IN_OK;
+    int done = 0, complete = 0;
+    epicsTimeStamp start;
+
+    if (depth < 1) depth = 1;
+    if (depth > USBTMC_BULK_IN_MAX_DEPTH) depth = USBTMC_BULK_IN_MAX_DEPTH;
+    if (chunkSize <= 0) chunkSize = capacity;
+    epicsTimeGetCurrent(&start);
+
+    /*
+     * A single transfer first, more only if the response turns out to be long
+     */
+    requested[0] = (chunkSize < capacity) ? chunkSize : capacity;
+    status = transport->submit(pvt, 0, buf, requested[0]);
+    if (status == USBTMC_BULK_IN_OK) {
+        submitted = 1;
+        offset = requested[0];
+    }
+    while ((status == USBTMC_BULK_IN_OK) && !done) {
+        int slot = completed % USBTMC_BULK_IN_MAX_DEPTH;
+        int actual = 0;
+
+        status = transport->wait(pvt, slot, timeLeft(timeout, &start), &actual);
+        if (status == USBTMC_BULK_IN_TIMEOUT) {
+            /* The data is all here even if the device never ends the transfer */
+            done = complete;
+            break;
+        }
+        completed++;
+        if (status != USBTMC_BULK_IN_OK)
+            break;
+        total += actual;
+
+        /*
+         * The header arrives with the first transfer, while the rest of
+         * the payload is still on its way.
+         */
+        if ((expected < 0) && (total >= USBTMC_BULK_IN_HEADER_SIZE)) {
+            expected = USBTMC_BULK_IN_HEADER_SIZE + (buf[4]        |
+                                                    (buf[5] << 8)  |
+                                                    (buf[6] << 16) |
+                                                    (buf[7] << 24));
+        }
+        /*
+         * The transfer ends with a short or zero-length packet.  Data that
+         * ends on a packet boundary is followed by a zero-length packet,
+         * which must be read so it is not taken as the next response.
+         */
+        if ((actual < requested[slot]) || (total >= capacity)) {
+            done = 1;
+            break;
+        }
+        if ((expected >= 0) && (total >= expected))
+            complete = 1;
+        while (((submitted - completed) < (complete ? 1 : depth)) && (offset < capacity)) {
+            int next = submitted % USBTMC_BULK_IN_MAX_DEPTH;
+            int len = capacity - offset;
+
+            if (len > chunkSize) len = chunkSize;
+            status = transport->submit(pvt, next, buf + offset, len);
+            if (status != USBTMC_BULK_IN_OK)
+                break;
+            requested[next] = len;
+            offset += len;
+            submitted++;
+        }
+    }
+
+    /*
+     * Reclaim transfers that are still in flight
+     */
+    if (completed < submitted) {
+        int i;
+
+        for (i = completed ; i < submitted ; i++)
+            transport->cancel(pvt, i % USBTMC_BULK_IN_MAX_DEPTH);
+        while (completed < submitted) {
+            int actual;
+
+            if (transport->wait(pvt, completed % USBTMC_BULK_IN_MAX_DEPTH,
+                                CANCEL_TIMEOUT, &actual) == USBTMC_BULK_IN_TIMEOUT) {
+                done = 0;
+                status = USBTMC_BULK_IN_CANCELLED;
+                break;
+            }
+            completed++;
+        }
+    }
+    if (nTransfers) *nTransfers = submitted;
+    *nRead = total;
+    return done ? USBTMC_BULK_IN_OK : status;
+}
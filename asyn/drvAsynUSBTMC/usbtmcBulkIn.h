@@ -0,0 +1,70 @@
+/*
+ * Pipelined bulk-IN transfers for USBTMC devices
+ *
+ ***************************************************************************
+ * Copyright (c) 2013 W. Eric Norum <wenorum@lbl.gov>                      *
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+
+#ifndef INCusbtmcBulkInH
+#define INCusbtmcBulkInH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define USBTMC_BULK_IN_HEADER_SIZE  12
+#define USBTMC_BULK_IN_MAX_DEPTH    8
+
+/*
+ * Completion status of one bulk-IN transfer.
+ * Other negative values are transport specific errors.
+ */
+#define USBTMC_BULK_IN_OK           0
+#define USBTMC_BULK_IN_TIMEOUT      (-1000)
+#define USBTMC_BULK_IN_CANCELLED    (-1001)
+
+/*
+ * Transport used by usbtmcBulkInRead.
+ * A transfer occupies one of USBTMC_BULK_IN_MAX_DEPTH slots from submit
+ * until wait has returned its completion.  Transfers on a bulk endpoint
+ * complete in the order they were submitted.
+ */
+typedef struct usbtmcTransport {
+    /* Queue a read of up to len bytes into buf.  Returns 0 or an error. */
+    int (*submit)(void *pvt, int slot, unsigned char *buf, int len);
+    /* Request cancellation of a queued transfer.  Its completion must still be waited for. */
+    void (*cancel)(void *pvt, int slot);
+    /*
+     * Wait up to timeout seconds for the transfer in slot to complete.
+     * Returns its status and sets *actual to the number of bytes received.
+     * Returns USBTMC_BULK_IN_TIMEOUT and leaves the transfer queued if it has not completed.
+     */
+    int (*wait)(void *pvt, int slot, double timeout, int *actual);
+} usbtmcTransport;
+
+/*
+ * Read one USBTMC bulk-IN transfer (header and payload) into buf.
+ *
+ * The first chunkSize bytes are read with a single transfer, so short
+ * responses cost one transfer.  If that transfer fills up, up to depth
+ * transfers of chunkSize bytes are kept in flight until the transfer ends
+ * with a short or zero-length packet.  Once the length given in the header
+ * has been received a single transfer is left to read the zero-length
+ * packet; if none arrives before the timeout the read still succeeds.
+ * chunkSize must be a multiple of the endpoint maximum packet size.
+ * Transfers still in flight at the end are cancelled.
+ *
+ * Returns 0 and sets *nRead, or the status of the failed transfer.
+ */
+int usbtmcBulkInRead(const usbtmcTransport *transport, void *pvt,
+                     unsigned char *buf, int capacity, int chunkSize, int depth,
+                     double timeout, int *nRead, int *nTransfers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCusbtmcBulkInH */
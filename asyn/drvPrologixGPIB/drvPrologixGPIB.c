@@ -2,6 +2,7 @@
  * Prologic Ethernet/GPIB driver
  */
 #include <string.h>
+#include <stdarg.h>
 #include <epicsStdio.h>
 #include <epicsString.h>
 #include <epicsExport.h>
@@ -32,13 +33,23 @@ typedef struct dPvt {
     int          autoConnect;
 
     /*
-     * Input/Output staging buffer
+     * Input buffer.
+     * Holds the reply to the last ++read until it has been consumed.
      */
     char        *buf;
     size_t       bufCapacity;
     size_t       bufCount;
     size_t       bufIndex;
 
+    /*
+     * Output staging buffer.
+     * Address selection, data and ++read are collected here
+     * and sent to the adapter with a single write.
+     */
+    char        *obuf;
+    size_t       obufCapacity;
+    size_t       obufCount;
+
     /*
      * Miscellaneous
      */
@@ -47,19 +58,93 @@ typedef struct dPvt {
     int          lastPrimaryAddress;
     int          lastSecondaryAddress;
     int          eos;
+
+    /*
+     * Statistics
+     */
+    unsigned long nTCPwrites;
+    unsigned long nAddressChanges;
+    unsigned long nAddressSkipped;
 } dPvt;
 
 #define EOT_MARKER  0xEF
 
+/*
+ * Get more space for an I/O buffer
+ */
+static asynStatus
+resizeBuffer(asynUser *pasynUser, char **buf, size_t *capacity, size_t size)
+{
+    char *np;
+    size_t newCapacity = size + 4096;
+
+    if ((size <= *capacity)
+     || (newCapacity <= *capacity)
+     || ((np = realloc(*buf, newCapacity)) == NULL)) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                      "Can't allocate memory for I/O buffer");
+        return asynError;
+    }
+    *buf = np;
+    *capacity = newCapacity;
+    return asynSuccess;
+}
+
+/*
+ * Append an adapter command to the output buffer
+ */
+static asynStatus
+stashCommand(dPvt *pdpvt, asynUser *pasynUser, const char *fmt, ...)
+{
+    va_list args;
+    size_t space;
+    int n;
+
+    for (;;) {
+        space = pdpvt->obufCapacity - pdpvt->obufCount;
+        va_start(args, fmt);
+        n = epicsVsnprintf(pdpvt->obuf + pdpvt->obufCount, space, fmt, args);
+        va_end(args);
+        if ((n >= 0) && ((size_t)n < space))
+            break;
+        if (resizeBuffer(pasynUser, &pdpvt->obuf, &pdpvt->obufCapacity,
+                                            pdpvt->obufCapacity + 1) != asynSuccess)
+            return asynError;
+    }
+    pdpvt->obufCount += n;
+    return asynSuccess;
+}
+
+/*
+ * Send the contents of the output buffer to the adapter
+ */
+static asynStatus
+sendCommands(dPvt *pdpvt, double timeout)
+{
+    size_t nt;
+    asynStatus status;
+
+    status = pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->obuf,
+                                            pdpvt->obufCount, timeout, &nt);
+    pdpvt->obufCount = 0;
+    pdpvt->nTCPwrites++;
+    if (status != asynSuccess) {
+        /* Can't tell whether the ++addr got through */
+        pdpvt->lastPrimaryAddress = -1;
+        pdpvt->lastSecondaryAddress = -1;
+    }
+    return status;
+}
+
 /*
  * Set the address of the device to which we wish to communicate.
- * Uses buf.
+ * The ++addr command is placed in the output buffer ahead of the
+ * command that follows, and is omitted if the device is already addressed.
  */
 static asynStatus
 setAddress(dPvt *pdpvt, asynUser *pasynUser)
 {
     int address, primary, secondary;
-    size_t n, nt;
     asynStatus status;
 
     if ((status = pasynManager->getAddr(pasynUser, &address)) != asynSuccess)
@@ -82,46 +167,23 @@ setAddress(dPvt *pdpvt, asynUser *pasynUser)
         return asynError;
     }
     if ((primary == pdpvt->lastPrimaryAddress)
-     && (secondary == pdpvt->lastSecondaryAddress))
+     && (secondary == pdpvt->lastSecondaryAddress)) {
+        pdpvt->nAddressSkipped++;
         return asynSuccess;
+    }
     if (secondary < 0)
-        n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++addr %d\n", primary);
+        status = stashCommand(pdpvt, pasynUser, "++addr %d\n", primary);
     else
-        n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++addr %d %d\n", primary, secondary + 96);
-    status = pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf,
-                                                                n, 1.0, &nt);
-    if (status != asynSuccess) {
-        pdpvt->lastPrimaryAddress = -1;
-        pdpvt->lastSecondaryAddress = -1;
+        status = stashCommand(pdpvt, pasynUser, "++addr %d %d\n", primary, secondary + 96);
+    if (status != asynSuccess)
         return status;
-    }
+    pdpvt->nAddressChanges++;
     pdpvt->lastPrimaryAddress = primary;
     pdpvt->lastSecondaryAddress = secondary;
     pdpvt->lastAddress = address;
     return asynSuccess;
 }
 
-/*
- * Get more space for I/O buffer
- */
-static asynStatus
-resizeBuffer(dPvt *pdpvt, asynUser *pasynUser, size_t size)
-{
-    char *np;
-    size_t newCapacity = size + 4096;
-
-    if ((size <= pdpvt->bufCapacity)
-     || (newCapacity <= pdpvt->bufCapacity)
-     || ((np = realloc(pdpvt->buf, newCapacity)) == NULL)) {
-        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
-                                      "Can't allocate memory for output buffer");
-        return asynError;
-    }
-    pdpvt->buf = np;
-    pdpvt->bufCapacity = size + newCapacity;
-    return asynSuccess;
-}
-
 /*
  * Place a character into output buffer
  * Escape special characters
@@ -129,8 +191,9 @@ resizeBuffer(dPvt *pdpvt, asynUser *pasynUser, size_t size)
 static asynStatus
 stashChar(dPvt *pdpvt, asynUser *pasynUser, int c)
 {
-    if (pdpvt->bufCount >= (pdpvt->bufCapacity - 3)) {
-        if (resizeBuffer(pdpvt, pasynUser, pdpvt->bufCapacity) != asynSuccess)
+    if (pdpvt->obufCount >= (pdpvt->obufCapacity - 3)) {
+        if (resizeBuffer(pasynUser, &pdpvt->obuf, &pdpvt->obufCapacity,
+                                            pdpvt->obufCapacity) != asynSuccess)
             return asynError;
     }
     switch (c) {
@@ -138,10 +201,10 @@ stashChar(dPvt *pdpvt, asynUser *pasynUser, int c)
     case '\n':
     case '\033':
     case '+':
-        pdpvt->buf[pdpvt->bufCount++] = '\033';
+        pdpvt->obuf[pdpvt->obufCount++] = '\033';
         break;
     }
-    pdpvt->buf[pdpvt->bufCount++] = c;
+    pdpvt->obuf[pdpvt->obufCount++] = c;
     return asynSuccess;
 }
 
@@ -151,6 +214,11 @@ prologixReport(void *drvPvt, FILE *fd, int details)
     dPvt *pdpvt = (dPvt *)drvPvt;
 
     fprintf(fd, "   Version: %s\n", pdpvt->versionString);
+    if (details >= 1) {
+        fprintf(fd, "   TCP writes: %lu\n", pdpvt->nTCPwrites);
+        fprintf(fd, "   Address changes: %lu, skipped: %lu\n",
+                                pdpvt->nAddressChanges, pdpvt->nAddressSkipped);
+    }
 }
 
 static asynStatus
@@ -166,13 +234,14 @@ prologixConnect(void *drvPvt, asynUser *pasynUser)
     pdpvt->lastPrimaryAddress = -1;
     pdpvt->lastSecondaryAddress = -1;
     pdpvt->bufCount = 0;
+    pdpvt->obufCount = 0;
     if ((status = pasynManager->getAddr(pasynUser, &address)) != asynSuccess)
         return status;
     if (address < 0) {
         status = pasynCommonSyncIO->connectDevice(pdpvt->pasynUserTCPcommon);
         if (status != asynSuccess)
             return status;
-        n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity,
+        status = stashCommand(pdpvt, pasynUser,
                     "++savecfg 0\n"    /* Don't save changes in EEPROM */
                     "++mode 1\n"       /* We are controller            */
                     "++ifc\n"          /* Clear the bus                */
@@ -183,8 +252,8 @@ prologixConnect(void *drvPvt, asynUser *pasynUser)
                     "++ver\n"          /* Request version information  */
                     , EOT_MARKER
                     );
-        status = pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf,
-                                                                n, 1.0, &nt);
+        if (status == asynSuccess)
+            status = sendCommands(pdpvt, 1.0);
         if (status != asynSuccess)
             return status;
         cp = pdpvt->versionString;
@@ -256,20 +325,17 @@ prologixRead(void *drvPvt, asynUser *pasynUser,
         int terminator = (pdpvt->eos >= 0) ? pdpvt->eos : EOT_MARKER;
 
         /*
-         * Address the device
+         * Address the device and ask it to talk with a single write
          */
+        pdpvt->obufCount = 0;
         if ((status = setAddress(pdpvt, pasynUser)) != asynSuccess)
             return status;
-
-        /*
-         * Read
-         */
         if (pdpvt->eos >= 0)
-            n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++read %d\n", pdpvt->eos);
+            status = stashCommand(pdpvt, pasynUser, "++read %d\n", pdpvt->eos);
         else
-            n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++read eoi\n");
-        status = pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf,
-                                                                    n, 1.0, &nt);
+            status = stashCommand(pdpvt, pasynUser, "++read eoi\n");
+        if (status == asynSuccess)
+            status = sendCommands(pdpvt, 1.0);
         if (status != asynSuccess)
             return status;
 
@@ -285,7 +351,8 @@ prologixRead(void *drvPvt, asynUser *pasynUser,
                 n = pdpvt->bufCapacity - pdpvt->bufCount;
                 if (n)
                     break;
-                if (resizeBuffer(pdpvt, pasynUser, pdpvt->bufCapacity + 16384) != asynSuccess) {
+                if (resizeBuffer(pasynUser, &pdpvt->buf, &pdpvt->bufCapacity,
+                                 pdpvt->bufCapacity + 16384) != asynSuccess) {
                     pdpvt->bufCount = 0;
                     return asynError;
                 }
@@ -358,21 +425,24 @@ prologixWrite(void *drvPvt, asynUser *pasynUser,
               const char *data, int numchars, int *nbytesTransferred)
 {
     dPvt *pdpvt = (dPvt *)drvPvt;
-    size_t n, nt;
+    size_t n;
     asynStatus status;
 
     /*
      * Check for output buffer space.
      * Escape stuffing may make this bigger, but at least this gets us close.
      */
-    if (numchars >= pdpvt->bufCapacity) {
-        if (resizeBuffer(pdpvt, pasynUser, numchars) != asynSuccess)
+    if (numchars + 20 >= pdpvt->obufCapacity) {
+        if (resizeBuffer(pasynUser, &pdpvt->obuf, &pdpvt->obufCapacity,
+                                                    numchars + 20) != asynSuccess)
             return asynError;
     }
 
     /*
-     * Address the device
+     * Address the device, if necessary, in the same write as the data
      */
+    pdpvt->obufCount = 0;
+    pdpvt->bufCount = 0;
     if ((status = setAddress(pdpvt, pasynUser)) != asynSuccess)
         return status;
 
@@ -383,30 +453,31 @@ prologixWrite(void *drvPvt, asynUser *pasynUser,
                  "%s %d prologixWrite\n", pdpvt->portName, pdpvt->lastAddress);
     *nbytesTransferred = 0;
     n = numchars;
-    pdpvt->bufCount = 0;
     while (n) {
         if ((status = stashChar(pdpvt, pasynUser, *data++)) != asynSuccess) {
-            pdpvt->bufCount = 0;
+            pdpvt->obufCount = 0;
+            pdpvt->lastPrimaryAddress = -1;
+            pdpvt->lastSecondaryAddress = -1;
             return status;
         }
         n--;
     }
     if (pdpvt->eos >= 0) {
         if ((status = stashChar(pdpvt, pasynUser, pdpvt->eos)) != asynSuccess) {
-            pdpvt->bufCount = 0;
+            pdpvt->obufCount = 0;
+            pdpvt->lastPrimaryAddress = -1;
+            pdpvt->lastSecondaryAddress = -1;
             return status;
         }
     }
-    pdpvt->buf[pdpvt->bufCount++] = '\n';
+    pdpvt->obuf[pdpvt->obufCount++] = '\n';
 
     /*
-     * Send the command
+     * Send address and data
      */
-    status = pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf,
-                                    pdpvt->bufCount, pasynUser->timeout, &nt);
+    status = sendCommands(pdpvt, pasynUser->timeout);
     if (status == asynSuccess)
         *nbytesTransferred = numchars;
-    pdpvt->bufCount = 0;
     return status;
 }
 
@@ -441,7 +512,7 @@ prologixSetEos(void *drvPvt, asynUser *pasynUser, const char *eos, int eoslen)
 {
     dPvt *pdpvt = (dPvt *)drvPvt;
     int newEos;
-    size_t n, nt;
+    asynStatus status;
 
     switch (eoslen) {
     case 0: newEos = -1;          break;
@@ -453,9 +524,11 @@ prologixSetEos(void *drvPvt, asynUser *pasynUser, const char *eos, int eoslen)
     }
     if (pdpvt->eos == newEos)
         return asynSuccess;
-    n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++eot_enable %d\n",
-                                                                (pdpvt->eos < 0));
-    return pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf, n, 1.0, &nt);
+    pdpvt->obufCount = 0;
+    status = stashCommand(pdpvt, pasynUser, "++eot_enable %d\n", (pdpvt->eos < 0));
+    if (status != asynSuccess)
+        return status;
+    return sendCommands(pdpvt, 1.0);
 }
 
 static asynStatus
@@ -477,10 +550,13 @@ static asynStatus
 prologixIfc(void *drvPvt, asynUser *pasynUser)
 {
     dPvt *pdpvt = (dPvt *)drvPvt;
-    size_t n, nt;
+    asynStatus status;
 
-    n = epicsSnprintf(pdpvt->buf, pdpvt->bufCapacity, "++ifc\n");
-    return pasynOctetSyncIO->write(pdpvt->pasynUserTCPoctet, pdpvt->buf, n, 1.0, &nt);
+    pdpvt->obufCount = 0;
+    status = stashCommand(pdpvt, pasynUser, "++ifc\n");
+    if (status != asynSuccess)
+        return status;
+    return sendCommands(pdpvt, 1.0);
 }
 
 static asynStatus
@@ -557,6 +633,8 @@ prologixGPIBConfigure(const char *portName, const char *host, int priority, int
     pdpvt->portName = epicsStrDup(portName);
     pdpvt->bufCapacity = 4096;
     pdpvt->buf = callocMustSucceed(1, pdpvt->bufCapacity, portName);
+    pdpvt->obufCapacity = 4096;
+    pdpvt->obuf = callocMustSucceed(1, pdpvt->obufCapacity, portName);
     pdpvt->eos = -1;
 
     /*
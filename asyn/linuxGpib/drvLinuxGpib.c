@@ -86,6 +86,7 @@ static asynStatus srqEnable (void *pdrvPvt, int onOff);
 static asynStatus serialPollBegin (void *pdrvPvt);
 static asynStatus serialPoll (void *pdrvPvt, int addr, double timeout,int *status);
 static asynStatus serialPollEnd (void *pdrvPvt);
+static asynStatus srqLevel (void *pdrvPvt,int *isSet);
 /*local methods*/
 static asynStatus checkError(void *pdrvPvt,asynUser *pasynUser,int addr);
 unsigned int sec_to_timeout( double sec );
@@ -113,7 +114,8 @@ static asynGpibPort GpibBoardDriver = {
     srqEnable,
     serialPollBegin,
     serialPoll,
-    serialPollEnd
+    serialPollEnd,
+    srqLevel
 };
 
 static asynStatus gpibPortSetPortOptions(void *pdrvPvt,asynUser *pasynUser,
@@ -835,6 +837,19 @@ static asynStatus serialPollEnd (void *pdrvPvt)
     return asynSuccess;
 }
 
+static asynStatus srqLevel (void *pdrvPvt,int *isSet)
+{
+    GpibBoardPvt *pGpibBoardPvt = (GpibBoardPvt *)pdrvPvt;
+    short lines = 0;
+
+    if(iblines(pGpibBoardPvt->ud,&lines)&ERR)
+        return asynError;
+    if(!(lines&ValidSRQ))
+        return asynError;
+    *isSet = (lines&BusSRQ) ? 1 : 0;
+    return asynSuccess;
+}
+
 asynStatus checkError(void *pdrvPvt,asynUser *pasynUser,int addr)
 {
     GpibBoardPvt *pGpibBoardPvt = (GpibBoardPvt *)pdrvPvt;
@@ -132,6 +132,7 @@ expectChar(interposePvt *pinterposePvt, asynUser *pasynUser, int expect)
  * Double up IAC characters.
  * We assume that memchr and memcpy are nicely optimized so we're better off
  * using them than looking at and copying the characters one at a time ourselves.
+ * The transmit buffer is grown once to the worst case, every character an IAC.
  */
 static asynStatus
 writeIt(void *ppvt, asynUser *pasynUser,
@@ -139,51 +140,37 @@ writeIt(void *ppvt, asynUser *pasynUser,
 {
     interposePvt *pinterposePvt = (interposePvt *)ppvt;
     const char *iac;
-    char *dst = pinterposePvt->xBuf;
     size_t nIAC = 0;
     asynStatus status;
 
     if ((iac = memchr(data, C_IAC, numchars)) != NULL) {
-        size_t nLeft = numchars;
-        size_t nCopy = iac - data + 1;
-        for (;;) {
-            size_t nNew = nCopy + 1;
-            char *np;
-            if (nNew > pinterposePvt->xBufCapacity) {
-                /*
-                 * Try to strike a balance between too many
-                 * realloc calls and too much wasted space.
-                 */
-                size_t newSize = pinterposePvt->xBufCapacity + 1024;
-                if (newSize < numchars)
-                    newSize = numchars + 1024;
-                if (newSize < nNew)
-                    newSize = nNew + 1024;
-                np = realloc(pinterposePvt->xBuf, newSize);
-                if (np == NULL) {
-                    epicsSnprintf(pasynUser->errorMessage,
-                                  pasynUser->errorMessageSize, "Out of memory");
-                    return asynError;
-                }
-                dst = np + (dst - pinterposePvt->xBuf);
-                pinterposePvt->xBuf = np;
-                pinterposePvt->xBufCapacity = newSize;
+        const char *end = data + numchars;
+        char *dst;
+
+        if (2 * numchars > pinterposePvt->xBufCapacity) {
+            size_t newSize = 2 * numchars + 1024;
+            char *np = realloc(pinterposePvt->xBuf, newSize);
+            if (np == NULL) {
+                epicsSnprintf(pasynUser->errorMessage,
+                              pasynUser->errorMessageSize, "Out of memory");
+                return asynError;
             }
+            pinterposePvt->xBuf = np;
+            pinterposePvt->xBufCapacity = newSize;
+        }
+        dst = pinterposePvt->xBuf;
+        for (;;) {
+            /* Copy the run up to and including the IAC, then double it */
+            size_t nCopy = iac - data + 1;
             memcpy(dst, data, nCopy);
             dst += nCopy;
-            if (iac != NULL) {
-                *dst++ = (char)C_IAC;
-                nIAC++;
-            }
-            nLeft -= nCopy;
-            if (nLeft == 0)
-                break;
+            *dst++ = (char)C_IAC;
+            nIAC++;
             data += nCopy;
-            if ((iac = memchr(data, C_IAC, nLeft)) != NULL)
-                nCopy = iac - data + 1;
-            else
-                nCopy = nLeft;
+            if ((iac = memchr(data, C_IAC, end - data)) == NULL)
+                break;
         }
+        memcpy(dst, data, end - data);
         numchars += nIAC;
         data = pinterposePvt->xBuf;
     }
@@ -194,49 +181,62 @@ writeIt(void *ppvt, asynUser *pasynUser,
     return status;
 }
 
+/*
+ * Remove the doubled IAC characters.
+ * Each IAC-free run is moved down once, so the cost does not depend on
+ * the number of IAC characters in the buffer.
+ */
 static asynStatus
 readIt(void *ppvt, asynUser *pasynUser,
     char *data, size_t maxchars, size_t *nbytesTransferred, int *eomReason)
 {
     interposePvt *pinterposePvt = (interposePvt *)ppvt;
     int eom;
-    size_t nRead, nCheck;
+    size_t nRead;
     char *iac;
-    char *base = data;
-    int unstuffed = 0;
     asynStatus status;
 
     status = pinterposePvt->pasynOctetDrv->read(pinterposePvt->drvOctetPvt,
                                     pasynUser, data, maxchars, &nRead, &eom);
     if (status != asynSuccess)
         return status;
-    nCheck = nRead;
-    while ((iac = memchr(data, C_IAC, nCheck)) != NULL) {
-        int c;
-        unstuffed = 1;
+    if ((iac = memchr(data, C_IAC, nRead)) != NULL) {
+        char *src = iac;
+        char *dst = iac;
+        char *end = data + nRead;
+
         eom &= ~ASYN_EOM_CNT;
-        if (iac == data + nCheck - 1) {
-            c = nextChar(pinterposePvt, pasynUser);
-            iac--;
-        }
-        else {
-            c = *(iac + 1) & 0xFF;
-            nRead--;
-        }
-        if (c != C_IAC) {
-            epicsSnprintf(pasynUser->errorMessage,
-                          pasynUser->errorMessageSize, "Missing IAC");
-            return asynError;
+        while (src < end) {
+            /* src points at an IAC which must be followed by another */
+            char *next;
+            int c;
+            size_t nCopy;
+
+            if (src + 1 == end) {
+                c = nextChar(pinterposePvt, pasynUser);
+                src++;
+            }
+            else {
+                c = src[1] & 0xFF;
+                src += 2;
+            }
+            if (c != C_IAC) {
+                epicsSnprintf(pasynUser->errorMessage,
+                              pasynUser->errorMessageSize, "Missing IAC");
+                return asynError;
+            }
+            *dst++ = (char)C_IAC;
+            if ((next = memchr(src, C_IAC, end - src)) == NULL)
+                next = end;
+            nCopy = next - src;
+            memmove(dst, src, nCopy);
+            dst += nCopy;
+            src = next;
         }
-        nCheck -= (iac - data) + 2;
-        data = iac + 1;
-        if (nCheck == 0)
-            break;
-        memmove(data, data + 1, nCheck);
-    }
-    if (unstuffed)
-        asynPrintIO(pasynUser, ASYN_TRACEIO_FILTER, base, nRead,
+        nRead = dst - data;
+        asynPrintIO(pasynUser, ASYN_TRACEIO_FILTER, data, nRead,
                                 "nRead %d after IAC unstuffing", (int)nRead);
+    }
     if (nRead == maxchars)
         eom |= ASYN_EOM_CNT;
     *nbytesTransferred = nRead;
@@ -318,29 +318,56 @@ static asynOctet octetMethods = {
  * asynOption support
  */
 
+/*
+ * A WILL/DO request and its reply
+ */
+typedef struct telnetOption {
+    int command;    /* C_WILL or C_DO */
+    int code;
+    int done;
+} telnetOption;
+
+/*
+ * A COM-PORT-OPTION subcommand and its reply
+ */
+#define CPO_MAX_BATCH 8
+typedef struct comPortOption {
+    char xBuf[5];   /* Subcommand and value */
+    int  xLen;
+    char rBuf[4];   /* Value returned by the server */
+    int  done;
+} comPortOption;
+
 /*
  * Two possible actions depending upon the 'command':
  *    1) Tell that server that we WILL do something and
  *       verify that it will allow us to DO so.
  *    2) Tell the server to DO something and verify that it WILL.
+ * All requests are sent with a single write, then the replies are
+ * collected in whatever order the server sends them.
  */
 static asynStatus
-willdo(interposePvt *pinterposePvt, asynUser *pasynUser, int command, int code)
+willdo(interposePvt *pinterposePvt, asynUser *pasynUser, telnetOption *opts, int nOpts)
 {
-    char          cbuf[3];
+    char          cbuf[3 * CPO_MAX_BATCH];
     asynStatus    status;
     int           c;
     int           wd;
+    int           i, n, nPending;
     size_t        nbytes;
 
-    cbuf[0] = (char)C_IAC;
-    cbuf[1] = command;
-    cbuf[2] = code;
+    for (i = 0, n = 0 ; i < nOpts ; i++) {
+        cbuf[n++] = (char)C_IAC;
+        cbuf[n++] = (char)opts[i].command;
+        cbuf[n++] = (char)opts[i].code;
+        opts[i].done = 0;
+    }
     status =  pinterposePvt->pasynOctetDrv->write(pinterposePvt->drvOctetPvt,
-                                                pasynUser, cbuf, 3, &nbytes);
+                                                pasynUser, cbuf, n, &nbytes);
     if (status != asynSuccess)
         return status;
-    for (;;) {
+    nPending = nOpts;
+    while (nPending) {
         while ((c = nextChar(pinterposePvt, pasynUser)) != C_IAC) {
             if (c == EOF) return asynError;
         }
@@ -351,43 +378,44 @@ willdo(interposePvt *pinterposePvt, asynUser *pasynUser, int command, int code)
 
         case C_DO:
         case C_DONT:
-            wd = c;
-            if ((c = nextChar(pinterposePvt, pasynUser)) == EOF)
-                return asynError;
-            if (c != cbuf[2]) continue;
-            if (cbuf[1] == (char)C_DO) {
-                epicsSnprintf(pasynUser->errorMessage,
-                          pasynUser->errorMessageSize,
-                          "Received response %#x in response to DO.", c);
-                return asynError;
-            }
-            if (wd == C_DONT) {
-                epicsSnprintf(pasynUser->errorMessage,
-                              pasynUser->errorMessageSize,
-                              "Device says DON'T %#x.", c);
-                return asynError;
-            }
-            return asynSuccess;
-
         case C_WILL:
         case C_WONT:
             wd = c;
             if ((c = nextChar(pinterposePvt, pasynUser)) == EOF)
                 return asynError;
-            if (c != cbuf[2]) continue;
-            if (cbuf[1] == (char)C_WILL) {
-                epicsSnprintf(pasynUser->errorMessage,
+            for (i = 0 ; i < nOpts ; i++) {
+                int reply = (opts[i].command == C_WILL) ? C_DO : C_WILL;
+                int refuse = (opts[i].command == C_WILL) ? C_DONT : C_WONT;
+
+                if (opts[i].done || (opts[i].code != c))
+                    continue;
+                if (wd == refuse) {
+                    epicsSnprintf(pasynUser->errorMessage,
                               pasynUser->errorMessageSize,
-                              "Received response %#x in response to WILL.", c);
-                return asynError;
+                              (wd == C_DONT) ? "Device says DON'T %#x."
+                                             : "Device says WON'T %#x.", c);
+                    return asynError;
+                }
+                if (wd == reply) {
+                    opts[i].done = 1;
+                    nPending--;
+                    break;
+                }
             }
-            if (wd == C_WONT) {
-                epicsSnprintf(pasynUser->errorMessage,
+            if (i == nOpts) {
+                /* No request is waiting for this reply */
+                for (i = 0 ; i < nOpts ; i++) {
+                    if (!opts[i].done && (opts[i].code == c)
+                     && (opts[i].command == wd)) {
+                        epicsSnprintf(pasynUser->errorMessage,
                               pasynUser->errorMessageSize,
-                              "Device says WON'T %#x.", c);
-                return asynError;
+                              "Received response %#x in response to %s.", c,
+                              (wd == C_DO) ? "DO" : "WILL");
+                        return asynError;
+                    }
+                }
             }
-            return asynSuccess;
+            break;
 
         case C_SB:
             if (nextChar(pinterposePvt, pasynUser) != SB_COM_PORT_OPTION)
@@ -408,23 +436,35 @@ willdo(interposePvt *pinterposePvt, asynUser *pasynUser, int command, int code)
             return asynError;
         }
     }
+    return asynSuccess;
 }
 
 /*
- * Send a COM_PORT_OPTION subcommand to the server
+ * Fetch the next byte of a subnegotiation value, undoing IAC stuffing
+ */
+static int
+nextSbChar(interposePvt *pinterposePvt, asynUser *pasynUser)
+{
+    int c = nextChar(pinterposePvt, pasynUser);
+
+    if ((c == C_IAC) && !expectChar(pinterposePvt, pasynUser, C_IAC))
+        return EOF;
+    return c;
+}
+
+/*
+ * Send COM_PORT_OPTION subcommands to the server with a single write
+ * and collect the replies.  The server answers in the order it was asked.
  */
 static asynStatus
-sbComPortOption(interposePvt *pinterposePvt, asynUser *pasynUser, const char *xBuf, int xLen, char *rBuf)
+sbComPortOptions(interposePvt *pinterposePvt, asynUser *pasynUser, comPortOption *opts, int nOpts)
 {
-    char          cbuf[20];
+    char          cbuf[20 * CPO_MAX_BATCH];
     asynStatus    status;
     int           c;
-    int           i, n;
+    int           i, j, n, nPending;
     size_t        nbytes;
 
-    cbuf[0] = (char)C_IAC;
-    cbuf[1] = (char)C_SB;
-    cbuf[2] = SB_COM_PORT_OPTION;
     /*
      * RFC 2217: a payload byte equal to IAC (0xFF) must be doubled so the
      * server does not mistake it for a command.  Only the interior payload
@@ -432,19 +472,25 @@ sbComPortOption(interposePvt *pinterposePvt, asynUser *pasynUser, const char *xB
      * stay single.  A baud rate whose big-endian encoding contains 0xFF
      * (e.g. 255) is the case that needs this.
      */
-    n = 3;
-    for (i = 0 ; i < xLen ; i++) {
-        cbuf[n++] = xBuf[i];
-        if ((xBuf[i] & 0xFF) == C_IAC)
-            cbuf[n++] = (char)C_IAC;
-    }
-    cbuf[n++] = (char)C_IAC;
-    cbuf[n++] = (char)C_SE;
+    for (i = 0, n = 0 ; i < nOpts ; i++) {
+        cbuf[n++] = (char)C_IAC;
+        cbuf[n++] = (char)C_SB;
+        cbuf[n++] = SB_COM_PORT_OPTION;
+        for (j = 0 ; j < opts[i].xLen ; j++) {
+            cbuf[n++] = opts[i].xBuf[j];
+            if ((opts[i].xBuf[j] & 0xFF) == C_IAC)
+                cbuf[n++] = (char)C_IAC;
+        }
+        cbuf[n++] = (char)C_IAC;
+        cbuf[n++] = (char)C_SE;
+        opts[i].done = 0;
+    }
     status =  pinterposePvt->pasynOctetDrv->write(pinterposePvt->drvOctetPvt,
                                             pasynUser, cbuf, n, &nbytes);
     if (status != asynSuccess)
         return status;
-    for (;;) {
+    nPending = nOpts;
+    while (nPending) {
         while ((c = nextChar(pinterposePvt, pasynUser)) != C_IAC) {
             if (c == EOF)
                 return asynError;
@@ -455,32 +501,52 @@ sbComPortOption(interposePvt *pinterposePvt, asynUser *pasynUser, const char *xB
         c = nextChar(pinterposePvt, pasynUser);
         if ((c == CPO_SERVER_NOTIFY_LINESTATE )
          || (c == CPO_SERVER_NOTIFY_MODEMSTATE)) {
-            if ((nextChar(pinterposePvt, pasynUser) == EOF)
+            if ((nextSbChar(pinterposePvt, pasynUser) == EOF)
              || !expectChar(pinterposePvt, pasynUser, C_IAC)
              || !expectChar(pinterposePvt, pasynUser, C_SE))
                 return asynError;
+            continue;
         }
-        else if (c == (*xBuf + 100)) {
-            while (--xLen > 0) {
-                if ((c = nextChar(pinterposePvt, pasynUser)) == EOF)
-                    return asynError;
-                *rBuf++ = c;
-            }
-            if (!expectChar(pinterposePvt, pasynUser, C_IAC)
-             || !expectChar(pinterposePvt, pasynUser, C_SE))
-                return asynError;
-            return asynSuccess;
+        for (i = 0 ; i < nOpts ; i++) {
+            if (!opts[i].done && (c == (opts[i].xBuf[0] + 100)))
+                break;
         }
-        else {
+        if (i == nOpts) {
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
-                        "Sent COM-PORT-OPTION %d but got reply %d", *xBuf, c);
+                        "Sent COM-PORT-OPTION %d but got reply %d", opts[0].xBuf[0], c);
             return asynError;
-
         }
+        for (j = 1 ; j < opts[i].xLen ; j++) {
+            if ((c = nextSbChar(pinterposePvt, pasynUser)) == EOF)
+                return asynError;
+            opts[i].rBuf[j-1] = c;
+        }
+        if (!expectChar(pinterposePvt, pasynUser, C_IAC)
+         || !expectChar(pinterposePvt, pasynUser, C_SE))
+            return asynError;
+        opts[i].done = 1;
+        nPending--;
     }
     return asynSuccess;
 }
 
+/*
+ * Send a COM_PORT_OPTION subcommand to the server
+ */
+static asynStatus
+sbComPortOption(interposePvt *pinterposePvt, asynUser *pasynUser, const char *xBuf, int xLen, char *rBuf)
+{
+    comPortOption opt;
+    asynStatus    status;
+
+    memcpy(opt.xBuf, xBuf, xLen);
+    opt.xLen = xLen;
+    status = sbComPortOptions(pinterposePvt, pasynUser, &opt, 1);
+    if (status == asynSuccess)
+        memcpy(rBuf, opt.rBuf, xLen - 1);
+    return status;
+}
+
 /*
  * asynOption methods
  */
@@ -740,33 +806,75 @@ getOption(void *ppvt, asynUser *pasynUser, const char *key, char *val, int valSi
 
 static asynOption optionMethods = { setOption, getOption };
 
+static void
+setComPortOption(comPortOption *opt, int option, epicsUInt32 val, int len)
+{
+    int i;
+
+    opt->xBuf[0] = option;
+    for (i = len ; i > 0 ; i--) {
+        opt->xBuf[i] = (char)val;
+        val >>= 8;
+    }
+    opt->xLen = len + 1;
+}
+
+/*
+ * Negotiate the TELNET options and set all serial line parameters.
+ * Each group goes out in one write, so reconnecting costs two round
+ * trips instead of one per option.
+ */
 static asynStatus
 restoreSettings(interposePvt *pinterposePvt, asynUser *pasynUser)
 {
     asynStatus s;
-    int i;
-    const char *keys[] = { "baud", "bits", "parity", "stop", "crtscts", "ixon" };
-    char val[20];
-    char xBuf[2], rBuf[1];
-
-    xBuf[0] = CPO_SET_MODEMSTATE_MASK;
-    xBuf[1] = 0;
-    if (((s = willdo(pinterposePvt, pasynUser, C_DO,   WD_TRANSMIT_BINARY))
-                                                                != asynSuccess)
-     || ((s = willdo(pinterposePvt, pasynUser, C_WILL, WD_TRANSMIT_BINARY))
-                                                                != asynSuccess)
-     || ((s = willdo(pinterposePvt, pasynUser, C_WILL, SB_COM_PORT_OPTION))
-                                                                != asynSuccess)
-     || ((s = sbComPortOption(pinterposePvt, pasynUser, xBuf, 2, rBuf))
-                                                                != asynSuccess))
+    telnetOption telnetOpts[] = {
+        { C_DO,   WD_TRANSMIT_BINARY },
+        { C_WILL, WD_TRANSMIT_BINARY },
+        { C_WILL, SB_COM_PORT_OPTION },
+    };
+    comPortOption cpo[6];
+    int baud, bits, stop;
+
+    if ((s = willdo(pinterposePvt, pasynUser, telnetOpts,
+                    sizeof telnetOpts / sizeof telnetOpts[0])) != asynSuccess)
         return s;
-    for (i = 0 ; i < (sizeof keys / sizeof keys[0]) ; i++) {
-        s = getOption(pinterposePvt, pasynUser, keys[i], val, sizeof val);
-        if (s != asynSuccess)
-            return s;
-        s = setOption(pinterposePvt, pasynUser, keys[i], val);
-        if (s != asynSuccess)
-            return s;
+    setComPortOption(&cpo[0], CPO_SET_MODEMSTATE_MASK, 0, 1);
+    setComPortOption(&cpo[1], CPO_SET_BAUDRATE, pinterposePvt->baud, 4);
+    setComPortOption(&cpo[2], CPO_SET_DATASIZE, pinterposePvt->bits, 1);
+    setComPortOption(&cpo[3], CPO_SET_PARITY, pinterposePvt->parity, 1);
+    setComPortOption(&cpo[4], CPO_SET_STOPSIZE, pinterposePvt->stop, 1);
+    setComPortOption(&cpo[5], CPO_SET_CONTROL, pinterposePvt->flow, 1);
+    if ((s = sbComPortOptions(pinterposePvt, pasynUser, cpo, 6)) != asynSuccess)
+        return s;
+    baud = ((cpo[1].rBuf[0] & 0xFF) << 24) |
+           ((cpo[1].rBuf[1] & 0xFF) << 16) |
+           ((cpo[1].rBuf[2] & 0xFF) <<  8) |
+            (cpo[1].rBuf[3] & 0xFF);
+    bits = cpo[2].rBuf[0] & 0xFF;
+    stop = cpo[4].rBuf[0] & 0xFF;
+    pinterposePvt->parity = cpo[3].rBuf[0] & 0xFF;
+    pinterposePvt->flow = cpo[5].rBuf[0] & 0xFF;
+    if (baud != pinterposePvt->baud) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Tried to set %d baud, actually set %d baud.",
+                                          pinterposePvt->baud, baud);
+        pinterposePvt->baud = baud;
+        return asynError;
+    }
+    if (bits != pinterposePvt->bits) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Tried to set %d bits, actually set %d bits.",
+                                          pinterposePvt->bits, bits);
+        pinterposePvt->bits = bits;
+        return asynError;
+    }
+    if (stop != pinterposePvt->stop) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+              "Tried to set %d stop bits, actually set %d stop bits.",
+                                          pinterposePvt->stop, stop);
+        pinterposePvt->stop = stop;
+        return asynError;
     }
     return asynSuccess;
 }
@@ -7,10 +7,27 @@
  * Author: Dirk Zimoch
  */
 
+/* Each write is paced against an absolute deadline, the start of the
+ * previous write plus the delay, so the time spent in the driver write is
+ * taken off the delay instead of adding to it.  The deadlines use the
+ * monotonic clock, so a step of the wall clock does not change the pacing.
+ * The delay after the last character is not slept; the next write waits
+ * for it only if it comes too early.
+ * Options:
+ *   delay      time between the start of two writes
+ *   chunk      number of characters per write (default 1)
+ *   delayAfter if not empty, only pace after these characters
+ *   stats      get: achieved vs. requested delay. set: reset
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
 #include <cantProceed.h>
 #include <epicsStdio.h>
 #include <epicsString.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
 #include <iocsh.h>
 
 #include <epicsExport.h>
@@ -27,26 +44,106 @@ typedef struct interposePvt {
     asynOption    *pasynOptionDrv;
     void          *optionPvt;
     double        delay;
+    size_t        chunk;
+    char          delayAfter[32];
+    int           delayAfterLen;
+    double        lastWrite;    /* start of the last write */
+    double        nextWrite;    /* deadline for the next write */
+    /* statistics */
+    unsigned long nDelays;
+    double        sumRequested;
+    double        sumAchieved;
+    double        minAchieved;
+    double        maxAchieved;
 }interposePvt;
 
+/* Monotonic clock in seconds */
+static double now(void)
+{
+#if LT_EPICSBASE(3,16,1,0)
+    epicsTimeStamp ts;
+
+    epicsTimeGetCurrent(&ts);
+    return ts.secPastEpoch + ts.nsec * 1e-9;
+#else
+    return epicsMonotonicGet() * 1e-9;
+#endif
+}
+
+static void sleepUntil(double deadline)
+{
+    double wait = deadline - now();
+
+    if (wait > 0) epicsThreadSleep(wait);
+}
+
+static void resetStats(interposePvt *pvt)
+{
+    pvt->nDelays = 0;
+    pvt->sumRequested = 0;
+    pvt->sumAchieved = 0;
+    pvt->minAchieved = 0;
+    pvt->maxAchieved = 0;
+}
+
+/* Number of characters to send with the next write */
+static size_t pieceLength(interposePvt *pvt, const char *data, size_t numchars)
+{
+    size_t n;
+
+    if (pvt->delayAfterLen == 0)
+        return (pvt->chunk < numchars) ? pvt->chunk : numchars;
+    for (n = 0; n < numchars; n++) {
+        if (memchr(pvt->delayAfter, data[n], pvt->delayAfterLen))
+            return n + 1;
+    }
+    return numchars;
+}
+
 /* asynOctet methods */
 static asynStatus writeIt(void *ppvt, asynUser *pasynUser,
     const char *data, size_t numchars, size_t *nbytesTransferred)
 {
     interposePvt *pvt = (interposePvt *)ppvt;
-    size_t n;
+    size_t n, len;
     size_t transferred = 0;
     asynStatus status = asynSuccess;
+    double start;
+    int paced, waited;
 
     while (transferred < numchars) {
-        /* write one char at a time */
+        len = pieceLength(pvt, data, numchars - transferred);
+        /* wait until the delay after the previous write has passed */
+        paced = (pvt->nextWrite > 0);
+        waited = paced && (now() < pvt->nextWrite);
+        if (waited)
+            sleepUntil(pvt->nextWrite);
+        start = now();
+        /* An idle gap before a message is not an inter-character delay */
+        if (paced && (waited || (transferred > 0))) {
+            double achieved = start - pvt->lastWrite;
+
+            pvt->nDelays++;
+            pvt->sumRequested += pvt->delay;
+            pvt->sumAchieved += achieved;
+            if ((pvt->nDelays == 1) || (achieved < pvt->minAchieved))
+                pvt->minAchieved = achieved;
+            if (achieved > pvt->maxAchieved)
+                pvt->maxAchieved = achieved;
+        }
         status = pvt->pasynOctetDrv->write(pvt->octetPvt,
-            pasynUser, data, 1, &n);
+            pasynUser, data, len, &n);
         if (status != asynSuccess) break;
-        /* delay */
-        epicsThreadSleep(pvt->delay);
+        pvt->lastWrite = start;
         transferred+=n;
         data+=n;
+        if ((pvt->delay <= 0)
+         || ((pvt->delayAfterLen > 0) && (n > 0)
+          && !memchr(pvt->delayAfter, data[-1], pvt->delayAfterLen))) {
+            pvt->nextWrite = 0;
+        } else {
+            pvt->nextWrite = start + pvt->delay;
+        }
     }
     *nbytesTransferred = transferred;
     return status;
@@ -140,6 +237,26 @@ getOption(void *ppvt, asynUser *pasynUser,
         epicsSnprintf(val, valSize, "%g", pvt->delay);
         return asynSuccess;
     }
+    if (epicsStrCaseCmp(key, "chunk") == 0) {
+        epicsSnprintf(val, valSize, "%lu", (unsigned long)pvt->chunk);
+        return asynSuccess;
+    }
+    if (epicsStrCaseCmp(key, "delayAfter") == 0) {
+        epicsStrnEscapedFromRaw(val, valSize, pvt->delayAfter, pvt->delayAfterLen);
+        return asynSuccess;
+    }
+    if (epicsStrCaseCmp(key, "stats") == 0) {
+        if (pvt->nDelays == 0) {
+            epicsSnprintf(val, valSize, "no delays");
+        } else {
+            epicsSnprintf(val, valSize,
+                "%lu delays, requested %.6f, achieved mean %.6f min %.6f max %.6f",
+                pvt->nDelays, pvt->sumRequested / pvt->nDelays,
+                pvt->sumAchieved / pvt->nDelays,
+                pvt->minAchieved, pvt->maxAchieved);
+        }
+        return asynSuccess;
+    }
     if (pvt->pasynOptionDrv)
         return pvt->pasynOptionDrv->getOption(pvt->optionPvt,
             pasynUser, key, val, valSize);
@@ -159,6 +276,26 @@ setOption(void *ppvt, asynUser *pasynUser, const char *key, const char *val)
         }
         return asynSuccess;
     }
+    if (epicsStrCaseCmp(key, "chunk") == 0) {
+        unsigned long chunk;
+
+        if ((sscanf(val, "%lu", &chunk) != 1) || (chunk < 1)) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                "Bad chunk size %s", val);
+            return asynError;
+        }
+        pvt->chunk = chunk;
+        return asynSuccess;
+    }
+    if (epicsStrCaseCmp(key, "delayAfter") == 0) {
+        pvt->delayAfterLen = (int)epicsStrnRawFromEscaped(pvt->delayAfter,
+            sizeof pvt->delayAfter, val, strlen(val));
+        return asynSuccess;
+    }
+    if (epicsStrCaseCmp(key, "stats") == 0) {
+        resetStats(pvt);
+        return asynSuccess;
+    }
     if (pvt->pasynOptionDrv)
         return pvt->pasynOptionDrv->setOption(pvt->optionPvt,
             pasynUser, key, val);
@@ -208,6 +345,7 @@ asynInterposeDelay(const char *portName, int addr, double delay)
         pvt->pasynOptionDrv = (asynOption *)poptionasynInterface->pinterface;
     }
     pvt->delay = delay;
+    pvt->chunk = 1;
     return 0;
 }
 
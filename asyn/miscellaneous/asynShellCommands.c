@@ -1007,6 +1007,168 @@ static void asynAutoConnectCall(const iocshArgBuf * args) {
     asynAutoConnect(portName,addr,yesNo);
 }
 
+static const iocshArg asynSetConnectBackoffArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetConnectBackoffArg1 = {"addr", iocshArgInt};
+static const iocshArg asynSetConnectBackoffArg2 = {"minDelay", iocshArgDouble};
+static const iocshArg asynSetConnectBackoffArg3 = {"maxDelay", iocshArgDouble};
+static const iocshArg asynSetConnectBackoffArg4 = {"jitter", iocshArgDouble};
+static const iocshArg asynSetConnectBackoffArg5 = {"failFast", iocshArgInt};
+static const iocshArg *const asynSetConnectBackoffArgs[] = {
+    &asynSetConnectBackoffArg0,&asynSetConnectBackoffArg1,
+    &asynSetConnectBackoffArg2,&asynSetConnectBackoffArg3,
+    &asynSetConnectBackoffArg4,&asynSetConnectBackoffArg5};
+static const iocshFuncDef asynSetConnectBackoffDef =
+    {"asynSetConnectBackoff", 6, asynSetConnectBackoffArgs};
+ASYN_API int
+ asynSetConnectBackoff(const char *portName,int addr,
+                       double minDelay,double maxDelay,double jitter,int failFast)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,addr);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynManager->setConnectBackoff(pasynUser,minDelay,maxDelay,jitter,failFast);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynSetConnectBackoffCall(const iocshArgBuf * args) {
+    asynSetConnectBackoff(args[0].sval,args[1].ival,args[2].dval,args[3].dval,
+                          args[4].dval,args[5].ival);
+}
+
+static const iocshArg asynSetQueuePolicyArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetQueuePolicyArg1 = {"policy", iocshArgString};
+static const iocshArg *const asynSetQueuePolicyArgs[] = {
+    &asynSetQueuePolicyArg0,&asynSetQueuePolicyArg1};
+static const iocshFuncDef asynSetQueuePolicyDef =
+    {"asynSetQueuePolicy", 2, asynSetQueuePolicyArgs};
+ASYN_API int
+ asynSetQueuePolicy(const char *portName,const char *policy)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+    asynQueuePolicy queuePolicy;
+
+    if(policy && epicsStrCaseCmp(policy,"fifo")==0) {
+        queuePolicy = asynQueuePolicyFifo;
+    } else if(policy && epicsStrCaseCmp(policy,"roundRobin")==0) {
+        queuePolicy = asynQueuePolicyRoundRobin;
+    } else if(policy && epicsStrCaseCmp(policy,"deadline")==0) {
+        queuePolicy = asynQueuePolicyDeadline;
+    } else {
+        printf("policy must be fifo, roundRobin or deadline\n");
+        return -1;
+    }
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status==asynSuccess)
+        status = pasynManager->setQueuePolicy(pasynUser,queuePolicy);
+    if(status!=asynSuccess) printf("%s\n",pasynUser->errorMessage);
+    pasynManager->freeAsynUser(pasynUser);
+    return (status==asynSuccess) ? 0 : -1;
+}
+static void asynSetQueuePolicyCall(const iocshArgBuf * args) {
+    asynSetQueuePolicy(args[0].sval,args[1].sval);
+}
+
+static const iocshArg asynSetQueueWeightArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetQueueWeightArg1 = {"addr", iocshArgInt};
+static const iocshArg asynSetQueueWeightArg2 = {"weight", iocshArgInt};
+static const iocshArg *const asynSetQueueWeightArgs[] = {
+    &asynSetQueueWeightArg0,&asynSetQueueWeightArg1,&asynSetQueueWeightArg2};
+static const iocshFuncDef asynSetQueueWeightDef =
+    {"asynSetQueueWeight", 3, asynSetQueueWeightArgs};
+ASYN_API int
+ asynSetQueueWeight(const char *portName,int addr,int weight)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,addr);
+    if(status==asynSuccess)
+        status = pasynManager->setQueueWeight(pasynUser,weight);
+    if(status!=asynSuccess) printf("%s\n",pasynUser->errorMessage);
+    pasynManager->freeAsynUser(pasynUser);
+    return (status==asynSuccess) ? 0 : -1;
+}
+static void asynSetQueueWeightCall(const iocshArgBuf * args) {
+    asynSetQueueWeight(args[0].sval,args[1].ival,args[2].ival);
+}
+
+static const iocshArg asynSetThreadAffinityArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetThreadAffinityArg1 = {"cpuList", iocshArgString};
+static const iocshArg *const asynSetThreadAffinityArgs[] = {
+    &asynSetThreadAffinityArg0,&asynSetThreadAffinityArg1};
+static const iocshFuncDef asynSetThreadAffinityDef =
+    {"asynSetThreadAffinity", 2, asynSetThreadAffinityArgs};
+ASYN_API int
+ asynSetThreadAffinity(const char *portName,const char *cpuList)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status==asynSuccess)
+        status = pasynManager->setThreadAffinity(pasynUser,cpuList);
+    if(status!=asynSuccess) printf("%s\n",pasynUser->errorMessage);
+    pasynManager->freeAsynUser(pasynUser);
+    return (status==asynSuccess) ? 0 : -1;
+}
+static void asynSetThreadAffinityCall(const iocshArgBuf * args) {
+    asynSetThreadAffinity(args[0].sval,args[1].sval);
+}
+
+static const iocshArg asynSetThreadSchedulerArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetThreadSchedulerArg1 = {"policy", iocshArgString};
+static const iocshArg asynSetThreadSchedulerArg2 = {"priority", iocshArgInt};
+static const iocshArg *const asynSetThreadSchedulerArgs[] = {
+    &asynSetThreadSchedulerArg0,&asynSetThreadSchedulerArg1,
+    &asynSetThreadSchedulerArg2};
+static const iocshFuncDef asynSetThreadSchedulerDef =
+    {"asynSetThreadScheduler", 3, asynSetThreadSchedulerArgs};
+ASYN_API int
+ asynSetThreadScheduler(const char *portName,const char *policy,int priority)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status==asynSuccess)
+        status = pasynManager->setThreadScheduler(pasynUser,policy,priority);
+    if(status!=asynSuccess) printf("%s\n",pasynUser->errorMessage);
+    pasynManager->freeAsynUser(pasynUser);
+    return (status==asynSuccess) ? 0 : -1;
+}
+static void asynSetThreadSchedulerCall(const iocshArgBuf * args) {
+    asynSetThreadScheduler(args[0].sval,args[1].sval,args[2].ival);
+}
+
+static const iocshArg asynThreadReportArg0 = {"portName", iocshArgString};
+static const iocshArg *const asynThreadReportArgs[] = {&asynThreadReportArg0};
+static const iocshFuncDef asynThreadReportDef =
+    {"asynThreadReport", 1, asynThreadReportArgs};
+ASYN_API int
+ asynThreadReport(const char *portName)
+{
+    pasynManager->threadReport(stdout,portName);
+    return 0;
+}
+static void asynThreadReportCall(const iocshArgBuf * args) {
+    asynThreadReport(args[0].sval);
+}
+
 static const iocshArg asynOctetConnectArg0 = {"device name", iocshArgString};
 static const iocshArg asynOctetConnectArg1 = {"asyn portName", iocshArgString};
 static const iocshArg asynOctetConnectArg2 = {"asyn addr (default=0)", iocshArgInt};
@@ -1160,6 +1322,64 @@ static void asynSetAutoConnectTimeoutCall(const iocshArgBuf * args) {
     pasynManager->setAutoConnectTimeout(timeout);
 }
 
+static const iocshArg asynSetParallelConnectArg0 = {"yesNo", iocshArgInt};
+static const iocshArg asynSetParallelConnectArg1 = {"timeout", iocshArgDouble};
+static const iocshArg *const asynSetParallelConnectArgs[] = {
+    &asynSetParallelConnectArg0, &asynSetParallelConnectArg1};
+static const iocshFuncDef asynSetParallelConnectDef =
+    {"asynSetParallelConnect", 2, asynSetParallelConnectArgs};
+static void asynSetParallelConnectCall(const iocshArgBuf * args) {
+    int yesNo      = args[0].ival;
+    double timeout = args[1].dval;
+    pasynManager->setParallelConnect(yesNo, timeout);
+}
+
+static const iocshArg asynWaitAllConnectedArg0 = {"timeout", iocshArgDouble};
+static const iocshArg *const asynWaitAllConnectedArgs[] = {
+    &asynWaitAllConnectedArg0};
+static const iocshFuncDef asynWaitAllConnectedDef =
+    {"asynWaitAllConnected", 1, asynWaitAllConnectedArgs};
+static void asynWaitAllConnectedCall(const iocshArgBuf * args) {
+    double timeout = args[0].dval;
+    pasynManager->waitAllConnected(timeout);
+}
+
+static const iocshFuncDef asynConnectReportDef =
+    {"asynConnectReport", 0, NULL};
+static void asynConnectReportCall(const iocshArgBuf * args) {
+    pasynManager->connectReport(stdout);
+}
+
+static const iocshArg asynStatisticsArg0 = {"portName", iocshArgString};
+static const iocshArg asynStatisticsArg1 = {"reset", iocshArgInt};
+static const iocshArg *const asynStatisticsArgs[] = {
+    &asynStatisticsArg0, &asynStatisticsArg1};
+static const iocshFuncDef asynStatisticsDef =
+    {"asynStatistics", 2, asynStatisticsArgs};
+ASYN_API int
+ asynStatistics(const char *portName,int reset)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynManager->queueStatisticsReport(stdout,portName);
+    if(!reset) return 0;
+    if(!portName || !*portName) {
+        printf("asynStatistics: reset needs a port name\n");
+        return -1;
+    }
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status==asynSuccess)
+        status = pasynManager->resetQueueStatistics(pasynUser);
+    if(status!=asynSuccess) printf("%s\n",pasynUser->errorMessage);
+    pasynManager->freeAsynUser(pasynUser);
+    return (status==asynSuccess) ? 0 : -1;
+}
+static void asynStatisticsCall(const iocshArgBuf * args) {
+    asynStatistics(args[0].sval,args[1].ival);
+}
+
 static const iocshArg asynRegisterTimeStampSourceArg0 = { "portName",iocshArgString};
 static const iocshArg asynRegisterTimeStampSourceArg1 = { "functionName",iocshArgString};
 static const iocshArg * const asynRegisterTimeStampSourceArgs[] = {
@@ -1361,6 +1581,12 @@ static void asynRegister(void)
     iocshRegister(&asynSetTraceIOTruncateSizeDef,asynSetTraceIOTruncateSizeCall);
     iocshRegister(&asynEnableDef,asynEnableCall);
     iocshRegister(&asynAutoConnectDef,asynAutoConnectCall);
+    iocshRegister(&asynSetConnectBackoffDef,asynSetConnectBackoffCall);
+    iocshRegister(&asynSetQueuePolicyDef,asynSetQueuePolicyCall);
+    iocshRegister(&asynSetQueueWeightDef,asynSetQueueWeightCall);
+    iocshRegister(&asynSetThreadAffinityDef,asynSetThreadAffinityCall);
+    iocshRegister(&asynSetThreadSchedulerDef,asynSetThreadSchedulerCall);
+    iocshRegister(&asynThreadReportDef,asynThreadReportCall);
     iocshRegister(&asynSetQueueLockPortTimeoutDef,asynSetQueueLockPortTimeoutCall);
     iocshRegister(&asynOctetConnectDef,asynOctetConnectCall);
     iocshRegister(&asynOctetDisconnectDef,asynOctetDisconnectCall);
@@ -1374,6 +1600,10 @@ static void asynRegister(void)
     iocshRegister(&asynOctetGetOutputEosDef,asynOctetGetOutputEosCall);
     iocshRegister(&asynWaitConnectDef,asynWaitConnectCall);
     iocshRegister(&asynSetAutoConnectTimeoutDef,asynSetAutoConnectTimeoutCall);
+    iocshRegister(&asynSetParallelConnectDef,asynSetParallelConnectCall);
+    iocshRegister(&asynWaitAllConnectedDef,asynWaitAllConnectedCall);
+    iocshRegister(&asynConnectReportDef,asynConnectReportCall);
+    iocshRegister(&asynStatisticsDef,asynStatisticsCall);
     iocshRegister(&asynRegisterTimeStampSourceDef, asynRegisterTimeStampSourceCall);
     iocshRegister(&asynUnregisterTimeStampSourceDef, asynUnregisterTimeStampSourceCall);
     iocshRegister(&asynSetMinTimerPeriodDef, asynSetMinTimerPeriodCall);
@@ -36,8 +36,23 @@ ASYN_API int
  asynSetTraceIOTruncateSize(const char *portName,int addr,int size);
 ASYN_API int
  asynAutoConnect(const char *portName,int addr,int yesNo);
+ASYN_API int
+ asynSetConnectBackoff(const char *portName,int addr,
+                       double minDelay,double maxDelay,double jitter,int failFast);
 ASYN_API int
  asynEnable(const char *portName,int addr,int yesNo);
+ASYN_API int
+ asynStatistics(const char *portName,int reset);
+ASYN_API int
+ asynSetQueuePolicy(const char *portName,const char *policy);
+ASYN_API int
+ asynSetQueueWeight(const char *portName,int addr,int weight);
+ASYN_API int
+ asynSetThreadAffinity(const char *portName,const char *cpuList);
+ASYN_API int
+ asynSetThreadScheduler(const char *portName,const char *policy,int priority);
+ASYN_API int
+ asynThreadReport(const char *portName);
 
 ASYN_API int
  asynOctetConnect(const char *entry, const char *port, int addr,
@@ -0,0 +1,240 @@
+/* asynStatisticsDriver.cpp */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+/*
+ * Publishes the queue statistics of another port as parameters, so they can be
+ * read by records and archived. The address is the queue priority:
+ * 0 low, 1 medium, 2 high, 3 connect.
+ * The statistics are read from asynManager every period seconds.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <iocsh.h>
+
+#include <asynPortDriver.h>
+#include <epicsExport.h>
+
+#define NUM_PRIORITIES (asynQueuePriorityConnect + 1)
+#define DEFAULT_PERIOD 1.0
+
+#define P_RequestsString        "QUEUE_REQUESTS"        /* asynInt32,   r/o */
+#define P_TimeoutsString        "QUEUE_TIMEOUTS"        /* asynInt32,   r/o */
+#define P_ExpiredString         "QUEUE_EXPIRED"         /* asynInt32,   r/o */
+#define P_DepthString           "QUEUE_DEPTH"           /* asynInt32,   r/o */
+#define P_MaxDepthString        "QUEUE_MAX_DEPTH"       /* asynInt32,   r/o */
+#define P_WaitMeanString        "QUEUE_WAIT_MEAN"       /* asynFloat64, r/o */
+#define P_WaitP50String         "QUEUE_WAIT_P50"        /* asynFloat64, r/o */
+#define P_WaitP90String         "QUEUE_WAIT_P90"        /* asynFloat64, r/o */
+#define P_WaitP99String         "QUEUE_WAIT_P99"        /* asynFloat64, r/o */
+#define P_WaitMaxString         "QUEUE_WAIT_MAX"        /* asynFloat64, r/o */
+#define P_ServiceMeanString     "QUEUE_SERVICE_MEAN"    /* asynFloat64, r/o */
+#define P_ServiceP50String      "QUEUE_SERVICE_P50"     /* asynFloat64, r/o */
+#define P_ServiceP90String      "QUEUE_SERVICE_P90"     /* asynFloat64, r/o */
+#define P_ServiceP99String      "QUEUE_SERVICE_P99"     /* asynFloat64, r/o */
+#define P_ServiceMaxString      "QUEUE_SERVICE_MAX"     /* asynFloat64, r/o */
+#define P_ResetString           "QUEUE_STATS_RESET"     /* asynInt32,   r/w */
+#define P_PeriodString          "QUEUE_STATS_PERIOD"    /* asynFloat64, r/w */
+
+static const char *driverName = "asynStatisticsDriver";
+
+class asynStatisticsDriver : public asynPortDriver {
+public:
+    asynStatisticsDriver(const char *portName, const char *targetPort, double period);
+    virtual asynStatus writeInt32(asynUser *pasynUser, epicsInt32 value);
+    virtual asynStatus writeFloat64(asynUser *pasynUser, epicsFloat64 value);
+    void pollTask(void);
+
+protected:
+    int P_Requests;
+    int P_Timeouts;
+    int P_Expired;
+    int P_Depth;
+    int P_MaxDepth;
+    int P_WaitMean;
+    int P_WaitP50;
+    int P_WaitP90;
+    int P_WaitP99;
+    int P_WaitMax;
+    int P_ServiceMean;
+    int P_ServiceP50;
+    int P_ServiceP90;
+    int P_ServiceP99;
+    int P_ServiceMax;
+    int P_Reset;
+    int P_Period;
+
+private:
+    void update();
+    asynUser *pasynUserTarget_;
+    epicsEventId wakeup_;
+};
+
+static void pollTask(void *drvPvt)
+{
+    asynStatisticsDriver *pPvt = (asynStatisticsDriver *)drvPvt;
+    pPvt->pollTask();
+}
+
+asynStatisticsDriver::asynStatisticsDriver(const char *portName, const char *targetPort,
+                                           double period)
+   : asynPortDriver(portName,
+                    NUM_PRIORITIES, /* maxAddr */
+                    asynInt32Mask | asynFloat64Mask | asynDrvUserMask, /* Interface mask */
+                    asynInt32Mask | asynFloat64Mask,  /* Interrupt mask */
+                    ASYN_MULTIDEVICE, /* asynFlags.  This driver does not block */
+                    1, /* Autoconnect */
+                    0, /* Default priority */
+                    0) /* Default stack size*/
+{
+    const char *functionName = "asynStatisticsDriver";
+    asynStatus status;
+
+    createParam(P_RequestsString,     asynParamInt32,   &P_Requests);
+    createParam(P_TimeoutsString,     asynParamInt32,   &P_Timeouts);
+    createParam(P_ExpiredString,      asynParamInt32,   &P_Expired);
+    createParam(P_DepthString,        asynParamInt32,   &P_Depth);
+    createParam(P_MaxDepthString,     asynParamInt32,   &P_MaxDepth);
+    createParam(P_WaitMeanString,     asynParamFloat64, &P_WaitMean);
+    createParam(P_WaitP50String,      asynParamFloat64, &P_WaitP50);
+    createParam(P_WaitP90String,      asynParamFloat64, &P_WaitP90);
+    createParam(P_WaitP99String,      asynParamFloat64, &P_WaitP99);
+    createParam(P_WaitMaxString,      asynParamFloat64, &P_WaitMax);
+    createParam(P_ServiceMeanString,  asynParamFloat64, &P_ServiceMean);
+    createParam(P_ServiceP50String,   asynParamFloat64, &P_ServiceP50);
+    createParam(P_ServiceP90String,   asynParamFloat64, &P_ServiceP90);
+    createParam(P_ServiceP99String,   asynParamFloat64, &P_ServiceP99);
+    createParam(P_ServiceMaxString,   asynParamFloat64, &P_ServiceMax);
+    createParam(P_ResetString,        asynParamInt32,   &P_Reset);
+    createParam(P_PeriodString,       asynParamFloat64, &P_Period);
+
+    if (period <= 0) period = DEFAULT_PERIOD;
+    setDoubleParam(P_Period, period);
+    wakeup_ = epicsEventMustCreate(epicsEventEmpty);
+
+    pasynUserTarget_ = pasynManager->createAsynUser(0, 0);
+    status = pasynManager->connectDevice(pasynUserTarget_, targetPort, -1);
+    if (status) {
+        printf("%s:%s: can't connect to port %s: %s\n",
+               driverName, functionName, targetPort, pasynUserTarget_->errorMessage);
+        return;
+    }
+    update();
+    if (epicsThreadCreate("asynStatistics",
+                          epicsThreadPriorityLow,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          (EPICSTHREADFUNC)::pollTask,
+                          this) == NULL) {
+        printf("%s:%s: epicsThreadCreate failure\n", driverName, functionName);
+    }
+}
+
+/** Reads the statistics of all queues. Called with the driver locked. */
+void asynStatisticsDriver::update()
+{
+    asynQueueStatistics stats;
+    int priority;
+
+    for (priority = asynQueuePriorityLow; priority < NUM_PRIORITIES; priority++) {
+        if (pasynManager->getQueueStatistics(pasynUserTarget_,
+                                             (asynQueuePriority)priority, &stats)) continue;
+        setIntegerParam(priority, P_Requests,      (epicsInt32)stats.nRequests);
+        setIntegerParam(priority, P_Timeouts,      (epicsInt32)stats.nTimeouts);
+        setIntegerParam(priority, P_Expired,       (epicsInt32)stats.nExpired);
+        setIntegerParam(priority, P_Depth,         (epicsInt32)stats.depth);
+        setIntegerParam(priority, P_MaxDepth,      (epicsInt32)stats.maxDepth);
+        setDoubleParam (priority, P_WaitMean,      stats.waitMean);
+        setDoubleParam (priority, P_WaitP50,       stats.waitP50);
+        setDoubleParam (priority, P_WaitP90,       stats.waitP90);
+        setDoubleParam (priority, P_WaitP99,       stats.waitP99);
+        setDoubleParam (priority, P_WaitMax,       stats.waitMax);
+        setDoubleParam (priority, P_ServiceMean,   stats.serviceMean);
+        setDoubleParam (priority, P_ServiceP50,    stats.serviceP50);
+        setDoubleParam (priority, P_ServiceP90,    stats.serviceP90);
+        setDoubleParam (priority, P_ServiceP99,    stats.serviceP99);
+        setDoubleParam (priority, P_ServiceMax,    stats.serviceMax);
+        callParamCallbacks(priority);
+    }
+}
+
+void asynStatisticsDriver::pollTask(void)
+{
+    double period;
+
+    lock();
+    while (1) {
+        getDoubleParam(P_Period, &period);
+        unlock();
+        epicsEventWaitWithTimeout(wakeup_, period);
+        lock();
+        update();
+    }
+}
+
+asynStatus asynStatisticsDriver::writeInt32(asynUser *pasynUser, epicsInt32 value)
+{
+    int function = pasynUser->reason;
+
+    if (function == P_Reset) {
+        if (value) {
+            pasynManager->resetQueueStatistics(pasynUserTarget_);
+            update();
+        }
+        return asynSuccess;
+    }
+    return asynPortDriver::writeInt32(pasynUser, value);
+}
+
+asynStatus asynStatisticsDriver::writeFloat64(asynUser *pasynUser, epicsFloat64 value)
+{
+    int function = pasynUser->reason;
+
+    if (function == P_Period) {
+        if (value <= 0) value = DEFAULT_PERIOD;
+        setDoubleParam(P_Period, value);
+        callParamCallbacks();
+        epicsEventSignal(wakeup_);
+        return asynSuccess;
+    }
+    return asynPortDriver::writeFloat64(pasynUser, value);
+}
+
+extern "C" {
+
+int asynStatisticsConfig(const char *portName, const char *targetPort, double period)
+{
+    if (!portName || !targetPort) {
+        printf("Usage: asynStatisticsConfig portName targetPort period\n");
+        return -1;
+    }
+    new asynStatisticsDriver(portName, targetPort, period);
+    return asynSuccess;
+}
+
+static const iocshArg configArg0 = { "portName", iocshArgString};
+static const iocshArg configArg1 = { "targetPort", iocshArgString};
+static const iocshArg configArg2 = { "period", iocshArgDouble};
+static const iocshArg * const configArgs[] = {&configArg0, &configArg1, &configArg2};
+static const iocshFuncDef configFuncDef = {"asynStatisticsConfig", 3, configArgs};
+static void configCallFunc(const iocshArgBuf *args)
+{
+    asynStatisticsConfig(args[0].sval, args[1].sval, args[2].dval);
+}
+
+static void asynStatisticsDriverRegister(void)
+{
+    iocshRegister(&configFuncDef, configCallFunc);
+}
+
+epicsExportRegistrar(asynStatisticsDriverRegister);
+
+}
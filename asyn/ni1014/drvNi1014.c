@@ -132,7 +132,8 @@ static asynGpibPort gpibPort = {
     gpibPortSrqEnable,
     gpibPortSerialPollBegin,
     gpibPortSerialPoll,
-    gpibPortSerialPollEnd
+    gpibPortSerialPollEnd,
+    gpibPortSrqStatus
 };
 
 /* Register definitions */
@@ -166,6 +166,7 @@ static asynStatus vxiSerialPollBegin(void *drvPvt);
 static asynStatus vxiSerialPoll(void *drvPvt, int addr,
     double timeout,int *statusByte);
 static asynStatus vxiSerialPollEnd(void *drvPvt);
+static asynStatus vxiSrqLevel(void *drvPvt,int *srqStatus);
 
 static asynGpibPort vxi11 = {
     vxiReport,
@@ -184,7 +185,8 @@ static asynGpibPort vxi11 = {
     vxiSrqEnable,
     vxiSerialPollBegin,
     vxiSerialPoll,
-    vxiSerialPollEnd
+    vxiSerialPollEnd,
+    vxiSrqLevel
 };
 
 static asynStatus vxiSetPortOption(void *drvPvt,
@@ -1133,6 +1135,25 @@ static asynStatus vxiDisconnect(void *drvPvt,asynUser *pasynUser)
     return status;
 }
 
+/*
+ * Decode a Device_ReadResp directly into the caller's buffer.
+ * On entry data.data_val points to the buffer and data.data_len is its size.
+ * xdr_bytes only allocates when data_val is NULL, so the payload is not
+ * copied again and no xdr_free is needed.
+ */
+static bool_t xdr_Device_ReadRespInPlace(XDR *xdrs, Device_ReadResp *objp)
+{
+    u_int maxLen = objp->data.data_len;
+
+    if (!xdr_Device_ErrorCode (xdrs, &objp->error))
+        return FALSE;
+    if (!xdr_long (xdrs, &objp->reason))
+        return FALSE;
+    if (!xdr_bytes (xdrs, &objp->data.data_val, &objp->data.data_len, maxLen))
+        return FALSE;
+    return TRUE;
+}
+
 static asynStatus vxiRead(void *drvPvt,asynUser *pasynUser,
     char *data,int maxchars,int *nbytesTransferred,int *eomReason)
 {
@@ -1171,14 +1192,17 @@ static asynStatus vxiRead(void *drvPvt,asynUser *pasynUser,
             devReadP.flags |= VXI_TERMCHRSET;
             devReadP.termChar = pdevLink->eos;
         }
-        /* initialize devReadR */
-        memset((char *) &devReadR, 0, sizeof(Device_ReadResp));
         /* RPC call */
         while(TRUE) { /*Allow for very long or infinite timeout*/
+            /* initialize devReadR to decode into the caller's buffer */
+            memset((char *) &devReadR, 0, sizeof(Device_ReadResp));
+            devReadR.data.data_val = data;
+            devReadR.data.data_len = maxchars;
             clntStat = clientIoCall(pvxiPort, pasynUser, device_read,
                 (const xdrproc_t) xdr_Device_ReadParms,(void *) &devReadP,
-                (const xdrproc_t) xdr_Device_ReadResp,(void *) &devReadR);
-            if(devReadP.io_timeout!=UINT_MAX
+                (const xdrproc_t) xdr_Device_ReadRespInPlace,(void *) &devReadR);
+            if(clntStat!=RPC_SUCCESS
+            || devReadP.io_timeout!=UINT_MAX
             || devReadR.error!=VXI_IOTIMEOUT
             || devReadR.data.data_len>0) break;
         }
@@ -1198,14 +1222,12 @@ static asynStatus vxiRead(void *drvPvt,asynUser *pasynUser,
         thisRead = devReadR.data.data_len;
         if(thisRead>0) {
             asynPrintIO(pasynUser,ASYN_TRACEIO_DRIVER,
-                devReadR.data.data_val,devReadR.data.data_len,
+                data,thisRead,
                 "%s %d vxiRead\n",pvxiPort->portName,addr);
-            memcpy(data, devReadR.data.data_val, thisRead);
             nRead += thisRead;
             data += thisRead;
             maxchars -= thisRead;
         }
-        xdr_free((const xdrproc_t) xdr_Device_ReadResp, (char *) &devReadR);
     } while(!devReadR.reason && thisRead>0);
     if(eomReason) {
         *eomReason = 0;
@@ -1534,6 +1556,17 @@ static asynStatus vxiSrqStatus(void *drvPvt,int *srqStatus)
     return status;
 }
 
+static asynStatus vxiSrqLevel(void *drvPvt,int *srqStatus)
+{
+    vxiPort    *pvxiPort = (vxiPort *)drvPvt;
+
+    assert(pvxiPort);
+    /*A single link has only one device and no bus status*/
+    if(pvxiPort->isSingleLink) return asynError;
+    return vxiBusStatus(pvxiPort, VXI_BSTAT_SRQ,
+        pvxiPort->defTimeout,srqStatus);
+}
+
 static asynStatus vxiSrqEnable(void *drvPvt, int onOff)
 {
     vxiPort    *pvxiPort = (vxiPort *)drvPvt;
@@ -6,6 +6,7 @@ testManagerDriverInit("cantBlockSingle",0,0,0)
 testManagerDriverInit("cantBlockMulti",0,0,1)
 testManagerDriverInit("canBlockSingle",1,0,0)
 testManagerDriverInit("canBlockMulti",1,0,1)
+testManagerDriverInit("slowMulti",1,0,1,.001)
 # following are noAutoConnect
 #testManagerDriverInit("cantBlockSingle",0,1,0)
 #testManagerDriverInit("cantBlockMulti",0,1,1)
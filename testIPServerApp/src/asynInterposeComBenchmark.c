@@ -0,0 +1,311 @@
+/* asynInterposeComBenchmark.c */
+/*
+ * Times the IAC stuffing and unstuffing of asynInterposeCom.
+ * A port that keeps everything in memory is created with asynInterposeCOM
+ * on top of it. It answers the TELNET and COM-PORT-OPTION negotiation,
+ * then takes the stuffed data of each write and hands out a stuffed copy
+ * of the test data to reads, so only the interpose layer is measured.
+ * The test data has an IAC (0xFF) every iacSpacing bytes, none if it is 0.
+ * The first write and read of each run are checked against the test data.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <epicsStdio.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <asynOctet.h>
+#include <asynOctetSyncIO.h>
+#include <asynInterposeCom.h>
+#include <epicsExport.h>
+
+#define C_IAC   255
+#define C_DO    253
+#define C_WILL  251
+#define C_SB    250
+#define C_SE    240
+#define SB_COM_PORT_OPTION 44
+
+#define DEFAULT_SIZE      1000000
+#define DEFAULT_READ_SIZE 65536
+#define TIMEOUT           1.0
+
+typedef struct comBenchmark {
+    asynInterface common;
+    asynInterface octet;
+    int           negotiating;  /* answer TELNET commands instead of moving data */
+    char          *reply;       /* negotiation replies or stuffed test data to read */
+    size_t        replySize;
+    size_t        replyLen;
+    size_t        readPos;
+    const char    *expect;      /* stuffed data the next write must match, if set */
+    size_t        expectLen;
+    int           nMismatch;
+}comBenchmark;
+
+static void appendReply(comBenchmark *pbench, const char *data, size_t len)
+{
+    if (pbench->replyLen + len > pbench->replySize) {
+        pbench->replySize = 2 * (pbench->replyLen + len);
+        pbench->reply = realloc(pbench->reply, pbench->replySize);
+        if (!pbench->reply) cantProceed("asynInterposeComBenchmark");
+    }
+    memcpy(pbench->reply + pbench->replyLen, data, len);
+    pbench->replyLen += len;
+}
+
+/* Agree to each WILL and DO and echo each COM-PORT-OPTION as the server reply */
+static void negotiate(comBenchmark *pbench, const char *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    size_t i = 0;
+
+    while (i + 2 < len) {
+        char answer[3];
+
+        if (p[i] != C_IAC) {
+            i++;
+            continue;
+        }
+        if ((p[i+1] == C_WILL) || (p[i+1] == C_DO)) {
+            answer[0] = (char)C_IAC;
+            answer[1] = (char)((p[i+1] == C_WILL) ? C_DO : C_WILL);
+            answer[2] = (char)p[i+2];
+            appendReply(pbench, answer, 3);
+            i += 3;
+        } else if ((p[i+1] == C_SB) && (i + 3 < len)) {
+            size_t end = i + 4;
+
+            /* The payload is echoed still stuffed, IAC SE ends it */
+            while (end + 1 < len && !((p[end] == C_IAC) && (p[end+1] == C_SE)))
+                end += (p[end] == C_IAC) ? 2 : 1;
+            if (end + 1 >= len) break;
+            answer[0] = (char)C_IAC;
+            answer[1] = (char)C_SB;
+            answer[2] = (char)SB_COM_PORT_OPTION;
+            appendReply(pbench, answer, 3);
+            answer[0] = (char)(p[i+3] + 100);
+            appendReply(pbench, answer, 1);
+            appendReply(pbench, data + i + 4, end + 2 - (i + 4));
+            i = end + 2;
+        } else {
+            i += 2;
+        }
+    }
+}
+
+static void report(void *drvPvt, FILE *fp, int details)
+{
+    comBenchmark *pbench = (comBenchmark *)drvPvt;
+
+    fprintf(fp, "    asynInterposeComBenchmark %lu bytes to read, %d mismatched writes\n",
+            (unsigned long)pbench->replyLen, pbench->nMismatch);
+}
+
+static asynStatus connect(void *drvPvt, asynUser *pasynUser)
+{
+    pasynManager->exceptionConnect(pasynUser);
+    return asynSuccess;
+}
+
+static asynStatus disconnect(void *drvPvt, asynUser *pasynUser)
+{
+    pasynManager->exceptionDisconnect(pasynUser);
+    return asynSuccess;
+}
+
+static asynCommon common = { report, connect, disconnect };
+
+static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
+    const char *data, size_t numchars, size_t *nbytesTransferred)
+{
+    comBenchmark *pbench = (comBenchmark *)drvPvt;
+
+    if (pbench->negotiating) {
+        negotiate(pbench, data, numchars);
+    } else if (pbench->expect) {
+        if ((numchars != pbench->expectLen) || memcmp(data, pbench->expect, numchars))
+            pbench->nMismatch++;
+        pbench->expect = NULL;
+    }
+    *nbytesTransferred = numchars;
+    return asynSuccess;
+}
+
+static asynStatus readIt(void *drvPvt, asynUser *pasynUser,
+    char *data, size_t maxchars, size_t *nbytesTransferred, int *eomReason)
+{
+    comBenchmark *pbench = (comBenchmark *)drvPvt;
+    size_t n = pbench->replyLen - pbench->readPos;
+
+    if (n == 0) {
+        *nbytesTransferred = 0;
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "asynInterposeComBenchmark: no more data");
+        return asynTimeout;
+    }
+    if (n > maxchars) n = maxchars;
+    memcpy(data, pbench->reply + pbench->readPos, n);
+    pbench->readPos += n;
+    if (pbench->negotiating && (pbench->readPos == pbench->replyLen))
+        pbench->readPos = pbench->replyLen = 0;
+    *nbytesTransferred = n;
+    if (eomReason) *eomReason = (n == maxchars) ? ASYN_EOM_CNT : 0;
+    return asynSuccess;
+}
+
+static asynStatus flushIt(void *drvPvt, asynUser *pasynUser)
+{
+    return asynSuccess;
+}
+
+static asynOctet octet = { writeIt, readIt, flushIt };
+
+static double mbPerSecond(size_t nBytes, int count, epicsTimeStamp *start, epicsTimeStamp *end)
+{
+    double elapsed = epicsTimeDiffInSeconds(end, start);
+
+    return (elapsed > 0.) ? (double)nBytes * count / elapsed / 1e6 : 0.;
+}
+
+static int asynInterposeComBenchmark(const char *port, int size, int iacSpacing,
+                                     int readSize, int count)
+{
+    comBenchmark *pbench;
+    asynUser *pasynUser;
+    char *data, *result;
+    size_t i, nIAC = 0, nDone, nBytes;
+    epicsTimeStamp start, end;
+    asynStatus status = asynSuccess;
+    int eomReason, n, nErrors = 0;
+
+    if (!port || !*port) {
+        printf("Usage: asynInterposeComBenchmark port size iacSpacing readSize count\n");
+        return -1;
+    }
+    if (size <= 0) size = DEFAULT_SIZE;
+    if (iacSpacing < 0) iacSpacing = 0;
+    if (readSize <= 0) readSize = DEFAULT_READ_SIZE;
+    if (count <= 0) count = 10;
+    data = callocMustSucceed(size, 1, "asynInterposeComBenchmark");
+    result = callocMustSucceed(size, 1, "asynInterposeComBenchmark");
+    for (i = 0; i < (size_t)size; i++) {
+        if (iacSpacing && ((i % iacSpacing) == (size_t)iacSpacing - 1)) {
+            data[i] = (char)C_IAC;
+            nIAC++;
+        } else {
+            data[i] = (char)(i % 251);
+        }
+    }
+
+    /* The port and its buffers are never freed, as ports can not be removed */
+    pbench = callocMustSucceed(1, sizeof(*pbench), "asynInterposeComBenchmark");
+    pbench->negotiating = 1;
+    pbench->common.interfaceType = asynCommonType;
+    pbench->common.pinterface = &common;
+    pbench->common.drvPvt = pbench;
+    pbench->octet.interfaceType = asynOctetType;
+    pbench->octet.pinterface = &octet;
+    pbench->octet.drvPvt = pbench;
+    if (pasynManager->registerPort(port, 0, 1, 0, 0) ||
+        pasynManager->registerInterface(port, &pbench->common) ||
+        pasynOctetBase->initialize(port, &pbench->octet, 0, 0, 0) ||
+        asynInterposeCOM(port)) {
+        printf("asynInterposeComBenchmark: can't create port %s\n", port);
+        return -1;
+    }
+    pbench->negotiating = 0;
+    pbench->readPos = pbench->replyLen = 0;
+    for (i = 0; i < (size_t)size; i++) {
+        appendReply(pbench, &data[i], 1);
+        if ((data[i] & 0xFF) == C_IAC) appendReply(pbench, &data[i], 1);
+    }
+    if (pasynOctetSyncIO->connect(port, 0, &pasynUser, NULL)) {
+        printf("asynInterposeComBenchmark: can't connect to port %s\n", port);
+        return -1;
+    }
+
+    epicsTimeGetCurrent(&start);
+    for (n = 0; n < count; n++) {
+        if (n == 0) {
+            pbench->expect = pbench->reply;
+            pbench->expectLen = pbench->replyLen;
+        }
+        status = pasynOctetSyncIO->write(pasynUser, data, size, TIMEOUT, &nDone);
+        if (status || (nDone != (size_t)size)) {
+            printf("asynInterposeComBenchmark: write %lu of %d bytes %s\n",
+                   (unsigned long)nDone, size, pasynUser->errorMessage);
+            nErrors++;
+            break;
+        }
+    }
+    epicsTimeGetCurrent(&end);
+    nErrors += pbench->nMismatch;
+    printf("%s write: %d x %d bytes, %lu IAC, %.1f MB/s\n",
+           port, n, size, (unsigned long)nIAC, mbPerSecond(size, n, &start, &end));
+
+    epicsTimeGetCurrent(&start);
+    for (n = 0; n < count && !status; n++) {
+        pbench->readPos = 0;
+        for (nBytes = 0; nBytes < (size_t)size; nBytes += nDone) {
+            size_t nRead = (size_t)size - nBytes;
+
+            if (nRead > (size_t)readSize) nRead = readSize;
+            status = pasynOctetSyncIO->read(pasynUser, result + nBytes, nRead,
+                                            TIMEOUT, &nDone, &eomReason);
+            if (status) {
+                printf("asynInterposeComBenchmark: read %s\n", pasynUser->errorMessage);
+                nErrors++;
+                break;
+            }
+        }
+        if ((n == 0) && !status && memcmp(result, data, size)) {
+            printf("asynInterposeComBenchmark: data read does not match\n");
+            nErrors++;
+        }
+    }
+    epicsTimeGetCurrent(&end);
+    printf("%s read: %d x %d bytes in %d byte reads, %.1f MB/s\n",
+           port, n, size, readSize, mbPerSecond(size, n, &start, &end));
+    printf("    errors %d\n", nErrors);
+    pasynOctetSyncIO->disconnect(pasynUser);
+    free(result);
+    free(data);
+    return nErrors ? -1 : 0;
+}
+
+/* iocsh functions */
+static const iocshArg benchmarkArg0 = {"port", iocshArgString};
+static const iocshArg benchmarkArg1 = {"size", iocshArgInt};
+static const iocshArg benchmarkArg2 = {"iacSpacing", iocshArgInt};
+static const iocshArg benchmarkArg3 = {"readSize", iocshArgInt};
+static const iocshArg benchmarkArg4 = {"count", iocshArgInt};
+static const iocshArg *const benchmarkArgs[] = {
+    &benchmarkArg0, &benchmarkArg1, &benchmarkArg2, &benchmarkArg3, &benchmarkArg4};
+static const iocshFuncDef benchmarkDef = {"asynInterposeComBenchmark", 5, benchmarkArgs};
+static void benchmarkCall(const iocshArgBuf * args)
+{
+    asynInterposeComBenchmark(args[0].sval, args[1].ival, args[2].ival, args[3].ival,
+                              args[4].ival);
+}
+
+static void asynInterposeComBenchmarkRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&benchmarkDef, benchmarkCall);
+    }
+}
+epicsExportRegistrar(asynInterposeComBenchmarkRegister);
@@ -0,0 +1,116 @@
+/* asynWriteReadBenchmark.c */
+/*
+ * Times a number of asynOctetSyncIO writeRead transactions on a port.
+ * Used to compare transports, for example drvAsynHiSLIP with drvVxi11
+ * talking to the same instrument, or drvAsynHiSLIP with hislipServer.
+ * With a large read size it measures the throughput of long responses,
+ * for example drvVxi11 talking to vxi11LoopbackServer.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <asynOctetSyncIO.h>
+#include <epicsExport.h>
+
+#define DEFAULT_READ_SIZE 4096
+#define TIMEOUT           2.0
+
+static int asynWriteReadBenchmark(const char *port, int addr, const char *command,
+                                  int count, int readSize)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+    char *response;
+    size_t nWrite, nRead;
+    int eomReason;
+    epicsTimeStamp start, end;
+    double elapsed, minTime = 1e30, maxTime = 0.;
+    double nBytes = 0.;
+    int i, nDone = 0;
+
+    if (!port || !command) {
+        printf("Usage: asynWriteReadBenchmark port addr command count readSize\n");
+        return -1;
+    }
+    if (count <= 0) count = 1000;
+    if (readSize <= 0) readSize = DEFAULT_READ_SIZE;
+    status = pasynOctetSyncIO->connect(port, addr, &pasynUser, NULL);
+    if (status) {
+        printf("asynWriteReadBenchmark: can't connect to port %s\n", port);
+        return -1;
+    }
+    response = malloc(readSize);
+    if (!response) {
+        printf("asynWriteReadBenchmark: can't allocate %d bytes\n", readSize);
+        pasynOctetSyncIO->disconnect(pasynUser);
+        return -1;
+    }
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < count; i++) {
+        epicsTimeStamp t0, t1;
+        double dt;
+
+        epicsTimeGetCurrent(&t0);
+        status = pasynOctetSyncIO->writeRead(pasynUser, command, strlen(command),
+                                             response, readSize, TIMEOUT,
+                                             &nWrite, &nRead, &eomReason);
+        if (status) {
+            printf("asynWriteReadBenchmark: %s\n", pasynUser->errorMessage);
+            break;
+        }
+        epicsTimeGetCurrent(&t1);
+        dt = epicsTimeDiffInSeconds(&t1, &t0);
+        if (dt < minTime) minTime = dt;
+        if (dt > maxTime) maxTime = dt;
+        nBytes += nRead;
+        nDone++;
+    }
+    epicsTimeGetCurrent(&end);
+    pasynOctetSyncIO->disconnect(pasynUser);
+    free(response);
+    if (nDone == 0) return -1;
+    elapsed = epicsTimeDiffInSeconds(&end, &start);
+    printf("%s: %d transactions in %.3f s, %.1f/s, "
+           "min %.1f us, mean %.1f us, max %.1f us, %.3f MB/s read\n",
+           port, nDone, elapsed, nDone / elapsed,
+           minTime * 1e6, elapsed / nDone * 1e6, maxTime * 1e6,
+           nBytes / elapsed / 1e6);
+    return 0;
+}
+
+/* iocsh functions */
+static const iocshArg benchmarkArg0 = {"port", iocshArgString};
+static const iocshArg benchmarkArg1 = {"addr", iocshArgInt};
+static const iocshArg benchmarkArg2 = {"command", iocshArgString};
+static const iocshArg benchmarkArg3 = {"count", iocshArgInt};
+static const iocshArg benchmarkArg4 = {"readSize", iocshArgInt};
+static const iocshArg *const benchmarkArgs[] = {
+    &benchmarkArg0, &benchmarkArg1, &benchmarkArg2, &benchmarkArg3, &benchmarkArg4};
+static const iocshFuncDef benchmarkDef = {"asynWriteReadBenchmark", 5, benchmarkArgs};
+static void benchmarkCall(const iocshArgBuf * args)
+{
+    asynWriteReadBenchmark(args[0].sval, args[1].ival, args[2].sval, args[3].ival,
+                           args[4].ival);
+}
+
+static void asynWriteReadBenchmarkRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&benchmarkDef, benchmarkCall);
+    }
+}
+epicsExportRegistrar(asynWriteReadBenchmarkRegister);
@@ -0,0 +1,300 @@
+/* hislipServer.c */
+/*
+ * A minimal HiSLIP (IVI-6.1) instrument used to test drvAsynHiSLIP without hardware.
+ *
+ * Each connection is served by its own thread.  Queries (messages ending in '?') are answered:
+ * "*IDN?" returns an identification string, any other query is echoed back.
+ * Other messages are accepted and ignored.  Device clear, status query,
+ * remote/local and lock requests on the asynchronous channel are acknowledged.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <osiSock.h>
+#include <cantProceed.h>
+#include <epicsThread.h>
+#include <epicsTypes.h>
+#include <epicsStdio.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#define HEADER_SIZE         16
+#define MAX_MESSAGE_SIZE    (1024*1024)
+#define IDN_STRING          "asyn,hislipServer,0,1\n"
+
+/* Message types, see drvAsynHiSLIP.c */
+#define Initialize                      0
+#define InitializeResponse              1
+#define AsyncLock                       4
+#define AsyncLockResponse               5
+#define Data                            6
+#define DataEnd                         7
+#define DeviceClearComplete             8
+#define DeviceClearAcknowledge          9
+#define AsyncRemoteLocalControl         10
+#define AsyncRemoteLocalResponse        11
+#define AsyncMaximumMessageSize         15
+#define AsyncMaximumMessageSizeResponse 16
+#define AsyncInitialize                 17
+#define AsyncInitializeResponse         18
+#define AsyncDeviceClear                19
+#define AsyncStatusQuery                21
+#define AsyncStatusResponse             22
+#define AsyncDeviceClearAcknowledge     23
+
+typedef struct header {
+    int          messageType;
+    int          controlCode;
+    epicsUInt32  parameter;
+    epicsUInt64  payloadLength;
+} header;
+
+typedef struct connection {
+    SOCKET  sock;
+    int     sessionId;
+    char    *payload;
+    size_t  payloadSize;
+} connection;
+
+static int nextSessionId = 1;
+
+static int recvAll(SOCKET sock, char *buf, size_t n)
+{
+    while (n > 0) {
+        int nr = recv(sock, buf, (int)n, 0);
+        if (nr <= 0) return -1;
+        buf += nr;
+        n -= nr;
+    }
+    return 0;
+}
+
+static int sendAll(SOCKET sock, const char *buf, size_t n)
+{
+    while (n > 0) {
+        int nw = send(sock, buf, (int)n, 0);
+        if (nw <= 0) return -1;
+        buf += nw;
+        n -= nw;
+    }
+    return 0;
+}
+
+static int sendMessage(connection *pconn, int messageType, int controlCode,
+                       epicsUInt32 parameter, const char *payload, size_t len)
+{
+    unsigned char hdr[HEADER_SIZE];
+    epicsUInt64 length = len;
+    int i;
+
+    hdr[0] = 'H';
+    hdr[1] = 'S';
+    hdr[2] = (unsigned char)messageType;
+    hdr[3] = (unsigned char)controlCode;
+    for (i = 0; i < 4; i++) hdr[4+i] = (unsigned char)(parameter >> (8 * (3 - i)));
+    for (i = 0; i < 8; i++) hdr[8+i] = (unsigned char)(length >> (8 * (7 - i)));
+    if (sendAll(pconn->sock, (char *)hdr, sizeof hdr)) return -1;
+    if (len && sendAll(pconn->sock, payload, len)) return -1;
+    return 0;
+}
+
+/* Reads a message, appending the payload to pconn->payload at offset *pLen */
+static int readMessage(connection *pconn, header *phdr, size_t *pLen)
+{
+    unsigned char hdr[HEADER_SIZE];
+    int i;
+
+    if (recvAll(pconn->sock, (char *)hdr, sizeof hdr)) return -1;
+    if ((hdr[0] != 'H') || (hdr[1] != 'S')) return -1;
+    phdr->messageType = hdr[2];
+    phdr->controlCode = hdr[3];
+    phdr->parameter = 0;
+    for (i = 0; i < 4; i++) phdr->parameter = (phdr->parameter << 8) | hdr[4+i];
+    phdr->payloadLength = 0;
+    for (i = 0; i < 8; i++) phdr->payloadLength = (phdr->payloadLength << 8) | hdr[8+i];
+    if (phdr->payloadLength > MAX_MESSAGE_SIZE) return -1;
+    if (*pLen + phdr->payloadLength > pconn->payloadSize) *pLen = 0;
+    if (recvAll(pconn->sock, pconn->payload + *pLen, (size_t)phdr->payloadLength)) return -1;
+    *pLen += (size_t)phdr->payloadLength;
+    return 0;
+}
+
+static void serveSync(connection *pconn)
+{
+    header hdr;
+    size_t len = 0;
+
+    for (;;) {
+        if (readMessage(pconn, &hdr, &len)) return;
+        switch (hdr.messageType) {
+        case Data:
+            break;
+        case DataEnd:
+            if ((len > 0) && (pconn->payload[len-1] == '\n')) len--;
+            if ((len > 0) && (pconn->payload[len-1] == '?')) {
+                if ((len == 5) && (strncmp(pconn->payload, "*IDN?", 5) == 0)) {
+                    if (sendMessage(pconn, DataEnd, 0, hdr.parameter,
+                                    IDN_STRING, strlen(IDN_STRING))) return;
+                } else {
+                    pconn->payload[len++] = '\n';
+                    if (sendMessage(pconn, DataEnd, 0, hdr.parameter,
+                                    pconn->payload, len)) return;
+                }
+            }
+            len = 0;
+            break;
+        case DeviceClearComplete:
+            len = 0;
+            if (sendMessage(pconn, DeviceClearAcknowledge, 0, 0, NULL, 0)) return;
+            break;
+        default:
+            len = 0;
+            break;
+        }
+    }
+}
+
+static void serveAsync(connection *pconn)
+{
+    header hdr;
+    size_t len;
+    unsigned char size[8];
+    int i;
+
+    for (;;) {
+        len = 0;
+        if (readMessage(pconn, &hdr, &len)) return;
+        switch (hdr.messageType) {
+        case AsyncMaximumMessageSize:
+            for (i = 0; i < 8; i++)
+                size[i] = (unsigned char)((epicsUInt64)MAX_MESSAGE_SIZE >> (8 * (7 - i)));
+            if (sendMessage(pconn, AsyncMaximumMessageSizeResponse, 0, 0,
+                            (char *)size, sizeof size)) return;
+            break;
+        case AsyncDeviceClear:
+            if (sendMessage(pconn, AsyncDeviceClearAcknowledge, 0, 0, NULL, 0)) return;
+            break;
+        case AsyncStatusQuery:
+            if (sendMessage(pconn, AsyncStatusResponse, 0, 0, NULL, 0)) return;
+            break;
+        case AsyncRemoteLocalControl:
+            if (sendMessage(pconn, AsyncRemoteLocalResponse, 0, 0, NULL, 0)) return;
+            break;
+        case AsyncLock:
+            if (sendMessage(pconn, AsyncLockResponse, 1, 0, NULL, 0)) return;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void connectionThread(void *arg)
+{
+    connection *pconn = (connection *)arg;
+    header hdr;
+    size_t len = 0;
+
+    /* The first message tells which channel this is */
+    if (readMessage(pconn, &hdr, &len) == 0) {
+        if (hdr.messageType == Initialize) {
+            pconn->sessionId = nextSessionId++ & 0xFFFF;
+            if (sendMessage(pconn, InitializeResponse, 0,
+                            (0x0100U << 16) | (epicsUInt32)pconn->sessionId, NULL, 0) == 0)
+                serveSync(pconn);
+        } else if (hdr.messageType == AsyncInitialize) {
+            pconn->sessionId = (int)hdr.parameter;
+            if (sendMessage(pconn, AsyncInitializeResponse, 0, ('A' << 8) | 'S', NULL, 0) == 0)
+                serveAsync(pconn);
+        }
+    }
+    epicsSocketDestroy(pconn->sock);
+    free(pconn->payload);
+    free(pconn);
+}
+
+static void listenThread(void *arg)
+{
+    SOCKET listenSock = *(SOCKET *)arg;
+
+    free(arg);
+    for (;;) {
+        osiSockAddr clientAddr;
+        osiSocklen_t addrSize = sizeof clientAddr;
+        connection *pconn;
+        SOCKET sock = epicsSocketAccept(listenSock, &clientAddr.sa, &addrSize);
+
+        if (sock == INVALID_SOCKET) {
+            epicsThreadSleep(1.0);
+            continue;
+        }
+        pconn = callocMustSucceed(1, sizeof(*pconn), "hislipServer");
+        pconn->sock = sock;
+        /* Room for one maximum size message plus the appended newline */
+        pconn->payloadSize = MAX_MESSAGE_SIZE;
+        pconn->payload = mallocMustSucceed(pconn->payloadSize + 1, "hislipServer");
+        epicsThreadCreate("hislipConnection",
+                          epicsThreadPriorityLow,
+                          epicsThreadGetStackSize(epicsThreadStackSmall),
+                          connectionThread, pconn);
+    }
+}
+
+static int hislipServer(int port)
+{
+    osiSockAddr addr;
+    SOCKET *pListenSock;
+
+    if (port <= 0) port = 4880;
+    pListenSock = mallocMustSucceed(sizeof(SOCKET), "hislipServer");
+    *pListenSock = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    if (*pListenSock == INVALID_SOCKET) {
+        printf("hislipServer: can't create socket\n");
+        free(pListenSock);
+        return -1;
+    }
+    epicsSocketEnableAddressReuseDuringTimeWaitState(*pListenSock);
+    memset(&addr, 0, sizeof addr);
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.ia.sin_port = htons((unsigned short)port);
+    if ((bind(*pListenSock, &addr.sa, sizeof addr.ia) != 0) ||
+        (listen(*pListenSock, 4) != 0)) {
+        printf("hislipServer: can't listen on port %d\n", port);
+        epicsSocketDestroy(*pListenSock);
+        free(pListenSock);
+        return -1;
+    }
+    epicsThreadCreate("hislipServer",
+                      epicsThreadPriorityLow,
+                      epicsThreadGetStackSize(epicsThreadStackSmall),
+                      listenThread, pListenSock);
+    return 0;
+}
+
+/* iocsh functions */
+static const iocshArg hislipServerArg0 = {"TCP port", iocshArgInt};
+static const iocshArg *const hislipServerArgs[] = {&hislipServerArg0};
+static const iocshFuncDef hislipServerDef = {"hislipServer", 1, hislipServerArgs};
+static void hislipServerCall(const iocshArgBuf * args)
+{
+    hislipServer(args[0].ival);
+}
+
+static void hislipServerRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&hislipServerDef, hislipServerCall);
+    }
+}
+epicsExportRegistrar(hislipServerRegister);
@@ -0,0 +1,247 @@
+/* vxi11LoopbackServer.c */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory, and
+* Berliner Elektronenspeicherring-Gesellschaft m.b.H. (BESSY).
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+/*
+ * A minimal VXI-11 core channel server used to test and benchmark drvVxi11
+ * without an instrument.  Every device_read returns part of a fixed size
+ * response, so large transfers can be timed with vxi11Configure pointing
+ * at localhost.  device_write restarts the response.
+ * The server registers with the portmapper, so rpcbind must be running.
+ *
+ * SRQ, locking and device_docmd are not supported.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <cantProceed.h>
+#include <iocsh.h>
+
+#include "vxi11.h"
+#include "osiRpc.h"
+#include "vxi11core.h"
+#include <epicsExport.h>
+
+#define DEFAULT_RESPONSE_SIZE   1000000
+#define MAX_RECV_SIZE           0x100000
+
+typedef struct loopbackServer {
+    char          *response;
+    u_long        responseSize;
+    u_long        position;
+    Device_Link   nextLid;
+    unsigned long nReads;
+    unsigned long nBytes;
+} loopbackServer;
+
+static loopbackServer *pserver;
+
+static void replyError(SVCXPRT *transp, Device_ErrorCode error)
+{
+    Device_Error devErr;
+
+    devErr.error = error;
+    svc_sendreply(transp, (xdrproc_t) xdr_Device_Error, (caddr_t) &devErr);
+}
+
+static void createLink(SVCXPRT *transp)
+{
+    Create_LinkParms crLinkP;
+    Create_LinkResp crLinkR;
+
+    memset(&crLinkP, 0, sizeof crLinkP);
+    if (!svc_getargs(transp, (xdrproc_t) xdr_Create_LinkParms, (caddr_t) &crLinkP)) {
+        svcerr_decode(transp);
+        return;
+    }
+    memset(&crLinkR, 0, sizeof crLinkR);
+    crLinkR.error = VXI_OK;
+    crLinkR.lid = pserver->nextLid++;
+    crLinkR.abortPort = 0;
+    crLinkR.maxRecvSize = MAX_RECV_SIZE;
+    svc_sendreply(transp, (xdrproc_t) xdr_Create_LinkResp, (caddr_t) &crLinkR);
+    svc_freeargs(transp, (xdrproc_t) xdr_Create_LinkParms, (caddr_t) &crLinkP);
+}
+
+static void deviceWrite(SVCXPRT *transp)
+{
+    Device_WriteParms devWriteP;
+    Device_WriteResp devWriteR;
+
+    memset(&devWriteP, 0, sizeof devWriteP);
+    if (!svc_getargs(transp, (xdrproc_t) xdr_Device_WriteParms, (caddr_t) &devWriteP)) {
+        svcerr_decode(transp);
+        return;
+    }
+    pserver->position = 0;
+    memset(&devWriteR, 0, sizeof devWriteR);
+    devWriteR.error = VXI_OK;
+    devWriteR.size = devWriteP.data.data_len;
+    svc_sendreply(transp, (xdrproc_t) xdr_Device_WriteResp, (caddr_t) &devWriteR);
+    svc_freeargs(transp, (xdrproc_t) xdr_Device_WriteParms, (caddr_t) &devWriteP);
+}
+
+static void deviceRead(SVCXPRT *transp)
+{
+    Device_ReadParms devReadP;
+    Device_ReadResp devReadR;
+    u_long remaining, nSend;
+
+    memset(&devReadP, 0, sizeof devReadP);
+    if (!svc_getargs(transp, (xdrproc_t) xdr_Device_ReadParms, (caddr_t) &devReadP)) {
+        svcerr_decode(transp);
+        return;
+    }
+    if (pserver->position >= pserver->responseSize) pserver->position = 0;
+    remaining = pserver->responseSize - pserver->position;
+    nSend = (devReadP.requestSize < remaining) ? devReadP.requestSize : remaining;
+    memset(&devReadR, 0, sizeof devReadR);
+    devReadR.error = VXI_OK;
+    devReadR.data.data_val = pserver->response + pserver->position;
+    devReadR.data.data_len = nSend;
+    pserver->position += nSend;
+    if (pserver->position >= pserver->responseSize) devReadR.reason |= VXI_ENDR;
+    if (nSend == devReadP.requestSize) devReadR.reason |= VXI_REQCNT;
+    pserver->nReads++;
+    pserver->nBytes += nSend;
+    svc_sendreply(transp, (xdrproc_t) xdr_Device_ReadResp, (caddr_t) &devReadR);
+    svc_freeargs(transp, (xdrproc_t) xdr_Device_ReadParms, (caddr_t) &devReadP);
+}
+
+static void deviceReadStb(SVCXPRT *transp)
+{
+    Device_ReadStbResp devReadStbR;
+
+    memset(&devReadStbR, 0, sizeof devReadStbR);
+    devReadStbR.error = VXI_OK;
+    svc_sendreply(transp, (xdrproc_t) xdr_Device_ReadStbResp, (caddr_t) &devReadStbR);
+}
+
+static void dispatch(struct svc_req *rqstp, SVCXPRT *transp)
+{
+    switch (rqstp->rq_proc) {
+    case NULLPROC:
+        svc_sendreply(transp, (xdrproc_t) xdr_void, NULL);
+        break;
+    case create_link:
+        createLink(transp);
+        break;
+    case device_write:
+        deviceWrite(transp);
+        break;
+    case device_read:
+        deviceRead(transp);
+        break;
+    case device_readstb:
+        deviceReadStb(transp);
+        break;
+    case device_trigger:
+    case device_clear:
+    case device_remote:
+    case device_local:
+    case destroy_link:
+        replyError(transp, VXI_OK);
+        break;
+    case device_lock:
+    case device_unlock:
+    case device_enable_srq:
+    case device_docmd:
+    case create_intr_chan:
+    case destroy_intr_chan:
+        replyError(transp, VXI_NOTSUPP);
+        break;
+    default:
+        svcerr_noproc(transp);
+        break;
+    }
+}
+
+static void serverThread(void *arg)
+{
+    svc_run();
+    printf("vxi11LoopbackServer: svc_run returned\n");
+}
+
+int vxi11LoopbackServer(int responseSize)
+{
+    SVCXPRT *transp;
+    u_long i;
+
+    if (pserver) {
+        printf("vxi11LoopbackServer: already running\n");
+        return -1;
+    }
+    if (rpcTaskInit() == -1) {
+        printf("vxi11LoopbackServer: can't init RPC\n");
+        return -1;
+    }
+    if (responseSize <= 0) responseSize = DEFAULT_RESPONSE_SIZE;
+    transp = svctcp_create(RPC_ANYSOCK, 0, 0);
+    if (!transp) {
+        printf("vxi11LoopbackServer: can't create TCP service\n");
+        return -1;
+    }
+    pmap_unset(DEVICE_CORE, DEVICE_CORE_VERSION);
+    if (!svc_register(transp, DEVICE_CORE, DEVICE_CORE_VERSION, dispatch, IPPROTO_TCP)) {
+        printf("vxi11LoopbackServer: can't register with the portmapper. Is rpcbind running?\n");
+        svc_destroy(transp);
+        return -1;
+    }
+    pserver = callocMustSucceed(1, sizeof(*pserver), "vxi11LoopbackServer");
+    pserver->responseSize = responseSize;
+    pserver->response = mallocMustSucceed(responseSize, "vxi11LoopbackServer");
+    for (i = 0; i < pserver->responseSize; i++)
+        pserver->response[i] = '0' + (char)(i % 10);
+    pserver->response[pserver->responseSize - 1] = '\n';
+    epicsThreadCreate("vxi11Loopback",
+                      epicsThreadPriorityLow,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      serverThread, NULL);
+    return 0;
+}
+
+int vxi11LoopbackServerReport(void)
+{
+    if (!pserver) {
+        printf("vxi11LoopbackServer: not running\n");
+        return -1;
+    }
+    printf("vxi11LoopbackServer: response size %lu, device_read calls %lu, bytes sent %lu\n",
+           (unsigned long)pserver->responseSize, pserver->nReads, pserver->nBytes);
+    return 0;
+}
+
+static const iocshArg vxi11LoopbackServerArg0 = { "response size",iocshArgInt};
+static const iocshArg *vxi11LoopbackServerArgs[1] = {&vxi11LoopbackServerArg0};
+static const iocshFuncDef vxi11LoopbackServerFuncDef = {"vxi11LoopbackServer",1,vxi11LoopbackServerArgs};
+static void vxi11LoopbackServerCallFunc(const iocshArgBuf *args)
+{
+    vxi11LoopbackServer(args[0].ival);
+}
+
+static const iocshFuncDef vxi11LoopbackServerReportFuncDef = {"vxi11LoopbackServerReport",0,NULL};
+static void vxi11LoopbackServerReportCallFunc(const iocshArgBuf *args)
+{
+    vxi11LoopbackServerReport();
+}
+
+static void vxi11LoopbackServerRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&vxi11LoopbackServerFuncDef,vxi11LoopbackServerCallFunc);
+        iocshRegister(&vxi11LoopbackServerReportFuncDef,vxi11LoopbackServerReportCallFunc);
+    }
+}
+epicsExportRegistrar(vxi11LoopbackServerRegister);
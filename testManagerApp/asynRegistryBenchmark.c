@@ -0,0 +1,122 @@
+/* asynRegistryBenchmark.c */
+/*
+ * Times the asynManager registry at startup scale: registers nPorts
+ * multi-device ports, connects to nAddrs addresses on each of them and
+ * looks up an interface through every device.
+ * The ports have no asynCommon interface and no port thread, so only the
+ * lookups of ports, devices and interfaces are measured.
+ * The ports can not be removed, so run it in an otherwise empty IOC.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsStdio.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <asynOctet.h>
+#include <epicsExport.h>
+
+static asynInterface octetInterface = {asynOctetType, 0, 0};
+
+static void printPhase(const char *phase, int n, const epicsTimeStamp *start)
+{
+    epicsTimeStamp end;
+    double elapsed;
+
+    epicsTimeGetCurrent(&end);
+    elapsed = epicsTimeDiffInSeconds(&end, start);
+    printf("%-24s %8d in %8.3f ms, %8.3f us each\n",
+           phase, n, elapsed * 1e3, n ? elapsed / n * 1e6 : 0.);
+}
+
+static int lookupDevices(const char *prefix, int nPorts, int nAddrs, int findIf)
+{
+    asynUser *pasynUser = pasynManager->createAsynUser(0, 0);
+    char portName[40];
+    int port, addr;
+
+    for (port = 0; port < nPorts; port++) {
+        epicsSnprintf(portName, sizeof(portName), "%s%d", prefix, port);
+        for (addr = 0; addr < nAddrs; addr++) {
+            if (pasynManager->connectDevice(pasynUser, portName, addr)) {
+                printf("asynRegistryBenchmark: %s\n", pasynUser->errorMessage);
+                pasynManager->freeAsynUser(pasynUser);
+                return -1;
+            }
+            if (findIf && !pasynManager->findInterface(pasynUser, asynOctetType, 1)) {
+                printf("asynRegistryBenchmark: %s %d no %s\n",
+                       portName, addr, asynOctetType);
+            }
+            pasynManager->disconnect(pasynUser);
+        }
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+
+static int asynRegistryBenchmark(const char *prefix, int nPorts, int nAddrs)
+{
+    epicsTimeStamp start;
+    char portName[40];
+    int port;
+
+    if (!prefix || !*prefix) prefix = "registryBenchmark";
+    if (nPorts <= 0) nPorts = 1000;
+    if (nAddrs <= 0) nAddrs = 100;
+
+    epicsTimeGetCurrent(&start);
+    for (port = 0; port < nPorts; port++) {
+        epicsSnprintf(portName, sizeof(portName), "%s%d", prefix, port);
+        if (pasynManager->registerPort(portName, ASYN_MULTIDEVICE, 0, 0, 0) ||
+            pasynManager->registerInterface(portName, &octetInterface)) {
+            printf("asynRegistryBenchmark: can't register port %s\n", portName);
+            return -1;
+        }
+    }
+    printPhase("registerPort", nPorts, &start);
+
+    epicsTimeGetCurrent(&start);
+    if (lookupDevices(prefix, nPorts, nAddrs, 0)) return -1;
+    printPhase("connectDevice (new)", nPorts * nAddrs, &start);
+
+    epicsTimeGetCurrent(&start);
+    if (lookupDevices(prefix, nPorts, nAddrs, 0)) return -1;
+    printPhase("connectDevice", nPorts * nAddrs, &start);
+
+    epicsTimeGetCurrent(&start);
+    if (lookupDevices(prefix, nPorts, nAddrs, 1)) return -1;
+    printPhase("connect+findInterface", nPorts * nAddrs, &start);
+    return 0;
+}
+
+/* iocsh functions */
+static const iocshArg benchmarkArg0 = {"portPrefix", iocshArgString};
+static const iocshArg benchmarkArg1 = {"nPorts", iocshArgInt};
+static const iocshArg benchmarkArg2 = {"nAddrs", iocshArgInt};
+static const iocshArg *const benchmarkArgs[] = {
+    &benchmarkArg0, &benchmarkArg1, &benchmarkArg2};
+static const iocshFuncDef benchmarkDef = {"asynRegistryBenchmark", 3, benchmarkArgs};
+static void benchmarkCall(const iocshArgBuf * args)
+{
+    asynRegistryBenchmark(args[0].sval, args[1].ival, args[2].ival);
+}
+
+static void asynRegistryBenchmarkRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&benchmarkDef, benchmarkCall);
+    }
+}
+epicsExportRegistrar(asynRegistryBenchmarkRegister);
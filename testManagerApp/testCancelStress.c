@@ -0,0 +1,368 @@
+/* testCancelStress.c */
+/*
+ * Stresses cancelRequest: nThreads threads each own nUsers asynUsers and
+ * for nCycles cycles queue a request for every one of them and cancel it
+ * again, while the port thread processes them and, on every other cycle,
+ * the queue timeouts expire.
+ * A request canceled on a cycle with a timeout is queued again at once with
+ * a much longer timeout, while the timer of the canceled one may still be
+ * firing. The timeout callback of the new request must not come early.
+ * After cancelRequest returns the callback of a request must have been
+ * called exactly once if wasQueued is 0 and never if it is 1.
+ * Every violation is counted as an error.
+ *
+ * Use it with a port that can block, e.g. testManagerDriverInit(port,1,0,0).
+ * If disconnectPeriod is > 0 the port must be multiDevice, e.g.
+ * testManagerDriverInit(port,1,0,1,.001). Half of the users then use address 1,
+ * which is disconnected every disconnectPeriod seconds, so requests are also
+ * canceled and queued again while the port thread is auto-connecting it.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <epicsExport.h>
+
+#define DEFAULT_TIMEOUT .0001
+#define REQUEUE_TIMEOUT 1.0
+
+typedef struct cancelTest cancelTest;
+
+typedef struct cancelUser {
+    asynUser   *pasynUser;
+    cancelTest *ptest;
+    int        nCallbacks;  /* protected by cancelTest.lock */
+    epicsTimeStamp queueTime;   /* of the last queueRequest, also protected */
+    double     timeout;
+}cancelUser;
+
+typedef struct cancelThread {
+    cancelTest *ptest;
+    cancelUser *pusers;
+    int        nCanceled;
+    int        nCompleted;
+    int        nErrors;
+    double     cancelSum;
+    double     cancelMax;
+}cancelThread;
+
+struct cancelTest {
+    epicsMutexId lock;
+    epicsEventId done;
+    int          nUsers;
+    int          nCycles;
+    int          active;
+    int          nProcessed;
+    int          nTimedOut;
+    int          nEarly;      /* timeout callbacks before the timeout */
+    int          stop;
+    double       disconnectPeriod;
+    asynUser     *pasynUserDisconnect;
+    asynCommon   *pasynCommon;
+    void         *drvPvt;
+    epicsEventId disconnectDone;
+    int          nDisconnects;
+};
+
+static void processCallback(asynUser *pasynUser)
+{
+    cancelUser *pcancelUser = (cancelUser *)pasynUser->userPvt;
+    cancelTest *ptest = pcancelUser->ptest;
+
+    epicsMutexMustLock(ptest->lock);
+    pcancelUser->nCallbacks++;
+    ptest->nProcessed++;
+    epicsMutexUnlock(ptest->lock);
+}
+
+static void timeoutCallback(asynUser *pasynUser)
+{
+    cancelUser *pcancelUser = (cancelUser *)pasynUser->userPvt;
+    cancelTest *ptest = pcancelUser->ptest;
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    epicsMutexMustLock(ptest->lock);
+    pcancelUser->nCallbacks++;
+    ptest->nTimedOut++;
+    /* Half the timeout allows for the timer queue rounding the delay */
+    if (epicsTimeDiffInSeconds(&now, &pcancelUser->queueTime) < pcancelUser->timeout / 2)
+        ptest->nEarly++;
+    epicsMutexUnlock(ptest->lock);
+}
+
+/* Runs in the port thread with asynQueuePriorityConnect */
+static void disconnectCallback(asynUser *pasynUser)
+{
+    cancelTest *ptest = (cancelTest *)pasynUser->userPvt;
+    int connected = 0;
+
+    pasynManager->isConnected(pasynUser, &connected);
+    if (connected && ptest->pasynCommon->disconnect(ptest->drvPvt, pasynUser) == asynSuccess)
+        ptest->nDisconnects++;
+}
+
+/* Disconnects address 1 every disconnectPeriod seconds. It is auto-connected
+ * again by the port thread when it finds a request for it */
+static void disconnectThreadFunc(void *arg)
+{
+    cancelTest *ptest = (cancelTest *)arg;
+
+    while (1) {
+        epicsMutexMustLock(ptest->lock);
+        if (ptest->stop) {
+            epicsMutexUnlock(ptest->lock);
+            break;
+        }
+        epicsMutexUnlock(ptest->lock);
+        if (pasynManager->queueRequest(ptest->pasynUserDisconnect,
+                                       asynQueuePriorityConnect, 0)) {
+            printf("testCancelStress: disconnect %s\n",
+                   ptest->pasynUserDisconnect->errorMessage);
+            break;
+        }
+        epicsThreadSleep(ptest->disconnectPeriod);
+    }
+    epicsEventSignal(ptest->disconnectDone);
+}
+
+static int getCallbacks(cancelUser *pcancelUser)
+{
+    int nCallbacks;
+
+    epicsMutexMustLock(pcancelUser->ptest->lock);
+    nCallbacks = pcancelUser->nCallbacks;
+    epicsMutexUnlock(pcancelUser->ptest->lock);
+    return nCallbacks;
+}
+
+/* Queues a request and cancels it, returns wasQueued or -1 on error */
+static int queueAndCancel(cancelThread *pthread, cancelUser *pcancelUser,
+                          double timeout, int yield)
+{
+    cancelTest *ptest = pthread->ptest;
+    asynUser *pasynUser = pcancelUser->pasynUser;
+    epicsTimeStamp start, end;
+    double elapsed;
+    int before, wasQueued, expected;
+
+    before = getCallbacks(pcancelUser);
+    epicsMutexMustLock(ptest->lock);
+    epicsTimeGetCurrent(&pcancelUser->queueTime);
+    pcancelUser->timeout = timeout;
+    epicsMutexUnlock(ptest->lock);
+    if (pasynManager->queueRequest(pasynUser, asynQueuePriorityLow, timeout)) {
+        printf("testCancelStress: queueRequest %s\n", pasynUser->errorMessage);
+        pthread->nErrors++;
+        return -1;
+    }
+    /* Give the port thread and the timer a chance to get there first */
+    if (yield) epicsThreadSleep(0.);
+    epicsTimeGetCurrent(&start);
+    pasynManager->cancelRequest(pasynUser, &wasQueued);
+    epicsTimeGetCurrent(&end);
+    elapsed = epicsTimeDiffInSeconds(&end, &start);
+    pthread->cancelSum += elapsed;
+    if (elapsed > pthread->cancelMax) pthread->cancelMax = elapsed;
+    if (wasQueued) pthread->nCanceled++;
+    else pthread->nCompleted++;
+    expected = wasQueued ? 0 : 1;
+    if (getCallbacks(pcancelUser) - before != expected) pthread->nErrors++;
+    return wasQueued;
+}
+
+static void cancelThreadFunc(void *arg)
+{
+    cancelThread *pthread = (cancelThread *)arg;
+    cancelTest *ptest = pthread->ptest;
+    int cycle, i;
+
+    for (cycle = 0; cycle < ptest->nCycles; cycle++) {
+        double timeout = (cycle & 1) ? DEFAULT_TIMEOUT : 0.;
+
+        for (i = 0; i < ptest->nUsers; i++) {
+            cancelUser *pcancelUser = &pthread->pusers[i];
+
+            /* The timer of a canceled request may still be running when it
+             * is queued again with a timeout */
+            if ((queueAndCancel(pthread, pcancelUser, timeout, i & 1) == 1)
+            && (timeout > 0.))
+                queueAndCancel(pthread, pcancelUser, REQUEUE_TIMEOUT, 0);
+        }
+    }
+    epicsMutexMustLock(ptest->lock);
+    if (--ptest->active == 0) epicsEventSignal(ptest->done);
+    epicsMutexUnlock(ptest->lock);
+}
+
+static int startDisconnect(cancelTest *ptest, const char *portName)
+{
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+
+    pasynUser = pasynManager->createAsynUser(disconnectCallback, 0);
+    pasynUser->userPvt = ptest;
+    if (pasynManager->connectDevice(pasynUser, portName, 1)) {
+        printf("testCancelStress: %s\n", pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynCommonType, 1);
+    if (!pasynInterface) {
+        printf("testCancelStress: %s has no asynCommon\n", portName);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    ptest->pasynUserDisconnect = pasynUser;
+    ptest->pasynCommon = (asynCommon *)pasynInterface->pinterface;
+    ptest->drvPvt = pasynInterface->drvPvt;
+    ptest->disconnectDone = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadMustCreate("cancelStressDisconnect", epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        disconnectThreadFunc, ptest);
+    return 0;
+}
+
+static int testCancelStress(const char *portName, int nThreads, int nUsers, int nCycles,
+                            double disconnectPeriod)
+{
+    cancelTest test;
+    cancelThread *pthreads;
+    cancelUser *pusers;
+    int nCanceled = 0, nCompleted = 0, nErrors = 0;
+    double cancelSum = 0., cancelMax = 0.;
+    int nTotal, i;
+
+    if (!portName) {
+        printf("Usage: testCancelStress port nThreads nUsers nCycles disconnectPeriod\n");
+        return -1;
+    }
+    if (nThreads <= 0) nThreads = 8;
+    if (nUsers <= 0) nUsers = 100;
+    if (nCycles <= 0) nCycles = 100;
+
+    memset(&test, 0, sizeof(test));
+    test.lock = epicsMutexMustCreate();
+    test.done = epicsEventMustCreate(epicsEventEmpty);
+    test.nUsers = nUsers;
+    test.nCycles = nCycles;
+    test.disconnectPeriod = disconnectPeriod;
+    nTotal = nThreads * nUsers;
+    pusers = callocMustSucceed(nTotal, sizeof(cancelUser), "testCancelStress");
+    pthreads = callocMustSucceed(nThreads, sizeof(cancelThread), "testCancelStress");
+    for (i = 0; i < nTotal; i++) {
+        cancelUser *pcancelUser = &pusers[i];
+
+        pcancelUser->ptest = &test;
+        pcancelUser->pasynUser = pasynManager->createAsynUser(processCallback, timeoutCallback);
+        pcancelUser->pasynUser->userPvt = pcancelUser;
+        if (pasynManager->connectDevice(pcancelUser->pasynUser, portName,
+                                        (disconnectPeriod > 0) ? (i & 1) : 0)) {
+            printf("testCancelStress: %s\n", pcancelUser->pasynUser->errorMessage);
+            return -1;
+        }
+    }
+    if (disconnectPeriod > 0 && startDisconnect(&test, portName)) return -1;
+    test.active = nThreads;
+    for (i = 0; i < nThreads; i++) {
+        char name[40];
+
+        pthreads[i].ptest = &test;
+        pthreads[i].pusers = &pusers[i * nUsers];
+        epicsSnprintf(name, sizeof(name), "cancelStress%d", i);
+        epicsThreadMustCreate(name, epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            cancelThreadFunc, &pthreads[i]);
+    }
+    epicsEventMustWait(test.done);
+    if (test.pasynUserDisconnect) {
+        epicsMutexMustLock(test.lock);
+        test.stop = 1;
+        epicsMutexUnlock(test.lock);
+        epicsEventMustWait(test.disconnectDone);
+    }
+
+    for (i = 0; i < nThreads; i++) {
+        nCanceled += pthreads[i].nCanceled;
+        nCompleted += pthreads[i].nCompleted;
+        nErrors += pthreads[i].nErrors;
+        cancelSum += pthreads[i].cancelSum;
+        if (pthreads[i].cancelMax > cancelMax) cancelMax = pthreads[i].cancelMax;
+    }
+    printf("%s %d threads, %d users each, %d cycles\n", portName, nThreads, nUsers, nCycles);
+    printf("    canceled %d, processed %d, timed out %d, errors %d\n",
+           nCanceled, test.nProcessed, test.nTimedOut, nErrors);
+    if (test.nEarly) {
+        printf("    ERROR %d timeout callbacks came before the timeout\n", test.nEarly);
+        nErrors += test.nEarly;
+    }
+    if (test.pasynUserDisconnect)
+        printf("    address 1 disconnected %d times\n", test.nDisconnects);
+    if (nCanceled + nCompleted > 0) {
+        printf("    cancelRequest mean %.3f max %.3f us\n",
+               cancelSum / (nCanceled + nCompleted) * 1e6, cancelMax * 1e6);
+    }
+    if (test.nProcessed + test.nTimedOut != nCompleted) {
+        printf("    ERROR %d callbacks for %d requests that were not canceled\n",
+               test.nProcessed + test.nTimedOut, nCompleted);
+        nErrors++;
+    }
+    for (i = 0; i < nTotal; i++) {
+        pasynManager->disconnect(pusers[i].pasynUser);
+        pasynManager->freeAsynUser(pusers[i].pasynUser);
+    }
+    if (test.pasynUserDisconnect) {
+        int wasQueued;
+
+        pasynManager->cancelRequest(test.pasynUserDisconnect, &wasQueued);
+        pasynManager->disconnect(test.pasynUserDisconnect);
+        pasynManager->freeAsynUser(test.pasynUserDisconnect);
+        epicsEventDestroy(test.disconnectDone);
+    }
+    free(pthreads);
+    free(pusers);
+    epicsEventDestroy(test.done);
+    epicsMutexDestroy(test.lock);
+    return nErrors ? -1 : 0;
+}
+
+/* iocsh functions */
+static const iocshArg testCancelStressArg0 = {"port", iocshArgString};
+static const iocshArg testCancelStressArg1 = {"nThreads", iocshArgInt};
+static const iocshArg testCancelStressArg2 = {"nUsers", iocshArgInt};
+static const iocshArg testCancelStressArg3 = {"nCycles", iocshArgInt};
+static const iocshArg testCancelStressArg4 = {"disconnectPeriod", iocshArgDouble};
+static const iocshArg *const testCancelStressArgs[] = {
+    &testCancelStressArg0, &testCancelStressArg1, &testCancelStressArg2,
+    &testCancelStressArg3, &testCancelStressArg4};
+static const iocshFuncDef testCancelStressDef = {"testCancelStress", 5, testCancelStressArgs};
+static void testCancelStressCall(const iocshArgBuf * args)
+{
+    testCancelStress(args[0].sval, args[1].ival, args[2].ival, args[3].ival, args[4].dval);
+}
+
+static void testCancelStressRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&testCancelStressDef, testCancelStressCall);
+    }
+}
+epicsExportRegistrar(testCancelStressRegister);
@@ -0,0 +1,222 @@
+/* testConnectBackoff.c */
+/*
+ * Checks the spacing of autoConnect attempts. testConnectBackoff registers
+ * a new multiDevice port portName whose address 0 never connects, keeps
+ * queueing requests for it and records when each of nAttempts connect
+ * attempts is made.
+ * If minDelay is 0 the backoff is not configured and the attempts must be
+ * 2 seconds apart. Otherwise setConnectBackoff(minDelay,maxDelay,0,failFast)
+ * is called and the spacing must double from minDelay up to maxDelay.
+ * With failFast queueRequest must fail while an attempt is not yet due,
+ * without it never.
+ * Every violation is counted as an error.
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <epicsExport.h>
+
+#define FIXED_SPACING 2.0
+#define POLL_PERIOD .01
+/* Allowed lateness of an attempt, mostly from polling */
+#define LATE_TOLERANCE .1
+
+typedef struct backoffTest {
+    epicsMutexId   lock;
+    epicsEventId   done;
+    asynInterface  common;
+    int            nAttempts;
+    int            attempts;
+    epicsTimeStamp *attemptTime;
+}backoffTest;
+
+static void report(void *drvPvt, FILE *fp, int details)
+{
+    backoffTest *ptest = (backoffTest *)drvPvt;
+
+    fprintf(fp, "    testConnectBackoff %d connect attempts\n", ptest->attempts);
+}
+
+/* The port connects, address 0 never does */
+static asynStatus connect(void *drvPvt, asynUser *pasynUser)
+{
+    backoffTest *ptest = (backoffTest *)drvPvt;
+    int addr;
+
+    if (pasynManager->getAddr(pasynUser, &addr)) return asynError;
+    if (addr < 0) {
+        pasynManager->exceptionConnect(pasynUser);
+        return asynSuccess;
+    }
+    epicsMutexMustLock(ptest->lock);
+    if (ptest->attempts < ptest->nAttempts)
+        epicsTimeGetCurrent(&ptest->attemptTime[ptest->attempts]);
+    ptest->attempts++;
+    epicsMutexUnlock(ptest->lock);
+    epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                  "testConnectBackoff: address %d does not connect", addr);
+    return asynError;
+}
+
+static asynStatus disconnect(void *drvPvt, asynUser *pasynUser)
+{
+    pasynManager->exceptionDisconnect(pasynUser);
+    return asynSuccess;
+}
+
+static asynCommon common = { report, connect, disconnect };
+
+static void requestCallback(asynUser *pasynUser)
+{
+    backoffTest *ptest = (backoffTest *)pasynUser->userPvt;
+
+    epicsEventSignal(ptest->done);
+}
+
+static int getAttempts(backoffTest *ptest)
+{
+    int attempts;
+
+    epicsMutexMustLock(ptest->lock);
+    attempts = ptest->attempts;
+    epicsMutexUnlock(ptest->lock);
+    return attempts;
+}
+
+static double expectedSpacing(int attempt, double minDelay, double maxDelay)
+{
+    double delay = minDelay;
+
+    if (minDelay <= 0) return FIXED_SPACING;
+    while (--attempt > 0 && delay < maxDelay) delay *= 2.0;
+    return (delay > maxDelay) ? maxDelay : delay;
+}
+
+static int testConnectBackoff(const char *portName, int nAttempts,
+                              double minDelay, double maxDelay, int failFast)
+{
+    backoffTest *ptest;
+    asynUser *pasynUser;
+    epicsTimeStamp start, now;
+    double limit = 0., spacing, expected;
+    int i, nFailFast = 0, nErrors = 0;
+
+    if (!portName || !*portName || nAttempts < 2 || minDelay < 0 ||
+        (minDelay > 0 && maxDelay < minDelay)) {
+        printf("Usage: testConnectBackoff port nAttempts minDelay maxDelay failFast\n");
+        return -1;
+    }
+    ptest = callocMustSucceed(1, sizeof(*ptest), "testConnectBackoff");
+    ptest->lock = epicsMutexMustCreate();
+    ptest->done = epicsEventMustCreate(epicsEventEmpty);
+    ptest->nAttempts = nAttempts;
+    ptest->attemptTime = callocMustSucceed(nAttempts, sizeof(epicsTimeStamp),
+                                           "testConnectBackoff");
+    ptest->common.interfaceType = asynCommonType;
+    ptest->common.pinterface = &common;
+    ptest->common.drvPvt = ptest;
+    /* The port and the test are never freed, as ports can not be removed */
+    if (pasynManager->registerPort(portName, ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0) ||
+        pasynManager->registerInterface(portName, &ptest->common)) {
+        printf("testConnectBackoff: can't register port %s\n", portName);
+        return -1;
+    }
+    pasynUser = pasynManager->createAsynUser(requestCallback, requestCallback);
+    pasynUser->userPvt = ptest;
+    if (pasynManager->connectDevice(pasynUser, portName, 0)) {
+        printf("testConnectBackoff: %s\n", pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    if (minDelay > 0 &&
+        pasynManager->setConnectBackoff(pasynUser, minDelay, maxDelay, 0., failFast)) {
+        printf("testConnectBackoff: %s\n", pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    for (i = 1; i < nAttempts; i++)
+        limit += expectedSpacing(i, minDelay, maxDelay) + LATE_TOLERANCE;
+    epicsTimeGetCurrent(&start);
+    while (getAttempts(ptest) < nAttempts) {
+        asynStatus status;
+
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &start) > limit + 1.0) {
+            printf("testConnectBackoff: only %d attempts in %.3f s\n",
+                   getAttempts(ptest), limit + 1.0);
+            nErrors++;
+            break;
+        }
+        status = pasynManager->queueRequest(pasynUser, asynQueuePriorityLow, POLL_PERIOD);
+        if (status == asynDisconnected) {
+            nFailFast++;
+            epicsThreadSleep(POLL_PERIOD);
+            continue;
+        }
+        if (status) {
+            printf("testConnectBackoff: queueRequest %s\n", pasynUser->errorMessage);
+            nErrors++;
+            break;
+        }
+        epicsEventMustWait(ptest->done);
+    }
+    printf("testConnectBackoff %s: %s\n", portName,
+           (minDelay > 0) ? "backoff" : "no backoff");
+    printf("    attempt  spacing  expected\n");
+    for (i = 1; i < nAttempts && i < getAttempts(ptest); i++) {
+        spacing = epicsTimeDiffInSeconds(&ptest->attemptTime[i], &ptest->attemptTime[i-1]);
+        expected = expectedSpacing(i, minDelay, maxDelay);
+        printf("    %7d %8.3f %9.3f\n", i + 1, spacing, expected);
+        if (spacing < expected - POLL_PERIOD || spacing > expected + LATE_TOLERANCE)
+            nErrors++;
+    }
+    if ((failFast && minDelay > 0) ? (nFailFast == 0) : (nFailFast != 0)) {
+        printf("testConnectBackoff: queueRequest failed fast %d times\n", nFailFast);
+        nErrors++;
+    }
+    printf("    failed fast %d, errors %d\n", nFailFast, nErrors);
+    pasynManager->disconnect(pasynUser);
+    pasynManager->freeAsynUser(pasynUser);
+    return nErrors ? -1 : 0;
+}
+
+static const iocshArg testConnectBackoffArg0 = {"port", iocshArgString};
+static const iocshArg testConnectBackoffArg1 = {"nAttempts", iocshArgInt};
+static const iocshArg testConnectBackoffArg2 = {"minDelay", iocshArgDouble};
+static const iocshArg testConnectBackoffArg3 = {"maxDelay", iocshArgDouble};
+static const iocshArg testConnectBackoffArg4 = {"failFast", iocshArgInt};
+static const iocshArg *const testConnectBackoffArgs[] = {
+    &testConnectBackoffArg0, &testConnectBackoffArg1, &testConnectBackoffArg2,
+    &testConnectBackoffArg3, &testConnectBackoffArg4};
+static const iocshFuncDef testConnectBackoffDef = {"testConnectBackoff", 5, testConnectBackoffArgs};
+static void testConnectBackoffCall(const iocshArgBuf * args)
+{
+    testConnectBackoff(args[0].sval, args[1].ival, args[2].dval, args[3].dval, args[4].ival);
+}
+
+static void testConnectBackoffRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&testConnectBackoffDef, testConnectBackoffCall);
+    }
+}
+epicsExportRegistrar(testConnectBackoffRegister);
@@ -0,0 +1,297 @@
+/* testDeadlineQueue.c */
+/*
+ * Checks the deadline queue policy and dropExpired. While a first request
+ * holds the port thread, nRequests requests with deadlines in shuffled
+ * order, requests without a deadline and requests whose deadline has
+ * already passed are queued. When the port is released they must be taken
+ * earliest deadline first, then those without a deadline in the order they
+ * were queued. Expired requests queued with dropExpired must get their
+ * timeout callback instead of the process callback, and be counted as
+ * expired in the queue statistics.
+ * If syncPort is given, a request with a passed deadline and dropExpired
+ * must also get its timeout callback, from queueRequestDeadline.
+ * Every violation is counted as an error.
+ *
+ * Use it with ports created by testManagerDriverInit(port,1,0,0) and
+ * testManagerDriverInit(syncPort,0,0,0).
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <epicsExport.h>
+
+/* Used to shuffle the deadlines, must not divide nRequests */
+#define SHUFFLE 7919
+#define FUTURE 10.0
+
+typedef struct deadlineTest deadlineTest;
+
+typedef struct deadlineUser {
+    asynUser       *pasynUser;
+    deadlineTest   *ptest;
+    int            index;        /* order in which it was queued */
+    int            hasDeadline;
+    int            dropExpired;
+    epicsTimeStamp deadline;
+    int            nProcess;
+    int            nTimeout;
+}deadlineUser;
+
+struct deadlineTest {
+    epicsMutexId lock;
+    epicsEventId blocked;
+    epicsEventId release;
+    epicsEventId done;
+    int          nUsers;
+    int          nCallbacks;
+    int          *order;         /* index of each user in callback order */
+};
+
+static void recordCallback(deadlineUser *puser, int timedOut)
+{
+    deadlineTest *ptest = puser->ptest;
+
+    epicsMutexMustLock(ptest->lock);
+    if (timedOut) puser->nTimeout++;
+    else puser->nProcess++;
+    if (ptest->nCallbacks < ptest->nUsers)
+        ptest->order[ptest->nCallbacks] = puser->index;
+    if (++ptest->nCallbacks == ptest->nUsers) epicsEventSignal(ptest->done);
+    epicsMutexUnlock(ptest->lock);
+}
+
+static void processCallback(asynUser *pasynUser)
+{
+    recordCallback((deadlineUser *)pasynUser->userPvt, 0);
+}
+
+static void timeoutCallback(asynUser *pasynUser)
+{
+    recordCallback((deadlineUser *)pasynUser->userPvt, 1);
+}
+
+/* Holds the port thread until the other requests are queued */
+static void blockCallback(asynUser *pasynUser)
+{
+    deadlineTest *ptest = (deadlineTest *)pasynUser->userPvt;
+
+    epicsEventSignal(ptest->blocked);
+    epicsEventMustWait(ptest->release);
+}
+
+/* Earliest deadline first, then those without one in queue order */
+static int compareUsers(const void *p1, const void *p2)
+{
+    const deadlineUser *pu1 = *(const deadlineUser * const *)p1;
+    const deadlineUser *pu2 = *(const deadlineUser * const *)p2;
+
+    if (pu1->hasDeadline != pu2->hasDeadline)
+        return pu1->hasDeadline ? -1 : 1;
+    if (pu1->hasDeadline) {
+        if (epicsTimeLessThan(&pu1->deadline, &pu2->deadline)) return -1;
+        if (epicsTimeLessThan(&pu2->deadline, &pu1->deadline)) return 1;
+    }
+    return pu1->index - pu2->index;
+}
+
+static int testSyncPort(const char *syncPort)
+{
+    deadlineTest test;
+    deadlineUser user;
+    epicsTimeStamp deadline;
+    asynStatus status;
+    int order, nErrors = 0;
+
+    memset(&test, 0, sizeof(test));
+    memset(&user, 0, sizeof(user));
+    test.lock = epicsMutexMustCreate();
+    test.done = epicsEventMustCreate(epicsEventEmpty);
+    test.nUsers = 1;
+    test.order = &order;
+    user.ptest = &test;
+    user.pasynUser = pasynManager->createAsynUser(processCallback, timeoutCallback);
+    user.pasynUser->userPvt = &user;
+    if (pasynManager->connectDevice(user.pasynUser, syncPort, 0)) {
+        printf("testDeadlineQueue: %s\n", user.pasynUser->errorMessage);
+        nErrors++;
+    } else {
+        epicsTimeGetCurrent(&deadline);
+        epicsTimeAddSeconds(&deadline, -1.0);
+        status = pasynManager->queueRequestDeadline(user.pasynUser,
+                     asynQueuePriorityLow, 0., &deadline, 1);
+        printf("%s expired request: status %d, %d process, %d timeout callbacks: %s\n",
+               syncPort, status, user.nProcess, user.nTimeout,
+               user.pasynUser->errorMessage);
+        if (status != asynSuccess || user.nProcess != 0 || user.nTimeout != 1)
+            nErrors++;
+        pasynManager->disconnect(user.pasynUser);
+    }
+    pasynManager->freeAsynUser(user.pasynUser);
+    epicsEventDestroy(test.done);
+    epicsMutexDestroy(test.lock);
+    return nErrors;
+}
+
+static int testDeadlineQueue(const char *portName, const char *syncPort, int nRequests)
+{
+    deadlineTest test;
+    deadlineUser *pusers, **psorted;
+    asynUser *pasynUserBlock;
+    asynQueueStatistics before, after;
+    epicsTimeStamp now;
+    int nPlain, nExpired, i, nErrors = 0;
+
+    if (!portName || !*portName) {
+        printf("Usage: testDeadlineQueue port syncPort nRequests\n");
+        return -1;
+    }
+    if (nRequests <= 0) nRequests = 100;
+    if (nRequests % SHUFFLE == 0) nRequests++;
+    nPlain = nExpired = (nRequests + 3) / 4;
+
+    memset(&test, 0, sizeof(test));
+    test.lock = epicsMutexMustCreate();
+    test.blocked = epicsEventMustCreate(epicsEventEmpty);
+    test.release = epicsEventMustCreate(epicsEventEmpty);
+    test.done = epicsEventMustCreate(epicsEventEmpty);
+    /* One more request has passed its deadline but is queued without dropExpired */
+    test.nUsers = nRequests + nPlain + nExpired + 1;
+    test.order = callocMustSucceed(test.nUsers, sizeof(int), "testDeadlineQueue");
+    pusers = callocMustSucceed(test.nUsers, sizeof(deadlineUser), "testDeadlineQueue");
+    psorted = callocMustSucceed(test.nUsers, sizeof(deadlineUser *), "testDeadlineQueue");
+
+    pasynUserBlock = pasynManager->createAsynUser(blockCallback, 0);
+    pasynUserBlock->userPvt = &test;
+    if (pasynManager->connectDevice(pasynUserBlock, portName, 0) ||
+        pasynManager->setQueuePolicy(pasynUserBlock, asynQueuePolicyDeadline) ||
+        pasynManager->getQueueStatistics(pasynUserBlock, asynQueuePriorityLow, &before)) {
+        printf("testDeadlineQueue: %s\n", pasynUserBlock->errorMessage);
+        pasynManager->freeAsynUser(pasynUserBlock);
+        return -1;
+    }
+    epicsTimeGetCurrent(&now);
+    for (i = 0; i < test.nUsers; i++) {
+        deadlineUser *puser = &pusers[i];
+
+        puser->ptest = &test;
+        puser->index = i;
+        puser->deadline = now;
+        if (i < nRequests) {
+            puser->hasDeadline = 1;
+            epicsTimeAddSeconds(&puser->deadline,
+                FUTURE + ((double)((i * SHUFFLE) % nRequests)) * 1e-3);
+        } else if (i < nRequests + nExpired) {
+            puser->hasDeadline = 1;
+            puser->dropExpired = 1;
+            epicsTimeAddSeconds(&puser->deadline, -2.0 + (i - nRequests) * 1e-3);
+        } else if (i == nRequests + nExpired) {
+            puser->hasDeadline = 1;
+            epicsTimeAddSeconds(&puser->deadline, -1.0);
+        }
+        puser->pasynUser = pasynManager->createAsynUser(processCallback, timeoutCallback);
+        puser->pasynUser->userPvt = puser;
+        if (pasynManager->connectDevice(puser->pasynUser, portName, 0)) {
+            printf("testDeadlineQueue: %s\n", puser->pasynUser->errorMessage);
+            return -1;
+        }
+        psorted[i] = puser;
+    }
+
+    if (pasynManager->queueRequest(pasynUserBlock, asynQueuePriorityLow, 0)) {
+        printf("testDeadlineQueue: %s\n", pasynUserBlock->errorMessage);
+        return -1;
+    }
+    epicsEventMustWait(test.blocked);
+    for (i = 0; i < test.nUsers; i++) {
+        deadlineUser *puser = &pusers[i];
+
+        if (pasynManager->queueRequestDeadline(puser->pasynUser, asynQueuePriorityLow, 0.,
+                (puser->hasDeadline ? &puser->deadline : 0), puser->dropExpired)) {
+            printf("testDeadlineQueue: %s\n", puser->pasynUser->errorMessage);
+            nErrors++;
+            epicsMutexMustLock(test.lock);
+            if (++test.nCallbacks == test.nUsers) epicsEventSignal(test.done);
+            epicsMutexUnlock(test.lock);
+        }
+    }
+    epicsEventSignal(test.release);
+    epicsEventMustWait(test.done);
+
+    qsort(psorted, test.nUsers, sizeof(deadlineUser *), compareUsers);
+    for (i = 0; i < test.nUsers; i++) {
+        deadlineUser *puser = psorted[i];
+
+        if (test.order[i] != puser->index) {
+            if (nErrors < 10)
+                printf("testDeadlineQueue: callback %d was for request %d, expected %d\n",
+                       i, test.order[i], puser->index);
+            nErrors++;
+        }
+        if (puser->nProcess != !puser->dropExpired || puser->nTimeout != puser->dropExpired) {
+            printf("testDeadlineQueue: request %d got %d process and %d timeout callbacks\n",
+                   puser->index, puser->nProcess, puser->nTimeout);
+            nErrors++;
+        }
+    }
+    pasynManager->getQueueStatistics(pasynUserBlock, asynQueuePriorityLow, &after);
+    printf("%s deadline queue: %d with deadline, %d without, %d expired, "
+           "%lu counted as expired\n",
+           portName, nRequests + 1, nPlain, nExpired, after.nExpired - before.nExpired);
+    if (after.nExpired - before.nExpired != (unsigned long)nExpired) nErrors++;
+    if (syncPort && *syncPort) nErrors += testSyncPort(syncPort);
+    printf("    errors %d\n", nErrors);
+
+    pasynManager->setQueuePolicy(pasynUserBlock, asynQueuePolicyFifo);
+    pasynManager->disconnect(pasynUserBlock);
+    pasynManager->freeAsynUser(pasynUserBlock);
+    for (i = 0; i < test.nUsers; i++) {
+        pasynManager->disconnect(pusers[i].pasynUser);
+        pasynManager->freeAsynUser(pusers[i].pasynUser);
+    }
+    free(psorted);
+    free(pusers);
+    free(test.order);
+    epicsEventDestroy(test.done);
+    epicsEventDestroy(test.release);
+    epicsEventDestroy(test.blocked);
+    epicsMutexDestroy(test.lock);
+    return nErrors ? -1 : 0;
+}
+
+/* iocsh functions */
+static const iocshArg testDeadlineQueueArg0 = {"port", iocshArgString};
+static const iocshArg testDeadlineQueueArg1 = {"syncPort", iocshArgString};
+static const iocshArg testDeadlineQueueArg2 = {"nRequests", iocshArgInt};
+static const iocshArg *const testDeadlineQueueArgs[] = {
+    &testDeadlineQueueArg0, &testDeadlineQueueArg1, &testDeadlineQueueArg2};
+static const iocshFuncDef testDeadlineQueueDef = {"testDeadlineQueue", 3, testDeadlineQueueArgs};
+static void testDeadlineQueueCall(const iocshArgBuf * args)
+{
+    testDeadlineQueue(args[0].sval, args[1].sval, args[2].ival);
+}
+
+static void testDeadlineQueueRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&testDeadlineQueueDef, testDeadlineQueueCall);
+    }
+}
+epicsExportRegistrar(testDeadlineQueueRegister);
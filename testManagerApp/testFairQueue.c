@@ -0,0 +1,191 @@
+/* testFairQueue.c */
+/*
+ * Measures the latency of requests to each address of a multiDevice port
+ * under skewed load: nChatty users keep requests queued for address 0 while
+ * one user queues requests for address 1 one at a time.
+ * Each callback takes serviceTime seconds, as a slow device would.
+ * With the fifo queue policy a request for address 1 waits for about
+ * nChatty requests for address 0, with roundRobin for at most one.
+ *
+ * Use it with a port created by testManagerDriverInit(port,1,0,1).
+ */
+/***********************************************************************
+* Copyright (c) 2002 The University of Chicago, as Operator of Argonne
+* National Laboratory, and the Regents of the University of
+* California, as Operator of Los Alamos National Laboratory
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsString.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+#include <asynDriver.h>
+#include <epicsExport.h>
+
+#define NUM_ADDRS 2
+#define DEFAULT_SERVICE_TIME .001
+
+typedef struct fairTest fairTest;
+
+typedef struct fairUser {
+    asynUser       *pasynUser;
+    fairTest       *ptest;
+    int            addr;
+    epicsTimeStamp queued;
+}fairUser;
+
+struct fairTest {
+    epicsMutexId lock;
+    epicsEventId done;
+    double       serviceTime;
+    int          nRequests;
+    int          stop;
+    int          active;
+    int          count[NUM_ADDRS];
+    double       sum[NUM_ADDRS];
+    double       max[NUM_ADDRS];
+};
+
+static void processCallback(asynUser *pasynUser)
+{
+    fairUser *pfairUser = (fairUser *)pasynUser->userPvt;
+    fairTest *ptest = pfairUser->ptest;
+    int addr = pfairUser->addr;
+    epicsTimeStamp now;
+    double latency;
+
+    epicsTimeGetCurrent(&now);
+    latency = epicsTimeDiffInSeconds(&now, &pfairUser->queued);
+    epicsThreadSleep(ptest->serviceTime);
+    epicsMutexMustLock(ptest->lock);
+    ptest->count[addr]++;
+    ptest->sum[addr] += latency;
+    if (latency > ptest->max[addr]) ptest->max[addr] = latency;
+    if (addr == 1 && ptest->count[addr] >= ptest->nRequests) ptest->stop = 1;
+    if (!ptest->stop) {
+        epicsTimeGetCurrent(&pfairUser->queued);
+        if (pasynManager->queueRequest(pasynUser, asynQueuePriorityLow, 0) == asynSuccess) {
+            epicsMutexUnlock(ptest->lock);
+            return;
+        }
+        printf("testFairQueue: queueRequest failed %s\n", pasynUser->errorMessage);
+        ptest->stop = 1;
+    }
+    if (--ptest->active == 0) epicsEventSignal(ptest->done);
+    epicsMutexUnlock(ptest->lock);
+}
+
+static int testFairQueue(const char *portName, const char *policy,
+                         int nChatty, int nRequests, double serviceTime)
+{
+    fairTest test;
+    fairUser *pfairUsers;
+    asynUser *pasynUser;
+    asynQueuePolicy queuePolicy = asynQueuePolicyFifo;
+    int nUsers, i;
+
+    if (!portName) {
+        printf("Usage: testFairQueue port policy nChatty nRequests serviceTime\n");
+        return -1;
+    }
+    if (policy && epicsStrCaseCmp(policy, "roundRobin") == 0)
+        queuePolicy = asynQueuePolicyRoundRobin;
+    if (nChatty <= 0) nChatty = 10;
+    if (nRequests <= 0) nRequests = 100;
+    if (serviceTime <= 0) serviceTime = DEFAULT_SERVICE_TIME;
+
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    if (pasynManager->connectDevice(pasynUser, portName, -1) ||
+        pasynManager->setQueuePolicy(pasynUser, queuePolicy)) {
+        printf("testFairQueue: %s\n", pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    pasynManager->freeAsynUser(pasynUser);
+
+    memset(&test, 0, sizeof(test));
+    test.lock = epicsMutexMustCreate();
+    test.done = epicsEventMustCreate(epicsEventEmpty);
+    test.serviceTime = serviceTime;
+    test.nRequests = nRequests;
+    nUsers = nChatty + 1;
+    pfairUsers = callocMustSucceed(nUsers, sizeof(fairUser), "testFairQueue");
+    for (i = 0; i < nUsers; i++) {
+        fairUser *pfairUser = &pfairUsers[i];
+
+        pfairUser->ptest = &test;
+        pfairUser->addr = (i < nChatty) ? 0 : 1;
+        pfairUser->pasynUser = pasynManager->createAsynUser(processCallback, 0);
+        pfairUser->pasynUser->userPvt = pfairUser;
+        if (pasynManager->connectDevice(pfairUser->pasynUser, portName, pfairUser->addr)) {
+            printf("testFairQueue: %s\n", pfairUser->pasynUser->errorMessage);
+            return -1;
+        }
+    }
+    /* Queue the chatty users first so that address 1 starts behind them */
+    epicsMutexMustLock(test.lock);
+    for (i = 0; i < nUsers; i++) {
+        fairUser *pfairUser = &pfairUsers[i];
+
+        epicsTimeGetCurrent(&pfairUser->queued);
+        if (pasynManager->queueRequest(pfairUser->pasynUser, asynQueuePriorityLow, 0)) {
+            printf("testFairQueue: %s\n", pfairUser->pasynUser->errorMessage);
+            continue;
+        }
+        test.active++;
+    }
+    epicsMutexUnlock(test.lock);
+    if (test.active) epicsEventMustWait(test.done);
+
+    printf("%s queue policy %s, %d users of address 0, %d requests to address 1, "
+           "service time %.3f ms\n",
+           portName, (queuePolicy == asynQueuePolicyRoundRobin) ? "roundRobin" : "fifo",
+           nChatty, nRequests, serviceTime * 1e3);
+    for (i = 0; i < NUM_ADDRS; i++) {
+        if (test.count[i] == 0) continue;
+        printf("    addr %d requests %d latency mean %.3f max %.3f ms\n",
+               i, test.count[i], test.sum[i] / test.count[i] * 1e3, test.max[i] * 1e3);
+    }
+    for (i = 0; i < nUsers; i++) {
+        pasynManager->disconnect(pfairUsers[i].pasynUser);
+        pasynManager->freeAsynUser(pfairUsers[i].pasynUser);
+    }
+    free(pfairUsers);
+    epicsEventDestroy(test.done);
+    epicsMutexDestroy(test.lock);
+    return 0;
+}
+
+/* iocsh functions */
+static const iocshArg testFairQueueArg0 = {"port", iocshArgString};
+static const iocshArg testFairQueueArg1 = {"policy", iocshArgString};
+static const iocshArg testFairQueueArg2 = {"nChatty", iocshArgInt};
+static const iocshArg testFairQueueArg3 = {"nRequests", iocshArgInt};
+static const iocshArg testFairQueueArg4 = {"serviceTime", iocshArgDouble};
+static const iocshArg *const testFairQueueArgs[] = {
+    &testFairQueueArg0, &testFairQueueArg1, &testFairQueueArg2,
+    &testFairQueueArg3, &testFairQueueArg4};
+static const iocshFuncDef testFairQueueDef = {"testFairQueue", 5, testFairQueueArgs};
+static void testFairQueueCall(const iocshArgBuf * args)
+{
+    testFairQueue(args[0].sval, args[1].sval, args[2].ival, args[3].ival, args[4].dval);
+}
+
+static void testFairQueueRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&testFairQueueDef, testFairQueueCall);
+    }
+}
+epicsExportRegistrar(testFairQueueRegister);
@@ -34,12 +34,13 @@ typedef struct testManagerPvt {
     const char    *portName;
     int           connected;
     int           multiDevice;
+    double        connectDelay; /* seconds each device connect takes */
     asynInterface common;
 }testManagerPvt;
 
 /* init routine */
 static int testManagerDriverInit(const char *dn, int canBlock,
-    int noAutoConnect,int multiDevice);
+    int noAutoConnect,int multiDevice,double connectDelay);
 
 /* asynCommon methods */
 static void report(void *drvPvt,FILE *fp,int details);
@@ -48,7 +49,7 @@ static asynStatus disconnect(void *drvPvt,asynUser *pasynUser);
 static asynCommon asyn = { report, connect, disconnect };
 
 static int testManagerDriverInit(const char *dn, int canBlock,
-    int noAutoConnect,int multiDevice)
+    int noAutoConnect,int multiDevice,double connectDelay)
 {
     testManagerPvt    *ptestManagerPvt;
     char       *portName;
@@ -62,6 +63,7 @@ static int testManagerDriverInit(const char *dn, int canBlock,
     strcpy(portName,dn);
     ptestManagerPvt->portName = portName;
     ptestManagerPvt->multiDevice = multiDevice;
+    ptestManagerPvt->connectDelay = connectDelay;
     ptestManagerPvt->common.interfaceType = asynCommonType;
     ptestManagerPvt->common.pinterface  = (void *)&asyn;
     ptestManagerPvt->common.drvPvt = ptestManagerPvt;
@@ -143,6 +145,8 @@ static asynStatus connect(void *drvPvt,asynUser *pasynUser)
             ptestManagerPvt->portName,addr);
         return asynError;
     }
+    if(ptestManagerPvt->connectDelay>0.0)
+        epicsThreadSleep(ptestManagerPvt->connectDelay);
     ptestManagerPvt->deviceConnected[addr] = 1;
     pasynManager->exceptionConnect(pasynUser);
     return(asynSuccess);
@@ -202,14 +206,17 @@ static const iocshArg testManagerDriverInitArg0 = { "portName", iocshArgString }
 static const iocshArg testManagerDriverInitArg1 = { "canBlock", iocshArgInt };
 static const iocshArg testManagerDriverInitArg2 = { "disable auto-connect", iocshArgInt };
 static const iocshArg testManagerDriverInitArg3 = { "multiDevice", iocshArgInt };
+static const iocshArg testManagerDriverInitArg4 = { "connectDelay", iocshArgDouble };
 static const iocshArg *testManagerDriverInitArgs[] = {
     &testManagerDriverInitArg0,&testManagerDriverInitArg1,
-    &testManagerDriverInitArg2,&testManagerDriverInitArg3};
+    &testManagerDriverInitArg2,&testManagerDriverInitArg3,
+    &testManagerDriverInitArg4};
 static const iocshFuncDef testManagerDriverInitFuncDef = {
-    "testManagerDriverInit", 4, testManagerDriverInitArgs};
+    "testManagerDriverInit", 5, testManagerDriverInitArgs};
 static void testManagerDriverInitCallFunc(const iocshArgBuf *args)
 {
-    testManagerDriverInit(args[0].sval,args[1].ival,args[2].ival,args[3].ival);
+    testManagerDriverInit(args[0].sval,args[1].ival,args[2].ival,args[3].ival,
+        args[4].dval);
 }
 
 static void testManagerDriverRegister(void)